@@ -11,6 +11,17 @@
 // Initial capacity for a heap.
 #define HEAP_CAPACITY 1024
 
+// Arity of an indexed priority queue.
+#ifndef IPQ_ARITY
+#define IPQ_ARITY 4
+#endif
+
+// Position of a handle that is not in an indexed priority queue.
+#define IPQ_NONE ((size_t)-1)
+
+// Out-degree of nodes in the Dijkstra benchmark.
+#define DEGREE 8
+
 // Type of elements that are stored in the heap.
 typedef int type_t;
 
@@ -170,6 +181,504 @@ static void heap_print(const struct heap *h)
     printf("] }\n");
 }
 
+//==============================================================================
+// Indexed Priority Queue
+//==============================================================================
+
+// Type of priorities in an indexed priority queue.
+typedef unsigned long priority_t;
+
+// An entry of an indexed priority queue.
+struct ipq_entry {
+    priority_t priority; // Priority.
+    size_t handle;       // Handle.
+};
+
+// An indexed d-ary min-heap. Elements are handles in the range [0, capacity),
+// and a position map locates any handle in the heap in constant time.
+struct ipq {
+    struct ipq_entry *entries; // Heap-ordered entries.
+    size_t *positions;         // Position of each handle in the heap (IPQ_NONE if absent).
+    size_t length;             // Number of handles in the heap.
+    size_t capacity;           // Number of handles.
+};
+
+// Creates an empty indexed priority queue for handles in the range [0, capacity).
+static struct ipq *ipq_create(size_t capacity)
+{
+    struct ipq *q = malloc(sizeof(struct ipq));
+    assert(q != NULL);
+
+    // Initialize data structure.
+    q->length = 0;
+    q->capacity = capacity;
+    q->entries = malloc(capacity * sizeof(struct ipq_entry));
+    assert(q->entries != NULL);
+    q->positions = malloc(capacity * sizeof(size_t));
+    assert(q->positions != NULL);
+    for (size_t i = 0; i < capacity; i++) {
+        q->positions[i] = IPQ_NONE;
+    }
+
+    return (q);
+}
+
+// Destroys an indexed priority queue.
+static void ipq_destroy(struct ipq *q)
+{
+    free(q->positions);
+    free(q->entries);
+    free(q);
+}
+
+// Returns the number of handles that are stored in an indexed priority queue.
+static size_t ipq_length(const struct ipq *q)
+{
+    return (q->length);
+}
+
+// Checks if a handle is stored in an indexed priority queue.
+static bool ipq_contains(const struct ipq *q, size_t handle)
+{
+    assert(handle < q->capacity);
+
+    return (q->positions[handle] != IPQ_NONE);
+}
+
+// Returns the priority of a handle that is stored in an indexed priority queue.
+static priority_t ipq_priority(const struct ipq *q, size_t handle)
+{
+    assert(ipq_contains(q, handle));
+
+    return (q->entries[q->positions[handle]].priority);
+}
+
+// Places an entry at a given position of an indexed priority queue.
+static void ipq_place(struct ipq *q, size_t pos, struct ipq_entry entry)
+{
+    q->entries[pos] = entry;
+    q->positions[entry.handle] = pos;
+}
+
+// Fixes the heap property after the priority of an entry decreases.
+static void ipq_fix_up(struct ipq *q, size_t node)
+{
+    struct ipq_entry entry = q->entries[node];
+
+    // Move parents down, rather than swapping at each level.
+    while (node > 0) {
+        size_t parent = (node - 1) / IPQ_ARITY;
+
+        if (q->entries[parent].priority <= entry.priority) {
+            break;
+        }
+
+        ipq_place(q, node, q->entries[parent]);
+        node = parent;
+    }
+
+    ipq_place(q, node, entry);
+}
+
+// Fixes the heap property after the priority of an entry increases.
+static void ipq_fix_down(struct ipq *q, size_t node)
+{
+    struct ipq_entry entry = q->entries[node];
+
+    for (;;) {
+        size_t first = IPQ_ARITY * node + 1;
+        size_t last = (first + IPQ_ARITY < q->length) ? first + IPQ_ARITY : q->length;
+        size_t smallest = node;
+        priority_t priority = entry.priority;
+
+        // Find the smallest child.
+        for (size_t child = first; child < last; child++) {
+            if (q->entries[child].priority < priority) {
+                smallest = child;
+                priority = q->entries[child].priority;
+            }
+        }
+
+        // Done: heap property is fixed.
+        if (smallest == node) {
+            break;
+        }
+
+        ipq_place(q, node, q->entries[smallest]);
+        node = smallest;
+    }
+
+    ipq_place(q, node, entry);
+}
+
+// Inserts a handle in an indexed priority queue.
+static void ipq_push(struct ipq *q, size_t handle, priority_t priority)
+{
+    assert(handle < q->capacity);
+    assert(!ipq_contains(q, handle));
+
+    ipq_place(q, q->length, (struct ipq_entry){priority, handle});
+    q->length += 1;
+    ipq_fix_up(q, q->length - 1);
+}
+
+// Returns the handle with the smallest priority in an indexed priority queue.
+static size_t ipq_top(const struct ipq *q)
+{
+    assert(q->length > 0);
+
+    return (q->entries[0].handle);
+}
+
+// Removes a handle from an indexed priority queue.
+static void ipq_remove(struct ipq *q, size_t handle)
+{
+    size_t pos = IPQ_NONE;
+    struct ipq_entry last;
+
+    assert(handle < q->capacity);
+    pos = q->positions[handle];
+    assert(pos != IPQ_NONE);
+
+    // Replace the entry by the last one, and restore the heap property.
+    q->positions[handle] = IPQ_NONE;
+    q->length -= 1;
+    if (pos == q->length) {
+        return;
+    }
+    last = q->entries[q->length];
+    ipq_place(q, pos, last);
+    if ((pos > 0) && (last.priority < q->entries[(pos - 1) / IPQ_ARITY].priority)) {
+        ipq_fix_up(q, pos);
+    } else {
+        ipq_fix_down(q, pos);
+    }
+}
+
+// Removes the handle with the smallest priority from an indexed priority queue.
+static size_t ipq_pop(struct ipq *q)
+{
+    size_t handle = ipq_top(q);
+
+    ipq_remove(q, handle);
+
+    return (handle);
+}
+
+// Decreases the priority of a handle in an indexed priority queue.
+static void ipq_decrease_priority(struct ipq *q, size_t handle, priority_t priority)
+{
+    size_t pos = IPQ_NONE;
+
+    assert(handle < q->capacity);
+    pos = q->positions[handle];
+    assert(pos != IPQ_NONE);
+    assert(priority <= q->entries[pos].priority);
+
+    q->entries[pos].priority = priority;
+    ipq_fix_up(q, pos);
+}
+
+// Builds an indexed priority queue in linear time from the priorities of handles [0, n).
+static void ipq_heapify(struct ipq *q, const priority_t priorities[], size_t n)
+{
+    assert(n <= q->capacity);
+
+    // Clear the queue.
+    for (size_t i = 0; i < q->length; i++) {
+        q->positions[q->entries[i].handle] = IPQ_NONE;
+    }
+
+    for (size_t i = 0; i < n; i++) {
+        ipq_place(q, i, (struct ipq_entry){priorities[i], i});
+    }
+    q->length = n;
+
+    // Sift down internal nodes, from the bottom up.
+    for (size_t i = (n + IPQ_ARITY - 2) / IPQ_ARITY; i > 0; i--) {
+        ipq_fix_down(q, i - 1);
+    }
+}
+
+// Inserts several handles in an indexed priority queue.
+static void ipq_push_many(struct ipq *q, const size_t handles[], const priority_t priorities[],
+                          size_t n)
+{
+    // Few handles, thus insert them one by one in O(n log length).
+    if (n < q->length / 2) {
+        for (size_t i = 0; i < n; i++) {
+            ipq_push(q, handles[i], priorities[i]);
+        }
+        return;
+    }
+
+    // Many handles, thus append them and rebuild the heap in O(n + length).
+    for (size_t i = 0; i < n; i++) {
+        assert(handles[i] < q->capacity);
+        assert(!ipq_contains(q, handles[i]));
+        ipq_place(q, q->length++, (struct ipq_entry){priorities[i], handles[i]});
+    }
+    for (size_t i = (q->length + IPQ_ARITY - 2) / IPQ_ARITY; i > 0; i--) {
+        ipq_fix_down(q, i - 1);
+    }
+}
+
+// Removes up to n handles with the smallest priorities from an indexed priority queue,
+// in increasing order of priority. Returns the number of removed handles.
+static size_t ipq_pop_many(struct ipq *q, size_t handles[], size_t n)
+{
+    size_t i = 0;
+
+    for (i = 0; (i < n) && (q->length > 0); i++) {
+        handles[i] = ipq_pop(q);
+    }
+
+    return (i);
+}
+
+//==============================================================================
+// Dijkstra Benchmark
+//==============================================================================
+
+// A min-heap with linear-scan priority updates, as used by the graph programs.
+struct scan_heap {
+    size_t *elements;       // Elements stored in the heap.
+    priority_t *priorities; // Priorities of elements stored in the heap.
+    size_t length;          // Current number of elements that are stored in the heap.
+};
+
+// Swaps two entries of a linear-scan heap.
+static void scan_heap_swap(struct scan_heap *h, size_t i, size_t j)
+{
+    size_t element = h->elements[i];
+    priority_t priority = h->priorities[i];
+
+    h->elements[i] = h->elements[j];
+    h->priorities[i] = h->priorities[j];
+    h->elements[j] = element;
+    h->priorities[j] = priority;
+}
+
+// Fixes the heap property after an insertion on a linear-scan heap.
+static void scan_heap_fix_up(struct scan_heap *h, size_t node)
+{
+    while ((node > 0) && (h->priorities[(node - 1) / 2] > h->priorities[node])) {
+        scan_heap_swap(h, node, (node - 1) / 2);
+        node = (node - 1) / 2;
+    }
+}
+
+// Removes the element with the smallest priority from a linear-scan heap.
+static size_t scan_heap_pop(struct scan_heap *h)
+{
+    size_t x = h->elements[0];
+    size_t root = 0;
+
+    scan_heap_swap(h, 0, --h->length);
+    for (;;) {
+        size_t smallest = root;
+        size_t left = 2 * root + 1;
+        size_t right = 2 * root + 2;
+
+        if ((left < h->length) && (h->priorities[left] < h->priorities[smallest])) {
+            smallest = left;
+        }
+        if ((right < h->length) && (h->priorities[right] < h->priorities[smallest])) {
+            smallest = right;
+        }
+        if (smallest == root) {
+            break;
+        }
+        scan_heap_swap(h, root, smallest);
+        root = smallest;
+    }
+
+    return (x);
+}
+
+// Decreases the priority of an element in a linear-scan heap.
+static void scan_heap_decrease_priority(struct scan_heap *h, size_t element, priority_t priority)
+{
+    for (size_t i = 0; i < h->length; i++) {
+        if (h->elements[i] == element) {
+            h->priorities[i] = priority;
+            scan_heap_fix_up(h, i);
+            return;
+        }
+    }
+}
+
+// Runs Dijkstra's Algorithm on a random graph using a linear-scan heap.
+static void dijkstra_scan(size_t nnodes, const size_t targets[], const unsigned weights[],
+                          priority_t distances[])
+{
+    struct scan_heap h;
+
+    h.elements = malloc(nnodes * sizeof(size_t));
+    assert(h.elements != NULL);
+    h.priorities = malloc(nnodes * sizeof(priority_t));
+    assert(h.priorities != NULL);
+    h.length = nnodes;
+
+    // Push initial distances. Node 0 is the source and it is already at the root.
+    for (size_t i = 0; i < nnodes; i++) {
+        distances[i] = (i == 0) ? 0 : (priority_t)-1;
+        h.elements[i] = i;
+        h.priorities[i] = distances[i];
+    }
+
+    while (h.length > 0) {
+        size_t i = scan_heap_pop(&h);
+
+        // Unreachable.
+        if (distances[i] == (priority_t)-1) {
+            break;
+        }
+
+        for (size_t k = i * DEGREE; k < (i + 1) * DEGREE; k++) {
+            priority_t d = distances[i] + weights[k];
+            if (d < distances[targets[k]]) {
+                distances[targets[k]] = d;
+                scan_heap_decrease_priority(&h, targets[k], d);
+            }
+        }
+    }
+
+    free(h.priorities);
+    free(h.elements);
+}
+
+// Runs Dijkstra's Algorithm on a random graph using an indexed priority queue.
+static void dijkstra_ipq(size_t nnodes, const size_t targets[], const unsigned weights[],
+                         priority_t distances[])
+{
+    struct ipq *q = ipq_create(nnodes);
+
+    // Push the source only, and push other nodes when they are first reached.
+    for (size_t i = 0; i < nnodes; i++) {
+        distances[i] = (i == 0) ? 0 : (priority_t)-1;
+    }
+    if (nnodes > 0) {
+        ipq_push(q, 0, 0);
+    }
+
+    while (ipq_length(q) > 0) {
+        size_t i = ipq_pop(q);
+
+        for (size_t k = i * DEGREE; k < (i + 1) * DEGREE; k++) {
+            size_t j = targets[k];
+            priority_t d = distances[i] + weights[k];
+
+            if (d < distances[j]) {
+                if (distances[j] == (priority_t)-1) {
+                    ipq_push(q, j, d);
+                } else {
+                    ipq_decrease_priority(q, j, d);
+                }
+                distances[j] = d;
+            }
+        }
+    }
+
+    ipq_destroy(q);
+}
+
+// Tests the indexed priority queue.
+static void test_ipq(size_t length, bool verbose)
+{
+    double tstart = 0.0;
+    double tend = 0.0;
+    const double MICROSECS = ((CLOCKS_PER_SEC / 1000000.0));
+    struct ipq *q = ipq_create(length);
+    priority_t *priorities = malloc(length * sizeof(priority_t));
+    size_t *handles = malloc(length * sizeof(size_t));
+    size_t *targets = malloc(length * DEGREE * sizeof(size_t));
+    unsigned *weights = malloc(length * DEGREE * sizeof(unsigned));
+    priority_t *distances[2];
+
+    assert((priorities != NULL) && (handles != NULL));
+    assert((targets != NULL) && (weights != NULL));
+
+    // Fix random number generator seed
+    // to have a determinist behavior across runs.
+    srand(0);
+
+    for (size_t i = 0; i < length; i++) {
+        priorities[i] = (priority_t)(rand() % (length + 1));
+        handles[i] = i;
+    }
+
+    // Build the queue in linear time, and drain it in batches.
+    tstart = clock();
+    ipq_heapify(q, priorities, length);
+    tend = clock();
+    printf("%18s: %2.lf us\n", "ipq_heapify()", (tend - tstart) / MICROSECS);
+    for (size_t n = 0, last = 0; (n = ipq_pop_many(q, handles, 16)) > 0;) {
+        for (size_t i = 0; i < n; i++) {
+            assert(priorities[handles[i]] >= last);
+            last = priorities[handles[i]];
+        }
+    }
+
+    // Push all handles at once, then decrease and remove some of them.
+    for (size_t i = 0; i < length; i++) {
+        handles[i] = i;
+    }
+    tstart = clock();
+    ipq_push_many(q, handles, priorities, length);
+    tend = clock();
+    printf("%18s: %2.lf us\n", "ipq_push_many()", (tend - tstart) / MICROSECS);
+    for (size_t i = 0; i < length; i += 2) {
+        ipq_decrease_priority(q, i, priorities[i] / 2);
+        assert(ipq_priority(q, i) == priorities[i] / 2);
+        priorities[i] /= 2;
+    }
+    for (size_t i = 1; i < length; i += 4) {
+        ipq_remove(q, i);
+    }
+    for (priority_t last = 0; ipq_length(q) > 0;) {
+        size_t i = ipq_pop(q);
+        assert((i % 4) != 1);
+        assert(priorities[i] >= last);
+        last = priorities[i];
+    }
+
+    if (verbose) {
+        printf("Indexed Priority Queue: arity %d\n", IPQ_ARITY);
+    }
+
+    // Random graph.
+    for (size_t i = 0; i < length * DEGREE; i++) {
+        targets[i] = (size_t)rand() % length;
+        weights[i] = 1 + (unsigned)(rand() % 100);
+    }
+
+    // Compare heaps on Dijkstra's Algorithm.
+    for (size_t i = 0; i < 2; i++) {
+        distances[i] = malloc(length * sizeof(priority_t));
+        assert(distances[i] != NULL);
+    }
+    tstart = clock();
+    dijkstra_scan(length, targets, weights, distances[0]);
+    tend = clock();
+    printf("%18s: %2.lf us\n", "dijkstra (scan)", (tend - tstart) / MICROSECS);
+    tstart = clock();
+    dijkstra_ipq(length, targets, weights, distances[1]);
+    tend = clock();
+    printf("%18s: %2.lf us\n", "dijkstra (ipq)", (tend - tstart) / MICROSECS);
+    assert(!memcmp(distances[0], distances[1], length * sizeof(priority_t)));
+
+    // Release resources.
+    for (size_t i = 0; i < 2; i++) {
+        free(distances[i]);
+    }
+    free(weights);
+    free(targets);
+    free(handles);
+    free(priorities);
+    ipq_destroy(q);
+}
+
 // Tests the Heap implementation.
 static void test(size_t length, bool verbose)
 {
@@ -206,6 +715,9 @@ static void test(size_t length, bool verbose)
 
     // Release heap.
     heap_destroy(h);
+
+    // Test the indexed priority queue.
+    test_ipq(length, verbose);
 }
 
 // Prints program usage and exits.
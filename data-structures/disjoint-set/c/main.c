@@ -1,12 +1,47 @@
 // Copyright (C) 2022 Pedro Henrique Penna <pedrohenriquepenna@outlook.com>
 
+#define _POSIX_C_SOURCE 200809L
+
 #include <assert.h>
+#include <inttypes.h>
+#include <pthread.h>
+#include <stdatomic.h>
 #include <stdbool.h>
 #include <stddef.h>
+#include <stdint.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
 #include <time.h>
+#include <unistd.h>
+
+// Width of element indexes in packed and concurrent disjoint sets.
+#ifndef DSET_INDEX_BITS
+#define DSET_INDEX_BITS 32
+#endif
+
+// Type of element indexes in packed and concurrent disjoint sets.
+#if (DSET_INDEX_BITS == 64)
+typedef uint64_t dset_index_t;
+#define PRI_DSET_INDEX PRIu64
+#define SCN_DSET_INDEX SCNu64
+#else
+typedef uint32_t dset_index_t;
+#define PRI_DSET_INDEX PRIu32
+#define SCN_DSET_INDEX SCNu32
+#endif
+
+// Flag of a root word in a packed disjoint set. The remaining bits store the rank.
+#define DSET_ROOT ((dset_index_t)1 << (DSET_INDEX_BITS - 1))
+
+// Number of edges ahead to prefetch in dset_union_many().
+#define DSET_PREFETCH_DISTANCE 16
+
+// Max number of threads in the connected components benchmark.
+#define CDSET_MAX_THREADS 64
+
+// Number of edges per node in the connected components benchmark.
+#define EDGES_PER_NODE 4
 
 //==============================================================================
 // Disjoint Set
@@ -115,6 +150,438 @@ static void dset_print(const struct dset *ds)
     printf("] }\n");
 }
 
+//==============================================================================
+// Packed Disjoint Set
+//==============================================================================
+
+// A disjoint set that packs parents and ranks in a single array. A word
+// either stores the parent of an element, or the DSET_ROOT flag and the rank
+// of a root. Each element thus costs a single index, and a union touches a
+// single cache line per root.
+struct pdset {
+    dset_index_t length;   // Number of elements.
+    dset_index_t *parents; // Parent or rank of elements.
+};
+
+// Creates a packed disjoint set.
+static struct pdset *pdset_create(dset_index_t length)
+{
+    struct pdset *ds = NULL;
+
+    // Only indexes that do not clash with the root flag are supported.
+    assert(length <= DSET_ROOT);
+
+    // Allocate resources.
+    assert((ds = malloc(sizeof(struct pdset))) != NULL);
+    assert((ds->parents = malloc(length * sizeof(ds->parents[0]))) != NULL);
+
+    // Initialize.
+    ds->length = length;
+    for (dset_index_t i = 0; i < length; i++) {
+        ds->parents[i] = DSET_ROOT;
+    }
+
+    return (ds);
+}
+
+// Destroys a packed disjoint set.
+static void pdset_destroy(struct pdset *ds)
+{
+    // Sanity check arguments.
+    assert(ds != NULL);
+
+    // Release resources.
+    free(ds->parents);
+    free(ds);
+}
+
+// Finds the representative element of a set in a packed disjoint set.
+static dset_index_t pdset_find(struct pdset *ds, dset_index_t p)
+{
+    // Sanity check arguments.
+    assert(ds != NULL);
+    assert(p < ds->length);
+
+    // Traverse set.
+    for (;;) {
+        dset_index_t parent = ds->parents[p];
+
+        // Found.
+        if (parent & DSET_ROOT) {
+            return (p);
+        }
+
+        // Path halving: point to the grandparent and skip it.
+        dset_index_t grandparent = ds->parents[parent];
+        if (grandparent & DSET_ROOT) {
+            return (parent);
+        }
+        ds->parents[p] = grandparent;
+        p = grandparent;
+    }
+}
+
+// Merges two sets of a packed disjoint set.
+static dset_index_t pdset_union(struct pdset *ds, dset_index_t p, dset_index_t q)
+{
+    // Find representative elements of each set.
+    dset_index_t p_set = pdset_find(ds, p);
+    dset_index_t q_set = pdset_find(ds, q);
+
+    // Merge sets.
+    if (p_set != q_set) {
+        // Union-by-rank heuristic: link the root of lower rank to the root
+        // of higher rank. Ranks are compared with the root flag set.
+        if (ds->parents[p_set] > ds->parents[q_set]) {
+            dset_index_t tmp = p_set;
+            p_set = q_set;
+            q_set = tmp;
+        }
+        if (ds->parents[p_set] == ds->parents[q_set]) {
+            ds->parents[q_set] += 1;
+        }
+        ds->parents[p_set] = q_set;
+    }
+
+    return (q_set);
+}
+
+// An edge.
+struct edge {
+    dset_index_t u; // First endpoint.
+    dset_index_t v; // Second endpoint.
+};
+
+// Merges the sets of the endpoints of several edges. Parents of endpoints
+// are prefetched some edges ahead, so cache misses of independent unions overlap.
+static void pdset_union_many(struct pdset *ds, const struct edge *edges, size_t nedges)
+{
+    for (size_t i = 0; i < nedges; i++) {
+        if (i + DSET_PREFETCH_DISTANCE < nedges) {
+            __builtin_prefetch(&ds->parents[edges[i + DSET_PREFETCH_DISTANCE].u], 1);
+            __builtin_prefetch(&ds->parents[edges[i + DSET_PREFETCH_DISTANCE].v], 1);
+        }
+        pdset_union(ds, edges[i].u, edges[i].v);
+    }
+}
+
+//==============================================================================
+// Concurrent Disjoint Set
+//==============================================================================
+
+// A concurrent disjoint set. Roots are linked by index order with CAS, so
+// concurrent unions never create cycles, and no locks are required.
+struct cdset {
+    dset_index_t length;           // Number of elements.
+    _Atomic dset_index_t *parents; // Parent of elements.
+};
+
+// Creates a concurrent disjoint set.
+static struct cdset *cdset_create(dset_index_t length)
+{
+    struct cdset *ds = NULL;
+
+    // Allocate resources.
+    assert((ds = malloc(sizeof(struct cdset))) != NULL);
+    assert((ds->parents = malloc(length * sizeof(ds->parents[0]))) != NULL);
+
+    // Initialize.
+    ds->length = length;
+    for (dset_index_t i = 0; i < length; i++) {
+        atomic_init(&ds->parents[i], i);
+    }
+
+    return (ds);
+}
+
+// Destroys a concurrent disjoint set.
+static void cdset_destroy(struct cdset *ds)
+{
+    // Sanity check arguments.
+    assert(ds != NULL);
+
+    // Release resources.
+    free(ds->parents);
+    free(ds);
+}
+
+// Finds the representative element of a set in a concurrent disjoint set.
+static dset_index_t cdset_find(struct cdset *ds, dset_index_t p)
+{
+    // Sanity check arguments.
+    assert(ds != NULL);
+    assert(p < ds->length);
+
+    // Traverse set.
+    for (;;) {
+        dset_index_t parent = atomic_load_explicit(&ds->parents[p], memory_order_relaxed);
+        dset_index_t grandparent = atomic_load_explicit(&ds->parents[parent], memory_order_relaxed);
+
+        // Found.
+        if (parent == grandparent) {
+            return (parent);
+        }
+
+        // Path splitting: point to the grandparent. If another thread has
+        // changed the parent meanwhile, it has moved it closer to the root.
+        atomic_compare_exchange_weak_explicit(&ds->parents[p], &parent, grandparent,
+                                              memory_order_relaxed, memory_order_relaxed);
+
+        // Move to the next element.
+        p = grandparent;
+    }
+}
+
+// Merges two sets of a concurrent disjoint set. Returns true if they were disjoint.
+static bool cdset_union(struct cdset *ds, dset_index_t p, dset_index_t q)
+{
+    // Sanity check arguments.
+    assert(ds != NULL);
+    assert(p < ds->length);
+    assert(q < ds->length);
+
+    for (;;) {
+        // Find representative elements of each set.
+        p = cdset_find(ds, p);
+        q = cdset_find(ds, q);
+
+        // Already merged.
+        if (p == q) {
+            return (false);
+        }
+
+        // Link the root with the smaller index to the root with the larger one.
+        if (p > q) {
+            dset_index_t tmp = p;
+            p = q;
+            q = tmp;
+        }
+        dset_index_t expected = p;
+        if (atomic_compare_exchange_strong(&ds->parents[p], &expected, q)) {
+            return (true);
+        }
+
+        // The root was linked by another thread, so retry.
+    }
+}
+
+//==============================================================================
+// Connected Components
+//==============================================================================
+
+// An edge list.
+struct edge_list {
+    dset_index_t nnodes; // Number of nodes.
+    size_t nedges;       // Number of edges.
+    struct edge *edges;  // Edges.
+};
+
+// Reads an edge list in SNAP format: one "u v" pair per line, and lines
+// starting with '#' are comments.
+static struct edge_list *edge_list_read(FILE *f)
+{
+    struct edge_list *el = NULL;
+    size_t capacity = 1024;
+    char line[256];
+
+    // Allocate resources.
+    assert((el = malloc(sizeof(struct edge_list))) != NULL);
+    assert((el->edges = malloc(capacity * sizeof(struct edge))) != NULL);
+    el->nnodes = 0;
+    el->nedges = 0;
+
+    while (fgets(line, sizeof(line), f) != NULL) {
+        struct edge e;
+
+        // Skip comments and malformed lines.
+        if ((line[0] == '#') || (sscanf(line, "%" SCN_DSET_INDEX " %" SCN_DSET_INDEX, &e.u, &e.v) != 2)) {
+            continue;
+        }
+
+        // Grow edge list.
+        if (el->nedges == capacity) {
+            capacity *= 2;
+            assert((el->edges = realloc(el->edges, capacity * sizeof(struct edge))) != NULL);
+        }
+
+        el->edges[el->nedges++] = e;
+        if (e.u >= el->nnodes) {
+            el->nnodes = e.u + 1;
+        }
+        if (e.v >= el->nnodes) {
+            el->nnodes = e.v + 1;
+        }
+    }
+
+    return (el);
+}
+
+// Destroys an edge list.
+static void edge_list_destroy(struct edge_list *el)
+{
+    free(el->edges);
+    free(el);
+}
+
+// Arguments of a connected components thread.
+struct worker {
+    pthread_t thread;         // Thread.
+    struct cdset *ds;         // Disjoint set.
+    const struct edge *edges; // Edges to process.
+    size_t nedges;            // Number of edges to process.
+};
+
+// Merges the sets of the endpoints of a range of edges.
+static void *worker(void *arg)
+{
+    struct worker *w = arg;
+
+    for (size_t i = 0; i < w->nedges; i++) {
+        cdset_union(w->ds, w->edges[i].u, w->edges[i].v);
+    }
+
+    return (NULL);
+}
+
+// Returns the current time in microseconds.
+static double now(void)
+{
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+
+    return (ts.tv_sec * 1000000.0 + ts.tv_nsec / 1000.0);
+}
+
+// Computes the connected components of a graph with several threads.
+// Returns the number of components and the elapsed time in microseconds.
+static dset_index_t components(const struct edge_list *el, size_t nthreads, double *elapsed)
+{
+    dset_index_t ncomponents = 0;
+    double tstart = 0.0;
+    struct worker workers[CDSET_MAX_THREADS];
+    struct cdset *ds = cdset_create(el->nnodes);
+
+    assert((nthreads > 0) && (nthreads <= CDSET_MAX_THREADS));
+
+    tstart = now();
+    for (size_t i = 0; i < nthreads; i++) {
+        size_t first = (el->nedges * i) / nthreads;
+        size_t last = (el->nedges * (i + 1)) / nthreads;
+
+        workers[i].ds = ds;
+        workers[i].edges = &el->edges[first];
+        workers[i].nedges = last - first;
+        int ret = pthread_create(&workers[i].thread, NULL, worker, &workers[i]);
+        assert(ret == 0);
+        ((void)ret);
+    }
+    for (size_t i = 0; i < nthreads; i++) {
+        pthread_join(workers[i].thread, NULL);
+    }
+    *elapsed = now() - tstart;
+
+    // Count representative elements.
+    for (dset_index_t i = 0; i < el->nnodes; i++) {
+        if (cdset_find(ds, i) == i) {
+            ncomponents++;
+        }
+    }
+
+    cdset_destroy(ds);
+
+    return (ncomponents);
+}
+
+// Compares memory and union throughput of the disjoint set layouts.
+static void test_packed(const struct edge_list *el)
+{
+    double tstart = 0.0;
+    double tend = 0.0;
+    dset_index_t ncomponents[3] = {0, 0, 0};
+    struct dset *ds = dset_create(el->nnodes);
+    struct pdset *pds = pdset_create(el->nnodes);
+    struct pdset *bds = pdset_create(el->nnodes);
+
+    // Separate arrays.
+    tstart = now();
+    for (size_t i = 0; i < el->nedges; i++) {
+        dset_union(ds, el->edges[i].u, el->edges[i].v);
+    }
+    tend = now();
+    printf("%18s: %2zu bytes/element %8.2lf Munions/s\n", "dset_union()",
+           sizeof(ds->elements[0]) + sizeof(ds->weights[0]), el->nedges / (tend - tstart));
+
+    // Packed array.
+    tstart = now();
+    for (size_t i = 0; i < el->nedges; i++) {
+        pdset_union(pds, el->edges[i].u, el->edges[i].v);
+    }
+    tend = now();
+    printf("%18s: %2zu bytes/element %8.2lf Munions/s\n", "pdset_union()",
+           sizeof(pds->parents[0]), el->nedges / (tend - tstart));
+
+    // Packed array and batched unions.
+    tstart = now();
+    pdset_union_many(bds, el->edges, el->nedges);
+    tend = now();
+    printf("%18s: %2zu bytes/element %8.2lf Munions/s\n", "pdset_union_many()",
+           sizeof(bds->parents[0]), el->nedges / (tend - tstart));
+
+    // Sanity check result.
+    for (dset_index_t i = 0; i < el->nnodes; i++) {
+        ncomponents[0] += (dset_find(ds, i) == i);
+        ncomponents[1] += (pdset_find(pds, i) == i);
+        ncomponents[2] += (pdset_find(bds, i) == i);
+        assert((dset_find(ds, i) == dset_find(ds, el->edges[0].u)) ==
+               (pdset_find(pds, i) == pdset_find(pds, el->edges[0].u)));
+    }
+    assert((ncomponents[0] == ncomponents[1]) && (ncomponents[1] == ncomponents[2]));
+
+    // Release resources.
+    pdset_destroy(bds);
+    pdset_destroy(pds);
+    dset_destroy(ds);
+}
+
+// Reports the scaling of connected components across thread counts, as
+// throughput and speedup over one thread. Thread counts above the number of
+// online cores time-share them, thus they show overhead rather than scaling.
+static void test_components(const struct edge_list *el)
+{
+    dset_index_t expected = 0;
+    double baseline = 0.0;
+    long ncpus = sysconf(_SC_NPROCESSORS_ONLN);
+    struct pdset *ds = pdset_create(el->nnodes);
+
+    // Sequential reference.
+    pdset_union_many(ds, el->edges, el->nedges);
+    for (dset_index_t i = 0; i < el->nnodes; i++) {
+        if (pdset_find(ds, i) == i) {
+            expected++;
+        }
+    }
+    pdset_destroy(ds);
+
+    printf("%" PRI_DSET_INDEX " nodes, %zu edges, %" PRI_DSET_INDEX " components\n", el->nnodes,
+           el->nedges, expected);
+    printf("%ld online cores\n", ncpus);
+    printf("%8s %16s %8s\n", "threads", "throughput", "speedup");
+    for (size_t nthreads = 1; nthreads <= CDSET_MAX_THREADS; nthreads *= 2) {
+        double elapsed = 0.0;
+        dset_index_t ncomponents = components(el, nthreads, &elapsed);
+
+        assert(ncomponents == expected);
+        ((void)ncomponents);
+        if (nthreads == 1) {
+            baseline = elapsed;
+        }
+        printf("%8zu %8.2lf Medges/s %8.2lf%s\n", nthreads, el->nedges / elapsed,
+               baseline / elapsed,
+               ((ncpus > 0) && (nthreads > (size_t)ncpus)) ? " (oversubscribed)" : "");
+    }
+}
+
 //==============================================================================
 // Test
 //==============================================================================
@@ -180,6 +647,24 @@ static void test(unsigned length, bool verbose)
 
     // Release disjoint set.
     dset_destroy(ds);
+
+    // Test connected components on a random graph, written in and read back
+    // from an edge list.
+    FILE *f = tmpfile();
+    assert(f != NULL);
+    srand(0);
+    fprintf(f, "# Random graph with %u nodes\n", length);
+    for (unsigned i = 0; (length > 0) && (i < EDGES_PER_NODE * length); i++) {
+        fprintf(f, "%u %u\n", (unsigned)rand() % length, (unsigned)rand() % length);
+    }
+    rewind(f);
+    struct edge_list *el = edge_list_read(f);
+    fclose(f);
+    if (el->nedges > 0) {
+        test_packed(el);
+    }
+    test_components(el);
+    edge_list_destroy(el);
 }
 
 //==============================================================================
@@ -191,6 +676,7 @@ static void usage(char *const argv[])
 {
     printf("%s - Testing program for disjoint sets.\n", argv[0]);
     printf("Usage: %s [--verbose] <length>\n", argv[0]);
+    printf("       %s --edges <edge list file>\n", argv[0]);
     exit(EXIT_FAILURE);
 }
 
@@ -213,6 +699,17 @@ int main(int argc, char *const argv[])
     // Parse command line arguments.
     if (argc == 2) {
         sscanf(argv[1], "%u", &length);
+    } else if ((argc == 3) && (!strcmp(argv[1], "--edges"))) {
+        FILE *f = fopen(argv[2], "r");
+        if (f == NULL) {
+            printf("Error: cannot open %s.\n", argv[2]);
+            usage(argv);
+        }
+        struct edge_list *el = edge_list_read(f);
+        fclose(f);
+        test_components(el);
+        edge_list_destroy(el);
+        return (EXIT_SUCCESS);
     } else if ((argc == 3) && (!strcmp(argv[1], "--verbose"))) {
         sscanf(argv[2], "%u", &length);
         verbose = true;
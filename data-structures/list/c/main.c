@@ -3,6 +3,7 @@
 #include <assert.h>
 #include <stdbool.h>
 #include <stddef.h>
+#include <stdint.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
@@ -11,8 +12,14 @@
 // Type of elements that are stored in the list.
 typedef int type_t;
 
+// Size of a cache line (in bytes).
+#define CACHE_LINE_SIZE 64
+
+// Number of nodes in each slab of a node pool.
+#define NODE_POOL_SLAB_LENGTH 4096
+
 //==============================================================================
-// Usage
+// Node Pool
 //==============================================================================
 
 // A singly linked list node.
@@ -21,14 +28,81 @@ struct node {
     struct node *next; // Next node.
 };
 
+// A slab of nodes.
+struct slab {
+    struct slab *next;                        // Next slab.
+    struct node nodes[NODE_POOL_SLAB_LENGTH]; // Nodes.
+};
+
+// A pool of nodes, which allocates nodes in slabs and recycles them in a free list.
+struct node_pool {
+    struct slab *slabs; // Allocated slabs.
+    size_t used;        // Number of nodes handed out from the most recent slab.
+    struct node *free;  // Free list.
+};
+
+// Initializes a node pool.
+static void node_pool_init(struct node_pool *pool)
+{
+    pool->slabs = NULL;
+    pool->used = NODE_POOL_SLAB_LENGTH;
+    pool->free = NULL;
+}
+
+// Releases all nodes of a node pool.
+static void node_pool_release(struct node_pool *pool)
+{
+    while (pool->slabs != NULL) {
+        struct slab *slab = pool->slabs;
+        pool->slabs = slab->next;
+        free(slab);
+    }
+    node_pool_init(pool);
+}
+
+// Allocates a node from a node pool.
+static struct node *node_pool_alloc(struct node_pool *pool)
+{
+    struct node *node = pool->free;
+
+    // Recycle a node from the free list.
+    if (node != NULL) {
+        pool->free = node->next;
+        return (node);
+    }
+
+    // The most recent slab is exhausted, thus allocate a new one.
+    if (pool->used == NODE_POOL_SLAB_LENGTH) {
+        struct slab *slab = malloc(sizeof(struct slab));
+        assert(slab != NULL);
+        slab->next = pool->slabs;
+        pool->slabs = slab;
+        pool->used = 0;
+    }
+
+    return (&pool->slabs->nodes[pool->used++]);
+}
+
+// Returns a node to a node pool.
+static void node_pool_free(struct node_pool *pool, struct node *node)
+{
+    node->next = pool->free;
+    pool->free = node;
+}
+
+//==============================================================================
+// Linked List
+//==============================================================================
+
 // A singly linked list.
 struct list {
-    unsigned length;  // Number of elements in the list.
-    struct node head; // Head node.
+    unsigned length;        // Number of elements in the list.
+    struct node head;       // Head node.
+    struct node_pool *pool; // Node pool (NULL if nodes are allocated with malloc()).
 };
 
-// Creates a linked list.
-static struct list *list_create(void)
+// Creates a linked list whose nodes are allocated from a node pool.
+static struct list *list_create_with(bool pooled)
 {
     struct list *list = NULL;
 
@@ -38,13 +112,37 @@ static struct list *list_create(void)
     // Initialize.
     list->length = 0;
     list->head.next = NULL;
+    list->pool = NULL;
+    if (pooled) {
+        assert((list->pool = malloc(sizeof(struct node_pool))) != NULL);
+        node_pool_init(list->pool);
+    }
 
     return (list);
 }
 
+// Creates a linked list.
+static struct list *list_create(void)
+{
+    return (list_create_with(false));
+}
+
 // Destroys a linked list.
 static void list_destroy(struct list *list)
 {
+    // Release all nodes at once.
+    if (list->pool != NULL) {
+        node_pool_release(list->pool);
+        free(list->pool);
+    } else {
+        struct node *node = list->head.next;
+        while (node != NULL) {
+            struct node *next = node->next;
+            free(node);
+            node = next;
+        }
+    }
+
     free(list);
 }
 
@@ -72,7 +170,11 @@ static void list_insert_after(struct list *list, struct node *p, type_t x)
     struct node *new_node = NULL;
 
     // Create node.
-    assert((new_node = malloc(sizeof(struct list))) != NULL);
+    if (list->pool != NULL) {
+        new_node = node_pool_alloc(list->pool);
+    } else {
+        assert((new_node = malloc(sizeof(struct node))) != NULL);
+    }
 
     // Initialize.
     new_node->next = p->next;
@@ -97,7 +199,11 @@ static type_t list_remove_next(struct list *list, struct node *p)
     x = node->x;
 
     // Destroy node.
-    free(node);
+    if (list->pool != NULL) {
+        node_pool_free(list->pool, node);
+    } else {
+        free(node);
+    }
 
     return (x);
 }
@@ -114,21 +220,219 @@ static void list_print(const struct list *l)
     printf("] }\n");
 }
 
+//==============================================================================
+// Unrolled Linked List
+//==============================================================================
+
+// Number of elements in a block of an unrolled list, so that a block fills a cache line.
+#define UBLOCK_LENGTH ((CACHE_LINE_SIZE - sizeof(void *) - sizeof(unsigned)) / sizeof(type_t))
+
+// A block of an unrolled linked list.
+struct ublock {
+    struct ublock *next;      // Next block.
+    unsigned count;           // Number of elements in the block.
+    type_t xs[UBLOCK_LENGTH]; // Elements.
+};
+
+// An unrolled linked list, which stores several elements in each node.
+struct ulist {
+    size_t length;       // Number of elements in the list.
+    struct ublock *head; // First block.
+    struct ublock *free; // Free list of blocks.
+};
+
+// Creates an unrolled linked list.
+static struct ulist *ulist_create(void)
+{
+    struct ulist *ul = NULL;
+
+    // Allocate resources.
+    assert((ul = malloc(sizeof(struct ulist))) != NULL);
+
+    // Initialize.
+    ul->length = 0;
+    ul->head = NULL;
+    ul->free = NULL;
+
+    return (ul);
+}
+
+// Releases a chain of blocks.
+static void ublock_release(struct ublock *b)
+{
+    while (b != NULL) {
+        struct ublock *next = b->next;
+        free(b);
+        b = next;
+    }
+}
+
+// Destroys an unrolled linked list.
+static void ulist_destroy(struct ulist *ul)
+{
+    ublock_release(ul->head);
+    ublock_release(ul->free);
+    free(ul);
+}
+
+// Allocates a block for an unrolled linked list.
+static struct ublock *ublock_alloc(struct ulist *ul)
+{
+    struct ublock *b = ul->free;
+
+    // Recycle a block from the free list.
+    if (b != NULL) {
+        ul->free = b->next;
+    } else {
+        assert((b = aligned_alloc(CACHE_LINE_SIZE, sizeof(struct ublock))) != NULL);
+    }
+
+    b->next = NULL;
+    b->count = 0;
+
+    return (b);
+}
+
+// Inserts an element at the i-th position of a block in an unrolled linked list.
+// If the block is NULL, the element is inserted at the front of the list.
+static void ulist_insert_at(struct ulist *ul, struct ublock *b, unsigned i, type_t x)
+{
+    // Insert at the front of the list, in a new block if the first one is full.
+    if (b == NULL) {
+        if ((ul->head == NULL) || (ul->head->count == UBLOCK_LENGTH)) {
+            b = ublock_alloc(ul);
+            b->next = ul->head;
+            ul->head = b;
+        }
+        b = ul->head;
+        i = 0;
+    }
+
+    assert(i <= b->count);
+
+    // The block is full, thus split it in half.
+    if (b->count == UBLOCK_LENGTH) {
+        struct ublock *nb = ublock_alloc(ul);
+        unsigned half = b->count / 2;
+
+        nb->count = b->count - half;
+        memcpy(nb->xs, &b->xs[half], nb->count * sizeof(type_t));
+        b->count = half;
+        nb->next = b->next;
+        b->next = nb;
+
+        if (i > half) {
+            b = nb;
+            i -= half;
+        }
+    }
+
+    // Shift right elements within the block.
+    memmove(&b->xs[i + 1], &b->xs[i], (b->count - i) * sizeof(type_t));
+    b->xs[i] = x;
+    b->count++;
+    ul->length++;
+}
+
+// Removes the i-th element of a block in an unrolled linked list.
+// The preceding block is required to unlink the block if it becomes empty.
+static type_t ulist_remove_at(struct ulist *ul, struct ublock *prev, struct ublock *b, unsigned i)
+{
+    type_t x = b->xs[i];
+
+    assert(i < b->count);
+
+    // Shift left elements within the block.
+    memmove(&b->xs[i], &b->xs[i + 1], (b->count - i - 1) * sizeof(type_t));
+    b->count--;
+    ul->length--;
+
+    // The block is empty, thus unlink it and recycle it.
+    if (b->count == 0) {
+        if (prev == NULL) {
+            ul->head = b->next;
+        } else {
+            prev->next = b->next;
+        }
+        b->next = ul->free;
+        ul->free = b;
+    }
+
+    return (x);
+}
+
+// Inserts an element at the front of an unrolled linked list.
+static void ulist_push_front(struct ulist *ul, type_t x)
+{
+    ulist_insert_at(ul, NULL, 0, x);
+}
+
+// Removes the element at the front of an unrolled linked list.
+static type_t ulist_pop_front(struct ulist *ul)
+{
+    return (ulist_remove_at(ul, NULL, ul->head, 0));
+}
+
+// Prints the contents of an unrolled list.
+static void ulist_print(const struct ulist *ul)
+{
+    printf("ulist { ");
+    printf("length: %zu, ", ul->length);
+    printf("blocks: [");
+    for (const struct ublock *b = ul->head; b != NULL; b = b->next) {
+        printf("[");
+        for (unsigned i = 0; i < b->count; i++) {
+            printf("%d%s", b->xs[i], ((i + 1) == b->count) ? "" : ", ");
+        }
+        printf("]%s", (b->next == NULL) ? "" : ", ");
+    }
+    printf("] }\n");
+}
+
+//==============================================================================
+// Vector
+//==============================================================================
+
+// A dynamic array, to compare lists against.
+struct vector {
+    type_t *elements; // Elements stored in the vector.
+    size_t length;    // Current number of elements that are stored in the vector.
+    size_t capacity;  // Max number of elements that can be stored in the vector.
+};
+
+// Appends an element to a vector.
+static void vector_push(struct vector *v, type_t x)
+{
+    // The vector is full, thus expand its capacity.
+    if (v->length == v->capacity) {
+        v->capacity = (v->capacity == 0) ? 1024 : 2 * v->capacity;
+        assert((v->elements = realloc(v->elements, v->capacity * sizeof(type_t))) != NULL);
+    }
+
+    v->elements[v->length++] = x;
+}
+
+// Removes the last element of a vector.
+static type_t vector_pop(struct vector *v)
+{
+    return (v->elements[--v->length]);
+}
+
 //==============================================================================
 // Usage
 //==============================================================================
 
-// Test driver for the linked list data structure.
-static void test(unsigned length, bool verbose)
+// Tests a linked list.
+static void test_list(unsigned length, bool verbose, bool pooled)
 {
     struct list *l;
     double tstart = 0.0;
     double tend = 0.0;
+    uint64_t sum = 0;
     const double MICROSECS = ((CLOCKS_PER_SEC / 1000000.0));
+    const char *name = pooled ? "list (pool)" : "list";
 
-    printf("running with length %d...\n", length);
-
-    l = list_create();
+    l = pooled ? list_create_with(true) : list_create();
 
     // Insert element sin the list.
     tstart = clock();
@@ -136,18 +440,19 @@ static void test(unsigned length, bool verbose)
         list_insert_after(l, list_head(l), (type_t)i);
     }
     tend = clock();
-    printf("%12s: %2.lf us\n", "insert", (tend - tstart) / MICROSECS);
+    printf("%12s %12s: %2.lf us\n", name, "insert", (tend - tstart) / MICROSECS);
     if (verbose) {
         list_print(l);
     }
 
     // Traverse the list.
     tstart = clock();
-    for (struct node *w = list_head(l); w != NULL; w = list_next(w)) {
-        /* noop */;
+    for (struct node *w = list_first(l); w != NULL; w = list_next(w)) {
+        sum += w->x;
     }
     tend = clock();
-    printf("%12s: %2.lf us\n", "traverse", (tend - tstart) / MICROSECS);
+    printf("%12s %12s: %2.lf us\n", name, "traverse", (tend - tstart) / MICROSECS);
+    assert(sum == (length * (length - 1ULL)) / 2);
 
     // Remove elements from the list.
     tstart = clock();
@@ -156,7 +461,7 @@ static void test(unsigned length, bool verbose)
         assert(x == (type_t)(length - i - 1));
     }
     tend = clock();
-    printf("%12s: %2.lf us\n", "remove:", (tend - tstart) / MICROSECS);
+    printf("%12s %12s: %2.lf us\n", name, "remove", (tend - tstart) / MICROSECS);
     if (verbose) {
         list_print(l);
     }
@@ -164,6 +469,124 @@ static void test(unsigned length, bool verbose)
     list_destroy(l);
 }
 
+// Tests an unrolled linked list.
+static void test_ulist(unsigned length, bool verbose)
+{
+    struct ulist *ul;
+    double tstart = 0.0;
+    double tend = 0.0;
+    uint64_t sum = 0;
+    const double MICROSECS = ((CLOCKS_PER_SEC / 1000000.0));
+
+    ul = ulist_create();
+
+    // Insert an element in the middle of a full block, which splits it.
+    for (unsigned i = 0; i < UBLOCK_LENGTH; i++) {
+        ulist_push_front(ul, (type_t)i);
+    }
+    ulist_insert_at(ul, ul->head, UBLOCK_LENGTH / 2 + 1, -1);
+    assert((ul->head->next != NULL) && (ul->head->next->xs[1] == -1));
+    if (verbose) {
+        ulist_print(ul);
+    }
+
+    // Remove all elements, which recycles both blocks.
+    assert(ulist_remove_at(ul, ul->head, ul->head->next, 1) == -1);
+    while (ul->length > 0) {
+        ulist_pop_front(ul);
+    }
+    assert(ul->head == NULL);
+
+    // Insert elements in the list.
+    tstart = clock();
+    for (unsigned i = 0; i < length; i++) {
+        ulist_push_front(ul, (type_t)i);
+    }
+    tend = clock();
+    printf("%12s %12s: %2.lf us\n", "ulist", "insert", (tend - tstart) / MICROSECS);
+    if (verbose) {
+        ulist_print(ul);
+    }
+
+    // Traverse the list.
+    tstart = clock();
+    for (const struct ublock *b = ul->head; b != NULL; b = b->next) {
+        for (unsigned i = 0; i < b->count; i++) {
+            sum += b->xs[i];
+        }
+    }
+    tend = clock();
+    printf("%12s %12s: %2.lf us\n", "ulist", "traverse", (tend - tstart) / MICROSECS);
+    assert(sum == (length * (length - 1ULL)) / 2);
+
+    // Remove elements from the list.
+    tstart = clock();
+    for (unsigned i = 0; i < length; i++) {
+        type_t x = ulist_pop_front(ul);
+        assert(x == (type_t)(length - i - 1));
+        ((void)x);
+    }
+    tend = clock();
+    printf("%12s %12s: %2.lf us\n", "ulist", "remove", (tend - tstart) / MICROSECS);
+    if (verbose) {
+        ulist_print(ul);
+    }
+
+    assert(ul->length == 0);
+
+    ulist_destroy(ul);
+}
+
+// Tests a vector, to compare lists against.
+static void test_vector(unsigned length)
+{
+    struct vector v = {NULL, 0, 0};
+    double tstart = 0.0;
+    double tend = 0.0;
+    uint64_t sum = 0;
+    const double MICROSECS = ((CLOCKS_PER_SEC / 1000000.0));
+
+    // Insert elements in the vector.
+    tstart = clock();
+    for (unsigned i = 0; i < length; i++) {
+        vector_push(&v, (type_t)i);
+    }
+    tend = clock();
+    printf("%12s %12s: %2.lf us\n", "vector", "insert", (tend - tstart) / MICROSECS);
+
+    // Traverse the vector.
+    tstart = clock();
+    for (size_t i = 0; i < v.length; i++) {
+        sum += v.elements[i];
+    }
+    tend = clock();
+    printf("%12s %12s: %2.lf us\n", "vector", "traverse", (tend - tstart) / MICROSECS);
+    assert(sum == (length * (length - 1ULL)) / 2);
+
+    // Remove elements from the vector.
+    tstart = clock();
+    for (unsigned i = 0; i < length; i++) {
+        type_t x = vector_pop(&v);
+        assert(x == (type_t)(length - i - 1));
+        ((void)x);
+    }
+    tend = clock();
+    printf("%12s %12s: %2.lf us\n", "vector", "remove", (tend - tstart) / MICROSECS);
+
+    free(v.elements);
+}
+
+// Test driver for the linked list data structure.
+static void test(unsigned length, bool verbose)
+{
+    printf("running with length %d...\n", length);
+
+    test_list(length, verbose, false);
+    test_list(length, verbose, true);
+    test_ulist(length, verbose);
+    test_vector(length);
+}
+
 //==============================================================================
 // Usage
 //==============================================================================
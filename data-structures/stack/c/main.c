@@ -1,8 +1,14 @@
 // Copyright (C) 2022 Pedro Henrique Penna <pedrohenriquepenna@outlook.com>
 
+// Required for clock_gettime().
+#define _POSIX_C_SOURCE 200809L
+
 #include <assert.h>
+#include <pthread.h>
+#include <stdatomic.h>
 #include <stdbool.h>
 #include <stddef.h>
+#include <stdint.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
@@ -11,6 +17,24 @@
 // Initial capacity for a stack.
 #define STACK_CAPACITY 1024
 
+// Size of a cache line (in bytes).
+#define CACHE_LINE_SIZE 64
+
+// Maximum number of threads that may access a lock-free stack.
+#define LF_STACK_MAX_THREADS 64
+
+// Number of slots in the elimination array of a lock-free stack.
+#define LF_STACK_ELIMINATION_SLOTS 16
+
+// Number of iterations that a push waits in the elimination array for a matching pop.
+#define LF_STACK_ELIMINATION_SPINS 128
+
+// Number of retired nodes after which a thread tries to advance the global epoch.
+#define LF_STACK_EPOCH_PERIOD 64
+
+// Number of push/pop pairs issued by each thread in the concurrent benchmark.
+#define NOPERATIONS 200000
+
 // Type of elements that are stored in the stack.
 typedef int type_t;
 
@@ -127,6 +151,418 @@ static void stack_print(const struct stack *s)
     printf("] }\n");
 }
 
+//==============================================================================
+// Lock-Free Stack
+//==============================================================================
+
+// Bits of a tagged pointer that hold the pointer. Upper bits hold a modification counter.
+#define TAG_SHIFT 48
+#define TAG_MASK ((UINT64_C(1) << TAG_SHIFT) - 1)
+
+// Values of an elimination slot that do not hold a node.
+#define SLOT_EMPTY ((uintptr_t)0)
+#define SLOT_TAKEN ((uintptr_t)1)
+
+// A node of a lock-free stack.
+struct lf_node {
+    type_t x;                // Element.
+    struct lf_node *next;    // Next node.
+    struct lf_node *retired; // Next retired node. Retiring a node must not write its next
+                             // pointer, which concurrent pops may still be reading.
+};
+
+// Per-thread state of epoch-based memory reclamation.
+struct lf_thread {
+    _Alignas(CACHE_LINE_SIZE) _Atomic uint64_t epoch; // Epoch observed by the thread.
+    _Atomic bool active;                              // In a critical section?
+    struct lf_node *limbo[3];                         // Nodes retired in each epoch.
+    size_t nretired;                                  // Number of nodes retired.
+    uint64_t seed;                                    // State of the random number generator.
+};
+
+// A slot of the elimination array.
+struct lf_slot {
+    _Alignas(CACHE_LINE_SIZE) _Atomic uintptr_t node; // Offered node, SLOT_EMPTY or SLOT_TAKEN.
+};
+
+// A lock-free stack (Treiber stack).
+struct lf_stack {
+    _Alignas(CACHE_LINE_SIZE) _Atomic uint64_t top;   // Tagged pointer to the top node.
+    _Alignas(CACHE_LINE_SIZE) _Atomic uint64_t epoch; // Global epoch.
+    bool elimination;                                 // Use the elimination array?
+    struct lf_slot slots[LF_STACK_ELIMINATION_SLOTS]; // Elimination array.
+    struct lf_thread threads[LF_STACK_MAX_THREADS];   // Per-thread state.
+};
+
+// Packs a pointer and a counter into a tagged pointer.
+static uint64_t tag_pack(struct lf_node *node, uint64_t counter)
+{
+    assert(((uintptr_t)node & ~TAG_MASK) == 0);
+
+    return ((counter << TAG_SHIFT) | (uint64_t)(uintptr_t)node);
+}
+
+// Extracts the pointer from a tagged pointer.
+static struct lf_node *tag_pointer(uint64_t tagged)
+{
+    return ((struct lf_node *)(uintptr_t)(tagged & TAG_MASK));
+}
+
+// Extracts the counter from a tagged pointer.
+static uint64_t tag_counter(uint64_t tagged)
+{
+    return (tagged >> TAG_SHIFT);
+}
+
+// Creates a lock-free stack.
+static struct lf_stack *lf_stack_create(bool elimination)
+{
+    struct lf_stack *s = aligned_alloc(CACHE_LINE_SIZE, sizeof(struct lf_stack));
+    assert(s != NULL);
+
+    // Initialize data structure.
+    atomic_init(&s->top, tag_pack(NULL, 0));
+    atomic_init(&s->epoch, 0);
+    s->elimination = elimination;
+    for (size_t i = 0; i < LF_STACK_ELIMINATION_SLOTS; i++) {
+        atomic_init(&s->slots[i].node, SLOT_EMPTY);
+    }
+    for (size_t i = 0; i < LF_STACK_MAX_THREADS; i++) {
+        atomic_init(&s->threads[i].epoch, 0);
+        atomic_init(&s->threads[i].active, false);
+        s->threads[i].limbo[0] = NULL;
+        s->threads[i].limbo[1] = NULL;
+        s->threads[i].limbo[2] = NULL;
+        s->threads[i].nretired = 0;
+        s->threads[i].seed = i + 1;
+    }
+
+    return (s);
+}
+
+// Releases a chain of nodes.
+static void lf_node_release(struct lf_node *node)
+{
+    while (node != NULL) {
+        struct lf_node *next = node->next;
+        free(node);
+        node = next;
+    }
+}
+
+// Releases a chain of retired nodes.
+static void lf_node_release_retired(struct lf_node *node)
+{
+    while (node != NULL) {
+        struct lf_node *retired = node->retired;
+        free(node);
+        node = retired;
+    }
+}
+
+// Destroys a lock-free stack. No thread may be accessing it.
+static void lf_stack_destroy(struct lf_stack *s)
+{
+    lf_node_release(tag_pointer(atomic_load(&s->top)));
+    for (size_t i = 0; i < LF_STACK_MAX_THREADS; i++) {
+        for (size_t j = 0; j < 3; j++) {
+            lf_node_release_retired(s->threads[i].limbo[j]);
+        }
+    }
+    free(s);
+}
+
+// Enters a critical section, in which a thread may dereference nodes of the stack.
+static void lf_epoch_enter(struct lf_stack *s, struct lf_thread *t)
+{
+    // Announce the critical section before reading the global epoch, so
+    // that the epoch cannot advance past a stale value that we observed.
+    atomic_store(&t->active, true);
+
+    uint64_t epoch = atomic_load(&s->epoch);
+
+    // The global epoch has advanced since we last looked, so nodes that we
+    // retired three epochs ago are no longer reachable by any thread.
+    if (atomic_load_explicit(&t->epoch, memory_order_relaxed) != epoch) {
+        lf_node_release_retired(t->limbo[epoch % 3]);
+        t->limbo[epoch % 3] = NULL;
+    }
+
+    atomic_store(&t->epoch, epoch);
+}
+
+// Leaves a critical section.
+static void lf_epoch_leave(struct lf_thread *t)
+{
+    atomic_store_explicit(&t->active, false, memory_order_release);
+}
+
+// Tries to advance the global epoch. It succeeds if all threads in a critical section observed it.
+static void lf_epoch_advance(struct lf_stack *s)
+{
+    uint64_t epoch = atomic_load(&s->epoch);
+
+    for (size_t i = 0; i < LF_STACK_MAX_THREADS; i++) {
+        if (atomic_load(&s->threads[i].active) && (atomic_load(&s->threads[i].epoch) != epoch)) {
+            return;
+        }
+    }
+
+    atomic_compare_exchange_strong(&s->epoch, &epoch, epoch + 1);
+}
+
+// Retires a node, which is released once no thread can reach it.
+static void lf_epoch_retire(struct lf_stack *s, struct lf_thread *t, struct lf_node *node)
+{
+    uint64_t epoch = atomic_load_explicit(&t->epoch, memory_order_relaxed);
+
+    node->retired = t->limbo[epoch % 3];
+    t->limbo[epoch % 3] = node;
+
+    if ((++t->nretired % LF_STACK_EPOCH_PERIOD) == 0) {
+        lf_epoch_advance(s);
+    }
+}
+
+// Returns a random slot of the elimination array.
+static struct lf_slot *lf_random_slot(struct lf_stack *s, struct lf_thread *t)
+{
+    // Xorshift.
+    t->seed ^= t->seed << 13;
+    t->seed ^= t->seed >> 7;
+    t->seed ^= t->seed << 17;
+
+    return (&s->slots[t->seed % LF_STACK_ELIMINATION_SLOTS]);
+}
+
+// Offers a node to a concurrent pop. Returns true if a pop took it.
+static bool lf_eliminate_push(struct lf_stack *s, struct lf_thread *t, struct lf_node *node)
+{
+    struct lf_slot *slot = lf_random_slot(s, t);
+    uintptr_t expected = SLOT_EMPTY;
+
+    if (!atomic_compare_exchange_strong(&slot->node, &expected, (uintptr_t)node)) {
+        return (false);
+    }
+
+    // Wait for a pop to take the node.
+    for (size_t i = 0; i < LF_STACK_ELIMINATION_SPINS; i++) {
+        if (atomic_load_explicit(&slot->node, memory_order_acquire) == SLOT_TAKEN) {
+            atomic_store(&slot->node, SLOT_EMPTY);
+            return (true);
+        }
+    }
+
+    // Withdraw the offer. If that fails, a pop took the node in the meantime.
+    expected = (uintptr_t)node;
+    if (atomic_compare_exchange_strong(&slot->node, &expected, SLOT_EMPTY)) {
+        return (false);
+    }
+    atomic_store(&slot->node, SLOT_EMPTY);
+
+    return (true);
+}
+
+// Takes a node offered by a concurrent push. Returns NULL if there is none.
+static struct lf_node *lf_eliminate_pop(struct lf_stack *s, struct lf_thread *t)
+{
+    struct lf_slot *slot = lf_random_slot(s, t);
+    uintptr_t node = atomic_load(&slot->node);
+
+    if ((node == SLOT_EMPTY) || (node == SLOT_TAKEN)) {
+        return (NULL);
+    }
+
+    if (!atomic_compare_exchange_strong(&slot->node, &node, SLOT_TAKEN)) {
+        return (NULL);
+    }
+
+    return ((struct lf_node *)node);
+}
+
+// Inserts an element in a lock-free stack.
+static void lf_stack_push(struct lf_stack *s, size_t tid, type_t element)
+{
+    struct lf_thread *t = &s->threads[tid];
+    struct lf_node *node = malloc(sizeof(struct lf_node));
+    uint64_t top = atomic_load(&s->top);
+
+    assert(node != NULL);
+    node->x = element;
+
+    for (;;) {
+        node->next = tag_pointer(top);
+
+        // Swing the top pointer, bumping its counter to avoid the ABA problem.
+        if (atomic_compare_exchange_weak(&s->top, &top, tag_pack(node, tag_counter(top) + 1))) {
+            return;
+        }
+
+        // Contention, thus back off to the elimination array.
+        if (s->elimination && lf_eliminate_push(s, t, node)) {
+            return;
+        }
+
+        top = atomic_load(&s->top);
+    }
+}
+
+// Removes an element from a lock-free stack. Returns false if the stack is empty.
+static bool lf_stack_pop(struct lf_stack *s, size_t tid, type_t *element)
+{
+    struct lf_thread *t = &s->threads[tid];
+    struct lf_node *node = NULL;
+
+    lf_epoch_enter(s, t);
+
+    for (;;) {
+        uint64_t top = atomic_load(&s->top);
+
+        node = tag_pointer(top);
+
+        // Empty stack.
+        if (node == NULL) {
+            lf_epoch_leave(t);
+            return (false);
+        }
+
+        // The node may be popped concurrently, but it is not released while we are in the
+        // critical section, so reading its next pointer is safe.
+        uint64_t next = tag_pack(node->next, tag_counter(top) + 1);
+        if (atomic_compare_exchange_weak(&s->top, &top, next)) {
+            *element = node->x;
+            lf_epoch_retire(s, t, node);
+            lf_epoch_leave(t);
+            return (true);
+        }
+
+        // Contention, thus back off to the elimination array. The node
+        // taken from a push was never reachable from the stack.
+        if (s->elimination && ((node = lf_eliminate_pop(s, t)) != NULL)) {
+            lf_epoch_leave(t);
+            *element = node->x;
+            free(node);
+            return (true);
+        }
+    }
+}
+
+//==============================================================================
+// Concurrent Benchmark
+//==============================================================================
+
+// Kinds of concurrent stacks.
+enum stack_kind {
+    STACK_MUTEX,       // Lock-based stack.
+    STACK_LOCK_FREE,   // Lock-free stack.
+    STACK_ELIMINATION, // Lock-free stack with elimination backoff.
+};
+
+// Arguments of a benchmark thread.
+struct worker {
+    pthread_t thread;      // Thread.
+    size_t tid;            // Thread index.
+    struct lf_stack *lf;   // Lock-free stack (NULL to use the lock-based stack).
+    struct stack *s;       // Lock-based stack.
+    pthread_mutex_t *lock; // Lock of the lock-based stack.
+    long long checksum;    // Sum of pushed minus popped elements.
+};
+
+// Issues push/pop pairs on a shared stack.
+static void *worker(void *arg)
+{
+    struct worker *w = arg;
+
+    for (size_t i = 0; i < NOPERATIONS; i++) {
+        type_t x = (type_t)(w->tid * NOPERATIONS + i);
+        type_t y = 0;
+
+        if (w->lf != NULL) {
+            lf_stack_push(w->lf, w->tid, x);
+            bool popped = lf_stack_pop(w->lf, w->tid, &y);
+            assert(popped);
+            ((void)popped);
+        } else {
+            pthread_mutex_lock(w->lock);
+            stack_push(w->s, x);
+            pthread_mutex_unlock(w->lock);
+            pthread_mutex_lock(w->lock);
+            y = stack_pop(w->s);
+            pthread_mutex_unlock(w->lock);
+        }
+
+        w->checksum += (long long)x - (long long)y;
+    }
+
+    return (NULL);
+}
+
+// Returns the current time in microseconds.
+static double now(void)
+{
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+
+    return (ts.tv_sec * 1000000.0 + ts.tv_nsec / 1000.0);
+}
+
+// Runs the concurrent benchmark with a given number of threads. Returns throughput in Mops/s.
+static double benchmark(size_t nthreads, enum stack_kind kind)
+{
+    double tstart = 0.0;
+    double tend = 0.0;
+    long long checksum = 0;
+    struct worker workers[LF_STACK_MAX_THREADS];
+    struct lf_stack *lf =
+        (kind != STACK_MUTEX) ? lf_stack_create(kind == STACK_ELIMINATION) : NULL;
+    struct stack *s = stack_create();
+    pthread_mutex_t lock = PTHREAD_MUTEX_INITIALIZER;
+
+    tstart = now();
+    for (size_t i = 0; i < nthreads; i++) {
+        workers[i].tid = i;
+        workers[i].lf = lf;
+        workers[i].s = s;
+        workers[i].lock = &lock;
+        workers[i].checksum = 0;
+        int ret = pthread_create(&workers[i].thread, NULL, worker, &workers[i]);
+        assert(ret == 0);
+        ((void)ret);
+    }
+    for (size_t i = 0; i < nthreads; i++) {
+        pthread_join(workers[i].thread, NULL);
+        checksum += workers[i].checksum;
+    }
+    tend = now();
+
+    // Every pushed element must have been popped exactly once.
+    assert(checksum == 0);
+
+    if (lf != NULL) {
+        assert(tag_pointer(atomic_load(&lf->top)) == NULL);
+        lf_stack_destroy(lf);
+    }
+    stack_destroy(s);
+
+    return ((2.0 * NOPERATIONS * nthreads) / (tend - tstart));
+}
+
+// Tests concurrent stacks.
+static void test_concurrent(void)
+{
+    printf("%8s %14s %14s %14s\n", "threads", "mutex", "lock-free", "elimination");
+
+    for (size_t nthreads = 1; nthreads <= LF_STACK_MAX_THREADS; nthreads *= 2) {
+        double mutex = benchmark(nthreads, STACK_MUTEX);
+        double lockfree = benchmark(nthreads, STACK_LOCK_FREE);
+        double elimination = benchmark(nthreads, STACK_ELIMINATION);
+
+        printf("%8zu %8.2lf Mop/s %8.2lf Mop/s %8.2lf Mop/s\n", nthreads, mutex, lockfree,
+               elimination);
+    }
+}
+
 // Tests Stacks.
 static void test(size_t length, bool verbose)
 {
@@ -163,6 +599,9 @@ static void test(size_t length, bool verbose)
 
     // Release stack.
     stack_destroy(s);
+
+    // Test concurrent stacks.
+    test_concurrent();
 }
 
 // Prints program usage and exits.
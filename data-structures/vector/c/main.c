@@ -1,16 +1,52 @@
 // Copyright (C) 2022 Pedro Henrique Penna <pedrohenriquepenna@outlook.com>
 
+// Required for mremap() and huge page flags.
+#define _GNU_SOURCE
+
 #include <assert.h>
+#include <linux/perf_event.h>
 #include <stdbool.h>
 #include <stddef.h>
+#include <stdint.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include <sys/ioctl.h>
+#include <sys/mman.h>
+#include <sys/resource.h>
+#include <sys/syscall.h>
 #include <time.h>
+#include <unistd.h>
 
 // Initial capacity for a vector.
 #define VECTOR_CAPACITY 1024
 
+// Number of elements that a vector created with VECTOR_INLINE stores inline, without a separate allocation.
+#define VECTOR_INLINE_CAPACITY 16
+
+// Alignment (in bytes) of the storage of aligned vectors.
+#define VECTOR_ALIGNMENT 64
+
+// Size (in bytes) of a huge page.
+#define VECTOR_HUGE_PAGE_SIZE ((size_t)2 << 20)
+
+// Size (in bytes) of the address space reserved by vectors created with VECTOR_RESERVE.
+#define VECTOR_RESERVE_SIZE ((size_t)1 << 40)
+
+// Flags for creating a vector.
+#define VECTOR_ALIGNED (1 << 0)     // Align storage to VECTOR_ALIGNMENT bytes.
+#define VECTOR_GROWTH_1_5X (1 << 1) // Grow capacity by 1.5x instead of 2x.
+#define VECTOR_MMAP (1 << 2)        // Map storage with transparent huge pages, grow with mremap().
+#define VECTOR_HUGETLB (1 << 3)     // Map storage with explicit huge pages (implies VECTOR_MMAP).
+#define VECTOR_RESERVE (1 << 4)     // Reserve address space up front, so storage never moves.
+#define VECTOR_INLINE (1 << 5)      // Store small vectors inline, right after the vector itself.
+
+// Flags of memory-mapped vectors.
+#define VECTOR_MAPPED (VECTOR_MMAP | VECTOR_HUGETLB | VECTOR_RESERVE)
+
+// Number of random reads in the TLB benchmark.
+#define TLB_BENCHMARK_READS ((size_t)1 << 22)
+
 // Type of elements that are stored in the vector.
 typedef int type_t;
 
@@ -19,36 +55,264 @@ struct vector {
     type_t *elements; // Elements stored in the vector.
     size_t length;    // Current number of elements that are stored in the vector.
     size_t capacity;  // Max number of elements that can be stored in the vector.
+    unsigned flags;   // Creation flags.
+    size_t mapped;    // Size (in bytes) of mapped storage.
 };
 
-// Creates a new vector.
-static struct vector *vector_create(void)
+// Offset (in bytes) of the inline storage of a vector, which follows it in the same allocation.
+#define VECTOR_INLINE_OFFSET \
+    ((sizeof(struct vector) + VECTOR_ALIGNMENT - 1) & ~((size_t)VECTOR_ALIGNMENT - 1))
+
+// Returns the inline storage of a vector, or NULL if it was not created with VECTOR_INLINE.
+static type_t *vector_inline(const struct vector *v)
+{
+    return ((v->flags & VECTOR_INLINE) ? (type_t *)((char *)v + VECTOR_INLINE_OFFSET) : NULL);
+}
+
+// Checks whether the elements of a vector are stored inline.
+static bool vector_is_inline(const struct vector *v)
+{
+    return ((v->flags & VECTOR_INLINE) && (v->elements == vector_inline(v)));
+}
+
+// Allocates storage for a given number of elements.
+static type_t *vector_alloc(size_t capacity, unsigned flags)
+{
+    type_t *elements = NULL;
+    size_t size = capacity * sizeof(type_t);
+
+    if (flags & VECTOR_ALIGNED) {
+        // Size must be a multiple of the alignment.
+        size = (size + VECTOR_ALIGNMENT - 1) & ~((size_t)VECTOR_ALIGNMENT - 1);
+        elements = aligned_alloc(VECTOR_ALIGNMENT, size);
+    } else {
+        elements = malloc(size);
+    }
+    assert(elements != NULL);
+
+    return (elements);
+}
+
+// Rounds a size up to a multiple of a power of two.
+static size_t round_up(size_t size, size_t align)
+{
+    return ((size + align - 1) & ~(align - 1));
+}
+
+// Maps storage for the elements of a vector.
+static type_t *vector_map(struct vector *v, size_t size)
+{
+    type_t *elements = MAP_FAILED;
+    const int prot = PROT_READ | PROT_WRITE;
+    const int flags = MAP_PRIVATE | MAP_ANONYMOUS;
+
+    // Reserve address space, but do not back it with memory yet.
+    if (v->flags & VECTOR_RESERVE) {
+        elements = mmap(NULL, VECTOR_RESERVE_SIZE, PROT_NONE, flags | MAP_NORESERVE, -1, 0);
+        assert(elements != MAP_FAILED);
+        madvise(elements, VECTOR_RESERVE_SIZE, MADV_HUGEPAGE);
+        v->mapped = 0;
+        return (elements);
+    }
+
+    // Explicit huge pages must have been reserved in the system.
+    if (v->flags & VECTOR_HUGETLB) {
+        elements = mmap(NULL, size, prot, flags | MAP_HUGETLB, -1, 0);
+        if (elements == MAP_FAILED) {
+            v->flags &= ~VECTOR_HUGETLB;
+            v->flags |= VECTOR_MMAP;
+        }
+    }
+
+    // Fall back to transparent huge pages.
+    if (elements == MAP_FAILED) {
+        elements = mmap(NULL, size, prot, flags, -1, 0);
+        assert(elements != MAP_FAILED);
+        madvise(elements, size, MADV_HUGEPAGE);
+    }
+
+    v->mapped = size;
+    return (elements);
+}
+
+// Moves the elements of a memory-mapped vector to a storage with a given capacity.
+static void vector_remap(struct vector *v, size_t capacity)
+{
+    type_t *elements = v->elements;
+    const bool was_inline = vector_is_inline(v);
+    size_t size = ((capacity > 0) ? capacity : 1) * sizeof(type_t);
+
+    // Round to whole pages, using huge pages for large vectors.
+    if ((v->flags & VECTOR_HUGETLB) || (size >= VECTOR_HUGE_PAGE_SIZE)) {
+        size = round_up(size, VECTOR_HUGE_PAGE_SIZE);
+    } else {
+        size = round_up(size, (size_t)sysconf(_SC_PAGESIZE));
+    }
+
+    // No storage mapped yet.
+    if ((v->elements == NULL) || was_inline) {
+        elements = vector_map(v, size);
+    }
+
+    if (v->flags & VECTOR_RESERVE) {
+        char *base = (char *)elements;
+
+        assert(size <= VECTOR_RESERVE_SIZE);
+
+        // Commit or release the tail of the reserved address space. Elements never move.
+        if (size > v->mapped) {
+            int ret = mprotect(base + v->mapped, size - v->mapped, PROT_READ | PROT_WRITE);
+            assert(ret == 0);
+            ((void)ret);
+        } else if (size < v->mapped) {
+            madvise(base + size, v->mapped - size, MADV_DONTNEED);
+            mprotect(base + size, v->mapped - size, PROT_NONE);
+        }
+    } else if (size != v->mapped) {
+        // Move page table entries, rather than copying elements.
+        type_t *moved = mremap(elements, v->mapped, size, MREMAP_MAYMOVE);
+
+        // Explicit huge page mappings cannot be expanded, so copy elements to a new mapping.
+        if (moved == MAP_FAILED) {
+            const size_t mapped = v->mapped;
+            moved = vector_map(v, size);
+            memcpy(moved, elements, v->length * sizeof(type_t));
+            munmap(elements, mapped);
+        }
+        elements = moved;
+    }
+
+    // Copy elements out of inline storage.
+    if (was_inline) {
+        memcpy(elements, v->elements, v->length * sizeof(type_t));
+    }
+
+    v->elements = elements;
+    v->mapped = size;
+    v->capacity = size / sizeof(type_t);
+}
+
+// Moves the elements of a vector to a storage with a given capacity.
+static void vector_realloc(struct vector *v, size_t capacity)
 {
-    struct vector *v = malloc(sizeof(struct vector));
+    assert(capacity >= v->length);
+
+    // Memory-mapped storage.
+    if (v->flags & VECTOR_MAPPED) {
+        vector_remap(v, capacity);
+        return;
+    }
+
+    // Small enough to fit inline.
+    if ((v->flags & VECTOR_INLINE) && (capacity <= VECTOR_INLINE_CAPACITY)) {
+        if (!vector_is_inline(v)) {
+            memcpy(vector_inline(v), v->elements, v->length * sizeof(type_t));
+            free(v->elements);
+            v->elements = vector_inline(v);
+        }
+        v->capacity = VECTOR_INLINE_CAPACITY;
+        return;
+    }
+
+    // Release all storage.
+    if (capacity == 0) {
+        free(v->elements);
+        v->elements = NULL;
+        v->capacity = 0;
+        return;
+    }
+
+    // Leaving inline storage, or preserving alignment, which realloc() does not do.
+    if (vector_is_inline(v) || (v->flags & VECTOR_ALIGNED)) {
+        type_t *elements = vector_alloc(capacity, v->flags);
+        if (v->length > 0) {
+            memcpy(elements, v->elements, v->length * sizeof(type_t));
+        }
+        if (!vector_is_inline(v)) {
+            free(v->elements);
+        }
+        v->elements = elements;
+    } else {
+        v->elements = realloc(v->elements, capacity * sizeof(type_t));
+        assert(v->elements != NULL);
+    }
+
+    v->capacity = capacity;
+}
+
+// Creates a new vector with a given initial capacity. Only vectors created
+// with VECTOR_INLINE carry inline storage, in the same allocation.
+static struct vector *vector_create_with(size_t capacity, unsigned flags)
+{
+    struct vector *v = NULL;
+
+    if (flags & VECTOR_INLINE) {
+        v = aligned_alloc(VECTOR_ALIGNMENT, VECTOR_INLINE_OFFSET + VECTOR_INLINE_CAPACITY * sizeof(type_t));
+    } else {
+        v = malloc(sizeof(struct vector));
+    }
     assert(v != NULL);
 
     // Initialize data structure.
     v->length = 0;
-    v->capacity = VECTOR_CAPACITY;
-    v->elements = malloc(v->capacity * sizeof(v->elements[0]));
-    assert(v->elements != NULL);
+    v->flags = flags;
+    v->mapped = 0;
+    v->elements = vector_inline(v);
+    v->capacity = (flags & VECTOR_INLINE) ? VECTOR_INLINE_CAPACITY : 0;
+    if (capacity > v->capacity) {
+        vector_realloc(v, capacity);
+    }
 
     return (v);
 }
 
+// Creates a new vector.
+static struct vector *vector_create(void)
+{
+    return (vector_create_with(VECTOR_CAPACITY, 0));
+}
+
 // Destroys a vector.
 static void vector_destroy(struct vector *v)
 {
-    free(v->elements);
+    // Memory-mapped vectors map storage on first growth.
+    if ((v->flags & VECTOR_RESERVE) && (v->mapped > 0)) {
+        munmap(v->elements, VECTOR_RESERVE_SIZE);
+    } else if ((v->flags & VECTOR_MAPPED) && (v->mapped > 0)) {
+        munmap(v->elements, v->mapped);
+    } else if (!vector_is_inline(v)) {
+        free(v->elements);
+    }
     free(v);
 }
 
-// Expands the capacity of a vector.
-static void vector_expand(struct vector *v)
+// Ensures that a vector can store at least a given number of elements.
+static void vector_reserve(struct vector *v, size_t capacity)
 {
-    v->capacity *= 2;
-    v->elements = realloc(v->elements, v->capacity * sizeof(v->elements[0]));
-    assert(v != NULL);
+    if (capacity > v->capacity) {
+        vector_realloc(v, capacity);
+    }
+}
+
+// Shrinks the capacity of a vector to its length.
+static void vector_shrink_to_fit(struct vector *v)
+{
+    if (v->capacity > v->length) {
+        vector_realloc(v, v->length);
+    }
+}
+
+// Expands the capacity of a vector, so that it can store at least a given number of elements.
+static void vector_expand(struct vector *v, size_t length)
+{
+    size_t capacity = (v->capacity > 0) ? v->capacity : 1;
+
+    // Grow geometrically.
+    while (capacity < length) {
+        capacity = (v->flags & VECTOR_GROWTH_1_5X) ? capacity + capacity / 2 : capacity * 2;
+    }
+
+    vector_realloc(v, capacity);
 }
 
 // Returns the number of elements that are stored in a vector.
@@ -57,24 +321,57 @@ static size_t vector_length(const struct vector *v)
     return (v->length);
 }
 
-// Inserts an element in a specific position of a vector.
-static void vector_insert(struct vector *v, size_t index, type_t element)
+// Inserts a range of elements in a specific position of a vector.
+static void vector_insert_range(struct vector *v, size_t index, const type_t elements[], size_t n)
 {
+    // Out of bounds.
+    if (index > v->length) {
+        fprintf(stderr, "Error: %zu is out of bounds of the vector\n", index);
+        exit(-1);
+    }
+
     // The vector is full, thus expand its capacity.
-    if (vector_length(v) == v->capacity) {
-        vector_expand(v);
+    if (v->length + n > v->capacity) {
+        vector_expand(v, v->length + n);
     }
 
+    // Shift right elements.
+    memmove(&v->elements[index + n], &v->elements[index], (v->length - index) * sizeof(type_t));
+
+    // Insert the elements in the specified position.
+    memcpy(&v->elements[index], elements, n * sizeof(type_t));
+
     // Increase the size of the vector.
-    v->length += 1;
+    v->length += n;
+}
 
-    // Shift right elements.
-    for (size_t i = v->length - 1; i > index; i--) {
-        v->elements[i] = v->elements[i - 1];
+// Appends a range of elements to the end of a vector.
+static void vector_append_n(struct vector *v, const type_t elements[], size_t n)
+{
+    vector_insert_range(v, v->length, elements, n);
+}
+
+// Inserts an element in a specific position of a vector.
+static void vector_insert(struct vector *v, size_t index, type_t element)
+{
+    vector_insert_range(v, index, &element, 1);
+}
+
+// Removes a range of elements from a specific position in a vector.
+static void vector_erase_range(struct vector *v, size_t index, size_t n)
+{
+    // Out of bounds.
+    if ((index > v->length) || (n > v->length - index)) {
+        fprintf(stderr, "Error: %zu is out of bounds of the vector\n", index + n);
+        exit(-1);
     }
 
-    // Insert the element in the specified position.
-    v->elements[index] = element;
+    // Shift left elements.
+    memmove(&v->elements[index], &v->elements[index + n],
+            (v->length - index - n) * sizeof(type_t));
+
+    // Decrease the size of the vector.
+    v->length -= n;
 }
 
 // Removes an element from a specific position in a vector.
@@ -88,13 +385,7 @@ static type_t vector_remove(struct vector *v, size_t index)
 
     type_t x = v->elements[index];
 
-    // Shift left elements.
-    for (size_t i = index; i < v->length - 1; i++) {
-        v->elements[i] = v->elements[i + 1];
-    }
-
-    // Decrease the size of the vector.
-    v->length -= 1;
+    vector_erase_range(v, index, 1);
 
     return (x);
 }
@@ -136,6 +427,249 @@ static void vector_print(const struct vector *v)
     printf("] }\n");
 }
 
+// Tests bulk operations on vectors.
+static void test_bulk(size_t length, bool verbose)
+{
+    double tstart = 0.0;
+    double tend = 0.0;
+    const double MICROSECS = ((CLOCKS_PER_SEC / 1000000.0));
+    type_t *elements = NULL;
+    struct vector *v = vector_create_with(0, VECTOR_ALIGNED | VECTOR_INLINE);
+
+    elements = malloc(length * sizeof(type_t));
+    assert(elements != NULL);
+    for (size_t i = 0; i < length; i++) {
+        elements[i] = (type_t)(i + 1);
+    }
+
+    // Tiny vectors are stored inline, and only vectors that ask for it pay for inline storage.
+    assert(vector_is_inline(v));
+    assert(((uintptr_t)v->elements % VECTOR_ALIGNMENT) == 0);
+
+    // Append all elements at once.
+    tstart = clock();
+    vector_append_n(v, elements, length);
+    tend = clock();
+    printf("%21s: %2.lf us\n", "vector_append_n()", (tend - tstart) / MICROSECS);
+    assert(vector_length(v) == length);
+    assert(((uintptr_t)v->elements % VECTOR_ALIGNMENT) == 0);
+
+    // Insert all elements again, in the middle of the vector.
+    tstart = clock();
+    vector_insert_range(v, length / 2, elements, length);
+    tend = clock();
+    printf("%21s: %2.lf us\n", "vector_insert_range()", (tend - tstart) / MICROSECS);
+    assert(vector_length(v) == 2 * length);
+    for (size_t i = 0; i < length; i++) {
+        assert(*vector_index(v, length / 2 + i) == elements[i]);
+    }
+
+    // Erase them.
+    tstart = clock();
+    vector_erase_range(v, length / 2, length);
+    tend = clock();
+    printf("%21s: %2.lf us\n", "vector_erase_range()", (tend - tstart) / MICROSECS);
+    assert(vector_length(v) == length);
+    for (size_t i = 0; i < length; i++) {
+        assert(*vector_index(v, i) == elements[i]);
+    }
+
+    // Keep only a few elements, which should move back inline.
+    vector_erase_range(v, 0, length - ((length < 4) ? length : 4));
+    vector_shrink_to_fit(v);
+    if (verbose) {
+        vector_print(v);
+    }
+    assert(vector_is_inline(v));
+
+    // Reserve space up front.
+    vector_reserve(v, 4 * length);
+    assert(v->capacity >= 4 * length);
+
+    // Release resources.
+    vector_destroy(v);
+    free(elements);
+}
+
+// Tests insert and remove throughput under different allocation policies.
+static void test_policies(size_t length)
+{
+    const double MICROSECS = ((CLOCKS_PER_SEC / 1000000.0));
+    const struct {
+        const char *name;
+        size_t capacity;
+        unsigned flags;
+    } policies[] = {
+        {"default", VECTOR_CAPACITY, 0},
+        {"growth-1.5x", VECTOR_CAPACITY, VECTOR_GROWTH_1_5X},
+        {"aligned", VECTOR_CAPACITY, VECTOR_ALIGNED},
+        {"inline", 0, VECTOR_INLINE},
+    };
+
+    printf("%21s %14s %14s %14s\n", "policy", "append", "insert-front", "remove-front");
+
+    for (size_t p = 0; p < sizeof(policies) / sizeof(policies[0]); p++) {
+        double tappend = 0.0;
+        double tinsert = 0.0;
+        double tremove = 0.0;
+        double tstart = 0.0;
+        struct vector *v = vector_create_with(policies[p].capacity, policies[p].flags);
+
+        // Append elements one at a time.
+        tstart = clock();
+        for (size_t i = 0; i < length; i++) {
+            vector_insert(v, vector_length(v), (type_t)i);
+        }
+        tappend = clock() - tstart;
+
+        // Insert elements one at a time at the front.
+        tstart = clock();
+        for (size_t i = 0; i < length; i++) {
+            vector_insert(v, 0, (type_t)i);
+        }
+        tinsert = clock() - tstart;
+
+        // Remove elements one at a time from the front.
+        tstart = clock();
+        for (size_t i = 0; i < 2 * length; i++) {
+            vector_remove(v, 0);
+        }
+        tremove = clock() - tstart;
+
+        printf("%21s %11.lf us %11.lf us %11.lf us\n", policies[p].name, tappend / MICROSECS,
+               tinsert / MICROSECS, tremove / MICROSECS);
+
+        vector_destroy(v);
+    }
+}
+
+// Opens a hardware counter for data TLB misses of the calling thread.
+static int tlb_counter_open(void)
+{
+    struct perf_event_attr attr;
+
+    memset(&attr, 0, sizeof(attr));
+    attr.type = PERF_TYPE_HW_CACHE;
+    attr.size = sizeof(attr);
+    attr.config = PERF_COUNT_HW_CACHE_DTLB | (PERF_COUNT_HW_CACHE_OP_READ << 8) |
+                  (PERF_COUNT_HW_CACHE_RESULT_MISS << 16);
+    attr.disabled = 1;
+    attr.exclude_kernel = 1;
+    attr.exclude_hv = 1;
+
+    // May fail if the system does not expose hardware counters.
+    return ((int)syscall(SYS_perf_event_open, &attr, 0, -1, -1, 0));
+}
+
+// Reads a hardware counter.
+static long long tlb_counter_read(int fd)
+{
+    long long count = -1;
+
+    if ((fd < 0) || (read(fd, &count, sizeof(count)) != sizeof(count))) {
+        return (-1);
+    }
+
+    return (count);
+}
+
+// Returns the current time in microseconds.
+static double now(void)
+{
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+
+    return (ts.tv_sec * 1000000.0 + ts.tv_nsec / 1000.0);
+}
+
+// Returns the number of minor page faults of the calling process.
+static long minor_faults(void)
+{
+    struct rusage usage;
+
+    getrusage(RUSAGE_SELF, &usage);
+
+    return (usage.ru_minflt);
+}
+
+// Tests growth latency and TLB misses of huge vectors under different allocation backends.
+static void test_growth(size_t length)
+{
+    const struct {
+        const char *name;
+        unsigned flags;
+    } backends[] = {
+        {"realloc", 0},
+        {"aligned-copy", VECTOR_ALIGNED},
+        {"mmap-thp", VECTOR_MMAP},
+        {"mmap-hugetlb", VECTOR_HUGETLB},
+        {"mmap-reserve", VECTOR_RESERVE},
+    };
+    int fd = tlb_counter_open();
+
+    printf("%14s %12s %14s %12s %12s %14s\n", "backend", "append", "max-growth", "faults",
+           "reads", "tlb-misses");
+
+    for (size_t b = 0; b < sizeof(backends) / sizeof(backends[0]); b++) {
+        double tstart = 0.0;
+        double tappend = 0.0;
+        double tgrowth = 0.0;
+        double treads = 0.0;
+        long faults = minor_faults();
+        long long misses = -1;
+        volatile uint64_t sum = 0;
+        uint64_t index = 1;
+        char misses_str[32] = "n/a";
+        struct vector *v = vector_create_with(0, backends[b].flags);
+
+        // Storage is mapped on first growth.
+        assert(v->mapped == 0);
+
+        // Append elements, and keep track of the slowest one that grew the vector.
+        tstart = now();
+        for (size_t i = 0; i < length; i++) {
+            if (vector_length(v) == v->capacity) {
+                double t = now();
+                vector_insert(v, vector_length(v), (type_t)i);
+                t = now() - t;
+                tgrowth = (t > tgrowth) ? t : tgrowth;
+            } else {
+                vector_insert(v, vector_length(v), (type_t)i);
+            }
+        }
+        tappend = now() - tstart;
+        faults = minor_faults() - faults;
+
+        // Read random elements.
+        ioctl(fd, PERF_EVENT_IOC_RESET, 0);
+        ioctl(fd, PERF_EVENT_IOC_ENABLE, 0);
+        tstart = now();
+        for (size_t i = 0; (i < TLB_BENCHMARK_READS) && (length > 0); i++) {
+            index = index * 6364136223846793005ULL + 1442695040888963407ULL;
+            sum += v->elements[(index >> 33) % vector_length(v)];
+        }
+        treads = now() - tstart;
+        ioctl(fd, PERF_EVENT_IOC_DISABLE, 0);
+        misses = tlb_counter_read(fd);
+        if (misses >= 0) {
+            snprintf(misses_str, sizeof(misses_str), "%lld", misses);
+        }
+
+        printf("%14s %9.lf us %11.lf us %12ld %9.lf us %14s%s\n", backends[b].name, tappend,
+               tgrowth, faults, treads, misses_str,
+               ((backends[b].flags & VECTOR_HUGETLB) && !(v->flags & VECTOR_HUGETLB))
+                   ? " (no huge pages reserved, fell back to mmap-thp)"
+                   : "");
+
+        vector_destroy(v);
+    }
+
+    if (fd >= 0) {
+        close(fd);
+    }
+}
+
 // Tests Vectors.
 static void test(size_t length, bool verbose)
 {
@@ -156,41 +690,52 @@ static void test(size_t length, bool verbose)
     if (verbose) {
         vector_print(v);
     }
-    printf("%18s: %2.lf us\n", "vector_insert()", (tend - tstart) / MICROSECS);
+    printf("%21s: %2.lf us\n", "vector_insert()", (tend - tstart) / MICROSECS);
 
     assert(vector_length(v) == length);
 
     // Get all elements in the vector.
+    tstart = clock();
     for (size_t i = 0; i < length; i++) {
         assert(*vector_index(v, i) == (type_t)(i + 1));
     }
+    tend = clock();
     if (verbose) {
         vector_print(v);
     }
-    printf("%18s: %2.lf us\n", "vector_get()", (tend - tstart) / MICROSECS);
+    printf("%21s: %2.lf us\n", "vector_get()", (tend - tstart) / MICROSECS);
 
     // Replace all elements in the vector.
+    tstart = clock();
     for (size_t i = 0; i < length; i++) {
         *vector_index_mut(v, i) = 0;
     }
+    tend = clock();
     if (verbose) {
         vector_print(v);
     }
-    printf("%18s: %2.lf us\n", "vector_index_mut()", (tend - tstart) / MICROSECS);
+    printf("%21s: %2.lf us\n", "vector_index_mut()", (tend - tstart) / MICROSECS);
 
     // Remove all elements from the vector.
+    tstart = clock();
     for (size_t i = 0; i < length; i++) {
         vector_remove(v, 0);
     }
+    tend = clock();
     if (verbose) {
         vector_print(v);
     }
-    printf("%18s: %2.lf us\n", "vector_remove()", (tend - tstart) / MICROSECS);
+    printf("%21s: %2.lf us\n", "vector_remove()", (tend - tstart) / MICROSECS);
 
     assert(vector_length(v) == 0);
 
     // Release vector.
     vector_destroy(v);
+
+    // Test bulk operations and allocation policies.
+    test_bulk(length, verbose);
+    test_policies(length);
+    test_growth(length);
 }
 
 // Prints program usage and exits.
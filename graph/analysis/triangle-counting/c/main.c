@@ -0,0 +1,1001 @@
+// Copyright (C) 2022 Pedro Henrique Penna <pedrohenriquepenna@outlook.com>
+
+#define _POSIX_C_SOURCE 200809L
+
+#include <assert.h>
+#include <fcntl.h>
+#include <limits.h>
+#include <math.h>
+#include <pthread.h>
+#include <stdatomic.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <time.h>
+#include <unistd.h>
+
+// Magic number of binary sparse graph files ("CSR1").
+#define CSR_MAGIC 0x31525343
+
+// Flag of binary sparse graph files that store each edge in both directions.
+#define CSR_UNDIRECTED 1
+
+// Max number of threads.
+#define GRAPH_MAX_THREADS 8
+
+// Number of nodes that a thread grabs at once.
+#define GRAPH_CHUNK 64
+
+// Number of nodes in a SIMD vector.
+#define INTERSECT_LANES 8
+
+// Core number of nodes that were not removed yet.
+#define KCORE_NONE UINT_MAX
+
+// Average number of neighbors of a node in random graphs.
+#define POWERLAW_DEGREE 16
+
+// Skew of endpoints of edges in random graphs. Higher values concentrate
+// edges on fewer nodes.
+#define POWERLAW_SKEW 2.0
+
+// Graphs with at most this number of nodes are checked against a naive
+// triangle count.
+#define CHECK_NNODES 4096
+
+//==============================================================================
+// Sparse Graph Data Structure
+//==============================================================================
+
+// An undirected sparse graph in compressed sparse row format. Each edge is
+// stored in the rows of both endpoints.
+struct csr {
+    unsigned nnodes;     // Number of nodes.
+    size_t nedges;       // Number of directed edges.
+    size_t *offsets;     // Offset of the first edge of each node (nnodes + 1 entries).
+    unsigned *targets;   // Target node of each edge.
+    unsigned *weights;   // Weight of each edge (NULL if unweighted).
+    void *mapping;       // Mapped file (NULL if allocated).
+    size_t mapping_size; // Size of the mapped file.
+};
+
+// Creates an empty sparse graph.
+static struct csr *csr_create(unsigned nnodes, size_t nedges)
+{
+    struct csr *g = NULL;
+
+    assert((g = malloc(sizeof(struct csr))) != NULL);
+    g->nnodes = nnodes;
+    g->nedges = nedges;
+    g->weights = NULL;
+    g->mapping = NULL;
+    g->mapping_size = 0;
+    assert((g->offsets = calloc(g->nnodes + 1, sizeof(size_t))) != NULL);
+    assert((g->targets = malloc((g->nedges + 1) * sizeof(unsigned))) != NULL);
+
+    return (g);
+}
+
+// Destroys a sparse graph.
+static void csr_destroy(struct csr *g)
+{
+    if (g->mapping != NULL) {
+        munmap(g->mapping, g->mapping_size);
+    } else {
+        free(g->weights);
+        free(g->targets);
+        free(g->offsets);
+    }
+    free(g);
+}
+
+// Returns the degree of a node in a sparse graph.
+static size_t csr_degree(const struct csr *g, unsigned u)
+{
+    return (g->offsets[u + 1] - g->offsets[u]);
+}
+
+// Compares two nodes.
+static int node_compare(const void *a, const void *b)
+{
+    const unsigned x = *(const unsigned *)a;
+    const unsigned y = *(const unsigned *)b;
+
+    return ((x > y) - (x < y));
+}
+
+// Builds a simple graph from a sparse graph: neighbors are sorted, and
+// duplicate edges and self-loops are dropped. Weights are dropped as well.
+static struct csr *csr_simplify(const struct csr *g)
+{
+    struct csr *s = csr_create(g->nnodes, g->nedges);
+    size_t nedges = 0;
+
+    for (unsigned u = 0; u < g->nnodes; u++) {
+        unsigned *row = &s->targets[nedges];
+        const size_t degree = csr_degree(g, u);
+        size_t n = 0;
+
+        memcpy(row, &g->targets[g->offsets[u]], degree * sizeof(unsigned));
+        qsort(row, degree, sizeof(unsigned), node_compare);
+        for (size_t k = 0; k < degree; k++) {
+            if ((row[k] != u) && ((n == 0) || (row[n - 1] != row[k]))) {
+                row[n++] = row[k];
+            }
+        }
+        nedges += n;
+        s->offsets[u + 1] = nedges;
+    }
+    s->nedges = nedges;
+
+    return (s);
+}
+
+// Header of a binary sparse graph file, as written by graph/loader. It is
+// followed by the offsets (nnodes + 1 entries of 64 bits), the targets and
+// the weights (nedges entries of 32 bits each).
+struct csr_header {
+    uint32_t magic;  // Magic number.
+    uint32_t flags;  // Flags.
+    uint64_t nnodes; // Number of nodes.
+    uint64_t nedges; // Number of edges.
+};
+
+// Checks the arrays of a graph in compressed sparse row format: offsets
+// must start at zero, never decrease and end at the number of edges, and
+// targets must be valid nodes, so that the graph can be walked without
+// further checks.
+static bool csr_check_arrays(const uint64_t *offsets, const uint32_t *targets, uint64_t nnodes,
+                             uint64_t nedges)
+{
+    // Check offsets.
+    if ((offsets[0] != 0) || (offsets[nnodes] != nedges)) {
+        return (false);
+    }
+    for (uint64_t u = 0; u < nnodes; u++) {
+        if (offsets[u] > offsets[u + 1]) {
+            return (false);
+        }
+    }
+
+    // Check targets.
+    for (uint64_t k = 0; k < nedges; k++) {
+        if (targets[k] >= nnodes) {
+            return (false);
+        }
+    }
+
+    return (true);
+}
+
+// Checks the contents of a mapped binary sparse graph file. Sizes are
+// checked without overflowing before arrays are checked.
+static bool csr_check(const void *mapping, size_t size)
+{
+    const struct csr_header *h = mapping;
+    const uint64_t *offsets = (const uint64_t *)(h + 1);
+    size_t remaining = 0;
+
+    // Check header.
+    if ((size < sizeof(struct csr_header)) || (h->magic != CSR_MAGIC)) {
+        return (false);
+    }
+
+    // Check sizes. Targets are 32-bit node numbers.
+    remaining = size - sizeof(struct csr_header);
+    if ((h->nnodes > (uint64_t)UINT32_MAX + 1) || (h->nnodes >= remaining / sizeof(uint64_t))) {
+        return (false);
+    }
+    remaining -= (h->nnodes + 1) * sizeof(uint64_t);
+    if ((h->nedges > remaining / (2 * sizeof(uint32_t))) ||
+        (remaining != h->nedges * 2 * sizeof(uint32_t))) {
+        return (false);
+    }
+
+    return (csr_check_arrays(offsets, (const uint32_t *)(offsets + h->nnodes + 1), h->nnodes,
+                             h->nedges));
+}
+
+// Maps a binary sparse graph file in memory. No data is copied: the graph
+// points into the mapping, and pages are loaded on first access. Only files
+// that store each edge in both directions are accepted.
+static struct csr *csr_map(const char *path)
+{
+    int fd = -1;
+    struct stat st;
+    struct csr *g = NULL;
+    const struct csr_header *h = NULL;
+
+    if ((fd = open(path, O_RDONLY)) < 0) {
+        return (NULL);
+    }
+    if ((fstat(fd, &st) < 0) || ((size_t)st.st_size < sizeof(struct csr_header))) {
+        close(fd);
+        return (NULL);
+    }
+
+    assert((g = malloc(sizeof(struct csr))) != NULL);
+    g->mapping_size = (size_t)st.st_size;
+    g->mapping = mmap(NULL, g->mapping_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (g->mapping == MAP_FAILED) {
+        free(g);
+        return (NULL);
+    }
+
+    // Check contents.
+    h = g->mapping;
+    if (!csr_check(g->mapping, g->mapping_size) || (!(h->flags & CSR_UNDIRECTED)) ||
+        (h->nnodes >= UINT32_MAX)) {
+        munmap(g->mapping, g->mapping_size);
+        free(g);
+        return (NULL);
+    }
+
+    g->nnodes = h->nnodes;
+    g->nedges = h->nedges;
+    g->offsets = (size_t *)(h + 1);
+    g->targets = (unsigned *)(g->offsets + g->nnodes + 1);
+    g->weights = g->targets + g->nedges;
+
+    return (g);
+}
+
+// Writes an unweighted sparse graph to a binary sparse graph file. All edges get weight one.
+static void csr_write(const struct csr *g, FILE *f)
+{
+    const struct csr_header h = {CSR_MAGIC, CSR_UNDIRECTED, g->nnodes, g->nedges};
+    const uint32_t weight = 1;
+
+    assert(fwrite(&h, sizeof(h), 1, f) == 1);
+    for (size_t i = 0; i <= g->nnodes; i++) {
+        const uint64_t offset = g->offsets[i];
+        assert(fwrite(&offset, sizeof(offset), 1, f) == 1);
+    }
+    assert(fwrite(g->targets, sizeof(uint32_t), g->nedges, f) == g->nedges);
+    for (size_t k = 0; k < g->nedges; k++) {
+        assert(fwrite(&weight, sizeof(weight), 1, f) == 1);
+    }
+}
+
+// Builds a random simple graph whose degrees follow a power law. Endpoints of
+// edges are skewed towards a few nodes, and then nodes are shuffled, so that
+// hubs are spread over memory.
+static struct csr *csr_create_powerlaw(unsigned nnodes)
+{
+    const size_t nedges = (size_t)nnodes * POWERLAW_DEGREE / 2;
+    struct csr *g = csr_create(nnodes, 2 * nedges);
+    struct csr *s = NULL;
+    unsigned *names = NULL;
+    unsigned *sources = NULL;
+    unsigned *targets = NULL;
+
+    assert((names = malloc(nnodes * sizeof(unsigned))) != NULL);
+    assert((sources = malloc(nedges * sizeof(unsigned))) != NULL);
+    assert((targets = malloc(nedges * sizeof(unsigned))) != NULL);
+
+    for (unsigned i = 0; i < nnodes; i++) {
+        names[i] = i;
+    }
+    for (unsigned i = nnodes; i > 1; i--) {
+        const unsigned j = (unsigned)rand() % i;
+        const unsigned tmp = names[i - 1];
+        names[i - 1] = names[j];
+        names[j] = tmp;
+    }
+
+    // Count degrees, shifted by one node.
+    for (size_t k = 0; k < nedges; k++) {
+        const double u = (double)rand() / ((double)RAND_MAX + 1.0);
+        const double v = (double)rand() / ((double)RAND_MAX + 1.0);
+        sources[k] = names[(unsigned)(nnodes * pow(u, POWERLAW_SKEW))];
+        targets[k] = names[(unsigned)(nnodes * pow(v, POWERLAW_SKEW))];
+        g->offsets[sources[k] + 1]++;
+        g->offsets[targets[k] + 1]++;
+    }
+    for (unsigned i = 0; i < nnodes; i++) {
+        g->offsets[i + 1] += g->offsets[i];
+    }
+
+    // Place edges, using the first offset of each node as cursor.
+    for (size_t k = 0; k < nedges; k++) {
+        g->targets[g->offsets[sources[k]]++] = targets[k];
+        g->targets[g->offsets[targets[k]]++] = sources[k];
+    }
+
+    // Cursors now point to the next row, so shift them back.
+    for (unsigned i = nnodes; i > 0; i--) {
+        g->offsets[i] = g->offsets[i - 1];
+    }
+    g->offsets[0] = 0;
+
+    s = csr_simplify(g);
+
+    free(targets);
+    free(sources);
+    free(names);
+    csr_destroy(g);
+
+    return (s);
+}
+
+// Orients the edges of a simple graph from lower to higher ranked nodes.
+// Nodes are ranked by degree, and ties are broken by number. Each triangle
+// is then found from its lowest ranked node only, and hubs, which have most
+// neighbors, keep few of them.
+static struct csr *csr_orient(const struct csr *g)
+{
+    struct csr *d = csr_create(g->nnodes, g->nedges / 2);
+    size_t nedges = 0;
+
+    for (unsigned u = 0; u < g->nnodes; u++) {
+        const size_t degree = csr_degree(g, u);
+        for (size_t k = g->offsets[u]; k < g->offsets[u + 1]; k++) {
+            const unsigned v = g->targets[k];
+            const size_t other = csr_degree(g, v);
+            if ((degree < other) || ((degree == other) && (u < v))) {
+                d->targets[nedges++] = v;
+            }
+        }
+        d->offsets[u + 1] = nedges;
+    }
+    assert(nedges == d->nedges);
+
+    return (d);
+}
+
+//==============================================================================
+// Sorted Set Intersection
+//==============================================================================
+
+// Kinds of intersection algorithms.
+enum intersect_kind {
+    INTERSECT_MERGE, // Scalar merge.
+    INTERSECT_SIMD,  // Block-wise SIMD merge.
+};
+
+// A vector of nodes.
+typedef unsigned vnode_t __attribute__((vector_size(INTERSECT_LANES * sizeof(unsigned))));
+
+// A vector of nodes that is loaded from any address of an array of nodes.
+typedef vnode_t vnode_unaligned_t __attribute__((aligned(sizeof(unsigned)), may_alias));
+
+// A vector of comparison results: lanes are -1 if true, and 0 otherwise.
+typedef int vmask_t __attribute__((vector_size(INTERSECT_LANES * sizeof(int))));
+
+// Counts the elements that are in two sorted sets, with a scalar merge.
+static size_t intersect_merge(const unsigned *a, size_t na, const unsigned *b, size_t nb)
+{
+    size_t i = 0;
+    size_t j = 0;
+    size_t count = 0;
+
+    while ((i < na) && (j < nb)) {
+        if (a[i] < b[j]) {
+            i++;
+        } else if (a[i] > b[j]) {
+            j++;
+        } else {
+            count++, i++, j++;
+        }
+    }
+
+    return (count);
+}
+
+// Counts the elements that are in two sorted sets, with a block-wise SIMD
+// merge. A block of each set is compared against all rotations of a block of
+// the other set, and the block with the lowest last element is advanced.
+// Sets have no duplicates, so each element matches at most once. Tails are
+// merged by scalar code.
+static size_t intersect_simd(const unsigned *a, size_t na, const unsigned *b, size_t nb)
+{
+    const vnode_t rotate = {1, 2, 3, 4, 5, 6, 7, 0};
+    vmask_t matches = {0};
+    size_t i = 0;
+    size_t j = 0;
+    size_t count = 0;
+
+    while ((i + INTERSECT_LANES <= na) && (j + INTERSECT_LANES <= nb)) {
+        const vnode_t va = *(const vnode_unaligned_t *)&a[i];
+        vnode_t vb = *(const vnode_unaligned_t *)&b[j];
+        const unsigned amax = a[i + INTERSECT_LANES - 1];
+        const unsigned bmax = b[j + INTERSECT_LANES - 1];
+
+        for (size_t r = 0; r < INTERSECT_LANES; r++) {
+            matches -= (va == vb);
+            vb = __builtin_shuffle(vb, rotate);
+        }
+        i += (amax <= bmax) ? INTERSECT_LANES : 0;
+        j += (bmax <= amax) ? INTERSECT_LANES : 0;
+    }
+    for (size_t l = 0; l < INTERSECT_LANES; l++) {
+        count += (size_t)matches[l];
+    }
+
+    return (count + intersect_merge(&a[i], na - i, &b[j], nb - j));
+}
+
+// Counts the elements that are in two sorted sets.
+static size_t intersect(enum intersect_kind kind, const unsigned *a, size_t na,
+                        const unsigned *b, size_t nb)
+{
+    switch (kind) {
+        case INTERSECT_MERGE:
+            return (intersect_merge(a, na, b, nb));
+        case INTERSECT_SIMD:
+            return (intersect_simd(a, na, b, nb));
+        default:
+            assert(false);
+            return (0);
+    }
+}
+
+//==============================================================================
+// Triangle Counting
+//==============================================================================
+
+// A thread of triangle counting.
+struct triangle_worker {
+    pthread_t thread;         // Thread.
+    const struct csr *d;      // Oriented graph.
+    enum intersect_kind kind; // Intersection algorithm.
+    atomic_size_t *next;      // Next node to grab.
+    size_t ntriangles;        // Number of triangles found by this thread.
+};
+
+// Runs a thread of triangle counting: threads grab chunks of nodes until
+// none is left, because work is skewed towards a few nodes.
+static void *triangle_worker(void *arg)
+{
+    struct triangle_worker *w = arg;
+    const struct csr *d = w->d;
+    size_t begin = 0;
+
+    while ((begin = atomic_fetch_add(w->next, GRAPH_CHUNK)) < d->nnodes) {
+        const size_t end = (begin + GRAPH_CHUNK < d->nnodes) ? begin + GRAPH_CHUNK : d->nnodes;
+        for (size_t u = begin; u < end; u++) {
+            const unsigned *nu = &d->targets[d->offsets[u]];
+            const size_t du = d->offsets[u + 1] - d->offsets[u];
+            for (size_t k = 0; k < du; k++) {
+                const unsigned v = nu[k];
+                w->ntriangles += intersect(w->kind, nu, du, &d->targets[d->offsets[v]],
+                                           d->offsets[v + 1] - d->offsets[v]);
+            }
+        }
+    }
+
+    return (NULL);
+}
+
+// Counts triangles in an oriented graph, using multiple threads. Each
+// triangle u -> v -> w is counted once, at its edge u -> v, by intersecting
+// the neighbors of u and v.
+static size_t triangle_count(const struct csr *d, enum intersect_kind kind, size_t nthreads)
+{
+    struct triangle_worker workers[GRAPH_MAX_THREADS];
+    atomic_size_t next = 0;
+    size_t ntriangles = 0;
+    int ret = 0;
+
+    assert((nthreads >= 1) && (nthreads <= GRAPH_MAX_THREADS));
+
+    for (size_t i = 0; i < nthreads; i++) {
+        workers[i] = (struct triangle_worker){0, d, kind, &next, 0};
+        ret = pthread_create(&workers[i].thread, NULL, triangle_worker, &workers[i]);
+        assert(ret == 0);
+    }
+    ((void)ret);
+    for (size_t i = 0; i < nthreads; i++) {
+        pthread_join(workers[i].thread, NULL);
+        ntriangles += workers[i].ntriangles;
+    }
+
+    return (ntriangles);
+}
+
+// Returns the global clustering coefficient of a simple graph: the fraction
+// of paths of length two that are closed by a triangle.
+static double transitivity(const struct csr *g, size_t ntriangles)
+{
+    double nwedges = 0.0;
+
+    for (unsigned u = 0; u < g->nnodes; u++) {
+        const double degree = (double)csr_degree(g, u);
+        nwedges += degree * (degree - 1) / 2;
+    }
+
+    return ((nwedges > 0.0) ? 3.0 * ntriangles / nwedges : 0.0);
+}
+
+//==============================================================================
+// k-Core Decomposition
+//==============================================================================
+
+// A thread of k-core decomposition.
+struct kcore_worker {
+    pthread_t thread;  // Thread.
+    size_t id;         // Thread number.
+    struct kcore *kc;  // Decomposition.
+    unsigned begin;    // First node.
+    unsigned end;      // Last node (exclusive).
+    unsigned min;      // Lowest degree of remaining nodes in the range.
+};
+
+// State of a k-core decomposition.
+struct kcore {
+    const struct csr *g;                                // Simple graph.
+    atomic_uint *degrees;                               // Degrees of remaining nodes.
+    unsigned *cores;                                    // Core numbers.
+    unsigned *frontier;                                 // Nodes that are removed in this round.
+    atomic_size_t nfrontier;                            // Number of nodes in the frontier.
+    unsigned *next;                                     // Nodes that are removed in the next round.
+    atomic_size_t nnext;                                // Number of nodes in the next frontier.
+    atomic_size_t cursor;                               // Next node of the frontier to grab.
+    size_t nthreads;                                    // Number of threads.
+    pthread_barrier_t barrier;                          // Synchronizes threads between rounds.
+    struct kcore_worker workers[GRAPH_MAX_THREADS];     // Threads.
+};
+
+// Runs a thread of k-core decomposition. Each level k starts from the lowest
+// degree of the remaining nodes, and nodes with that degree are removed in
+// rounds: removing a node decrements the degrees of its neighbors, and a
+// neighbor whose degree drops to k is removed in the next round. The thread
+// that performs the last decrement of a neighbor enqueues it, so each node
+// is removed once.
+static void *kcore_worker(void *arg)
+{
+    struct kcore_worker *w = arg;
+    struct kcore *kc = w->kc;
+    const struct csr *g = kc->g;
+
+    for (;;) {
+        unsigned k = KCORE_NONE;
+
+        // Skip to the lowest degree of the remaining nodes.
+        w->min = KCORE_NONE;
+        for (unsigned u = w->begin; u < w->end; u++) {
+            const unsigned degree = atomic_load_explicit(&kc->degrees[u], memory_order_relaxed);
+            if ((kc->cores[u] == KCORE_NONE) && (degree < w->min)) {
+                w->min = degree;
+            }
+        }
+        pthread_barrier_wait(&kc->barrier);
+        for (size_t i = 0; i < kc->nthreads; i++) {
+            k = (kc->workers[i].min < k) ? kc->workers[i].min : k;
+        }
+        if (k == KCORE_NONE) {
+            break;
+        }
+
+        // Gather the first frontier.
+        for (unsigned u = w->begin; u < w->end; u++) {
+            if ((kc->cores[u] == KCORE_NONE) &&
+                (atomic_load_explicit(&kc->degrees[u], memory_order_relaxed) == k)) {
+                kc->frontier[atomic_fetch_add(&kc->nfrontier, 1)] = u;
+            }
+        }
+        pthread_barrier_wait(&kc->barrier);
+
+        while (atomic_load(&kc->nfrontier) > 0) {
+            const size_t nfrontier = atomic_load(&kc->nfrontier);
+            size_t begin = 0;
+
+            // Remove nodes in the frontier.
+            while ((begin = atomic_fetch_add(&kc->cursor, GRAPH_CHUNK)) < nfrontier) {
+                const size_t end = (begin + GRAPH_CHUNK < nfrontier) ? begin + GRAPH_CHUNK : nfrontier;
+                for (size_t i = begin; i < end; i++) {
+                    const unsigned u = kc->frontier[i];
+                    kc->cores[u] = k;
+                    for (size_t e = g->offsets[u]; e < g->offsets[u + 1]; e++) {
+                        const unsigned v = g->targets[e];
+                        if ((atomic_load_explicit(&kc->degrees[v], memory_order_relaxed) > k) &&
+                            (atomic_fetch_sub(&kc->degrees[v], 1) == k + 1)) {
+                            kc->next[atomic_fetch_add(&kc->nnext, 1)] = v;
+                        }
+                    }
+                }
+            }
+            pthread_barrier_wait(&kc->barrier);
+
+            // Swap frontiers.
+            if (w->id == 0) {
+                unsigned *tmp = kc->frontier;
+                kc->frontier = kc->next;
+                kc->next = tmp;
+                atomic_store(&kc->nfrontier, atomic_load(&kc->nnext));
+                atomic_store(&kc->nnext, 0);
+                atomic_store(&kc->cursor, 0);
+            }
+            pthread_barrier_wait(&kc->barrier);
+        }
+    }
+
+    return (NULL);
+}
+
+// Computes the core number of each node of a simple graph with parallel
+// peeling: the core number of a node is the largest k such that the node is
+// in a subgraph in which all nodes have degree k or more.
+static void kcore(const struct csr *g, unsigned *cores, size_t nthreads)
+{
+    struct kcore *kc = NULL;
+    int ret = 0;
+
+    assert((nthreads >= 1) && (nthreads <= GRAPH_MAX_THREADS));
+
+    assert((kc = malloc(sizeof(struct kcore))) != NULL);
+    assert((kc->degrees = malloc(g->nnodes * sizeof(atomic_uint))) != NULL);
+    assert((kc->frontier = malloc((g->nnodes + 1) * sizeof(unsigned))) != NULL);
+    assert((kc->next = malloc((g->nnodes + 1) * sizeof(unsigned))) != NULL);
+    for (unsigned u = 0; u < g->nnodes; u++) {
+        atomic_init(&kc->degrees[u], (unsigned)csr_degree(g, u));
+        cores[u] = KCORE_NONE;
+    }
+    kc->g = g;
+    kc->cores = cores;
+    atomic_init(&kc->nfrontier, 0);
+    atomic_init(&kc->nnext, 0);
+    atomic_init(&kc->cursor, 0);
+    kc->nthreads = nthreads;
+
+    ret = pthread_barrier_init(&kc->barrier, NULL, nthreads);
+    assert(ret == 0);
+    for (size_t i = 0; i < nthreads; i++) {
+        const unsigned begin = (unsigned)((size_t)g->nnodes * i / nthreads);
+        const unsigned end = (unsigned)((size_t)g->nnodes * (i + 1) / nthreads);
+        kc->workers[i] = (struct kcore_worker){0, i, kc, begin, end, KCORE_NONE};
+    }
+    for (size_t i = 0; i < nthreads; i++) {
+        ret = pthread_create(&kc->workers[i].thread, NULL, kcore_worker, &kc->workers[i]);
+        assert(ret == 0);
+    }
+    ((void)ret);
+    for (size_t i = 0; i < nthreads; i++) {
+        pthread_join(kc->workers[i].thread, NULL);
+    }
+
+    pthread_barrier_destroy(&kc->barrier);
+    free(kc->next);
+    free(kc->frontier);
+    free(kc->degrees);
+    free(kc);
+}
+
+// Computes the core number of each node of a simple graph with the
+// sequential bucket algorithm of Batagelj and Zaversnik: nodes are kept
+// sorted by degree, and the node with the lowest degree is removed first.
+static void kcore_sequential(const struct csr *g, unsigned *cores)
+{
+    const unsigned n = g->nnodes;
+    unsigned maxdegree = 0;
+    unsigned *bins = NULL;
+    unsigned *order = NULL;
+    unsigned *positions = NULL;
+
+    for (unsigned u = 0; u < n; u++) {
+        cores[u] = (unsigned)csr_degree(g, u);
+        maxdegree = (cores[u] > maxdegree) ? cores[u] : maxdegree;
+    }
+    assert((bins = calloc(maxdegree + 2, sizeof(unsigned))) != NULL);
+    assert((order = malloc((n + 1) * sizeof(unsigned))) != NULL);
+    assert((positions = malloc((n + 1) * sizeof(unsigned))) != NULL);
+
+    // Sort nodes by degree.
+    for (unsigned u = 0; u < n; u++) {
+        bins[cores[u] + 1]++;
+    }
+    for (unsigned d = 0; d <= maxdegree; d++) {
+        bins[d + 1] += bins[d];
+    }
+    for (unsigned u = 0; u < n; u++) {
+        positions[u] = bins[cores[u]]++;
+        order[positions[u]] = u;
+    }
+    for (unsigned d = maxdegree + 1; d > 0; d--) {
+        bins[d] = bins[d - 1];
+    }
+    bins[0] = 0;
+
+    // Remove nodes by increasing degree, and move neighbors to lower bins.
+    for (unsigned i = 0; i < n; i++) {
+        const unsigned u = order[i];
+        for (size_t e = g->offsets[u]; e < g->offsets[u + 1]; e++) {
+            const unsigned v = g->targets[e];
+            if (cores[v] > cores[u]) {
+                const unsigned pv = positions[v];
+                const unsigned pw = bins[cores[v]];
+                const unsigned w = order[pw];
+                if (v != w) {
+                    order[pv] = w, positions[w] = pv;
+                    order[pw] = v, positions[v] = pw;
+                }
+                bins[cores[v]]++;
+                cores[v]--;
+            }
+        }
+    }
+
+    free(positions);
+    free(order);
+    free(bins);
+}
+
+//==============================================================================
+// Test
+//==============================================================================
+
+// Returns the current time in microseconds.
+static double now(void)
+{
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+
+    return (ts.tv_sec * 1000000.0 + ts.tv_nsec / 1000.0);
+}
+
+// Counts triangles in a simple graph naively: for each edge u - v with
+// u < v, neighbors w > v of both u and v are counted.
+static size_t triangle_count_naive(const struct csr *g)
+{
+    size_t ntriangles = 0;
+
+    for (unsigned u = 0; u < g->nnodes; u++) {
+        for (size_t k = g->offsets[u]; k < g->offsets[u + 1]; k++) {
+            const unsigned v = g->targets[k];
+            if (u >= v) {
+                continue;
+            }
+            for (size_t i = g->offsets[u], j = g->offsets[v];
+                 (i < g->offsets[u + 1]) && (j < g->offsets[v + 1]);) {
+                if (g->targets[i] < g->targets[j]) {
+                    i++;
+                } else if (g->targets[i] > g->targets[j]) {
+                    j++;
+                } else {
+                    ntriangles += (g->targets[i] > v);
+                    i++, j++;
+                }
+            }
+        }
+    }
+
+    return (ntriangles);
+}
+
+// Returns the largest out-degree of a sparse graph.
+static size_t csr_max_degree(const struct csr *g)
+{
+    size_t max = 0;
+
+    for (unsigned u = 0; u < g->nnodes; u++) {
+        max = (csr_degree(g, u) > max) ? csr_degree(g, u) : max;
+    }
+
+    return (max);
+}
+
+// Benchmarks triangle counting and k-core decomposition on a simple graph.
+// Results are checked against naive triangle counting on small graphs, and
+// against sequential algorithms otherwise.
+static void test_graph(const struct csr *g)
+{
+    const char *names[] = {"merge", "simd"};
+    const enum intersect_kind kinds[] = {INTERSECT_MERGE, INTERSECT_SIMD};
+    const double nedges = g->nedges / 2.0;
+    size_t expected = 0;
+    unsigned *expected_cores = NULL;
+    unsigned *cores = NULL;
+    unsigned maxcore = 0;
+    struct csr *d = NULL;
+    double tstart = 0.0;
+    double tend = 0.0;
+
+    printf("Graph: %u nodes, %.0lf edges (max degree %zu)\n", g->nnodes, nedges,
+           csr_max_degree(g));
+
+    // Orientation.
+    tstart = now();
+    d = csr_orient(g);
+    tend = now();
+    printf("Orientation: %2.lf us (max out-degree %zu)\n", tend - tstart, csr_max_degree(d));
+
+    // Triangle counting.
+    expected = (g->nnodes <= CHECK_NNODES) ? triangle_count_naive(g)
+                                           : triangle_count(d, INTERSECT_MERGE, 1);
+    for (size_t k = 0; k < sizeof(kinds) / sizeof(kinds[0]); k++) {
+        for (size_t nthreads = 1; nthreads <= GRAPH_MAX_THREADS; nthreads *= GRAPH_MAX_THREADS) {
+            tstart = now();
+            const size_t ntriangles = triangle_count(d, kinds[k], nthreads);
+            tend = now();
+            assert(ntriangles == expected);
+            printf("Triangle counting (%s, %zu threads): %2.lf us (%.1lf M edges/s)\n", names[k],
+                   nthreads, tend - tstart, nedges / (tend - tstart));
+        }
+    }
+    printf("Triangles: %zu (transitivity %.4lf)\n", expected, transitivity(g, expected));
+
+    // k-core decomposition.
+    assert((expected_cores = malloc((g->nnodes + 1) * sizeof(unsigned))) != NULL);
+    assert((cores = malloc((g->nnodes + 1) * sizeof(unsigned))) != NULL);
+    tstart = now();
+    kcore_sequential(g, expected_cores);
+    tend = now();
+    printf("k-core decomposition (sequential): %2.lf us (%.1lf M edges/s)\n", tend - tstart,
+           nedges / (tend - tstart));
+    for (size_t nthreads = 1; nthreads <= GRAPH_MAX_THREADS; nthreads *= GRAPH_MAX_THREADS) {
+        tstart = now();
+        kcore(g, cores, nthreads);
+        tend = now();
+        assert(!memcmp(cores, expected_cores, g->nnodes * sizeof(unsigned)));
+        printf("k-core decomposition (%zu threads): %2.lf us (%.1lf M edges/s)\n", nthreads,
+               tend - tstart, nedges / (tend - tstart));
+    }
+    for (unsigned u = 0; u < g->nnodes; u++) {
+        maxcore = (cores[u] > maxcore) ? cores[u] : maxcore;
+    }
+    printf("Degeneracy: %u\n", maxcore);
+
+    // Release resources.
+    free(cores);
+    free(expected_cores);
+    csr_destroy(d);
+}
+
+// Tests triangle counting and k-core decomposition.
+static void test(unsigned nnodes, bool verbose)
+{
+    struct csr *g = NULL;
+
+    // Fix random number generator seed
+    // to have a determinist behavior across runs.
+    srand(0);
+
+    // Sets with and without common elements.
+    {
+        unsigned a[3 * INTERSECT_LANES];
+        unsigned b[3 * INTERSECT_LANES];
+        for (unsigned i = 0; i < 3 * INTERSECT_LANES; i++) {
+            a[i] = 2 * i;
+            b[i] = 3 * i;
+        }
+        for (size_t na = 0; na <= 3 * INTERSECT_LANES; na++) {
+            for (size_t nb = 0; nb <= 3 * INTERSECT_LANES; nb++) {
+                assert(intersect_simd(a, na, b, nb) == intersect_merge(a, na, b, nb));
+            }
+        }
+        assert(intersect_simd(a, 3 * INTERSECT_LANES, a, 3 * INTERSECT_LANES) ==
+               3 * INTERSECT_LANES);
+    }
+
+    // Small graph, checked against naive triangle counting, and stored in a
+    // binary sparse graph file.
+    {
+        char csr_path[] = "/tmp/triangle-counting-XXXXXX";
+        FILE *f = fdopen(mkstemp(csr_path), "wb");
+        struct csr *loaded = NULL;
+        struct csr *simple = NULL;
+
+        g = csr_create_powerlaw(CHECK_NNODES);
+        if (verbose) {
+            for (unsigned u = 0; u < g->nnodes; u++) {
+                printf("%u:", u);
+                for (size_t k = g->offsets[u]; k < g->offsets[u + 1]; k++) {
+                    printf(" %u", g->targets[k]);
+                }
+                printf("\n");
+            }
+        }
+        test_graph(g);
+
+        assert(f != NULL);
+        csr_write(g, f);
+        fclose(f);
+        assert((loaded = csr_map(csr_path)) != NULL);
+        simple = csr_simplify(loaded);
+        assert(simple->nedges == g->nedges);
+        assert(!memcmp(simple->targets, g->targets, g->nedges * sizeof(unsigned)));
+        csr_destroy(simple);
+        csr_destroy(loaded);
+        unlink(csr_path);
+        csr_destroy(g);
+    }
+
+    // Large power-law graph.
+    g = csr_create_powerlaw(nnodes);
+    test_graph(g);
+    csr_destroy(g);
+}
+
+// Runs triangle counting and k-core decomposition on a graph that is loaded
+// from a binary sparse graph file.
+static void test_loaded(const char *filename)
+{
+    double tstart = 0.0;
+    double tend = 0.0;
+    struct csr *loaded = NULL;
+    struct csr *g = NULL;
+
+    tstart = now();
+    loaded = csr_map(filename);
+    tend = now();
+    if ((loaded == NULL) || (loaded->nnodes == 0)) {
+        fprintf(stderr, "Error: cannot load %s (must be undirected).\n", filename);
+        exit(EXIT_FAILURE);
+    }
+    printf("Loaded %u nodes and %zu edges (%zu bytes): %2.lf us\n", loaded->nnodes,
+           loaded->nedges, loaded->mapping_size, tend - tstart);
+
+    // Sort neighbors, and drop duplicate edges and self-loops.
+    tstart = now();
+    g = csr_simplify(loaded);
+    tend = now();
+    printf("Simplification: %2.lf us\n", tend - tstart);
+
+    test_graph(g);
+
+    // Release resources.
+    csr_destroy(g);
+    csr_destroy(loaded);
+}
+
+//==============================================================================
+// Usage
+//==============================================================================
+
+// Prints program usage and exits.
+static void usage(char *const argv[])
+{
+    printf("%s - Testing program for triangle counting and k-core decomposition.\n", argv[0]);
+    printf("Usage: %s [--verbose] <num_nodes>\n", argv[0]);
+    printf("       %s --graph <undirected graph file>\n", argv[0]);
+    exit(EXIT_FAILURE);
+}
+
+//==============================================================================
+// Main
+//==============================================================================
+
+// Drives the test function.
+int main(int argc, char *const argv[])
+{
+    unsigned nnodes = 0;
+    bool verbose = false;
+
+    // Check for missing arguments.
+    if ((argc < 2) || (argc > 3)) {
+        printf("Error: invalid number of arguments.\n");
+        usage(argv);
+    }
+
+    // Parse command line arguments.
+    if ((argc == 3) && (!strcmp(argv[1], "--graph"))) {
+        test_loaded(argv[2]);
+        return (EXIT_SUCCESS);
+    } else if (argc == 2) {
+        sscanf(argv[1], "%u", &nnodes);
+    } else if ((argc == 3) && (!strcmp(argv[1], "--verbose"))) {
+        sscanf(argv[2], "%u", &nnodes);
+        verbose = true;
+    } else {
+        printf("Error: invalid arguments.\n");
+        usage(argv);
+    }
+
+    // Check for invalid arguments.
+    if (nnodes < 2) {
+        printf("Error: number of nodes must be at least 2.\n");
+        usage(argv);
+    }
+
+    // Run it!
+    test(nnodes, verbose);
+
+    return (EXIT_SUCCESS);
+}
@@ -0,0 +1,694 @@
+// Copyright (C) 2023 Pedro Henrique Penna <pedrohenriquepenna@outlook.com>
+
+#define _POSIX_C_SOURCE 200809L
+
+#include <assert.h>
+#include <fcntl.h>
+#include <inttypes.h>
+#include <pthread.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <time.h>
+#include <unistd.h>
+
+// Magic number of binary sparse graph files ("CSR1").
+#define CSR_MAGIC 0x31525343
+
+// Flag of binary sparse graph files that store each edge in both directions.
+#define CSR_UNDIRECTED 1
+
+// Header of a binary sparse graph file. It is followed by the offsets
+// (nnodes + 1 entries of 64 bits), the targets and the weights (nedges
+// entries of 32 bits each), so that a mapped file is used in place.
+struct csr_header {
+    uint32_t magic;  // Magic number.
+    uint32_t flags;  // Flags.
+    uint64_t nnodes; // Number of nodes.
+    uint64_t nedges; // Number of edges.
+};
+
+// A binary sparse graph file mapped in memory.
+struct csr_file {
+    uint32_t flags;      // Flags.
+    size_t nnodes;       // Number of nodes.
+    size_t nedges;       // Number of edges.
+    uint64_t *offsets;   // Offset of the first edge of each node (nnodes + 1 entries).
+    uint32_t *targets;   // Target node of each edge.
+    uint32_t *weights;   // Weight of each edge.
+    void *mapping;       // Mapped file.
+    size_t mapping_size; // Size of the mapped file.
+};
+
+// Checks the arrays of a graph in compressed sparse row format: offsets
+// must start at zero, never decrease and end at the number of edges, and
+// targets must be valid nodes, so that the graph can be walked without
+// further checks.
+static bool csr_check_arrays(const uint64_t *offsets, const uint32_t *targets, uint64_t nnodes,
+                             uint64_t nedges)
+{
+    // Check offsets.
+    if ((offsets[0] != 0) || (offsets[nnodes] != nedges)) {
+        return (false);
+    }
+    for (uint64_t u = 0; u < nnodes; u++) {
+        if (offsets[u] > offsets[u + 1]) {
+            return (false);
+        }
+    }
+
+    // Check targets.
+    for (uint64_t k = 0; k < nedges; k++) {
+        if (targets[k] >= nnodes) {
+            return (false);
+        }
+    }
+
+    return (true);
+}
+
+// Checks the contents of a mapped binary sparse graph file. Sizes are
+// checked without overflowing before arrays are checked.
+static bool csr_file_check(const void *mapping, size_t size)
+{
+    const struct csr_header *h = mapping;
+    const uint64_t *offsets = (const uint64_t *)(h + 1);
+    size_t remaining = 0;
+
+    // Check header.
+    if ((size < sizeof(struct csr_header)) || (h->magic != CSR_MAGIC)) {
+        return (false);
+    }
+
+    // Check sizes. Targets are 32-bit node numbers.
+    remaining = size - sizeof(struct csr_header);
+    if ((h->nnodes > (uint64_t)UINT32_MAX + 1) || (h->nnodes >= remaining / sizeof(uint64_t))) {
+        return (false);
+    }
+    remaining -= (h->nnodes + 1) * sizeof(uint64_t);
+    if ((h->nedges > remaining / (2 * sizeof(uint32_t))) ||
+        (remaining != h->nedges * 2 * sizeof(uint32_t))) {
+        return (false);
+    }
+
+    return (csr_check_arrays(offsets, (const uint32_t *)(offsets + h->nnodes + 1), h->nnodes,
+                             h->nedges));
+}
+
+// Maps a binary sparse graph file in memory. No data is copied: the graph
+// points into the mapping. Returns false if the file cannot be mapped or
+// is malformed.
+static bool csr_file_map(struct csr_file *f, const char *path)
+{
+    int fd = -1;
+    struct stat st;
+    const struct csr_header *h = NULL;
+
+    if ((fd = open(path, O_RDONLY)) < 0) {
+        return (false);
+    }
+    if ((fstat(fd, &st) < 0) || ((size_t)st.st_size < sizeof(struct csr_header))) {
+        close(fd);
+        return (false);
+    }
+
+    f->mapping_size = (size_t)st.st_size;
+    f->mapping = mmap(NULL, f->mapping_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (f->mapping == MAP_FAILED) {
+        return (false);
+    }
+
+    if (!csr_file_check(f->mapping, f->mapping_size)) {
+        munmap(f->mapping, f->mapping_size);
+        return (false);
+    }
+
+    h = f->mapping;
+    f->flags = h->flags;
+    f->nnodes = h->nnodes;
+    f->nedges = h->nedges;
+    f->offsets = (uint64_t *)(h + 1);
+    f->targets = (uint32_t *)(f->offsets + f->nnodes + 1);
+    f->weights = f->targets + f->nedges;
+
+    return (true);
+}
+
+// Unmaps a binary sparse graph file.
+static void csr_file_unmap(struct csr_file *f)
+{
+    munmap(f->mapping, f->mapping_size);
+}
+
+// Max number of parser threads.
+#define LOADER_MAX_THREADS 8
+
+// Number of edges per node in the test graph.
+#define EDGES_PER_NODE 10
+
+//==============================================================================
+// Edge List
+//==============================================================================
+
+// A weighted edge.
+struct edge {
+    uint32_t u;      // Source node.
+    uint32_t v;      // Target node.
+    uint32_t weight; // Weight.
+};
+
+// A list of edges.
+struct edge_list {
+    uint64_t nnodes;    // Number of nodes.
+    size_t nedges;      // Number of edges.
+    size_t capacity;    // Max number of edges.
+    struct edge *edges; // Edges.
+};
+
+// Initializes an empty edge list.
+static void edge_list_init(struct edge_list *el)
+{
+    el->nnodes = 0;
+    el->nedges = 0;
+    el->capacity = 1024;
+    assert((el->edges = malloc(el->capacity * sizeof(struct edge))) != NULL);
+}
+
+// Appends an edge to an edge list.
+static void edge_list_append(struct edge_list *el, struct edge e)
+{
+    // Grow edge list.
+    if (el->nedges == el->capacity) {
+        el->capacity *= 2;
+        assert((el->edges = realloc(el->edges, el->capacity * sizeof(struct edge))) != NULL);
+    }
+
+    el->edges[el->nedges++] = e;
+    if (e.u >= el->nnodes) {
+        el->nnodes = (uint64_t)e.u + 1;
+    }
+    if (e.v >= el->nnodes) {
+        el->nnodes = (uint64_t)e.v + 1;
+    }
+}
+
+//==============================================================================
+// Edge List Parser
+//==============================================================================
+
+// Parses an unsigned decimal number and advances the cursor. Returns false
+// if no digit is found before the end of the line.
+static bool parse_number(const char **cursor, const char *end, uint64_t *number)
+{
+    const char *p = *cursor;
+
+    // Skip blanks.
+    while ((p < end) && ((*p == ' ') || (*p == '\t'))) {
+        p++;
+    }
+
+    // No number.
+    if ((p == end) || (*p < '0') || (*p > '9')) {
+        *cursor = p;
+        return (false);
+    }
+
+    *number = 0;
+    while ((p < end) && (*p >= '0') && (*p <= '9')) {
+        const uint64_t digit = (uint64_t)(*p - '0');
+
+        // Overflow.
+        if (*number > (UINT64_MAX - digit) / 10) {
+            *cursor = p;
+            return (false);
+        }
+
+        *number = *number * 10 + digit;
+        p++;
+    }
+    *cursor = p;
+
+    return (true);
+}
+
+// Parses one line of an edge list. SNAP lines are "u v [weight]" and
+// comments start with '#'. DIMACS lines are "a u v weight" with nodes
+// numbered from one, comments start with 'c' and the problem line with 'p'.
+static void parse_line(const char *p, const char *end, struct edge_list *el)
+{
+    uint64_t u = 0;
+    uint64_t v = 0;
+    uint64_t w = 1;
+    uint64_t base = 0;
+
+    // Skip blanks.
+    while ((p < end) && ((*p == ' ') || (*p == '\t'))) {
+        p++;
+    }
+
+    // Skip empty lines and comments.
+    if ((p == end) || (*p == '#') || (*p == '%') || (*p == 'c') || (*p == '\r')) {
+        return;
+    }
+
+    // DIMACS problem line: p sp <nnodes> <nedges>.
+    if (*p == 'p') {
+        p++;
+        while ((p < end) && (*p != ' ')) {
+            p++;
+        }
+        while ((p < end) && (*p == ' ')) {
+            p++;
+        }
+        while ((p < end) && (*p != ' ')) {
+            p++;
+        }
+        if (parse_number(&p, end, &u) && (u > el->nnodes) && (u <= (uint64_t)UINT32_MAX + 1)) {
+            el->nnodes = u;
+        }
+        return;
+    }
+
+    // DIMACS arc.
+    if (*p == 'a') {
+        p++;
+        base = 1;
+    }
+
+    // Skip malformed lines, and nodes or weights that do not fit in 32 bits.
+    if (!parse_number(&p, end, &u) || !parse_number(&p, end, &v) || (u < base) || (v < base) ||
+        (u - base > UINT32_MAX) || (v - base > UINT32_MAX)) {
+        return;
+    }
+    if (!parse_number(&p, end, &w) && (p < end) && (*p >= '0') && (*p <= '9')) {
+        return;
+    }
+    if (w > UINT32_MAX) {
+        return;
+    }
+
+    edge_list_append(el, (struct edge){(uint32_t)(u - base), (uint32_t)(v - base), (uint32_t)w});
+}
+
+// Arguments of a parser thread.
+struct parser {
+    pthread_t thread;    // Thread.
+    const char *begin;   // First character to parse.
+    const char *end;     // Last character to parse (exclusive).
+    struct edge_list el; // Parsed edges.
+};
+
+// Parses a chunk of lines.
+static void *parser(void *arg)
+{
+    struct parser *w = arg;
+    const char *p = w->begin;
+
+    edge_list_init(&w->el);
+
+    while (p < w->end) {
+        const char *eol = memchr(p, '\n', (size_t)(w->end - p));
+        if (eol == NULL) {
+            eol = w->end;
+        }
+        parse_line(p, eol, &w->el);
+        p = eol + 1;
+    }
+
+    return (NULL);
+}
+
+// Parses an edge list in memory with several threads. The text is split in
+// chunks that end at line boundaries, and each thread parses one chunk.
+static void parse(const char *text, size_t length, size_t nthreads, struct edge_list *el)
+{
+    struct parser workers[LOADER_MAX_THREADS];
+    const char *begin = text;
+
+    assert((nthreads > 0) && (nthreads <= LOADER_MAX_THREADS));
+
+    for (size_t i = 0; i < nthreads; i++) {
+        const char *end = text + (length * (i + 1)) / nthreads;
+
+        // Move the end of the chunk to the end of the line.
+        if (end < begin) {
+            end = begin;
+        }
+        while ((end < text + length) && (end > text) && (end[-1] != '\n')) {
+            end++;
+        }
+
+        workers[i].begin = begin;
+        workers[i].end = end;
+        int ret = pthread_create(&workers[i].thread, NULL, parser, &workers[i]);
+        assert(ret == 0);
+        ((void)ret);
+        begin = end;
+    }
+
+    // Concatenate edges in chunk order.
+    el->nnodes = 0;
+    el->nedges = 0;
+    el->capacity = 0;
+    for (size_t i = 0; i < nthreads; i++) {
+        pthread_join(workers[i].thread, NULL);
+        el->capacity += workers[i].el.nedges;
+    }
+    assert((el->edges = malloc(el->capacity * sizeof(struct edge) + 1)) != NULL);
+    for (size_t i = 0; i < nthreads; i++) {
+        memcpy(&el->edges[el->nedges], workers[i].el.edges,
+               workers[i].el.nedges * sizeof(struct edge));
+        el->nedges += workers[i].el.nedges;
+        if (workers[i].el.nnodes > el->nnodes) {
+            el->nnodes = workers[i].el.nnodes;
+        }
+        free(workers[i].el.edges);
+    }
+}
+
+//==============================================================================
+// Binary Sparse Graph
+//==============================================================================
+
+// Writes an edge list to a binary sparse graph file.
+static void csr_write(const struct edge_list *el, bool undirected, FILE *f)
+{
+    struct csr_header h = {CSR_MAGIC, undirected ? CSR_UNDIRECTED : 0, el->nnodes, 0};
+    uint64_t *offsets = calloc(el->nnodes + 1, sizeof(uint64_t));
+    uint32_t *targets = NULL;
+    uint32_t *weights = NULL;
+
+    assert(offsets != NULL);
+
+    // Count degrees, shifted by one node.
+    h.nedges = undirected ? 2 * el->nedges : el->nedges;
+    for (size_t i = 0; i < el->nedges; i++) {
+        offsets[el->edges[i].u + 1]++;
+        if (undirected) {
+            offsets[el->edges[i].v + 1]++;
+        }
+    }
+    for (uint64_t i = 0; i < el->nnodes; i++) {
+        offsets[i + 1] += offsets[i];
+    }
+
+    // Place edges, using the first offset of each node as cursor.
+    assert((targets = malloc(h.nedges * sizeof(uint32_t) + 1)) != NULL);
+    assert((weights = malloc(h.nedges * sizeof(uint32_t) + 1)) != NULL);
+    for (size_t i = 0; i < el->nedges; i++) {
+        const struct edge *e = &el->edges[i];
+        uint64_t k = offsets[e->u]++;
+        targets[k] = e->v, weights[k] = e->weight;
+        if (undirected) {
+            k = offsets[e->v]++;
+            targets[k] = e->u, weights[k] = e->weight;
+        }
+    }
+
+    // Cursors now point to the next row, so shift them back.
+    for (uint64_t i = el->nnodes; i > 0; i--) {
+        offsets[i] = offsets[i - 1];
+    }
+    offsets[0] = 0;
+
+    assert(fwrite(&h, sizeof(h), 1, f) == 1);
+    assert(fwrite(offsets, sizeof(uint64_t), el->nnodes + 1, f) == el->nnodes + 1);
+    assert(fwrite(targets, sizeof(uint32_t), h.nedges, f) == h.nedges);
+    assert(fwrite(weights, sizeof(uint32_t), h.nedges, f) == h.nedges);
+
+    free(weights);
+    free(targets);
+    free(offsets);
+}
+
+//==============================================================================
+// Conversion
+//==============================================================================
+
+// Returns the current time in microseconds.
+static double now(void)
+{
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+
+    return (ts.tv_sec * 1000000.0 + ts.tv_nsec / 1000.0);
+}
+
+// Maps a text file in memory.
+static const char *text_map(const char *path, size_t *length)
+{
+    int fd = -1;
+    struct stat st;
+    void *text = NULL;
+
+    if ((fd = open(path, O_RDONLY)) < 0) {
+        return (NULL);
+    }
+    if ((fstat(fd, &st) < 0) || (st.st_size == 0)) {
+        close(fd);
+        return (NULL);
+    }
+    *length = (size_t)st.st_size;
+    text = mmap(NULL, *length, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+
+    return ((text == MAP_FAILED) ? NULL : text);
+}
+
+// Converts an edge list text file to a binary sparse graph file.
+static int convert(const char *input, const char *output, bool undirected, size_t nthreads)
+{
+    size_t length = 0;
+    double tstart = 0.0;
+    double tend = 0.0;
+    struct edge_list el;
+    const char *text = text_map(input, &length);
+    FILE *f = NULL;
+
+    if (text == NULL) {
+        fprintf(stderr, "Error: cannot read %s.\n", input);
+        return (EXIT_FAILURE);
+    }
+    if ((f = fopen(output, "wb")) == NULL) {
+        fprintf(stderr, "Error: cannot write %s.\n", output);
+        munmap((void *)text, length);
+        return (EXIT_FAILURE);
+    }
+
+    tstart = now();
+    parse(text, length, nthreads, &el);
+    tend = now();
+    printf("%12s: %2.lf us (%zu threads)\n", "parse()", tend - tstart, nthreads);
+
+    tstart = now();
+    csr_write(&el, undirected, f);
+    fclose(f);
+    tend = now();
+    printf("%12s: %2.lf us\n", "csr_write()", tend - tstart);
+    printf("%" PRIu64 " nodes, %zu edges\n", el.nnodes, el.nedges);
+
+    free(el.edges);
+    munmap((void *)text, length);
+
+    return (EXIT_SUCCESS);
+}
+
+//==============================================================================
+// Test
+//==============================================================================
+
+// Tests the loader on a random graph.
+static void test(size_t nnodes, bool verbose)
+{
+    char text_path[] = "/tmp/loader-XXXXXX";
+    char csr_path[] = "/tmp/loader-XXXXXX";
+    size_t nedges = (nnodes > 0) ? EDGES_PER_NODE * nnodes : 0;
+    size_t length = 0;
+    double tstart = 0.0;
+    double tend = 0.0;
+    struct edge_list el;
+    struct edge *edges = malloc(nedges * sizeof(struct edge) + 1);
+    FILE *f = NULL;
+    const char *text = NULL;
+    struct csr_file g;
+
+    assert(edges != NULL);
+
+    // Fix random number generator seed
+    // to have a determinist behavior across runs.
+    srand(0);
+
+    // Write a random graph. Odd edges use the DIMACS syntax.
+    assert((f = fdopen(mkstemp(text_path), "w")) != NULL);
+    fprintf(f, "# Random graph\n");
+    fprintf(f, "p sp %zu %zu\n", nnodes, nedges);
+    for (size_t i = 0; i < nedges; i++) {
+        edges[i].u = (uint32_t)((size_t)rand() % nnodes);
+        edges[i].v = (uint32_t)((size_t)rand() % nnodes);
+        edges[i].weight = 1 + (uint32_t)(rand() % 100);
+        if (i % 2) {
+            fprintf(f, "a %u %u %u\n", edges[i].u + 1, edges[i].v + 1, edges[i].weight);
+        } else {
+            fprintf(f, "%u\t%u %u\n", edges[i].u, edges[i].v, edges[i].weight);
+        }
+    }
+    fclose(f);
+
+    // Nodes and weights that do not fit in 32 bits are rejected.
+    {
+        const char bad[] = "4294967296 1\n1 4294967296\na 4294967297 1 1\n"
+                           "1 2 4294967296\n1 2 99999999999999999999\n2 3 4\n";
+        parse(bad, sizeof(bad) - 1, 1, &el);
+        assert((el.nedges == 1) && (el.nnodes == 4));
+        assert((el.edges[0].u == 2) && (el.edges[0].v == 3) && (el.edges[0].weight == 4));
+        free(el.edges);
+    }
+
+    text = text_map(text_path, &length);
+    assert(text != NULL);
+    if (verbose) {
+        printf("%zu bytes of text\n", length);
+    }
+
+    // Parse with several threads: edges must come out in order.
+    for (size_t nthreads = 1; nthreads <= LOADER_MAX_THREADS; nthreads *= 2) {
+        tstart = now();
+        parse(text, length, nthreads, &el);
+        tend = now();
+        printf("%12s: %2.lf us (%zu threads)\n", "parse()", tend - tstart, nthreads);
+
+        assert((el.nnodes == nnodes) && (el.nedges == nedges));
+        assert((nedges == 0) || !memcmp(el.edges, edges, nedges * sizeof(struct edge)));
+        if (nthreads < LOADER_MAX_THREADS) {
+            free(el.edges);
+        }
+    }
+    munmap((void *)text, length);
+
+    // Convert and map.
+    assert((f = fdopen(mkstemp(csr_path), "wb")) != NULL);
+    tstart = now();
+    csr_write(&el, false, f);
+    fclose(f);
+    tend = now();
+    printf("%12s: %2.lf us\n", "csr_write()", tend - tstart);
+
+    tstart = now();
+    assert(csr_file_map(&g, csr_path));
+    tend = now();
+    printf("%12s: %2.lf us (%zu bytes, %.1lf bytes/edge)\n", "csr_map()", tend - tstart,
+           g.mapping_size, (double)g.mapping_size / ((nedges > 0) ? nedges : 1));
+
+    // Every edge must be in the row of its source.
+    assert((g.nnodes == nnodes) && (g.nedges == nedges));
+    for (size_t i = 0; i < nedges; i++) {
+        bool found = false;
+        for (uint64_t k = g.offsets[edges[i].u]; k < g.offsets[edges[i].u + 1]; k++) {
+            if ((g.targets[k] == edges[i].v) && (g.weights[k] == edges[i].weight)) {
+                found = true;
+                break;
+            }
+        }
+        assert(found);
+        ((void)found);
+    }
+
+    // Corrupted files must be rejected.
+    if (nnodes > 1) {
+        char *bytes = NULL;
+        struct csr_header *h = NULL;
+        uint64_t *offsets = NULL;
+        uint32_t *targets = NULL;
+        assert((bytes = malloc(g.mapping_size)) != NULL);
+        h = (struct csr_header *)bytes;
+        offsets = (uint64_t *)(h + 1);
+        targets = (uint32_t *)(offsets + nnodes + 1);
+        for (size_t i = 0; i < 4; i++) {
+            memcpy(bytes, g.mapping, g.mapping_size);
+            switch (i) {
+                case 0:
+                    h->nedges = nedges + (UINT64_C(1) << 61);
+                    break;
+                case 1:
+                    offsets[1] = offsets[2] + 1;
+                    break;
+                case 2:
+                    offsets[nnodes] = nedges + 1;
+                    break;
+                default:
+                    targets[0] = (uint32_t)nnodes;
+                    break;
+            }
+            assert(!csr_file_check(bytes, g.mapping_size));
+        }
+        free(bytes);
+    }
+
+    // Release resources.
+    csr_file_unmap(&g);
+    unlink(csr_path);
+    unlink(text_path);
+    free(el.edges);
+    free(edges);
+}
+
+//==============================================================================
+// Usage
+//==============================================================================
+
+// Prints program usage and exits.
+static void usage(char *const argv[])
+{
+    printf("%s - Edge list to binary sparse graph converter.\n", argv[0]);
+    printf("Usage: %s [--verbose] <num_nodes>\n", argv[0]);
+    printf("       %s --convert [--undirected] <edge list file> <graph file>\n", argv[0]);
+    exit(EXIT_FAILURE);
+}
+
+//==============================================================================
+// Main
+//==============================================================================
+
+// Drives the test function.
+int main(int argc, char *const argv[])
+{
+    size_t nnodes = 0;
+    bool verbose = false;
+    long ncpus = sysconf(_SC_NPROCESSORS_ONLN);
+    size_t nthreads = (ncpus < 1) ? 1 : (ncpus > LOADER_MAX_THREADS) ? LOADER_MAX_THREADS
+                                                                      : (size_t)ncpus;
+
+    // Check for missing arguments.
+    if ((argc < 2) || (argc > 5)) {
+        printf("Error: invalid number of arguments.\n");
+        usage(argv);
+    }
+
+    // Parse command line arguments.
+    if ((argc == 4) && (!strcmp(argv[1], "--convert"))) {
+        return (convert(argv[2], argv[3], false, nthreads));
+    } else if ((argc == 5) && (!strcmp(argv[1], "--convert")) &&
+               (!strcmp(argv[2], "--undirected"))) {
+        return (convert(argv[3], argv[4], true, nthreads));
+    } else if (argc == 2) {
+        sscanf(argv[1], "%zu", &nnodes);
+    } else if ((argc == 3) && (!strcmp(argv[1], "--verbose"))) {
+        sscanf(argv[2], "%zu", &nnodes);
+        verbose = true;
+    } else {
+        printf("Error: invalid arguments.\n");
+        usage(argv);
+    }
+
+    // Run it!
+    test(nnodes, verbose);
+
+    return (EXIT_SUCCESS);
+}
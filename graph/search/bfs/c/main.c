@@ -1,12 +1,22 @@
 // Copyright (C) 2022 Pedro Henrique Penna <pedrohenriquepenna@outlook.com>
 
+#define _POSIX_C_SOURCE 200809L
+
 #include <assert.h>
+#include <fcntl.h>
 #include <stdbool.h>
 #include <stddef.h>
+#include <stdint.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
 #include <time.h>
+#include <unistd.h>
+
+// Magic number of binary sparse graph files ("CSR1").
+#define CSR_MAGIC 0x31525343
 
 //==============================================================================
 // Graph Data Structure
@@ -76,19 +86,188 @@ static void graph_print(const struct graph *g, FILE *f)
         precision += 1;
     }
     fprintf(f, "graph {\n");
-    fprintf(f, "nnodes: %d,\n", g->nnodes);
+    fprintf(f, "nnodes: %zu,\n", g->nnodes);
     fprintf(f, "links: \n");
     for (size_t i = 0; i < g->nnodes; i++) {
         fprintf(f, " [ ");
         for (size_t j = 0; j < g->nnodes; j++) {
             const struct link *l = graph_link(g, i, j);
-            fprintf(f, "%*u ", precision, l->weight);
+            fprintf(f, "%*u ", (int)precision, l->weight);
         }
         fprintf(f, "]\n");
     }
     fprintf(f, "}\n");
 }
 
+//==============================================================================
+// Sparse Graph Data Structure
+//==============================================================================
+
+// Header of a binary sparse graph file, as written by graph/loader. It is
+// followed by the offsets (nnodes + 1 entries of 64 bits), the targets and
+// the weights (nedges entries of 32 bits each).
+struct csr_header {
+    uint32_t magic;  // Magic number.
+    uint32_t flags;  // Flags.
+    uint64_t nnodes; // Number of nodes.
+    uint64_t nedges; // Number of edges.
+};
+
+// A sparse graph in compressed sparse row format, mapped from a file.
+struct csr {
+    size_t nnodes;       // Number of nodes.
+    size_t nedges;       // Number of edges.
+    uint64_t *offsets;   // Offset of the first edge of each node (nnodes + 1 entries).
+    uint32_t *targets;   // Target node of each edge.
+    uint32_t *weights;   // Weight of each edge.
+    void *mapping;       // Mapped file.
+    size_t mapping_size; // Size of the mapped file.
+};
+
+// Checks the arrays of a graph in compressed sparse row format: offsets
+// must start at zero, never decrease and end at the number of edges, and
+// targets must be valid nodes, so that the graph can be walked without
+// further checks.
+static bool csr_check_arrays(const uint64_t *offsets, const uint32_t *targets, uint64_t nnodes,
+                             uint64_t nedges)
+{
+    // Check offsets.
+    if ((offsets[0] != 0) || (offsets[nnodes] != nedges)) {
+        return (false);
+    }
+    for (uint64_t u = 0; u < nnodes; u++) {
+        if (offsets[u] > offsets[u + 1]) {
+            return (false);
+        }
+    }
+
+    // Check targets.
+    for (uint64_t k = 0; k < nedges; k++) {
+        if (targets[k] >= nnodes) {
+            return (false);
+        }
+    }
+
+    return (true);
+}
+
+// Checks the contents of a mapped binary sparse graph file. Sizes are
+// checked without overflowing before arrays are checked.
+static bool csr_check(const void *mapping, size_t size)
+{
+    const struct csr_header *h = mapping;
+    const uint64_t *offsets = (const uint64_t *)(h + 1);
+    size_t remaining = 0;
+
+    // Check header.
+    if ((size < sizeof(struct csr_header)) || (h->magic != CSR_MAGIC)) {
+        return (false);
+    }
+
+    // Check sizes. Targets are 32-bit node numbers.
+    remaining = size - sizeof(struct csr_header);
+    if ((h->nnodes > (uint64_t)UINT32_MAX + 1) || (h->nnodes >= remaining / sizeof(uint64_t))) {
+        return (false);
+    }
+    remaining -= (h->nnodes + 1) * sizeof(uint64_t);
+    if ((h->nedges > remaining / (2 * sizeof(uint32_t))) ||
+        (remaining != h->nedges * 2 * sizeof(uint32_t))) {
+        return (false);
+    }
+
+    return (csr_check_arrays(offsets, (const uint32_t *)(offsets + h->nnodes + 1), h->nnodes,
+                             h->nedges));
+}
+
+// Maps a binary sparse graph file in memory. No data is copied: the graph
+// points into the mapping, and pages are loaded on first access. Malformed
+// files are rejected.
+static struct csr *csr_map(const char *path)
+{
+    int fd = -1;
+    struct stat st;
+    struct csr *g = NULL;
+    const struct csr_header *h = NULL;
+
+    if ((fd = open(path, O_RDONLY)) < 0) {
+        return (NULL);
+    }
+    if ((fstat(fd, &st) < 0) || ((size_t)st.st_size < sizeof(struct csr_header))) {
+        close(fd);
+        return (NULL);
+    }
+
+    assert((g = malloc(sizeof(struct csr))) != NULL);
+    g->mapping_size = (size_t)st.st_size;
+    g->mapping = mmap(NULL, g->mapping_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (g->mapping == MAP_FAILED) {
+        free(g);
+        return (NULL);
+    }
+
+    // Check contents.
+    h = g->mapping;
+    if (!csr_check(g->mapping, g->mapping_size)) {
+        munmap(g->mapping, g->mapping_size);
+        free(g);
+        return (NULL);
+    }
+
+    g->nnodes = h->nnodes;
+    g->nedges = h->nedges;
+    g->offsets = (uint64_t *)(h + 1);
+    g->targets = (uint32_t *)(g->offsets + g->nnodes + 1);
+    g->weights = g->targets + g->nedges;
+
+    return (g);
+}
+
+// Unmaps a binary sparse graph file.
+static void csr_unmap(struct csr *g)
+{
+    munmap(g->mapping, g->mapping_size);
+    free(g);
+}
+
+// Writes a graph stored as an adjacency matrix to a binary sparse graph file.
+static void csr_write_graph(const struct graph *g, uint32_t flags, FILE *f)
+{
+    struct csr_header h = {CSR_MAGIC, flags, g->nnodes, 0};
+    uint64_t offset = 0;
+
+    // Count edges.
+    for (size_t i = 0; i < g->nnodes * g->nnodes; i++) {
+        h.nedges += (g->links[i].weight > 0);
+    }
+    assert(fwrite(&h, sizeof(h), 1, f) == 1);
+
+    // Offsets.
+    for (size_t i = 0; i < g->nnodes; i++) {
+        assert(fwrite(&offset, sizeof(offset), 1, f) == 1);
+        for (size_t j = 0; j < g->nnodes; j++) {
+            offset += (graph_link(g, i, j)->weight > 0);
+        }
+    }
+    assert(fwrite(&offset, sizeof(offset), 1, f) == 1);
+
+    // Targets.
+    for (size_t i = 0; i < g->nnodes * g->nnodes; i++) {
+        uint32_t target = i % g->nnodes;
+        if (g->links[i].weight > 0) {
+            assert(fwrite(&target, sizeof(target), 1, f) == 1);
+        }
+    }
+
+    // Weights.
+    for (size_t i = 0; i < g->nnodes * g->nnodes; i++) {
+        uint32_t weight = g->links[i].weight;
+        if (weight > 0) {
+            assert(fwrite(&weight, sizeof(weight), 1, f) == 1);
+        }
+    }
+}
+
 //==============================================================================
 // Queue Data Structure
 //==============================================================================
@@ -218,6 +397,50 @@ static size_t bfs(const struct graph *g, size_t source, size_t *path)
     return (path_length);
 }
 
+// Performs a breadth-first search in a sparse graph.
+static size_t bfs_sparse(const struct csr *g, size_t source, size_t *path)
+{
+    size_t path_length = 0;
+    struct queue *q = NULL;
+    bool *visited = calloc(g->nnodes, sizeof(bool));
+
+    assert(visited != NULL);
+    assert((q = queue_create(g->nnodes)) != NULL);
+
+    // Push source node.
+    queue_push_back(q, source);
+    visited[source] = true;
+
+    // Process all nodes that in the queue.
+    while (queue_length(q) != 0) {
+        size_t i = queue_pop_front(q);
+
+        // Add this node to the path.
+        path[path_length++] = i;
+
+        // Enqueue all non-visited neighbor nodes.
+        for (uint64_t k = g->offsets[i]; k < g->offsets[i + 1]; k++) {
+            size_t j = g->targets[k];
+
+            // This neighbor was visited.
+            if (visited[j]) {
+                continue;
+            }
+
+            // Enqueue this node for later
+            // processing and mark it as visited.
+            queue_push_back(q, j);
+            visited[j] = true;
+        }
+    }
+
+    // Release resources.
+    queue_destroy(q);
+    free(visited);
+
+    return (path_length);
+}
+
 //==============================================================================
 // Test
 //==============================================================================
@@ -269,10 +492,61 @@ static void test(size_t nnodes, bool verbose)
         printf("NULL\n");
     }
 
+    // Search in a sparse graph mapped from a file.
+    if (nnodes > 0) {
+        char csr_path[] = "/tmp/bfs-XXXXXX";
+        FILE *f = fdopen(mkstemp(csr_path), "wb");
+        assert(f != NULL);
+        csr_write_graph(g, 0, f);
+        fclose(f);
+        struct csr *sg = csr_map(csr_path);
+        assert(sg != NULL);
+        size_t sparse_path[nnodes];
+        tstart = clock();
+        size_t sparse_path_length = bfs_sparse(sg, 0, sparse_path);
+        tend = clock();
+        printf("Breadth-First Search (sparse): %2.lf us\n", (tend - tstart) / MICROSECS);
+        assert(sparse_path_length == path_length);
+        assert(!memcmp(path, sparse_path, path_length * sizeof(size_t)));
+        csr_unmap(sg);
+        unlink(csr_path);
+    }
+
     // Release graph.
     graph_destroy(g);
 }
 
+// Runs a breadth-first search on a graph that is loaded from a binary sparse graph file.
+static void test_loaded(const char *filename)
+{
+    double tstart = 0.0;
+    double tend = 0.0;
+    const double MICROSECS = ((CLOCKS_PER_SEC / 1000000.0));
+    struct csr *g = NULL;
+    size_t *path = NULL;
+    size_t path_length = 0;
+
+    tstart = clock();
+    g = csr_map(filename);
+    tend = clock();
+    if ((g == NULL) || (g->nnodes == 0)) {
+        fprintf(stderr, "Error: cannot load %s.\n", filename);
+        exit(EXIT_FAILURE);
+    }
+    printf("Loaded %zu nodes and %zu edges (%zu bytes): %2.lf us\n", g->nnodes, g->nedges,
+           g->mapping_size, (tend - tstart) / MICROSECS);
+
+    assert((path = malloc(g->nnodes * sizeof(size_t))) != NULL);
+    tstart = clock();
+    path_length = bfs_sparse(g, 0, path);
+    tend = clock();
+    printf("Breadth-First Search: %2.lf us (%zu nodes reached)\n", (tend - tstart) / MICROSECS,
+           path_length);
+
+    free(path);
+    csr_unmap(g);
+}
+
 //==============================================================================
 // Usage
 //==============================================================================
@@ -282,6 +556,7 @@ static void usage(char *const argv[])
 {
     printf("%s - Testing program for breadth-first search.\n", argv[0]);
     printf("Usage: %s [--verbose] <>\num_nodes n", argv[0]);
+    printf("       %s --graph <graph file>\n", argv[0]);
     exit(EXIT_FAILURE);
 }
 
@@ -302,7 +577,10 @@ int main(int argc, char *const argv[])
     }
 
     // Parse command line arguments.
-    if (argc == 2) {
+    if ((argc == 3) && (!strcmp(argv[1], "--graph"))) {
+        test_loaded(argv[2]);
+        return (EXIT_SUCCESS);
+    } else if (argc == 2) {
         sscanf(argv[1], "%zu", &nnodes);
     } else if ((argc == 3) && (!strcmp(argv[1], "--verbose"))) {
         sscanf(argv[2], "%zu", &nnodes);
@@ -1,12 +1,34 @@
 // Copyright (C) 2022 Pedro Henrique Penna <pedrohenriquepenna@outlook.com>
 
+#define _POSIX_C_SOURCE 200809L
+
 #include <assert.h>
+#include <fcntl.h>
 #include <stdbool.h>
 #include <stddef.h>
+#include <stdint.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
 #include <time.h>
+#include <unistd.h>
+
+// Magic number of binary sparse graph files ("CSR1").
+#define CSR_MAGIC 0x31525343
+
+// Flag of binary sparse graph files that store each edge in both directions.
+#define CSR_UNDIRECTED 1
+
+// Null node in a sparse graph.
+#define DFS_NONE UINT32_MAX
+
+// Number of edges per node in the sparse graph benchmark.
+#define EDGES_PER_NODE 10
+
+// Max number of nodes for brute-force checks.
+#define BRUTE_FORCE_NNODES 256
 
 //==============================================================================
 // Graph Data Structure
@@ -76,13 +98,13 @@ static void graph_print(const struct graph *g, FILE *f)
         precision += 1;
     }
     fprintf(f, "graph {\n");
-    fprintf(f, "nnodes: %d,\n", g->nnodes);
+    fprintf(f, "nnodes: %zu,\n", g->nnodes);
     fprintf(f, "links: \n");
     for (size_t i = 0; i < g->nnodes; i++) {
         fprintf(f, " [ ");
         for (size_t j = 0; j < g->nnodes; j++) {
             const struct link *l = graph_link(g, i, j);
-            fprintf(f, "%*u ", precision, l->weight);
+            fprintf(f, "%*u ", (int)precision, l->weight);
         }
         fprintf(f, "]\n");
     }
@@ -249,10 +271,742 @@ static size_t dfs(const struct graph *g, size_t source, size_t *path)
     return (path_length);
 }
 
+//==============================================================================
+// Bitset Data Structure
+//==============================================================================
+
+// A fixed-size set of bits.
+struct bitset {
+    size_t nbits;    // Number of bits.
+    uint64_t *words; // Words.
+};
+
+// Creates a bitset with all bits cleared.
+static struct bitset *bitset_create(size_t nbits)
+{
+    struct bitset *b = malloc(sizeof(struct bitset));
+    assert(b != NULL);
+
+    b->nbits = nbits;
+    assert((b->words = calloc((nbits + 63) / 64, sizeof(uint64_t))) != NULL);
+
+    return (b);
+}
+
+// Destroys a bitset.
+static void bitset_destroy(struct bitset *b)
+{
+    free(b->words);
+    free(b);
+}
+
+// Clears all bits of a bitset.
+static void bitset_clear_all(struct bitset *b)
+{
+    memset(b->words, 0, ((b->nbits + 63) / 64) * sizeof(uint64_t));
+}
+
+// Tests a bit of a bitset.
+static bool bitset_test(const struct bitset *b, size_t i)
+{
+    return ((b->words[i / 64] >> (i % 64)) & 1);
+}
+
+// Sets a bit of a bitset.
+static void bitset_set(struct bitset *b, size_t i)
+{
+    b->words[i / 64] |= UINT64_C(1) << (i % 64);
+}
+
+// Clears a bit of a bitset.
+static void bitset_clear(struct bitset *b, size_t i)
+{
+    b->words[i / 64] &= ~(UINT64_C(1) << (i % 64));
+}
+
+//==============================================================================
+// Sparse Graph Data Structure
+//==============================================================================
+
+// An edge.
+struct edge {
+    unsigned u; // Source node.
+    unsigned v; // Target node.
+};
+
+// A directed sparse graph in compressed sparse row format.
+struct csr {
+    unsigned nnodes;     // Number of nodes.
+    size_t nedges;       // Number of edges.
+    size_t *offsets;     // Offset of the first edge of each node (nnodes + 1 entries).
+    unsigned *targets;   // Target node of each edge.
+    void *mapping;       // Mapped file (NULL if allocated).
+    size_t mapping_size; // Size of the mapped file.
+};
+
+// Builds a sparse graph from a list of edges. If undirected is set, each
+// edge is stored in the rows of both endpoints.
+static struct csr *csr_create(unsigned nnodes, const struct edge *edges, size_t nedges,
+                              bool undirected)
+{
+    struct csr *g = NULL;
+
+    // Allocate data structure.
+    assert((g = malloc(sizeof(struct csr))) != NULL);
+    g->nnodes = nnodes;
+    g->nedges = undirected ? 2 * nedges : nedges;
+    g->mapping = NULL;
+    g->mapping_size = 0;
+    assert((g->offsets = calloc((size_t)nnodes + 1, sizeof(size_t))) != NULL);
+    assert((g->targets = malloc(g->nedges * sizeof(unsigned))) != NULL);
+
+    // Count degrees, shifted by one node.
+    for (size_t i = 0; i < nedges; i++) {
+        g->offsets[edges[i].u + 1]++;
+        if (undirected) {
+            g->offsets[edges[i].v + 1]++;
+        }
+    }
+    for (unsigned i = 0; i < nnodes; i++) {
+        g->offsets[i + 1] += g->offsets[i];
+    }
+
+    // Place edges, using the first offset of each node as cursor.
+    for (size_t i = 0; i < nedges; i++) {
+        g->targets[g->offsets[edges[i].u]++] = edges[i].v;
+        if (undirected) {
+            g->targets[g->offsets[edges[i].v]++] = edges[i].u;
+        }
+    }
+
+    // Cursors now point to the next row, so shift them back.
+    for (unsigned i = nnodes; i > 0; i--) {
+        g->offsets[i] = g->offsets[i - 1];
+    }
+    g->offsets[0] = 0;
+
+    return (g);
+}
+
+// Destroys a sparse graph.
+static void csr_destroy(struct csr *g)
+{
+    if (g->mapping != NULL) {
+        munmap(g->mapping, g->mapping_size);
+    } else {
+        free(g->targets);
+        free(g->offsets);
+    }
+    free(g);
+}
+
+// Header of a binary sparse graph file, as written by graph/loader. It is
+// followed by the offsets (nnodes + 1 entries of 64 bits), the targets and
+// the weights (nedges entries of 32 bits each).
+struct csr_header {
+    uint32_t magic;  // Magic number.
+    uint32_t flags;  // Flags.
+    uint64_t nnodes; // Number of nodes.
+    uint64_t nedges; // Number of edges.
+};
+
+// Checks the arrays of a graph in compressed sparse row format: offsets
+// must start at zero, never decrease and end at the number of edges, and
+// targets must be valid nodes, so that the graph can be walked without
+// further checks.
+static bool csr_check_arrays(const uint64_t *offsets, const uint32_t *targets, uint64_t nnodes,
+                             uint64_t nedges)
+{
+    // Check offsets.
+    if ((offsets[0] != 0) || (offsets[nnodes] != nedges)) {
+        return (false);
+    }
+    for (uint64_t u = 0; u < nnodes; u++) {
+        if (offsets[u] > offsets[u + 1]) {
+            return (false);
+        }
+    }
+
+    // Check targets.
+    for (uint64_t k = 0; k < nedges; k++) {
+        if (targets[k] >= nnodes) {
+            return (false);
+        }
+    }
+
+    return (true);
+}
+
+// Checks the contents of a mapped binary sparse graph file. Sizes are
+// checked without overflowing before arrays are checked.
+static bool csr_check(const void *mapping, size_t size)
+{
+    const struct csr_header *h = mapping;
+    const uint64_t *offsets = (const uint64_t *)(h + 1);
+    size_t remaining = 0;
+
+    // Check header.
+    if ((size < sizeof(struct csr_header)) || (h->magic != CSR_MAGIC)) {
+        return (false);
+    }
+
+    // Check sizes. Targets are 32-bit node numbers.
+    remaining = size - sizeof(struct csr_header);
+    if ((h->nnodes > (uint64_t)UINT32_MAX + 1) || (h->nnodes >= remaining / sizeof(uint64_t))) {
+        return (false);
+    }
+    remaining -= (h->nnodes + 1) * sizeof(uint64_t);
+    if ((h->nedges > remaining / (2 * sizeof(uint32_t))) ||
+        (remaining != h->nedges * 2 * sizeof(uint32_t))) {
+        return (false);
+    }
+
+    return (csr_check_arrays(offsets, (const uint32_t *)(offsets + h->nnodes + 1), h->nnodes,
+                             h->nedges));
+}
+
+// Maps a binary sparse graph file in memory. No data is copied: the graph
+// points into the mapping, and pages are loaded on first access. Malformed
+// files are rejected.
+static struct csr *csr_map(const char *path, uint32_t *flags)
+{
+    int fd = -1;
+    struct stat st;
+    struct csr *g = NULL;
+    const struct csr_header *h = NULL;
+
+    if ((fd = open(path, O_RDONLY)) < 0) {
+        return (NULL);
+    }
+    if ((fstat(fd, &st) < 0) || ((size_t)st.st_size < sizeof(struct csr_header))) {
+        close(fd);
+        return (NULL);
+    }
+
+    assert((g = malloc(sizeof(struct csr))) != NULL);
+    g->mapping_size = (size_t)st.st_size;
+    g->mapping = mmap(NULL, g->mapping_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (g->mapping == MAP_FAILED) {
+        free(g);
+        return (NULL);
+    }
+
+    // Check contents.
+    h = g->mapping;
+    if (!csr_check(g->mapping, g->mapping_size) || (h->nnodes >= DFS_NONE)) {
+        munmap(g->mapping, g->mapping_size);
+        free(g);
+        return (NULL);
+    }
+
+    *flags = h->flags;
+    g->nnodes = h->nnodes;
+    g->nedges = h->nedges;
+    g->offsets = (size_t *)(h + 1);
+    g->targets = (unsigned *)(g->offsets + g->nnodes + 1);
+
+    return (g);
+}
+
+// Writes a graph stored as an adjacency matrix to a binary sparse graph file.
+static void csr_write_graph(const struct graph *g, uint32_t flags, FILE *f)
+{
+    struct csr_header h = {CSR_MAGIC, flags, g->nnodes, 0};
+    uint64_t offset = 0;
+
+    // Count edges.
+    for (size_t i = 0; i < g->nnodes * g->nnodes; i++) {
+        h.nedges += (g->links[i].weight > 0);
+    }
+    assert(fwrite(&h, sizeof(h), 1, f) == 1);
+
+    // Offsets.
+    for (size_t i = 0; i < g->nnodes; i++) {
+        assert(fwrite(&offset, sizeof(offset), 1, f) == 1);
+        for (size_t j = 0; j < g->nnodes; j++) {
+            offset += (graph_link(g, i, j)->weight > 0);
+        }
+    }
+    assert(fwrite(&offset, sizeof(offset), 1, f) == 1);
+
+    // Targets.
+    for (size_t i = 0; i < g->nnodes * g->nnodes; i++) {
+        uint32_t target = i % g->nnodes;
+        if (g->links[i].weight > 0) {
+            assert(fwrite(&target, sizeof(target), 1, f) == 1);
+        }
+    }
+
+    // Weights.
+    for (size_t i = 0; i < g->nnodes * g->nnodes; i++) {
+        uint32_t weight = g->links[i].weight;
+        if (weight > 0) {
+            assert(fwrite(&weight, sizeof(weight), 1, f) == 1);
+        }
+    }
+}
+
+//==============================================================================
+// Sparse Depth-First Search
+//==============================================================================
+
+// Callbacks of a depth-first search. Any of them may be NULL.
+struct dfs_visitor {
+    void *arg;                                           // Argument of callbacks.
+    void (*discover)(void *arg, unsigned u, unsigned p); // Node u is reached from p.
+    void (*revisit)(void *arg, unsigned u, unsigned v);  // Edge u->v reaches a visited node.
+    void (*finish)(void *arg, unsigned u, unsigned p);   // All edges of u are explored.
+};
+
+// A frame of the explicit depth-first search stack.
+struct dfs_frame {
+    unsigned node; // Node.
+    size_t next;   // Next edge to explore.
+};
+
+// Performs an iterative depth-first search in a sparse graph from a root
+// node. Visited nodes are marked in a bitset, and frames must have room for
+// one entry per node.
+static void dfs_visit(const struct csr *g, unsigned root, struct bitset *visited,
+                      struct dfs_frame *frames, const struct dfs_visitor *v)
+{
+    size_t depth = 0;
+
+    // Discover root node.
+    bitset_set(visited, root);
+    if (v->discover != NULL) {
+        v->discover(v->arg, root, DFS_NONE);
+    }
+    frames[depth++] = (struct dfs_frame){root, g->offsets[root]};
+
+    while (depth > 0) {
+        struct dfs_frame *f = &frames[depth - 1];
+
+        // All edges explored, thus backtrack.
+        if (f->next == g->offsets[f->node + 1]) {
+            unsigned parent = (depth > 1) ? frames[depth - 2].node : DFS_NONE;
+            if (v->finish != NULL) {
+                v->finish(v->arg, f->node, parent);
+            }
+            depth--;
+            continue;
+        }
+
+        unsigned w = g->targets[f->next++];
+
+        // This neighbor was visited.
+        if (bitset_test(visited, w)) {
+            if (v->revisit != NULL) {
+                v->revisit(v->arg, f->node, w);
+            }
+            continue;
+        }
+
+        // Descend into this neighbor.
+        bitset_set(visited, w);
+        if (v->discover != NULL) {
+            v->discover(v->arg, w, f->node);
+        }
+        frames[depth++] = (struct dfs_frame){w, g->offsets[w]};
+    }
+}
+
+// Performs an iterative depth-first search that covers all nodes of a sparse
+// graph. Nodes that are already set in visited are skipped.
+static void dfs_all(const struct csr *g, struct bitset *visited, const struct dfs_visitor *v)
+{
+    struct dfs_frame *frames = malloc(g->nnodes * sizeof(struct dfs_frame));
+    assert((g->nnodes == 0) || (frames != NULL));
+
+    for (unsigned i = 0; i < g->nnodes; i++) {
+        if (!bitset_test(visited, i)) {
+            dfs_visit(g, i, visited, frames, v);
+        }
+    }
+
+    free(frames);
+}
+
+//==============================================================================
+// Topological Sort
+//==============================================================================
+
+// State of a topological sort.
+struct topo {
+    unsigned *order;         // Nodes in reverse finishing order.
+    unsigned length;         // Number of finished nodes.
+    struct bitset *finished; // Finished nodes.
+    bool cycle;              // Was a cycle found?
+};
+
+// Detects back edges, which close cycles.
+static void topo_revisit(void *arg, unsigned u, unsigned v)
+{
+    struct topo *t = arg;
+    ((void)u);
+
+    // Visited but not finished, thus an ancestor.
+    if (!bitset_test(t->finished, v)) {
+        t->cycle = true;
+    }
+}
+
+// Places a finished node before all nodes finished so far.
+static void topo_finish(void *arg, unsigned u, unsigned p)
+{
+    struct topo *t = arg;
+    ((void)p);
+
+    bitset_set(t->finished, u);
+    t->order[t->length++] = u;
+}
+
+// Sorts the nodes of a directed acyclic graph so that every edge goes from
+// an earlier to a later node. Returns false if the graph has a cycle.
+static bool topological_sort(const struct csr *g, unsigned *order)
+{
+    struct bitset *visited = bitset_create(g->nnodes);
+    struct topo t = {order, 0, bitset_create(g->nnodes), false};
+    const struct dfs_visitor v = {&t, NULL, topo_revisit, topo_finish};
+
+    dfs_all(g, visited, &v);
+
+    // Reverse finishing order.
+    for (unsigned i = 0; i < t.length / 2; i++) {
+        unsigned tmp = order[i];
+        order[i] = order[t.length - 1 - i];
+        order[t.length - 1 - i] = tmp;
+    }
+
+    bitset_destroy(t.finished);
+    bitset_destroy(visited);
+
+    return (!t.cycle);
+}
+
+//==============================================================================
+// Strongly Connected Components
+//==============================================================================
+
+// State of Tarjan's Algorithm.
+struct tarjan {
+    unsigned *index;        // Discovery index of each node.
+    unsigned *low;          // Lowest index reachable from the subtree of each node.
+    unsigned *stack;        // Nodes of components that are not complete yet.
+    unsigned length;        // Number of nodes in the stack.
+    unsigned counter;       // Next discovery index.
+    struct bitset *onstack; // Nodes in the stack.
+    unsigned *components;   // Component of each node.
+    unsigned ncomponents;   // Number of components.
+};
+
+// Assigns a discovery index to a node and pushes it on the stack.
+static void tarjan_discover(void *arg, unsigned u, unsigned p)
+{
+    struct tarjan *t = arg;
+    ((void)p);
+
+    t->index[u] = t->low[u] = t->counter++;
+    t->stack[t->length++] = u;
+    bitset_set(t->onstack, u);
+}
+
+// Lowers the low link of a node through an edge to a node in the stack.
+static void tarjan_revisit(void *arg, unsigned u, unsigned v)
+{
+    struct tarjan *t = arg;
+
+    if (bitset_test(t->onstack, v) && (t->index[v] < t->low[u])) {
+        t->low[u] = t->index[v];
+    }
+}
+
+// Pops a component if a node is its root, and propagates its low link.
+static void tarjan_finish(void *arg, unsigned u, unsigned p)
+{
+    struct tarjan *t = arg;
+
+    // Root of a component.
+    if (t->low[u] == t->index[u]) {
+        unsigned w = DFS_NONE;
+        do {
+            w = t->stack[--t->length];
+            bitset_clear(t->onstack, w);
+            t->components[w] = t->ncomponents;
+        } while (w != u);
+        t->ncomponents++;
+    }
+
+    if ((p != DFS_NONE) && (t->low[u] < t->low[p])) {
+        t->low[p] = t->low[u];
+    }
+}
+
+// Finds the strongly connected components of a directed graph with an
+// iterative Tarjan's Algorithm. Returns the number of components.
+static unsigned tarjan(const struct csr *g, unsigned *components)
+{
+    struct bitset *visited = bitset_create(g->nnodes);
+    struct tarjan t;
+    const struct dfs_visitor v = {&t, tarjan_discover, tarjan_revisit, tarjan_finish};
+
+    t.index = malloc(g->nnodes * sizeof(unsigned));
+    t.low = malloc(g->nnodes * sizeof(unsigned));
+    t.stack = malloc(g->nnodes * sizeof(unsigned));
+    assert((g->nnodes == 0) || ((t.index != NULL) && (t.low != NULL) && (t.stack != NULL)));
+    t.length = 0;
+    t.counter = 0;
+    t.onstack = bitset_create(g->nnodes);
+    t.components = components;
+    t.ncomponents = 0;
+
+    dfs_all(g, visited, &v);
+
+    // Release resources.
+    bitset_destroy(t.onstack);
+    free(t.stack);
+    free(t.low);
+    free(t.index);
+    bitset_destroy(visited);
+
+    return (t.ncomponents);
+}
+
+//==============================================================================
+// Articulation Points
+//==============================================================================
+
+// State of the articulation points search.
+struct cut {
+    unsigned *index;     // Discovery index of each node.
+    unsigned *low;       // Lowest index reachable from the subtree of each node.
+    unsigned *parents;   // Parent of each node in the search tree.
+    unsigned *children;  // Number of children of each node in the search tree.
+    unsigned counter;    // Next discovery index.
+    struct bitset *cuts; // Articulation points.
+};
+
+// Assigns a discovery index to a node.
+static void cut_discover(void *arg, unsigned u, unsigned p)
+{
+    struct cut *c = arg;
+
+    c->index[u] = c->low[u] = c->counter++;
+    c->parents[u] = p;
+    c->children[u] = 0;
+}
+
+// Lowers the low link of a node through a non-tree edge.
+static void cut_revisit(void *arg, unsigned u, unsigned v)
+{
+    struct cut *c = arg;
+
+    if ((v != c->parents[u]) && (c->index[v] < c->low[u])) {
+        c->low[u] = c->index[v];
+    }
+}
+
+// Checks if the parent of a finished node separates it from the rest of the graph.
+static void cut_finish(void *arg, unsigned u, unsigned p)
+{
+    struct cut *c = arg;
+
+    // Root node: an articulation point if it has several children.
+    if (p == DFS_NONE) {
+        if (c->children[u] > 1) {
+            bitset_set(c->cuts, u);
+        }
+        return;
+    }
+
+    c->children[p]++;
+    if (c->low[u] < c->low[p]) {
+        c->low[p] = c->low[u];
+    }
+
+    // No edge from the subtree of u climbs above p.
+    if ((c->parents[p] != DFS_NONE) && (c->low[u] >= c->index[p])) {
+        bitset_set(c->cuts, p);
+    }
+}
+
+// Finds the articulation points of an undirected graph. Returns their number.
+static unsigned articulation_points(const struct csr *g, struct bitset *cuts)
+{
+    unsigned ncuts = 0;
+    struct bitset *visited = bitset_create(g->nnodes);
+    struct cut c;
+    const struct dfs_visitor v = {&c, cut_discover, cut_revisit, cut_finish};
+
+    c.index = malloc(g->nnodes * sizeof(unsigned));
+    c.low = malloc(g->nnodes * sizeof(unsigned));
+    c.parents = malloc(g->nnodes * sizeof(unsigned));
+    c.children = malloc(g->nnodes * sizeof(unsigned));
+    assert((g->nnodes == 0) || ((c.index != NULL) && (c.low != NULL)));
+    assert((g->nnodes == 0) || ((c.parents != NULL) && (c.children != NULL)));
+    c.counter = 0;
+    c.cuts = cuts;
+
+    dfs_all(g, visited, &v);
+
+    for (unsigned i = 0; i < g->nnodes; i++) {
+        ncuts += bitset_test(cuts, i);
+    }
+
+    // Release resources.
+    free(c.children);
+    free(c.parents);
+    free(c.low);
+    free(c.index);
+    bitset_destroy(visited);
+
+    return (ncuts);
+}
+
+// Counts discovered nodes.
+static void count_discover(void *arg, unsigned u, unsigned p)
+{
+    unsigned *count = arg;
+    ((void)u);
+    ((void)p);
+
+    (*count)++;
+}
+
+// Counts the connected components of an undirected graph, skipping nodes
+// that are already set in visited.
+static unsigned count_components(const struct csr *g, struct bitset *visited)
+{
+    unsigned ncomponents = 0;
+    struct dfs_frame *frames = malloc(g->nnodes * sizeof(struct dfs_frame));
+    const struct dfs_visitor v = {NULL, NULL, NULL, NULL};
+
+    assert((g->nnodes == 0) || (frames != NULL));
+
+    for (unsigned i = 0; i < g->nnodes; i++) {
+        if (!bitset_test(visited, i)) {
+            dfs_visit(g, i, visited, frames, &v);
+            ncomponents++;
+        }
+    }
+
+    free(frames);
+
+    return (ncomponents);
+}
+
 //==============================================================================
 // Test
 //==============================================================================
 
+// Tests sparse depth-first search algorithms on random graphs.
+static void test_sparse(unsigned nnodes)
+{
+    size_t nedges = (nnodes > 1) ? (size_t)EDGES_PER_NODE * nnodes : 0;
+    size_t n = 0;
+    double tstart = 0.0;
+    double tend = 0.0;
+    const double MICROSECS = ((CLOCKS_PER_SEC / 1000000.0));
+    struct edge *edges = malloc((nedges + nnodes) * sizeof(struct edge));
+    unsigned *order = malloc(nnodes * sizeof(unsigned));
+    unsigned *position = malloc(nnodes * sizeof(unsigned));
+    struct bitset *visited = bitset_create(nnodes);
+    struct bitset *cuts = bitset_create(nnodes);
+    const struct dfs_visitor v = {NULL, NULL, NULL, NULL};
+    struct csr *g = NULL;
+
+    assert((nnodes == 0) || ((edges != NULL) && (order != NULL) && (position != NULL)));
+
+    // Random directed acyclic graph: edges go from smaller to larger nodes.
+    for (size_t i = 0; i < nedges; i++) {
+        unsigned u = (unsigned)rand() % (nnodes - 1);
+        edges[i] = (struct edge){u, u + 1 + (unsigned)rand() % (nnodes - 1 - u)};
+    }
+    g = csr_create(nnodes, edges, nedges, false);
+    printf("Sparse graph: %u nodes, %zu edges\n", g->nnodes, g->nedges);
+
+    // Depth-first search.
+    tstart = clock();
+    dfs_all(g, visited, &v);
+    tend = clock();
+    printf("%22s: %2.lf us\n", "dfs_all()", (tend - tstart) / MICROSECS);
+
+    // Topological sort: every edge must go forward.
+    tstart = clock();
+    bool acyclic = topological_sort(g, order);
+    tend = clock();
+    printf("%22s: %2.lf us\n", "topological_sort()", (tend - tstart) / MICROSECS);
+    assert(acyclic);
+    ((void)acyclic);
+    for (unsigned i = 0; i < nnodes; i++) {
+        position[order[i]] = i;
+    }
+    for (size_t i = 0; i < nedges; i++) {
+        assert(position[edges[i].u] < position[edges[i].v]);
+    }
+    csr_destroy(g);
+
+    // Close a cycle through each group of four consecutive nodes. Edges
+    // between groups go forward, so each group is a component.
+    for (size_t i = 0; i < nedges; i++) {
+        if (edges[i].u / 4 != edges[i].v / 4) {
+            edges[n++] = edges[i];
+        }
+    }
+    for (unsigned u = 0; u < nnodes; u++) {
+        unsigned next = ((u % 4 == 3) || (u + 1 == nnodes)) ? u - u % 4 : u + 1;
+        edges[n++] = (struct edge){u, next};
+    }
+    g = csr_create(nnodes, edges, n, false);
+    tstart = clock();
+    unsigned ncomponents = tarjan(g, order);
+    tend = clock();
+    printf("%22s: %2.lf us (%u found)\n", "tarjan()", (tend - tstart) / MICROSECS, ncomponents);
+    assert(ncomponents == (nnodes + 3) / 4);
+    for (unsigned u = 0; u < nnodes; u++) {
+        assert(order[u] == order[u - u % 4]);
+    }
+    assert(!topological_sort(g, order) || (nnodes <= 1));
+    csr_destroy(g);
+
+    // Random tree, with a few extra edges.
+    n = 0;
+    for (unsigned u = 1; u < nnodes; u++) {
+        edges[n++] = (struct edge){(unsigned)rand() % u, u};
+    }
+    for (unsigned i = 0; (nnodes > 0) && (i < nnodes / 8); i++) {
+        edges[n++] = (struct edge){(unsigned)rand() % nnodes, (unsigned)rand() % nnodes};
+    }
+    g = csr_create(nnodes, edges, n, true);
+    tstart = clock();
+    unsigned ncuts = articulation_points(g, cuts);
+    tend = clock();
+    printf("%22s: %2.lf us (%u found)\n", "articulation_points()", (tend - tstart) / MICROSECS,
+           ncuts);
+
+    // Brute force: removing an articulation point adds components.
+    if (nnodes <= BRUTE_FORCE_NNODES) {
+        bitset_clear_all(visited);
+        unsigned expected = count_components(g, visited);
+        for (unsigned u = 0; u < nnodes; u++) {
+            bitset_clear_all(visited);
+            bitset_set(visited, u);
+            bool cut = count_components(g, visited) > expected;
+            assert(cut == bitset_test(cuts, u));
+            ((void)cut);
+        }
+    }
+
+    // Release resources.
+    csr_destroy(g);
+    bitset_destroy(cuts);
+    bitset_destroy(visited);
+    free(position);
+    free(order);
+    free(edges);
+}
+
 // Tests Binary Search.
 static void test(size_t nnodes, bool verbose)
 {
@@ -300,8 +1054,87 @@ static void test(size_t nnodes, bool verbose)
         printf("NULL\n");
     }
 
+    // Search in a sparse graph mapped from a file.
+    if (nnodes > 0) {
+        char csr_path[] = "/tmp/dfs-XXXXXX";
+        FILE *f = fdopen(mkstemp(csr_path), "wb");
+        uint32_t flags = 0;
+        unsigned count = 0;
+        const struct dfs_visitor v = {&count, count_discover, NULL, NULL};
+        assert(f != NULL);
+        csr_write_graph(g, 0, f);
+        fclose(f);
+        struct csr *sg = csr_map(csr_path, &flags);
+        assert(sg != NULL);
+        struct bitset *visited = bitset_create(sg->nnodes);
+        struct dfs_frame *frames = malloc(sg->nnodes * sizeof(struct dfs_frame));
+        assert(frames != NULL);
+        tstart = clock();
+        dfs_visit(sg, 0, visited, frames, &v);
+        tend = clock();
+        printf("Depth-First Search (sparse): %2.lf us\n", (tend - tstart) / MICROSECS);
+        assert(count == path_length);
+        free(frames);
+        bitset_destroy(visited);
+        csr_destroy(sg);
+        unlink(csr_path);
+    }
+
     // Release graph.
     graph_destroy(g);
+
+    // Test on a sparse graph.
+    test_sparse(nnodes * nnodes);
+}
+
+// Runs depth-first search algorithms on a graph that is loaded from a binary sparse graph file.
+static void test_loaded(const char *filename)
+{
+    double tstart = 0.0;
+    double tend = 0.0;
+    const double MICROSECS = ((CLOCKS_PER_SEC / 1000000.0));
+    uint32_t flags = 0;
+    struct csr *g = NULL;
+    struct bitset *visited = NULL;
+    unsigned *components = NULL;
+    const struct dfs_visitor v = {NULL, NULL, NULL, NULL};
+
+    tstart = clock();
+    g = csr_map(filename, &flags);
+    tend = clock();
+    if (g == NULL) {
+        fprintf(stderr, "Error: cannot load %s.\n", filename);
+        exit(EXIT_FAILURE);
+    }
+    printf("Loaded %u nodes and %zu edges (%zu bytes): %2.lf us\n", g->nnodes, g->nedges,
+           g->mapping_size, (tend - tstart) / MICROSECS);
+
+    visited = bitset_create(g->nnodes);
+    tstart = clock();
+    dfs_all(g, visited, &v);
+    tend = clock();
+    printf("%22s: %2.lf us\n", "dfs_all()", (tend - tstart) / MICROSECS);
+
+    assert((components = malloc(g->nnodes * sizeof(unsigned) + 1)) != NULL);
+    tstart = clock();
+    unsigned ncomponents = tarjan(g, components);
+    tend = clock();
+    printf("%22s: %2.lf us (%u found)\n", "tarjan()", (tend - tstart) / MICROSECS, ncomponents);
+
+    // Articulation points are defined on undirected graphs.
+    if (flags & CSR_UNDIRECTED) {
+        struct bitset *cuts = bitset_create(g->nnodes);
+        tstart = clock();
+        unsigned ncuts = articulation_points(g, cuts);
+        tend = clock();
+        printf("%22s: %2.lf us (%u found)\n", "articulation_points()",
+               (tend - tstart) / MICROSECS, ncuts);
+        bitset_destroy(cuts);
+    }
+
+    free(components);
+    bitset_destroy(visited);
+    csr_destroy(g);
 }
 
 //==============================================================================
@@ -313,6 +1146,7 @@ static void usage(char *const argv[])
 {
     printf("%s - Testing program for depth-first search.\n", argv[0]);
     printf("Usage: %s [--verbose] <>\num_nodes n", argv[0]);
+    printf("       %s --graph <graph file>\n", argv[0]);
     exit(EXIT_FAILURE);
 }
 
@@ -333,7 +1167,10 @@ int main(int argc, char *const argv[])
     }
 
     // Parse command line arguments.
-    if (argc == 2) {
+    if ((argc == 3) && (!strcmp(argv[1], "--graph"))) {
+        test_loaded(argv[2]);
+        return (EXIT_SUCCESS);
+    } else if (argc == 2) {
         sscanf(argv[1], "%zu", &nnodes);
     } else if ((argc == 3) && (!strcmp(argv[1], "--verbose"))) {
         sscanf(argv[2], "%zu", &nnodes);
@@ -1,12 +1,49 @@
 // Copyright (C) 2022 Pedro Henrique Penna <pedrohenriquepenna@outlook.com>
 
+#define _POSIX_C_SOURCE 200809L
+
 #include <assert.h>
+#include <fcntl.h>
+#include <math.h>
+#include <pthread.h>
+#include <stdatomic.h>
 #include <stdbool.h>
 #include <stddef.h>
+#include <stdint.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
 #include <time.h>
+#include <unistd.h>
+
+// Magic number of binary sparse graph files ("CSR1").
+#define CSR_MAGIC 0x31525343
+
+// Magic number of contraction hierarchy files ("CH01").
+#define CH_MAGIC 0x31304843
+
+// Max number of nodes settled by a witness search.
+#define CH_WITNESS_LIMIT 256
+
+// Offset that keeps node priorities positive in contraction hierarchies.
+#define CH_PRIORITY_BIAS ((size_t)1 << 32)
+
+// Max number of threads in parallel algorithms.
+#define DIJKSTRA_MAX_THREADS 8
+
+// Number of sources in multi-source benchmarks.
+#define NSOURCES 8
+
+// Number of point-to-point queries in benchmarks.
+#define NQUERIES 100
+
+// Average number of neighbors of a node in geometric graphs.
+#define GEOMETRIC_DEGREE 10
+
+// Weight of a unit of length in geometric graphs.
+#define GEOMETRIC_SCALE 100
 
 //==============================================================================
 // Graph Data Structure
@@ -18,6 +55,8 @@ typedef int type_t;
 // A graph node.
 struct node {
     type_t element; // Element.
+    double x;       // Horizontal coordinate.
+    double y;       // Vertical coordinate.
 };
 
 // A graph link.
@@ -76,19 +115,374 @@ static void graph_print(const struct graph *g, FILE *f)
         precision += 1;
     }
     fprintf(f, "graph {\n");
-    fprintf(f, "nnodes: %d,\n", g->nnodes);
+    fprintf(f, "nnodes: %zu,\n", g->nnodes);
     fprintf(f, "links: \n");
     for (size_t i = 0; i < g->nnodes; i++) {
         fprintf(f, " [ ");
         for (size_t j = 0; j < g->nnodes; j++) {
             const struct link *l = graph_link(g, i, j);
-            fprintf(f, "%*u ", precision, l->weight);
+            fprintf(f, "%*u ", (int)precision, l->weight);
         }
         fprintf(f, "]\n");
     }
     fprintf(f, "}\n");
 }
 
+//==============================================================================
+// Sparse Graph Data Structure
+//==============================================================================
+
+// A sparse graph in compressed sparse row format.
+struct csr {
+    size_t nnodes;       // Number of nodes.
+    size_t nedges;       // Number of edges.
+    size_t *offsets;     // Offset of the first edge of each node (nnodes + 1 entries).
+    unsigned *targets;   // Target node of each edge.
+    unsigned *weights;   // Weight of each edge.
+    struct node *nodes;  // Coordinates of each node (NULL if unknown).
+    void *mapping;       // Mapped file (NULL if allocated).
+    size_t mapping_size; // Size of the mapped file.
+};
+
+// Creates a road-network-like graph: a grid in which each node links to its
+// four neighbors, in both directions, with small random weights.
+static struct csr *csr_create_grid(size_t side, unsigned max_weight)
+{
+    struct csr *g = NULL;
+    size_t k = 0;
+
+    // Allocate data structure.
+    assert((g = malloc(sizeof(struct csr))) != NULL);
+    g->nnodes = side * side;
+    g->nedges = 4 * side * (side - 1);
+    g->mapping = NULL;
+    g->mapping_size = 0;
+    assert((g->offsets = malloc((g->nnodes + 1) * sizeof(size_t))) != NULL);
+    assert((g->targets = malloc(g->nedges * sizeof(unsigned))) != NULL);
+    assert((g->weights = malloc(g->nedges * sizeof(unsigned))) != NULL);
+    assert((g->nodes = malloc(g->nnodes * sizeof(struct node))) != NULL);
+
+    // Initialize data structure.
+    for (size_t i = 0; i < g->nnodes; i++) {
+        size_t row = i / side;
+        size_t col = i % side;
+        const bool neighbors[4] = {row > 0, col > 0, col + 1 < side, row + 1 < side};
+        const size_t targets[4] = {i - side, i - 1, i + 1, i + side};
+
+        g->nodes[i] = (struct node){(type_t)i, (double)col, (double)row};
+        g->offsets[i] = k;
+        for (size_t j = 0; j < 4; j++) {
+            if (neighbors[j]) {
+                g->targets[k] = (unsigned)targets[j];
+                g->weights[k] = 1 + (unsigned)rand() % max_weight;
+                k++;
+            }
+        }
+    }
+    g->offsets[g->nnodes] = k;
+    assert(k == g->nedges);
+
+    return (g);
+}
+
+// Returns the Euclidean distance between two nodes.
+static double node_distance(const struct node *a, const struct node *b)
+{
+    return (sqrt((a->x - b->x) * (a->x - b->x) + (a->y - b->y) * (a->y - b->y)));
+}
+
+// Creates a random geometric graph: nodes are scattered in a square of the
+// given side, and each node links to all nodes within a fixed radius, in both
+// directions. The weight of a link is its length, rounded up. Nodes are
+// numbered in cell order, so that nearby nodes are also close in memory.
+static struct csr *csr_create_geometric(size_t side)
+{
+    const double radius = sqrt(GEOMETRIC_DEGREE / 3.14159265358979323846);
+    const size_t reach = (size_t)ceil(radius);
+    struct csr *g = NULL;
+    struct node *points = NULL;
+    size_t *cells = NULL;
+    size_t k = 0;
+
+    // Allocate data structure.
+    assert((g = malloc(sizeof(struct csr))) != NULL);
+    g->nnodes = side * side;
+    g->nedges = 0;
+    g->mapping = NULL;
+    g->mapping_size = 0;
+    assert((g->offsets = malloc((g->nnodes + 1) * sizeof(size_t))) != NULL);
+    assert((g->nodes = malloc(g->nnodes * sizeof(struct node))) != NULL);
+    assert((points = malloc(g->nnodes * sizeof(struct node))) != NULL);
+    assert((cells = calloc(g->nnodes + 1, sizeof(size_t))) != NULL);
+
+    // Scatter nodes, one per unit cell on average.
+    for (size_t i = 0; i < g->nnodes; i++) {
+        points[i].element = (type_t)i;
+        points[i].x = side * ((double)rand() / ((double)RAND_MAX + 1));
+        points[i].y = side * ((double)rand() / ((double)RAND_MAX + 1));
+        cells[(size_t)points[i].y * side + (size_t)points[i].x + 1]++;
+    }
+
+    // Sort nodes by cell.
+    for (size_t c = 0; c < g->nnodes; c++) {
+        cells[c + 1] += cells[c];
+    }
+    for (size_t i = 0; i < g->nnodes; i++) {
+        size_t c = (size_t)points[i].y * side + (size_t)points[i].x;
+        g->nodes[cells[c]++] = points[i];
+    }
+    for (size_t c = g->nnodes; c > 0; c--) {
+        cells[c] = cells[c - 1];
+    }
+    cells[0] = 0;
+
+    // Link nearby nodes in two passes: count, then place.
+    for (size_t pass = 0; pass < 2; pass++) {
+        k = 0;
+        for (size_t i = 0; i < g->nnodes; i++) {
+            const struct node *a = &g->nodes[i];
+            size_t row = (size_t)a->y;
+            size_t col = (size_t)a->x;
+
+            g->offsets[i] = k;
+            for (size_t r = (row > reach) ? row - reach : 0; (r <= row + reach) && (r < side);
+                 r++) {
+                for (size_t c = (col > reach) ? col - reach : 0; (c <= col + reach) && (c < side);
+                     c++) {
+                    for (size_t j = cells[r * side + c]; j < cells[r * side + c + 1]; j++) {
+                        double d = node_distance(a, &g->nodes[j]);
+                        if ((j == i) || (d > radius)) {
+                            continue;
+                        }
+                        if (pass == 1) {
+                            unsigned w = (unsigned)ceil(d * GEOMETRIC_SCALE);
+                            g->targets[k] = (unsigned)j;
+                            g->weights[k] = (w > 0) ? w : 1;
+                        }
+                        k++;
+                    }
+                }
+            }
+        }
+        g->offsets[g->nnodes] = k;
+        if (pass == 0) {
+            g->nedges = k;
+            assert((g->targets = malloc(g->nedges * sizeof(unsigned))) != NULL);
+            assert((g->weights = malloc(g->nedges * sizeof(unsigned))) != NULL);
+        }
+    }
+
+    // Release temporary storage.
+    free(cells);
+    free(points);
+
+    return (g);
+}
+
+// Creates the reverse of a sparse graph, in which every edge is flipped.
+static struct csr *csr_reverse(const struct csr *g)
+{
+    struct csr *r = NULL;
+
+    // Allocate data structure.
+    assert((r = malloc(sizeof(struct csr))) != NULL);
+    r->nnodes = g->nnodes;
+    r->nedges = g->nedges;
+    r->nodes = NULL;
+    r->mapping = NULL;
+    r->mapping_size = 0;
+    assert((r->offsets = calloc(r->nnodes + 1, sizeof(size_t))) != NULL);
+    assert((r->targets = malloc(r->nedges * sizeof(unsigned))) != NULL);
+    assert((r->weights = malloc(r->nedges * sizeof(unsigned))) != NULL);
+
+    // Count in-degrees, shifted by one node.
+    for (size_t k = 0; k < g->nedges; k++) {
+        r->offsets[g->targets[k] + 1]++;
+    }
+    for (size_t i = 0; i < r->nnodes; i++) {
+        r->offsets[i + 1] += r->offsets[i];
+    }
+
+    // Place edges, using the first offset of each node as cursor.
+    for (size_t i = 0; i < g->nnodes; i++) {
+        for (size_t k = g->offsets[i]; k < g->offsets[i + 1]; k++) {
+            size_t l = r->offsets[g->targets[k]]++;
+            r->targets[l] = (unsigned)i;
+            r->weights[l] = g->weights[k];
+        }
+    }
+
+    // Cursors now point to the next row, so shift them back.
+    for (size_t i = r->nnodes; i > 0; i--) {
+        r->offsets[i] = r->offsets[i - 1];
+    }
+    r->offsets[0] = 0;
+
+    return (r);
+}
+
+// Destroys a sparse graph.
+static void csr_destroy(struct csr *g)
+{
+    if (g->mapping != NULL) {
+        munmap(g->mapping, g->mapping_size);
+    } else {
+        free(g->weights);
+        free(g->targets);
+        free(g->offsets);
+    }
+    free(g->nodes);
+    free(g);
+}
+
+// Header of a binary sparse graph file, as written by graph/loader. It is
+// followed by the offsets (nnodes + 1 entries of 64 bits), the targets and
+// the weights (nedges entries of 32 bits each).
+struct csr_header {
+    uint32_t magic;  // Magic number.
+    uint32_t flags;  // Flags.
+    uint64_t nnodes; // Number of nodes.
+    uint64_t nedges; // Number of edges.
+};
+
+// Checks the arrays of a graph in compressed sparse row format: offsets
+// must start at zero, never decrease and end at the number of edges, and
+// targets must be valid nodes, so that the graph can be walked without
+// further checks.
+static bool csr_check_arrays(const uint64_t *offsets, const uint32_t *targets, uint64_t nnodes,
+                             uint64_t nedges)
+{
+    // Check offsets.
+    if ((offsets[0] != 0) || (offsets[nnodes] != nedges)) {
+        return (false);
+    }
+    for (uint64_t u = 0; u < nnodes; u++) {
+        if (offsets[u] > offsets[u + 1]) {
+            return (false);
+        }
+    }
+
+    // Check targets.
+    for (uint64_t k = 0; k < nedges; k++) {
+        if (targets[k] >= nnodes) {
+            return (false);
+        }
+    }
+
+    return (true);
+}
+
+// Checks the contents of a mapped binary sparse graph file. Sizes are
+// checked without overflowing before arrays are checked.
+static bool csr_check(const void *mapping, size_t size)
+{
+    const struct csr_header *h = mapping;
+    const uint64_t *offsets = (const uint64_t *)(h + 1);
+    size_t remaining = 0;
+
+    // Check header.
+    if ((size < sizeof(struct csr_header)) || (h->magic != CSR_MAGIC)) {
+        return (false);
+    }
+
+    // Check sizes. Targets are 32-bit node numbers.
+    remaining = size - sizeof(struct csr_header);
+    if ((h->nnodes > (uint64_t)UINT32_MAX + 1) || (h->nnodes >= remaining / sizeof(uint64_t))) {
+        return (false);
+    }
+    remaining -= (h->nnodes + 1) * sizeof(uint64_t);
+    if ((h->nedges > remaining / (2 * sizeof(uint32_t))) ||
+        (remaining != h->nedges * 2 * sizeof(uint32_t))) {
+        return (false);
+    }
+
+    return (csr_check_arrays(offsets, (const uint32_t *)(offsets + h->nnodes + 1), h->nnodes,
+                             h->nedges));
+}
+
+// Maps a binary sparse graph file in memory. No data is copied: the graph
+// points into the mapping, and pages are loaded on first access. Malformed
+// files are rejected.
+static struct csr *csr_map(const char *path)
+{
+    int fd = -1;
+    struct stat st;
+    struct csr *g = NULL;
+    const struct csr_header *h = NULL;
+
+    if ((fd = open(path, O_RDONLY)) < 0) {
+        return (NULL);
+    }
+    if ((fstat(fd, &st) < 0) || ((size_t)st.st_size < sizeof(struct csr_header))) {
+        close(fd);
+        return (NULL);
+    }
+
+    assert((g = malloc(sizeof(struct csr))) != NULL);
+    g->mapping_size = (size_t)st.st_size;
+    g->mapping = mmap(NULL, g->mapping_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (g->mapping == MAP_FAILED) {
+        free(g);
+        return (NULL);
+    }
+
+    // Check contents.
+    h = g->mapping;
+    if (!csr_check(g->mapping, g->mapping_size)) {
+        munmap(g->mapping, g->mapping_size);
+        free(g);
+        return (NULL);
+    }
+
+    g->nnodes = h->nnodes;
+    g->nedges = h->nedges;
+    g->nodes = NULL;
+    g->offsets = (size_t *)(h + 1);
+    g->targets = (unsigned *)(g->offsets + g->nnodes + 1);
+    g->weights = g->targets + g->nedges;
+
+    return (g);
+}
+
+// Writes a graph stored as an adjacency matrix to a binary sparse graph file.
+static void csr_write_graph(const struct graph *g, uint32_t flags, FILE *f)
+{
+    struct csr_header h = {CSR_MAGIC, flags, g->nnodes, 0};
+    uint64_t offset = 0;
+
+    // Count edges.
+    for (size_t i = 0; i < g->nnodes * g->nnodes; i++) {
+        h.nedges += (g->links[i].weight > 0);
+    }
+    assert(fwrite(&h, sizeof(h), 1, f) == 1);
+
+    // Offsets.
+    for (size_t i = 0; i < g->nnodes; i++) {
+        assert(fwrite(&offset, sizeof(offset), 1, f) == 1);
+        for (size_t j = 0; j < g->nnodes; j++) {
+            offset += (graph_link(g, i, j)->weight > 0);
+        }
+    }
+    assert(fwrite(&offset, sizeof(offset), 1, f) == 1);
+
+    // Targets.
+    for (size_t i = 0; i < g->nnodes * g->nnodes; i++) {
+        uint32_t target = i % g->nnodes;
+        if (g->links[i].weight > 0) {
+            assert(fwrite(&target, sizeof(target), 1, f) == 1);
+        }
+    }
+
+    // Weights.
+    for (size_t i = 0; i < g->nnodes * g->nnodes; i++) {
+        uint32_t weight = g->links[i].weight;
+        if (weight > 0) {
+            assert(fwrite(&weight, sizeof(weight), 1, f) == 1);
+        }
+    }
+}
+
 //==============================================================================
 // Binary Heap Structure
 //==============================================================================
@@ -101,10 +495,11 @@ static void swap(size_t *x, size_t *y)
     *y = tmp;
 }
 
-// A heap that can grow dynamically.
+// A heap of elements in the range [0, capacity).
 struct heap {
     size_t *elements;   // Elements stored in the heap.
     size_t *priorities; // Priorities of elements stored in the heap.
+    size_t *positions;  // Position of each element in the heap.
     size_t length;      // Current number of elements that are stored in the heap.
     size_t capacity;    // Max number of elements that can be stored in the heap.
 };
@@ -120,6 +515,7 @@ static struct heap *heap_create(size_t capacity)
     h->capacity = capacity;
     assert((h->priorities = malloc(h->capacity * sizeof(h->priorities[0]))) != NULL);
     assert((h->elements = malloc(h->capacity * sizeof(h->elements[0]))) != NULL);
+    assert((h->positions = malloc(h->capacity * sizeof(h->positions[0]))) != NULL);
 
     return (h);
 }
@@ -127,6 +523,7 @@ static struct heap *heap_create(size_t capacity)
 // Destroys a heap.
 static void heap_destroy(struct heap *h)
 {
+    free(h->positions);
     free(h->elements);
     free(h->priorities);
     free(h);
@@ -138,6 +535,15 @@ static size_t heap_length(const struct heap *h)
     return (h->length);
 }
 
+// Swaps two entries of a heap.
+static void heap_swap(struct heap *h, size_t i, size_t j)
+{
+    swap(&h->priorities[i], &h->priorities[j]);
+    swap(&h->elements[i], &h->elements[j]);
+    h->positions[h->elements[i]] = i;
+    h->positions[h->elements[j]] = j;
+}
+
 // Fixes the heap property after an insertion on a heap.
 static void heap_fix_up(struct heap *h, size_t node)
 {
@@ -149,8 +555,7 @@ static void heap_fix_up(struct heap *h, size_t node)
         }
 
         // Swap elements.
-        swap(&h->priorities[root], &h->priorities[node]);
-        swap(&h->elements[root], &h->elements[node]);
+        heap_swap(h, root, node);
         node = root;
     }
 }
@@ -167,6 +572,7 @@ static void heap_push(struct heap *h, size_t element, size_t priority)
     // Insert element;
     h->elements[h->length - 1] = element;
     h->priorities[h->length - 1] = priority;
+    h->positions[element] = h->length - 1;
     if (h->length > 1) {
         heap_fix_up(h, h->length - 1);
     }
@@ -202,8 +608,7 @@ static void heap_fix_down(struct heap *h, size_t root)
         }
 
         // Swap elements and advance root.
-        swap(&h->priorities[root], &h->priorities[smallest]);
-        swap(&h->elements[root], &h->elements[smallest]);
+        heap_swap(h, root, smallest);
         root = smallest;
     } while (true);
 }
@@ -220,8 +625,7 @@ static size_t heap_pop(struct heap *h)
     size_t x = h->elements[0];
 
     // Remove element.
-    swap(&h->priorities[0], &h->priorities[h->length - 1]);
-    swap(&h->elements[0], &h->elements[h->length - 1]);
+    heap_swap(h, 0, h->length - 1);
     h->length -= 1;
     if (h->length > 1) {
         heap_fix_down(h, 0);
@@ -230,139 +634,1912 @@ static size_t heap_pop(struct heap *h)
     return (x);
 }
 
+// Returns the smallest priority in a heap.
+static size_t heap_top_priority(const struct heap *h)
+{
+    assert(h->length > 0);
+
+    return (h->priorities[0]);
+}
+
+// Removes all elements from a heap.
+static void heap_clear(struct heap *h)
+{
+    h->length = 0;
+}
+
 // Decreases the priority of an element in a heap.
 static size_t heap_increase_priority(struct heap *h, size_t element, size_t new_priority)
 {
-    size_t i = 0;
-    size_t old_priority = 0;
-
-    // Empty heap.
-    assert(h->length > 0);
+    size_t i = h->positions[element];
+    size_t old_priority = h->priorities[i];
 
-    // Search for element.
-    for (i = 0; i < h->length; i++) {
-        // Found
-        if (h->elements[i] == element) {
-            assert(h->priorities[i] > new_priority);
-            old_priority = h->priorities[i];
-            h->priorities[i] = new_priority;
-            heap_fix_up(h, i);
-            return (old_priority);
-        }
-    }
+    // The element should be in the heap.
+    assert((i < h->length) && (h->elements[i] == element));
+    assert(old_priority > new_priority);
 
-    // Should not happen.
-    printf("not found %zu\n", element);
-    assert(0);
+    h->priorities[i] = new_priority;
+    heap_fix_up(h, i);
 
-    return (-1);
+    return (old_priority);
 }
 
 //==============================================================================
-// Dijkstra's Algorithm
+// Radix Heap Structure
 //==============================================================================
 
-// Performs a Dijkstra's Algorithm in a graph.
-static size_t dijkstra(const struct graph *g, size_t src, size_t dest, size_t *path)
+// Number of buckets in a radix heap: one for each bit of a key, plus one.
+#define RADIX_NBUCKETS (sizeof(size_t) * 8 + 1)
+
+// A bucket of a radix heap.
+struct radix_bucket {
+    size_t *elements; // Elements stored in the bucket.
+    size_t length;    // Number of elements stored in the bucket.
+    size_t capacity;  // Max number of elements that can be stored in the bucket.
+};
+
+// A monotone radix heap of elements in the range [0, capacity). Keys of
+// pushed elements may not be smaller than the key of the last popped one.
+struct radix_heap {
+    struct radix_bucket buckets[RADIX_NBUCKETS]; // Buckets.
+    size_t *priorities;                          // Priority of each element.
+    size_t *buckets_of;                          // Bucket of each element.
+    size_t *slots;                               // Slot of each element in its bucket.
+    size_t last;                                 // Last popped priority.
+    size_t length;                               // Number of elements in the heap.
+};
+
+// Creates an empty radix heap.
+static struct radix_heap *radix_heap_create(size_t capacity)
 {
-    struct heap *h = NULL;
-    size_t distances[g->nnodes];
+    struct radix_heap *h = malloc(sizeof(struct radix_heap));
+    assert(h != NULL);
 
-    assert((h = heap_create(g->nnodes)) != NULL);
+    // Initialize data structure.
+    h->last = 0;
+    h->length = 0;
+    assert((h->priorities = malloc(capacity * sizeof(h->priorities[0]))) != NULL);
+    assert((h->buckets_of = malloc(capacity * sizeof(h->buckets_of[0]))) != NULL);
+    assert((h->slots = malloc(capacity * sizeof(h->slots[0]))) != NULL);
+    for (size_t i = 0; i < RADIX_NBUCKETS; i++) {
+        h->buckets[i].elements = NULL;
+        h->buckets[i].length = 0;
+        h->buckets[i].capacity = 0;
+    }
 
-    // Push initial distances.
-    distances[src] = 0;
-    for (size_t i = 0; i < g->nnodes; i++) {
-        if (i != src) {
-            path[i] = g->nnodes;
-            distances[i] = (size_t)(-1);
-        }
-        heap_push(h, i, distances[i]);
+    return (h);
+}
+
+// Destroys a radix heap.
+static void radix_heap_destroy(struct radix_heap *h)
+{
+    for (size_t i = 0; i < RADIX_NBUCKETS; i++) {
+        free(h->buckets[i].elements);
     }
+    free(h->slots);
+    free(h->buckets_of);
+    free(h->priorities);
+    free(h);
+}
 
-    // Process all nodes that in the graph.
-    while (heap_length(h) != 0) {
-        size_t i = heap_pop(h);
+// Returns the number of elements that are stored in a radix heap.
+static size_t radix_heap_length(const struct radix_heap *h)
+{
+    return (h->length);
+}
 
-        // Shortest path found.
-        if (i == dest) {
-            break;
-        }
+// Returns the bucket of a priority in a radix heap: the position of the
+// highest bit in which the priority differs from the last popped one.
+static size_t radix_heap_bucket(const struct radix_heap *h, size_t priority)
+{
+    size_t diff = priority ^ h->last;
 
-        // Process all neighbor nodes.
-        for (size_t j = 0; j < g->nnodes; j++) {
-            struct link *l = graph_link(g, i, j);
+    return ((diff == 0) ? 0 : RADIX_NBUCKETS - 1 - (size_t)__builtin_clzl(diff));
+}
 
-            // This is a neighbor.
-            if (l->weight > 0) {
-                size_t new_distance = distances[i] + l->weight;
+// Places an element in the bucket that matches its priority.
+static void radix_heap_place(struct radix_heap *h, size_t element)
+{
+    size_t i = radix_heap_bucket(h, h->priorities[element]);
+    struct radix_bucket *b = &h->buckets[i];
 
-                // Update distances.
-                if (new_distance < distances[j]) {
-                    path[j] = i;
-                    distances[j] = new_distance;
-                    heap_increase_priority(h, j, new_distance);
-                }
-            }
-        }
+    // Grow bucket.
+    if (b->length == b->capacity) {
+        b->capacity = (b->capacity == 0) ? 16 : 2 * b->capacity;
+        assert((b->elements = realloc(b->elements, b->capacity * sizeof(size_t))) != NULL);
     }
 
-    // Release resources.
-    heap_destroy(h);
+    h->buckets_of[element] = i;
+    h->slots[element] = b->length;
+    b->elements[b->length++] = element;
+}
 
-    return (distances[dest]);
+// Takes an element out of its bucket.
+static void radix_heap_unplace(struct radix_heap *h, size_t element)
+{
+    struct radix_bucket *b = &h->buckets[h->buckets_of[element]];
+    size_t last = b->elements[--b->length];
+
+    // Move last element of the bucket to the freed slot.
+    b->elements[h->slots[element]] = last;
+    h->slots[last] = h->slots[element];
 }
 
-//==============================================================================
-// Test
-//==============================================================================
+// Inserts an element in a radix heap.
+static void radix_heap_push(struct radix_heap *h, size_t element, size_t priority)
+{
+    // Keys must be monotone.
+    assert(priority >= h->last);
 
-// Tests Dijkstra's Algorithm.
-static void test(size_t nnodes, bool verbose)
+    h->priorities[element] = priority;
+    radix_heap_place(h, element);
+    h->length += 1;
+}
+
+// Removes the element with the smallest priority from a radix heap.
+static size_t radix_heap_pop(struct radix_heap *h)
 {
-    const float p = 0.55;
-    const unsigned MAX_WEIGTH = (unsigned)nnodes;
-    size_t source = 0;
-    size_t dest = nnodes - 1;
-    size_t path[nnodes];
-    size_t distance = 0;
-    double tstart = 0.0;
-    double tend = 0.0;
-    const double MICROSECS = ((CLOCKS_PER_SEC / 1000000.0));
-    struct graph *g = graph_create(nnodes);
+    struct radix_bucket *b = &h->buckets[0];
 
-    // Fix random number generator seed
-    // to have a determinist behavior across runs.
-    srand(0);
+    // Empty heap.
+    assert(h->length > 0);
 
-    // Initialize the graph.
-    for (size_t i = 0; i < g->nnodes; i++) {
-        for (size_t j = 0; j < g->nnodes; j++) {
-            float q = (rand() % 100) / 100.0;
-            if (q < p) {
-                unsigned w = nnodes + (rand() % MAX_WEIGTH);
-                struct link *l = graph_link(g, i, j);
-                l->weight = w;
+    // Refill the first bucket.
+    if (b->length == 0) {
+        size_t i = 1;
+        struct radix_bucket *full = NULL;
+        size_t n = 0;
+
+        // Find the first non-empty bucket and its smallest priority.
+        while (h->buckets[i].length == 0) {
+            i++;
+        }
+        full = &h->buckets[i];
+        h->last = h->priorities[full->elements[0]];
+        for (size_t j = 1; j < full->length; j++) {
+            if (h->priorities[full->elements[j]] < h->last) {
+                h->last = h->priorities[full->elements[j]];
             }
         }
-    }
-    assert(source < dest);
-    for (size_t i = source; i < dest; i++) {
-        struct link *l = graph_link(g, i, i + 1);
-        l->weight = 1;
-    }
 
-    if (verbose) {
-        graph_print(g, stdout);
+        // Redistribute elements. All of them go to lower buckets.
+        n = full->length;
+        full->length = 0;
+        for (size_t j = 0; j < n; j++) {
+            radix_heap_place(h, full->elements[j]);
+        }
     }
 
-    // Search in the array.
-    tstart = clock();
-    distance = dijkstra(g, source, dest, path);
-    tend = clock();
+    h->length -= 1;
 
-    // Report time.
-    printf("Dijkstra's Algorithm: %2.lf us\n", (tend - tstart) / MICROSECS);
+    return (b->elements[--b->length]);
+}
+
+// Decreases the priority of an element in a radix heap.
+static void radix_heap_decrease_priority(struct radix_heap *h, size_t element,
+                                         size_t new_priority)
+{
+    assert((new_priority >= h->last) && (new_priority < h->priorities[element]));
+
+    radix_heap_unplace(h, element);
+    h->priorities[element] = new_priority;
+    radix_heap_place(h, element);
+}
+
+//==============================================================================
+// Pairing Heap Structure
+//==============================================================================
+
+// Null link in a pairing heap.
+#define PAIRING_NONE ((size_t)-1)
+
+// A pairing heap of elements in the range [0, capacity). Each element is a
+// node of a multi-way tree, linked to its first child and to its siblings.
+struct pairing_heap {
+    size_t *priorities; // Priority of each element.
+    size_t *children;   // First child of each element.
+    size_t *siblings;   // Next sibling of each element.
+    size_t *previous;   // Previous sibling of each element, or parent if first child.
+    size_t root;        // Element with the smallest priority.
+    size_t length;      // Number of elements in the heap.
+};
+
+// Creates an empty pairing heap.
+static struct pairing_heap *pairing_heap_create(size_t capacity)
+{
+    struct pairing_heap *h = malloc(sizeof(struct pairing_heap));
+    assert(h != NULL);
+
+    // Initialize data structure.
+    h->root = PAIRING_NONE;
+    h->length = 0;
+    assert((h->priorities = malloc(capacity * sizeof(h->priorities[0]))) != NULL);
+    assert((h->children = malloc(capacity * sizeof(h->children[0]))) != NULL);
+    assert((h->siblings = malloc(capacity * sizeof(h->siblings[0]))) != NULL);
+    assert((h->previous = malloc(capacity * sizeof(h->previous[0]))) != NULL);
+
+    return (h);
+}
+
+// Destroys a pairing heap.
+static void pairing_heap_destroy(struct pairing_heap *h)
+{
+    free(h->previous);
+    free(h->siblings);
+    free(h->children);
+    free(h->priorities);
+    free(h);
+}
+
+// Returns the number of elements that are stored in a pairing heap.
+static size_t pairing_heap_length(const struct pairing_heap *h)
+{
+    return (h->length);
+}
+
+// Melds two trees of a pairing heap and returns the root of the resulting tree.
+static size_t pairing_heap_meld(struct pairing_heap *h, size_t x, size_t y)
+{
+    // The root with the largest priority becomes the first child of the other.
+    if (h->priorities[y] < h->priorities[x]) {
+        size_t tmp = x;
+        x = y;
+        y = tmp;
+    }
+    h->siblings[y] = h->children[x];
+    if (h->children[x] != PAIRING_NONE) {
+        h->previous[h->children[x]] = y;
+    }
+    h->previous[y] = x;
+    h->children[x] = y;
+
+    return (x);
+}
+
+// Inserts an element in a pairing heap.
+static void pairing_heap_push(struct pairing_heap *h, size_t element, size_t priority)
+{
+    h->priorities[element] = priority;
+    h->children[element] = PAIRING_NONE;
+    h->siblings[element] = PAIRING_NONE;
+    h->previous[element] = PAIRING_NONE;
+    h->root = (h->root == PAIRING_NONE) ? element : pairing_heap_meld(h, h->root, element);
+    h->length += 1;
+}
+
+// Removes the element with the smallest priority from a pairing heap.
+static size_t pairing_heap_pop(struct pairing_heap *h)
+{
+    size_t x = h->root;
+    size_t child = PAIRING_NONE;
+    size_t pairs = PAIRING_NONE;
+
+    // Empty heap.
+    assert(h->length > 0);
+
+    // First pass: meld children in pairs, from left to right, and stack the results.
+    child = h->children[x];
+    while (child != PAIRING_NONE) {
+        size_t y = child;
+        size_t z = h->siblings[y];
+        size_t next = (z == PAIRING_NONE) ? PAIRING_NONE : h->siblings[z];
+
+        h->siblings[y] = PAIRING_NONE;
+        if (z != PAIRING_NONE) {
+            h->siblings[z] = PAIRING_NONE;
+            y = pairing_heap_meld(h, y, z);
+        }
+        h->siblings[y] = pairs;
+        pairs = y;
+        child = next;
+    }
+
+    // Second pass: meld stacked trees, from right to left.
+    h->root = PAIRING_NONE;
+    while (pairs != PAIRING_NONE) {
+        size_t y = pairs;
+
+        pairs = h->siblings[y];
+        h->siblings[y] = PAIRING_NONE;
+        h->root = (h->root == PAIRING_NONE) ? y : pairing_heap_meld(h, h->root, y);
+    }
+    if (h->root != PAIRING_NONE) {
+        h->previous[h->root] = PAIRING_NONE;
+    }
+
+    h->length -= 1;
+
+    return (x);
+}
+
+// Decreases the priority of an element in a pairing heap.
+static void pairing_heap_decrease_priority(struct pairing_heap *h, size_t element,
+                                           size_t new_priority)
+{
+    size_t prev = h->previous[element];
+
+    assert(new_priority < h->priorities[element]);
+
+    h->priorities[element] = new_priority;
+
+    // Root remains the root.
+    if (element == h->root) {
+        return;
+    }
+
+    // Cut the subtree of the element, and meld it with the root.
+    if (h->children[prev] == element) {
+        h->children[prev] = h->siblings[element];
+    } else {
+        h->siblings[prev] = h->siblings[element];
+    }
+    if (h->siblings[element] != PAIRING_NONE) {
+        h->previous[h->siblings[element]] = prev;
+    }
+    h->siblings[element] = PAIRING_NONE;
+    h->previous[element] = PAIRING_NONE;
+    h->root = pairing_heap_meld(h, h->root, element);
+}
+
+//==============================================================================
+// Priority Queue
+//==============================================================================
+
+// Kinds of priority queues.
+enum queue_kind {
+    QUEUE_BINARY,  // Binary heap.
+    QUEUE_RADIX,   // Radix heap.
+    QUEUE_PAIRING, // Pairing heap.
+};
+
+// A priority queue that dispatches to one of the heaps.
+struct queue {
+    enum queue_kind kind; // Kind of the queue.
+    union {
+        struct heap *binary;
+        struct radix_heap *radix;
+        struct pairing_heap *pairing;
+    } u; // Underlying heap.
+};
+
+// Creates an empty priority queue.
+static struct queue queue_create(enum queue_kind kind, size_t capacity)
+{
+    struct queue q;
+
+    q.kind = kind;
+    switch (kind) {
+        case QUEUE_BINARY:
+            q.u.binary = heap_create(capacity);
+            break;
+        case QUEUE_RADIX:
+            q.u.radix = radix_heap_create(capacity);
+            break;
+        case QUEUE_PAIRING:
+        default:
+            q.u.pairing = pairing_heap_create(capacity);
+            break;
+    }
+
+    return (q);
+}
+
+// Destroys a priority queue.
+static void queue_destroy(struct queue *q)
+{
+    switch (q->kind) {
+        case QUEUE_BINARY:
+            heap_destroy(q->u.binary);
+            break;
+        case QUEUE_RADIX:
+            radix_heap_destroy(q->u.radix);
+            break;
+        case QUEUE_PAIRING:
+        default:
+            pairing_heap_destroy(q->u.pairing);
+            break;
+    }
+}
+
+// Returns the number of elements that are stored in a priority queue.
+static size_t queue_length(const struct queue *q)
+{
+    switch (q->kind) {
+        case QUEUE_BINARY:
+            return (heap_length(q->u.binary));
+        case QUEUE_RADIX:
+            return (radix_heap_length(q->u.radix));
+        case QUEUE_PAIRING:
+        default:
+            return (pairing_heap_length(q->u.pairing));
+    }
+}
+
+// Inserts an element in a priority queue.
+static void queue_push(struct queue *q, size_t element, size_t priority)
+{
+    switch (q->kind) {
+        case QUEUE_BINARY:
+            heap_push(q->u.binary, element, priority);
+            break;
+        case QUEUE_RADIX:
+            radix_heap_push(q->u.radix, element, priority);
+            break;
+        case QUEUE_PAIRING:
+        default:
+            pairing_heap_push(q->u.pairing, element, priority);
+            break;
+    }
+}
+
+// Removes the element with the smallest priority from a priority queue.
+static size_t queue_pop(struct queue *q)
+{
+    switch (q->kind) {
+        case QUEUE_BINARY:
+            return (heap_pop(q->u.binary));
+        case QUEUE_RADIX:
+            return (radix_heap_pop(q->u.radix));
+        case QUEUE_PAIRING:
+        default:
+            return (pairing_heap_pop(q->u.pairing));
+    }
+}
+
+// Decreases the priority of an element in a priority queue.
+static void queue_decrease_priority(struct queue *q, size_t element, size_t new_priority)
+{
+    switch (q->kind) {
+        case QUEUE_BINARY:
+            heap_increase_priority(q->u.binary, element, new_priority);
+            break;
+        case QUEUE_RADIX:
+            radix_heap_decrease_priority(q->u.radix, element, new_priority);
+            break;
+        case QUEUE_PAIRING:
+        default:
+            pairing_heap_decrease_priority(q->u.pairing, element, new_priority);
+            break;
+    }
+}
+
+//==============================================================================
+// Dijkstra's Algorithm
+//==============================================================================
+
+// Performs a Dijkstra's Algorithm in a graph.
+static size_t dijkstra(const struct graph *g, size_t src, size_t dest, size_t *path)
+{
+    struct heap *h = NULL;
+    size_t distances[g->nnodes];
+
+    assert((h = heap_create(g->nnodes)) != NULL);
+
+    // Push initial distances.
+    distances[src] = 0;
+    for (size_t i = 0; i < g->nnodes; i++) {
+        if (i != src) {
+            path[i] = g->nnodes;
+            distances[i] = (size_t)(-1);
+        }
+        heap_push(h, i, distances[i]);
+    }
+
+    // Process all nodes that in the graph.
+    while (heap_length(h) != 0) {
+        size_t i = heap_pop(h);
+
+        // Shortest path found.
+        if (i == dest) {
+            break;
+        }
+
+        // Process all neighbor nodes.
+        for (size_t j = 0; j < g->nnodes; j++) {
+            struct link *l = graph_link(g, i, j);
+
+            // This is a neighbor.
+            if (l->weight > 0) {
+                size_t new_distance = distances[i] + l->weight;
+
+                // Update distances.
+                if (new_distance < distances[j]) {
+                    path[j] = i;
+                    distances[j] = new_distance;
+                    heap_increase_priority(h, j, new_distance);
+                }
+            }
+        }
+    }
+
+    // Release resources.
+    heap_destroy(h);
+
+    return (distances[dest]);
+}
+
+// Performs a Dijkstra's Algorithm from a source to all nodes in a sparse graph.
+static void dijkstra_sparse(const struct csr *g, size_t src, size_t *distances,
+                            enum queue_kind kind)
+{
+    struct queue q = queue_create(kind, g->nnodes);
+
+    // Push the source only, other nodes are pushed when first reached.
+    for (size_t i = 0; i < g->nnodes; i++) {
+        distances[i] = (size_t)(-1);
+    }
+    distances[src] = 0;
+    queue_push(&q, src, 0);
+
+    // Process all reachable nodes.
+    while (queue_length(&q) != 0) {
+        size_t i = queue_pop(&q);
+
+        // Process all neighbor nodes.
+        for (size_t k = g->offsets[i]; k < g->offsets[i + 1]; k++) {
+            size_t j = g->targets[k];
+            size_t new_distance = distances[i] + g->weights[k];
+
+            // Update distances.
+            if (new_distance < distances[j]) {
+                if (distances[j] == (size_t)(-1)) {
+                    queue_push(&q, j, new_distance);
+                } else {
+                    queue_decrease_priority(&q, j, new_distance);
+                }
+                distances[j] = new_distance;
+            }
+        }
+    }
+
+    // Release resources.
+    queue_destroy(&q);
+}
+
+//==============================================================================
+// Point-to-Point Queries
+//==============================================================================
+
+// Workspace of point-to-point queries in a sparse graph. It is reused across
+// queries, and only nodes that were reached are reset, thus the cost of a
+// query depends on the number of nodes that it reaches only.
+struct search {
+    size_t *distances; // Tentative distance of each node.
+    bool *settled;     // Nodes whose distance is final.
+    size_t *reached;   // Nodes with a finite distance.
+    size_t nreached;   // Number of nodes with a finite distance.
+    size_t nsettled;   // Number of nodes settled by the last query.
+    struct heap *heap; // Nodes to settle.
+};
+
+// Creates a workspace for point-to-point queries.
+static struct search *search_create(size_t nnodes)
+{
+    struct search *s = NULL;
+
+    assert((s = malloc(sizeof(struct search))) != NULL);
+    assert((s->distances = malloc(nnodes * sizeof(size_t))) != NULL);
+    assert((s->settled = calloc(nnodes, sizeof(bool))) != NULL);
+    assert((s->reached = malloc(nnodes * sizeof(size_t))) != NULL);
+    s->heap = heap_create(nnodes);
+    s->nreached = 0;
+    s->nsettled = 0;
+    for (size_t i = 0; i < nnodes; i++) {
+        s->distances[i] = (size_t)(-1);
+    }
+
+    return (s);
+}
+
+// Destroys a workspace for point-to-point queries.
+static void search_destroy(struct search *s)
+{
+    heap_destroy(s->heap);
+    free(s->reached);
+    free(s->settled);
+    free(s->distances);
+    free(s);
+}
+
+// Resets the nodes that were reached by the last query.
+static void search_reset(struct search *s)
+{
+    for (size_t i = 0; i < s->nreached; i++) {
+        s->distances[s->reached[i]] = (size_t)(-1);
+        s->settled[s->reached[i]] = false;
+    }
+    s->nreached = 0;
+    s->nsettled = 0;
+    heap_clear(s->heap);
+}
+
+// Updates the distance and the priority of a node. A node that was settled is
+// pushed again, thus heuristics that are admissible but not consistent still
+// find shortest paths.
+static void search_update(struct search *s, size_t i, size_t distance, size_t priority)
+{
+    if (s->distances[i] == (size_t)(-1)) {
+        s->reached[s->nreached++] = i;
+        heap_push(s->heap, i, priority);
+    } else if (s->settled[i]) {
+        s->settled[i] = false;
+        heap_push(s->heap, i, priority);
+    } else {
+        heap_increase_priority(s->heap, i, priority);
+    }
+    s->distances[i] = distance;
+}
+
+// Removes the node with the smallest priority from a workspace and settles it.
+static size_t search_settle(struct search *s)
+{
+    size_t i = heap_pop(s->heap);
+
+    s->settled[i] = true;
+    s->nsettled++;
+
+    return (i);
+}
+
+// Performs a Dijkstra's Algorithm from a source to a destination in a sparse
+// graph. The search stops as soon as the destination is settled.
+static size_t dijkstra_query(const struct csr *g, struct search *s, size_t src, size_t dest)
+{
+    search_reset(s);
+    search_update(s, src, 0, 0);
+
+    while (heap_length(s->heap) != 0) {
+        size_t i = search_settle(s);
+
+        // Shortest path found.
+        if (i == dest) {
+            break;
+        }
+
+        // Process all neighbor nodes.
+        for (size_t k = g->offsets[i]; k < g->offsets[i + 1]; k++) {
+            size_t j = g->targets[k];
+            size_t new_distance = s->distances[i] + g->weights[k];
+
+            if (new_distance < s->distances[j]) {
+                search_update(s, j, new_distance, new_distance);
+            }
+        }
+    }
+
+    return (s->distances[dest]);
+}
+
+// Performs a bidirectional Dijkstra's Algorithm from a source to a destination
+// in a sparse graph. A forward search runs on the graph and a backward search
+// runs on its reverse, settling nodes of the search with the smallest tentative
+// distance first. The shortest path is known once the sum of the smallest
+// tentative distances of both searches reaches the length of the best path
+// that connects them.
+static size_t dijkstra_bidirectional(const struct csr *g, const struct csr *r,
+                                     struct search *forward, struct search *backward,
+                                     size_t src, size_t dest)
+{
+    size_t best = (src == dest) ? 0 : (size_t)(-1);
+
+    search_reset(forward);
+    search_reset(backward);
+    search_update(forward, src, 0, 0);
+    search_update(backward, dest, 0, 0);
+
+    while ((heap_length(forward->heap) != 0) && (heap_length(backward->heap) != 0)) {
+        size_t ftop = heap_top_priority(forward->heap);
+        size_t btop = heap_top_priority(backward->heap);
+        bool is_forward = (ftop <= btop);
+        const struct csr *h = is_forward ? g : r;
+        struct search *s = is_forward ? forward : backward;
+        struct search *other = is_forward ? backward : forward;
+
+        // Stopping criterion.
+        if (ftop + btop >= best) {
+            break;
+        }
+
+        size_t i = search_settle(s);
+
+        // Process all neighbor nodes.
+        for (size_t k = h->offsets[i]; k < h->offsets[i + 1]; k++) {
+            size_t j = h->targets[k];
+            size_t new_distance = s->distances[i] + h->weights[k];
+
+            if (new_distance < s->distances[j]) {
+                search_update(s, j, new_distance, new_distance);
+            }
+
+            // Both searches met.
+            if ((other->distances[j] != (size_t)(-1)) &&
+                (s->distances[j] + other->distances[j] < best)) {
+                best = s->distances[j] + other->distances[j];
+            }
+        }
+    }
+
+    return (best);
+}
+
+// A heuristic for the A* Algorithm. It estimates the distance between two
+// nodes, and it is admissible if it never overestimates it.
+struct heuristic {
+    const void *arg;                                         // Argument of the estimate.
+    size_t (*estimate)(const void *arg, size_t i, size_t j); // Estimates distance from i to j.
+};
+
+// Nodes of a graph that are laid out in a plane, and in which no link is
+// lighter than its length times a scale.
+struct euclidean {
+    const struct node *nodes; // Coordinates of each node.
+    double scale;             // Smallest weight of a unit of length.
+};
+
+// Estimates the distance between two nodes with their Euclidean distance.
+static size_t euclidean_estimate(const void *arg, size_t i, size_t j)
+{
+    const struct euclidean *e = arg;
+
+    return ((size_t)(e->scale * node_distance(&e->nodes[i], &e->nodes[j])));
+}
+
+// Performs an A* Algorithm from a source to a destination in a sparse graph.
+// Nodes are settled in order of their distance from the source plus the
+// estimated distance to the destination.
+static size_t astar(const struct csr *g, struct search *s, const struct heuristic *h,
+                    size_t src, size_t dest)
+{
+    search_reset(s);
+    search_update(s, src, 0, h->estimate(h->arg, src, dest));
+
+    while (heap_length(s->heap) != 0) {
+        size_t i = search_settle(s);
+
+        // Shortest path found.
+        if (i == dest) {
+            break;
+        }
+
+        // Process all neighbor nodes.
+        for (size_t k = g->offsets[i]; k < g->offsets[i + 1]; k++) {
+            size_t j = g->targets[k];
+            size_t new_distance = s->distances[i] + g->weights[k];
+
+            if (new_distance < s->distances[j]) {
+                search_update(s, j, new_distance, new_distance + h->estimate(h->arg, j, dest));
+            }
+        }
+    }
+
+    return (s->distances[dest]);
+}
+
+//==============================================================================
+// Delta-Stepping
+//==============================================================================
+
+// A growable list of nodes.
+struct bin {
+    size_t *nodes;   // Nodes.
+    size_t length;   // Number of nodes.
+    size_t capacity; // Max number of nodes before growing.
+};
+
+// Appends a node to a list.
+static void bin_push(struct bin *b, size_t node)
+{
+    if (b->length == b->capacity) {
+        b->capacity = (b->capacity == 0) ? 64 : 2 * b->capacity;
+        assert((b->nodes = realloc(b->nodes, b->capacity * sizeof(size_t))) != NULL);
+    }
+    b->nodes[b->length++] = node;
+}
+
+// A thread of a delta-stepping. Each thread keeps its own buckets, so that
+// threads never contend on insertions.
+struct delta_worker {
+    pthread_t thread;          // Thread.
+    size_t id;                 // Thread number.
+    struct delta_stepping *ds; // Shared state.
+    struct bin *buckets;       // Local buckets.
+    size_t nbuckets;           // Number of local buckets.
+    struct bin settled;        // Nodes settled in the current bucket.
+    size_t count;              // Nodes in the current local bucket.
+    size_t next;               // First non-empty local bucket after the current one.
+};
+
+// Shared state of a delta-stepping.
+struct delta_stepping {
+    const struct csr *g;          // Graph.
+    size_t delta;                 // Width of a bucket.
+    size_t nthreads;              // Number of threads.
+    _Atomic size_t *distances;    // Tentative distance of each node.
+    size_t *frontier;             // Nodes of the current bucket, gathered from all threads.
+    size_t nfrontier;             // Number of nodes in the frontier.
+    size_t frontier_capacity;     // Max number of nodes in the frontier before growing.
+    size_t current;               // Current bucket.
+    pthread_barrier_t barrier;    // Synchronizes all threads between steps.
+    struct delta_worker *workers; // Threads.
+};
+
+// Lowers the tentative distance of a node and, on success, inserts it in the
+// local bucket that matches its new distance.
+static void delta_relax(struct delta_worker *w, size_t node, size_t distance)
+{
+    struct delta_stepping *ds = w->ds;
+    size_t old = atomic_load_explicit(&ds->distances[node], memory_order_relaxed);
+
+    while (distance < old) {
+        if (atomic_compare_exchange_weak_explicit(&ds->distances[node], &old, distance,
+                                                  memory_order_relaxed, memory_order_relaxed)) {
+            size_t b = distance / ds->delta;
+
+            // Grow local buckets.
+            if (b >= w->nbuckets) {
+                size_t n = (2 * w->nbuckets > b + 1) ? 2 * w->nbuckets : b + 1;
+                assert((w->buckets = realloc(w->buckets, n * sizeof(struct bin))) != NULL);
+                memset(&w->buckets[w->nbuckets], 0, (n - w->nbuckets) * sizeof(struct bin));
+                w->nbuckets = n;
+            }
+            bin_push(&w->buckets[b], node);
+            break;
+        }
+    }
+}
+
+// Relaxes light (weight < delta) or heavy edges that leave a node.
+static void delta_relax_edges(struct delta_worker *w, size_t i, bool light)
+{
+    const struct csr *g = w->ds->g;
+    size_t distance = atomic_load_explicit(&w->ds->distances[i], memory_order_relaxed);
+
+    for (size_t k = g->offsets[i]; k < g->offsets[i + 1]; k++) {
+        if ((g->weights[k] < w->ds->delta) == light) {
+            delta_relax(w, g->targets[k], distance + g->weights[k]);
+        }
+    }
+}
+
+// Runs a thread of a delta-stepping. Buckets are processed in order. Nodes
+// of the current bucket are gathered from all threads and split among them,
+// and their light edges are relaxed until the bucket stays empty: these may
+// insert nodes back in it. Heavy edges can only reach later buckets, so they
+// are relaxed once, after the bucket is settled.
+static void *delta_worker(void *arg)
+{
+    struct delta_worker *w = arg;
+    struct delta_stepping *ds = w->ds;
+
+    do {
+        // Light edges.
+        do {
+            size_t offset = 0;
+
+            // Gather the current bucket.
+            w->count = (ds->current < w->nbuckets) ? w->buckets[ds->current].length : 0;
+            pthread_barrier_wait(&ds->barrier);
+            if (w->id == 0) {
+                ds->nfrontier = 0;
+                for (size_t i = 0; i < ds->nthreads; i++) {
+                    ds->nfrontier += ds->workers[i].count;
+                }
+                if (ds->nfrontier > ds->frontier_capacity) {
+                    ds->frontier_capacity = 2 * ds->nfrontier;
+                    free(ds->frontier);
+                    ds->frontier = malloc(ds->frontier_capacity * sizeof(size_t));
+                    assert(ds->frontier != NULL);
+                }
+            }
+            pthread_barrier_wait(&ds->barrier);
+            if (ds->nfrontier == 0) {
+                break;
+            }
+            for (size_t i = 0; i < w->id; i++) {
+                offset += ds->workers[i].count;
+            }
+            if (w->count > 0) {
+                memcpy(&ds->frontier[offset], w->buckets[ds->current].nodes,
+                       w->count * sizeof(size_t));
+                w->buckets[ds->current].length = 0;
+            }
+            pthread_barrier_wait(&ds->barrier);
+
+            // Relax light edges of my share of the bucket, skipping nodes that
+            // have since moved to a lower bucket.
+            for (size_t j = (ds->nfrontier * w->id) / ds->nthreads;
+                 j < (ds->nfrontier * (w->id + 1)) / ds->nthreads; j++) {
+                size_t i = ds->frontier[j];
+                size_t distance = atomic_load_explicit(&ds->distances[i], memory_order_relaxed);
+                if (distance / ds->delta == ds->current) {
+                    bin_push(&w->settled, i);
+                    delta_relax_edges(w, i, true);
+                }
+            }
+        } while (true);
+
+        // Heavy edges.
+        for (size_t j = 0; j < w->settled.length; j++) {
+            delta_relax_edges(w, w->settled.nodes[j], false);
+        }
+        w->settled.length = 0;
+
+        // Find the next non-empty bucket.
+        w->next = (size_t)(-1);
+        for (size_t b = ds->current + 1; b < w->nbuckets; b++) {
+            if (w->buckets[b].length > 0) {
+                w->next = b;
+                break;
+            }
+        }
+        pthread_barrier_wait(&ds->barrier);
+        if (w->id == 0) {
+            ds->current = (size_t)(-1);
+            for (size_t i = 0; i < ds->nthreads; i++) {
+                if (ds->workers[i].next < ds->current) {
+                    ds->current = ds->workers[i].next;
+                }
+            }
+        }
+        pthread_barrier_wait(&ds->barrier);
+    } while (ds->current != (size_t)(-1));
+
+    return (NULL);
+}
+
+// Performs a delta-stepping from a source to all nodes in a sparse graph,
+// using multiple threads. Tentative distances are kept in buckets of width
+// delta: a small delta settles few nodes per step, and a large one relaxes
+// edges of nodes whose distances are not final yet.
+static void delta_stepping(const struct csr *g, size_t src, size_t *distances, size_t delta,
+                           size_t nthreads)
+{
+    struct delta_stepping ds;
+    struct delta_worker workers[DIJKSTRA_MAX_THREADS];
+
+    assert((nthreads >= 1) && (nthreads <= DIJKSTRA_MAX_THREADS) && (delta > 0));
+
+    // Initialize shared state.
+    ds.g = g;
+    ds.delta = delta;
+    ds.nthreads = nthreads;
+    ds.frontier = NULL;
+    ds.nfrontier = 0;
+    ds.frontier_capacity = 0;
+    ds.current = 0;
+    ds.workers = workers;
+    assert((ds.distances = malloc(g->nnodes * sizeof(_Atomic size_t))) != NULL);
+    for (size_t i = 0; i < g->nnodes; i++) {
+        atomic_init(&ds.distances[i], (size_t)(-1));
+    }
+    int ret = pthread_barrier_init(&ds.barrier, NULL, nthreads);
+    assert(ret == 0);
+    ((void)ret);
+
+    // Initialize threads. The source goes to the first one.
+    for (size_t i = 0; i < nthreads; i++) {
+        workers[i].id = i;
+        workers[i].ds = &ds;
+        workers[i].buckets = NULL;
+        workers[i].nbuckets = 0;
+        workers[i].settled = (struct bin){NULL, 0, 0};
+    }
+    delta_relax(&workers[0], src, 0);
+
+    // Run threads.
+    for (size_t i = 0; i < nthreads; i++) {
+        ret = pthread_create(&workers[i].thread, NULL, delta_worker, &workers[i]);
+        assert(ret == 0);
+    }
+    for (size_t i = 0; i < nthreads; i++) {
+        pthread_join(workers[i].thread, NULL);
+    }
+
+    // Collect distances.
+    for (size_t i = 0; i < g->nnodes; i++) {
+        distances[i] = atomic_load_explicit(&ds.distances[i], memory_order_relaxed);
+    }
+
+    // Release resources.
+    for (size_t i = 0; i < nthreads; i++) {
+        for (size_t b = 0; b < workers[i].nbuckets; b++) {
+            free(workers[i].buckets[b].nodes);
+        }
+        free(workers[i].buckets);
+        free(workers[i].settled.nodes);
+    }
+    pthread_barrier_destroy(&ds.barrier);
+    free(ds.frontier);
+    free(ds.distances);
+}
+
+// Returns the current time in microseconds.
+static double now(void)
+{
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+
+    return (ts.tv_sec * 1000000.0 + ts.tv_nsec / 1000.0);
+}
+
+// Tunes the width of buckets for delta-stepping on a graph. Candidates are
+// powers of two around the largest weight divided by the average degree, and
+// the one with the fastest search from a sample source wins.
+static size_t delta_tune(const struct csr *g, size_t src, size_t nthreads)
+{
+    size_t best = 1;
+    double best_time = 0.0;
+    size_t max_weight = 1;
+    size_t guess = 1;
+    size_t *distances = NULL;
+
+    if (g->nedges == 0) {
+        return (1);
+    }
+
+    // Initial guess.
+    for (size_t k = 0; k < g->nedges; k++) {
+        if (g->weights[k] > max_weight) {
+            max_weight = g->weights[k];
+        }
+    }
+    guess = (max_weight * g->nnodes) / g->nedges;
+    guess = (guess > 0) ? guess : 1;
+
+    // Try candidates.
+    assert((distances = malloc(g->nnodes * sizeof(size_t))) != NULL);
+    for (size_t delta = (guess >= 4) ? guess / 4 : 1; delta <= 16 * guess; delta *= 2) {
+        double tstart = now();
+        delta_stepping(g, src, distances, delta, nthreads);
+        double elapsed = now() - tstart;
+        if ((best_time <= 0.0) || (elapsed < best_time)) {
+            best = delta;
+            best_time = elapsed;
+        }
+    }
+    free(distances);
+
+    return (best);
+}
+
+// A thread of a multi-source search.
+struct sssp_worker {
+    pthread_t thread;      // Thread.
+    const struct csr *g;   // Graph.
+    const size_t *sources; // Sources.
+    size_t nsources;       // Number of sources.
+    _Atomic size_t *next;  // Next source to search from.
+    size_t **distances;    // Distances from each source.
+};
+
+// Runs a thread of a multi-source search: each source is searched by a
+// single thread, and threads grab sources until none is left.
+static void *sssp_worker(void *arg)
+{
+    struct sssp_worker *w = arg;
+    size_t i = 0;
+
+    while ((i = atomic_fetch_add_explicit(w->next, 1, memory_order_relaxed)) < w->nsources) {
+        dijkstra_sparse(w->g, w->sources[i], w->distances[i], QUEUE_RADIX);
+    }
+
+    return (NULL);
+}
+
+// Performs Dijkstra's Algorithm from multiple sources in a sparse graph. Sources
+// are independent, thus they are searched in parallel without synchronization.
+static void dijkstra_many(const struct csr *g, const size_t *sources, size_t nsources,
+                          size_t **distances, size_t nthreads)
+{
+    struct sssp_worker workers[DIJKSTRA_MAX_THREADS];
+    _Atomic size_t next;
+
+    assert((nthreads >= 1) && (nthreads <= DIJKSTRA_MAX_THREADS));
+    atomic_init(&next, 0);
+
+    for (size_t i = 0; i < nthreads; i++) {
+        workers[i] = (struct sssp_worker){0, g, sources, nsources, &next, distances};
+        int ret = pthread_create(&workers[i].thread, NULL, sssp_worker, &workers[i]);
+        assert(ret == 0);
+        ((void)ret);
+    }
+    for (size_t i = 0; i < nthreads; i++) {
+        pthread_join(workers[i].thread, NULL);
+    }
+}
+
+//==============================================================================
+// Contraction Hierarchies
+//==============================================================================
+
+// An arc of a graph under contraction.
+struct ch_arc {
+    unsigned node;   // Node at the other end.
+    unsigned weight; // Weight.
+};
+
+// A growable list of arcs.
+struct ch_arcs {
+    struct ch_arc *arcs; // Arcs.
+    size_t length;       // Number of arcs.
+    size_t capacity;     // Max number of arcs before growing.
+};
+
+// Appends an arc to a list, or lowers the weight of an existing arc to the same node.
+static void ch_arcs_add(struct ch_arcs *l, unsigned node, unsigned weight)
+{
+    for (size_t k = 0; k < l->length; k++) {
+        if (l->arcs[k].node == node) {
+            if (weight < l->arcs[k].weight) {
+                l->arcs[k].weight = weight;
+            }
+            return;
+        }
+    }
+
+    if (l->length == l->capacity) {
+        l->capacity = (l->capacity == 0) ? 4 : 2 * l->capacity;
+        assert((l->arcs = realloc(l->arcs, l->capacity * sizeof(struct ch_arc))) != NULL);
+    }
+    l->arcs[l->length++] = (struct ch_arc){node, weight};
+}
+
+// Removes the arc to a node from a list.
+static void ch_arcs_remove(struct ch_arcs *l, unsigned node)
+{
+    for (size_t k = 0; k < l->length; k++) {
+        if (l->arcs[k].node == node) {
+            l->arcs[k] = l->arcs[--l->length];
+            return;
+        }
+    }
+}
+
+// State of the preprocessing of a contraction hierarchy. When a node is
+// contracted, all of its neighbors are ranked higher, thus its arcs are kept
+// to build the hierarchy, and arcs to it are removed from its neighbors.
+struct ch_builder {
+    size_t nnodes;          // Number of nodes.
+    struct ch_arcs *out;    // Arcs leaving each node.
+    struct ch_arcs *in;     // Arcs entering each node.
+    size_t *deleted;        // Number of contracted neighbors of each node.
+    size_t *targets;        // Stamp of the last contraction that targets each node.
+    size_t stamp;           // Stamp of the current contraction.
+    struct search *witness; // Workspace of witness searches.
+};
+
+// Searches for paths from a node that avoid the node being contracted, up to
+// a distance. The search stops once all targets are settled. It also gives
+// up after settling a few nodes, in which case the contraction adds shortcuts
+// that may not be needed, but never misses one.
+static void ch_witness(struct ch_builder *b, size_t src, size_t skip, size_t max_distance,
+                       size_t ntargets)
+{
+    struct search *s = b->witness;
+
+    search_reset(s);
+    search_update(s, src, 0, 0);
+
+    while ((heap_length(s->heap) != 0) && (s->nsettled < CH_WITNESS_LIMIT)) {
+        size_t i = search_settle(s);
+
+        if ((s->distances[i] > max_distance) ||
+            ((b->targets[i] == b->stamp) && (i != src) && (--ntargets == 0))) {
+            break;
+        }
+
+        for (size_t k = 0; k < b->out[i].length; k++) {
+            size_t j = b->out[i].arcs[k].node;
+            size_t new_distance = s->distances[i] + b->out[i].arcs[k].weight;
+
+            if ((j != skip) && (new_distance < s->distances[j])) {
+                search_update(s, j, new_distance, new_distance);
+            }
+        }
+    }
+}
+
+// Contracts a node: for each pair of neighbors u -> v -> x, a shortcut u -> x
+// is added unless a witness path from u to x that avoids v is not longer.
+// Returns the number of shortcuts. If simulate is set, shortcuts are only
+// counted.
+static size_t ch_contract(struct ch_builder *b, size_t v, bool simulate)
+{
+    const struct ch_arcs *in = &b->in[v];
+    const struct ch_arcs *out = &b->out[v];
+    size_t nshortcuts = 0;
+    unsigned max_out = 0;
+
+    // Mark targets with a fresh stamp, so that marks of earlier contractions,
+    // simulated or not, never count.
+    b->stamp++;
+    for (size_t k = 0; k < out->length; k++) {
+        b->targets[out->arcs[k].node] = b->stamp;
+        if (out->arcs[k].weight > max_out) {
+            max_out = out->arcs[k].weight;
+        }
+    }
+
+    for (size_t k = 0; k < in->length; k++) {
+        unsigned u = in->arcs[k].node;
+        unsigned w1 = in->arcs[k].weight;
+
+        ch_witness(b, u, v, (size_t)w1 + max_out, out->length - (b->targets[u] == b->stamp));
+        for (size_t l = 0; l < out->length; l++) {
+            unsigned x = out->arcs[l].node;
+            unsigned w2 = out->arcs[l].weight;
+
+            if ((x == u) || (b->witness->distances[x] <= (size_t)w1 + w2)) {
+                continue;
+            }
+
+            nshortcuts++;
+            if (!simulate) {
+                ch_arcs_add(&b->out[u], x, w1 + w2);
+                ch_arcs_add(&b->in[x], u, w1 + w2);
+            }
+        }
+    }
+
+    if (!simulate) {
+        for (size_t k = 0; k < in->length; k++) {
+            ch_arcs_remove(&b->out[in->arcs[k].node], (unsigned)v);
+            b->deleted[in->arcs[k].node]++;
+        }
+        for (size_t k = 0; k < out->length; k++) {
+            ch_arcs_remove(&b->in[out->arcs[k].node], (unsigned)v);
+            b->deleted[out->arcs[k].node]++;
+        }
+    }
+
+    return (nshortcuts);
+}
+
+// Computes the priority of a node for contraction: its edge difference (the
+// number of shortcuts that contracting it adds minus the number of arcs that
+// it removes) plus its number of contracted neighbors, which spreads
+// contractions uniformly across the graph.
+static size_t ch_priority(struct ch_builder *b, size_t v)
+{
+    size_t degree = b->in[v].length + b->out[v].length;
+
+    return (CH_PRIORITY_BIAS + ch_contract(b, v, true) + b->deleted[v] - degree);
+}
+
+// Builds a sparse graph from the arcs that are left after all nodes are
+// contracted. These lead to higher-ranked nodes only.
+static struct csr *ch_upward(const struct ch_arcs *arcs, size_t nnodes)
+{
+    struct csr *g = NULL;
+    size_t k = 0;
+
+    assert((g = malloc(sizeof(struct csr))) != NULL);
+    g->nnodes = nnodes;
+    g->nodes = NULL;
+    g->mapping = NULL;
+    g->mapping_size = 0;
+    assert((g->offsets = malloc((nnodes + 1) * sizeof(size_t))) != NULL);
+
+    // Count arcs.
+    g->nedges = 0;
+    for (size_t i = 0; i < nnodes; i++) {
+        g->nedges += arcs[i].length;
+    }
+    assert((g->targets = malloc(g->nedges * sizeof(unsigned))) != NULL);
+    assert((g->weights = malloc(g->nedges * sizeof(unsigned))) != NULL);
+
+    // Place arcs.
+    for (size_t i = 0; i < nnodes; i++) {
+        g->offsets[i] = k;
+        for (size_t l = 0; l < arcs[i].length; l++) {
+            g->targets[k] = arcs[i].arcs[l].node;
+            g->weights[k] = arcs[i].arcs[l].weight;
+            k++;
+        }
+    }
+    g->offsets[nnodes] = k;
+
+    return (g);
+}
+
+// A contraction hierarchy. Nodes are ranked by the order in which they were
+// contracted, and shortcuts preserve distances among the remaining nodes. A
+// query only follows edges towards higher-ranked nodes, from both ends.
+struct ch {
+    struct csr *forward;  // Upward edges leaving each node.
+    struct csr *backward; // Upward edges entering each node, reversed.
+    void *mapping;        // Mapped file (NULL if allocated).
+    size_t mapping_size;  // Size of the mapped file.
+};
+
+// Builds a contraction hierarchy of a sparse graph. Nodes are contracted in
+// order of priority. Priorities change as neighbors are contracted, so they
+// are updated lazily: a node is contracted only if its priority is still the
+// smallest one after it is recomputed.
+static struct ch *ch_create(const struct csr *g)
+{
+    struct ch *ch = NULL;
+    struct ch_builder b;
+    struct heap *order = heap_create(g->nnodes);
+
+    // Initialize builder.
+    b.nnodes = g->nnodes;
+    assert((b.out = calloc(g->nnodes, sizeof(struct ch_arcs))) != NULL);
+    assert((b.in = calloc(g->nnodes, sizeof(struct ch_arcs))) != NULL);
+    assert((b.deleted = calloc(g->nnodes, sizeof(size_t))) != NULL);
+    assert((b.targets = calloc(g->nnodes, sizeof(size_t))) != NULL);
+    b.stamp = 0;
+    b.witness = search_create(g->nnodes);
+    for (size_t i = 0; i < g->nnodes; i++) {
+        for (size_t k = g->offsets[i]; k < g->offsets[i + 1]; k++) {
+            if (g->targets[k] != i) {
+                ch_arcs_add(&b.out[i], g->targets[k], g->weights[k]);
+                ch_arcs_add(&b.in[g->targets[k]], (unsigned)i, g->weights[k]);
+            }
+        }
+    }
+
+    // Contract all nodes.
+    for (size_t i = 0; i < g->nnodes; i++) {
+        heap_push(order, i, ch_priority(&b, i));
+    }
+    while (heap_length(order) != 0) {
+        size_t v = heap_pop(order);
+        size_t priority = ch_priority(&b, v);
+
+        if ((heap_length(order) != 0) && (priority > heap_top_priority(order))) {
+            heap_push(order, v, priority);
+            continue;
+        }
+
+        ch_contract(&b, v, false);
+    }
+
+    // Build hierarchy.
+    assert((ch = malloc(sizeof(struct ch))) != NULL);
+    ch->forward = ch_upward(b.out, g->nnodes);
+    ch->backward = ch_upward(b.in, g->nnodes);
+    ch->mapping = NULL;
+    ch->mapping_size = 0;
+
+    // Release resources.
+    for (size_t i = 0; i < g->nnodes; i++) {
+        free(b.out[i].arcs);
+        free(b.in[i].arcs);
+    }
+    search_destroy(b.witness);
+    free(b.targets);
+    free(b.deleted);
+    free(b.in);
+    free(b.out);
+    heap_destroy(order);
+
+    return (ch);
+}
+
+// Destroys a contraction hierarchy.
+static void ch_destroy(struct ch *ch)
+{
+    if (ch->mapping != NULL) {
+        free(ch->forward);
+        free(ch->backward);
+        munmap(ch->mapping, ch->mapping_size);
+    } else {
+        csr_destroy(ch->forward);
+        csr_destroy(ch->backward);
+    }
+    free(ch);
+}
+
+// Header of a contraction hierarchy file. It is followed by the offsets,
+// targets and weights of the forward graph, and then of the backward graph,
+// laid out as in binary sparse graph files.
+struct ch_header {
+    uint32_t magic;     // Magic number.
+    uint32_t flags;     // Flags.
+    uint64_t nnodes;    // Number of nodes.
+    uint64_t nforward;  // Number of edges in the forward graph.
+    uint64_t nbackward; // Number of edges in the backward graph.
+};
+
+// Writes the arrays of a sparse graph to a file.
+static void ch_write_csr(const struct csr *g, FILE *f)
+{
+    assert(fwrite(g->offsets, sizeof(uint64_t), g->nnodes + 1, f) == g->nnodes + 1);
+    assert(fwrite(g->targets, sizeof(uint32_t), g->nedges, f) == g->nedges);
+    assert(fwrite(g->weights, sizeof(uint32_t), g->nedges, f) == g->nedges);
+}
+
+// Writes a contraction hierarchy to a file.
+static void ch_write(const struct ch *ch, FILE *f)
+{
+    const struct ch_header h = {CH_MAGIC, 0, ch->forward->nnodes, ch->forward->nedges,
+                                ch->backward->nedges};
+
+    assert(fwrite(&h, sizeof(h), 1, f) == 1);
+    ch_write_csr(ch->forward, f);
+    ch_write_csr(ch->backward, f);
+}
+
+// Checks the size of the arrays of a sparse graph in a mapped file, without
+// overflowing, and consumes them from the remaining size of the file.
+static bool ch_check_size(size_t *remaining, uint64_t nnodes, uint64_t nedges)
+{
+    if (nnodes >= *remaining / sizeof(uint64_t)) {
+        return (false);
+    }
+    *remaining -= (nnodes + 1) * sizeof(uint64_t);
+    if (nedges > *remaining / (2 * sizeof(uint32_t))) {
+        return (false);
+    }
+    *remaining -= nedges * 2 * sizeof(uint32_t);
+
+    return (true);
+}
+
+// Points a sparse graph to its arrays in a mapped file, and returns the end
+// of them. Returns NULL if the arrays are malformed.
+static const void *ch_map_csr(struct csr *g, const void *p, size_t nnodes, size_t nedges)
+{
+    g->nnodes = nnodes;
+    g->nedges = nedges;
+    g->nodes = NULL;
+    g->mapping = NULL;
+    g->mapping_size = 0;
+    g->offsets = (size_t *)p;
+    g->targets = (unsigned *)(g->offsets + nnodes + 1);
+    g->weights = g->targets + nedges;
+
+    if (!csr_check_arrays(p, (const uint32_t *)g->targets, nnodes, nedges)) {
+        return (NULL);
+    }
+
+    return (g->weights + nedges);
+}
+
+// Maps a contraction hierarchy file in memory. Sizes, offsets and targets
+// of both graphs are checked before the hierarchy is handed out.
+static struct ch *ch_map(const char *path)
+{
+    int fd = -1;
+    struct stat st;
+    struct ch *ch = NULL;
+    const struct ch_header *h = NULL;
+    const void *p = NULL;
+    size_t remaining = 0;
+
+    if ((fd = open(path, O_RDONLY)) < 0) {
+        return (NULL);
+    }
+    if ((fstat(fd, &st) < 0) || ((size_t)st.st_size < sizeof(struct ch_header))) {
+        close(fd);
+        return (NULL);
+    }
+
+    assert((ch = malloc(sizeof(struct ch))) != NULL);
+    ch->mapping_size = (size_t)st.st_size;
+    ch->mapping = mmap(NULL, ch->mapping_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (ch->mapping == MAP_FAILED) {
+        free(ch);
+        return (NULL);
+    }
+
+    // Check header and sizes.
+    h = ch->mapping;
+    remaining = ch->mapping_size - sizeof(struct ch_header);
+    if ((h->magic != CH_MAGIC) || (h->nnodes > (uint64_t)UINT32_MAX + 1) ||
+        !ch_check_size(&remaining, h->nnodes, h->nforward) ||
+        !ch_check_size(&remaining, h->nnodes, h->nbackward) || (remaining != 0)) {
+        munmap(ch->mapping, ch->mapping_size);
+        free(ch);
+        return (NULL);
+    }
+
+    // Check arrays.
+    assert((ch->forward = malloc(sizeof(struct csr))) != NULL);
+    assert((ch->backward = malloc(sizeof(struct csr))) != NULL);
+    if (((p = ch_map_csr(ch->forward, h + 1, h->nnodes, h->nforward)) == NULL) ||
+        (ch_map_csr(ch->backward, p, h->nnodes, h->nbackward) == NULL)) {
+        ch_destroy(ch);
+        return (NULL);
+    }
+
+    return (ch);
+}
+
+// Checks whether a node that a search in a contraction hierarchy settled has a
+// shorter path through a higher-ranked node. Then no shortest path goes up
+// through it, and its edges need not be relaxed (stall-on-demand). Edges that
+// enter a node from higher-ranked nodes are the edges of the opposite graph.
+static bool ch_stalled(const struct csr *opposite, const struct search *s, size_t i)
+{
+    for (size_t k = opposite->offsets[i]; k < opposite->offsets[i + 1]; k++) {
+        size_t j = opposite->targets[k];
+        if ((s->distances[j] != (size_t)(-1)) &&
+            (s->distances[j] + opposite->weights[k] < s->distances[i])) {
+            return (true);
+        }
+    }
+
+    return (false);
+}
+
+// Finds the distance from a source to a destination in a contraction
+// hierarchy. Both searches only go up the hierarchy, and they meet at the
+// highest-ranked node of a shortest path. Each search stops once its
+// smallest tentative distance reaches the best distance found.
+static size_t ch_query(const struct ch *ch, struct search *forward, struct search *backward,
+                       size_t src, size_t dest)
+{
+    size_t best = (size_t)(-1);
+
+    search_reset(forward);
+    search_reset(backward);
+    search_update(forward, src, 0, 0);
+    search_update(backward, dest, 0, 0);
+
+    while ((heap_length(forward->heap) != 0) || (heap_length(backward->heap) != 0)) {
+        bool is_forward = (heap_length(backward->heap) == 0) ||
+                          ((heap_length(forward->heap) != 0) &&
+                           (heap_top_priority(forward->heap) <= heap_top_priority(backward->heap)));
+        const struct csr *g = is_forward ? ch->forward : ch->backward;
+        const struct csr *opposite = is_forward ? ch->backward : ch->forward;
+        struct search *s = is_forward ? forward : backward;
+        struct search *other = is_forward ? backward : forward;
+
+        // This search cannot improve the best distance anymore.
+        if (heap_top_priority(s->heap) >= best) {
+            heap_clear(s->heap);
+            continue;
+        }
+
+        size_t i = search_settle(s);
+
+        // Both searches met.
+        if ((other->distances[i] != (size_t)(-1)) &&
+            (s->distances[i] + other->distances[i] < best)) {
+            best = s->distances[i] + other->distances[i];
+        }
+
+        // Go up the hierarchy.
+        if (ch_stalled(opposite, s, i)) {
+            continue;
+        }
+        for (size_t k = g->offsets[i]; k < g->offsets[i + 1]; k++) {
+            size_t j = g->targets[k];
+            size_t new_distance = s->distances[i] + g->weights[k];
+
+            if (new_distance < s->distances[j]) {
+                search_update(s, j, new_distance, new_distance);
+            }
+        }
+    }
+
+    return (best);
+}
+
+//==============================================================================
+// Test
+//==============================================================================
+
+// Compares two latencies.
+static int compare_latencies(const void *a, const void *b)
+{
+    double x = *(const double *)a;
+    double y = *(const double *)b;
+
+    return ((x > y) - (x < y));
+}
+
+// Benchmarks point-to-point queries with a contraction hierarchy against
+// Dijkstra's Algorithm. The hierarchy goes through a file, as it would when
+// preprocessing and queries run on different machines.
+static void test_ch(const struct csr *g, const char *name)
+{
+    const char *names[] = {"Dijkstra's Algorithm", "contraction hierarchy"};
+    const double percentiles[] = {0.50, 0.90, 0.99};
+    double latencies[2][NQUERIES];
+    double tstart = 0.0;
+    double elapsed = 0.0;
+    char path[] = "/tmp/ch-XXXXXX";
+    FILE *f = NULL;
+    struct ch *ch = NULL;
+    struct search *forward = search_create(g->nnodes);
+    struct search *backward = search_create(g->nnodes);
+
+    // Preprocess.
+    tstart = now();
+    ch = ch_create(g);
+    elapsed = now() - tstart;
+    printf("Contraction hierarchy (%s): %2.lf us, %zu upward edges (%zu in graph)\n", name,
+           elapsed, ch->forward->nedges + ch->backward->nedges, g->nedges);
+
+    // Serialize.
+    assert((f = fdopen(mkstemp(path), "wb")) != NULL);
+    ch_write(ch, f);
+    fclose(f);
+    ch_destroy(ch);
+    tstart = now();
+    ch = ch_map(path);
+    elapsed = now() - tstart;
+    assert(ch != NULL);
+    printf("Contraction hierarchy (%s): mapped in %2.lf us (%zu bytes)\n", name, elapsed,
+           ch->mapping_size);
+
+    // Corrupted files must be rejected.
+    for (size_t i = 0; (i < 3) && (ch->forward->nedges > 0); i++) {
+        char corrupt[] = "/tmp/ch-XXXXXX";
+        char *bytes = NULL;
+        struct ch_header *h = NULL;
+        assert((bytes = malloc(ch->mapping_size)) != NULL);
+        memcpy(bytes, ch->mapping, ch->mapping_size);
+        h = (struct ch_header *)bytes;
+        switch (i) {
+            case 0:
+                h->nforward += UINT64_C(1) << 61;
+                break;
+            case 1:
+                ((uint64_t *)(h + 1))[1] = h->nforward + 1;
+                break;
+            default:
+                ((uint32_t *)((uint64_t *)(h + 1) + h->nnodes + 1))[0] = (uint32_t)h->nnodes;
+                break;
+        }
+        assert((f = fdopen(mkstemp(corrupt), "wb")) != NULL);
+        assert(fwrite(bytes, ch->mapping_size, 1, f) == 1);
+        fclose(f);
+        assert(ch_map(corrupt) == NULL);
+        unlink(corrupt);
+        free(bytes);
+    }
+
+    // Query.
+    for (size_t q = 0; q < NQUERIES; q++) {
+        size_t src = (size_t)rand() % g->nnodes;
+        size_t dest = (size_t)rand() % g->nnodes;
+
+        tstart = now();
+        size_t expected = dijkstra_query(g, forward, src, dest);
+        latencies[0][q] = now() - tstart;
+
+        tstart = now();
+        size_t distance = ch_query(ch, forward, backward, src, dest);
+        latencies[1][q] = now() - tstart;
+
+        assert(distance == expected);
+    }
+
+    // Report latency percentiles.
+    for (size_t i = 0; i < 2; i++) {
+        qsort(latencies[i], NQUERIES, sizeof(double), compare_latencies);
+        printf("Point-to-point query (%s, %s):", name, names[i]);
+        for (size_t j = 0; j < sizeof(percentiles) / sizeof(percentiles[0]); j++) {
+            printf(" p%.0lf %.1lf us", 100 * percentiles[j],
+                   latencies[i][(size_t)(percentiles[j] * (NQUERIES - 1))]);
+        }
+        printf("\n");
+    }
+    printf("Point-to-point query (%s): speedup %.1lf (median)\n", name,
+           latencies[0][NQUERIES / 2] / latencies[1][NQUERIES / 2]);
+
+    // Release resources.
+    ch_destroy(ch);
+    unlink(path);
+    search_destroy(backward);
+    search_destroy(forward);
+}
+
+// Benchmarks parallel shortest paths on a sparse graph. Expected distances
+// from the first node are given.
+static void test_parallel(const struct csr *g, const size_t *expected)
+{
+    size_t *distances = NULL;
+    size_t *many[NSOURCES];
+    size_t sources[NSOURCES];
+    size_t delta = 0;
+    double tstart = 0.0;
+    double baseline = 0.0;
+    double elapsed = 0.0;
+
+    assert((distances = malloc(g->nnodes * sizeof(size_t))) != NULL);
+
+    // Baseline: sequential Dijkstra's Algorithm.
+    tstart = now();
+    dijkstra_sparse(g, 0, distances, QUEUE_RADIX);
+    baseline = now() - tstart;
+
+    // Single source.
+    delta = delta_tune(g, 0, DIJKSTRA_MAX_THREADS);
+    printf("Delta-stepping: delta = %zu\n", delta);
+    for (size_t nthreads = 1; nthreads <= DIJKSTRA_MAX_THREADS; nthreads *= 2) {
+        tstart = now();
+        delta_stepping(g, 0, distances, delta, nthreads);
+        elapsed = now() - tstart;
+        printf("Delta-stepping (%zu threads): %2.lf us (speedup %.2lf)\n", nthreads, elapsed,
+               baseline / elapsed);
+        assert(!memcmp(distances, expected, g->nnodes * sizeof(size_t)));
+    }
+
+    // Multiple sources.
+    for (size_t i = 0; i < NSOURCES; i++) {
+        sources[i] = (i == 0) ? 0 : (size_t)rand() % g->nnodes;
+        assert((many[i] = malloc(g->nnodes * sizeof(size_t))) != NULL);
+    }
+    for (size_t nthreads = 1; nthreads <= DIJKSTRA_MAX_THREADS; nthreads *= 2) {
+        tstart = now();
+        dijkstra_many(g, sources, NSOURCES, many, nthreads);
+        elapsed = now() - tstart;
+        printf("Multi-source Dijkstra's Algorithm (%d sources, %zu threads): %2.lf us "
+               "(speedup %.2lf)\n",
+               NSOURCES, nthreads, elapsed, NSOURCES * baseline / elapsed);
+        assert(!memcmp(many[0], expected, g->nnodes * sizeof(size_t)));
+    }
+
+    // Release resources.
+    for (size_t i = 0; i < NSOURCES; i++) {
+        free(many[i]);
+    }
+    free(distances);
+}
+
+// Benchmarks point-to-point queries between random nodes of a sparse graph.
+static void test_queries(const struct csr *g, const char *name, double scale)
+{
+    const char *names[] = {"unidirectional", "bidirectional", "A*"};
+    const struct euclidean e = {g->nodes, scale};
+    const struct heuristic h = {&e, euclidean_estimate};
+    size_t settled[3] = {0, 0, 0};
+    double times[3] = {0.0, 0.0, 0.0};
+    size_t distances[3];
+    double tstart = 0.0;
+    const double MICROSECS = ((CLOCKS_PER_SEC / 1000000.0));
+    struct csr *r = csr_reverse(g);
+    struct search *forward = search_create(g->nnodes);
+    struct search *backward = search_create(g->nnodes);
+
+    for (size_t q = 0; q < NQUERIES; q++) {
+        size_t src = (size_t)rand() % g->nnodes;
+        size_t dest = (size_t)rand() % g->nnodes;
+
+        tstart = clock();
+        distances[0] = dijkstra_query(g, forward, src, dest);
+        times[0] += clock() - tstart;
+        settled[0] += forward->nsettled;
+
+        tstart = clock();
+        distances[1] = dijkstra_bidirectional(g, r, forward, backward, src, dest);
+        times[1] += clock() - tstart;
+        settled[1] += forward->nsettled + backward->nsettled;
+
+        tstart = clock();
+        distances[2] = astar(g, forward, &h, src, dest);
+        times[2] += clock() - tstart;
+        settled[2] += forward->nsettled;
+
+        // Check results.
+        assert((distances[0] == distances[1]) && (distances[0] == distances[2]));
+    }
+
+    // Report average latency and work per query.
+    for (size_t i = 0; i < 3; i++) {
+        printf("Point-to-point query (%s, %s): %2.lf us, %zu nodes settled\n", name, names[i],
+               times[i] / MICROSECS / NQUERIES, settled[i] / NQUERIES);
+    }
+
+    // Release resources.
+    search_destroy(backward);
+    search_destroy(forward);
+    csr_destroy(r);
+}
+
+// Benchmarks priority queues for Dijkstra's Algorithm on a road-network-like graph.
+static void test_road(size_t side, bool verbose)
+{
+    const unsigned MAX_ROAD_WEIGHT = 100;
+    const enum queue_kind kinds[] = {QUEUE_BINARY, QUEUE_RADIX, QUEUE_PAIRING};
+    const char *names[] = {"binary heap", "radix heap", "pairing heap"};
+    size_t *distances[3];
+    double tstart = 0.0;
+    double tend = 0.0;
+    const double MICROSECS = ((CLOCKS_PER_SEC / 1000000.0));
+    struct csr *g = NULL;
+
+    // Empty graph.
+    if (side == 0) {
+        return;
+    }
+
+    g = csr_create_grid(side, MAX_ROAD_WEIGHT);
+
+    if (verbose) {
+        printf("Road graph: %zu nodes, %zu edges\n", g->nnodes, g->nedges);
+    }
+
+    for (size_t i = 0; i < 3; i++) {
+        assert((distances[i] = malloc(g->nnodes * sizeof(size_t))) != NULL);
+
+        tstart = clock();
+        dijkstra_sparse(g, 0, distances[i], kinds[i]);
+        tend = clock();
+
+        // Report time.
+        printf("Dijkstra's Algorithm (%s): %2.lf us\n", names[i], (tend - tstart) / MICROSECS);
+
+        // Check results.
+        assert(!memcmp(distances[0], distances[i], g->nnodes * sizeof(size_t)));
+    }
+
+    // Parallel shortest paths.
+    test_parallel(g, distances[0]);
+
+    // Point-to-point queries. No link of the grid is lighter than its length.
+    test_queries(g, "road", 1.0);
+    test_ch(g, "road");
+
+    // Release resources.
+    for (size_t i = 0; i < 3; i++) {
+        free(distances[i]);
+    }
+    csr_destroy(g);
+
+    // Point-to-point queries on a geometric graph.
+    g = csr_create_geometric(side);
+    if (verbose) {
+        printf("Geometric graph: %zu nodes, %zu edges\n", g->nnodes, g->nedges);
+    }
+    test_queries(g, "geometric", GEOMETRIC_SCALE);
+    test_ch(g, "geometric");
+    csr_destroy(g);
+}
+
+// Tests Dijkstra's Algorithm.
+static void test(size_t nnodes, bool verbose)
+{
+    const float p = 0.55;
+    const unsigned MAX_WEIGTH = (unsigned)nnodes;
+    size_t source = 0;
+    size_t dest = nnodes - 1;
+    size_t path[nnodes];
+    size_t distance = 0;
+    double tstart = 0.0;
+    double tend = 0.0;
+    const double MICROSECS = ((CLOCKS_PER_SEC / 1000000.0));
+    struct graph *g = graph_create(nnodes);
+
+    // Fix random number generator seed
+    // to have a determinist behavior across runs.
+    srand(0);
+
+    // Initialize the graph.
+    for (size_t i = 0; i < g->nnodes; i++) {
+        for (size_t j = 0; j < g->nnodes; j++) {
+            float q = (rand() % 100) / 100.0;
+            if (q < p) {
+                unsigned w = nnodes + (rand() % MAX_WEIGTH);
+                struct link *l = graph_link(g, i, j);
+                l->weight = w;
+            }
+        }
+    }
+    assert(source < dest);
+    for (size_t i = source; i < dest; i++) {
+        struct link *l = graph_link(g, i, i + 1);
+        l->weight = 1;
+    }
+
+    if (verbose) {
+        graph_print(g, stdout);
+    }
+
+    // Search in the array.
+    tstart = clock();
+    distance = dijkstra(g, source, dest, path);
+    tend = clock();
+
+    // Report time.
+    printf("Dijkstra's Algorithm: %2.lf us\n", (tend - tstart) / MICROSECS);
 
     if (verbose) {
 
@@ -372,7 +2549,7 @@ static void test(size_t nnodes, bool verbose)
         printf("Path: %zu ", i);
         while (j < nnodes) {
             struct link *l = graph_link(g, j, i);
-            printf("-(%zu)-> %zu ", l->weight, j);
+            printf("-(%u)-> %zu ", l->weight, j);
             if (j == source) {
                 break;
             }
@@ -383,8 +2560,80 @@ static void test(size_t nnodes, bool verbose)
         printf("\n");
     }
 
+    // Search in a sparse graph mapped from a file.
+    if (nnodes > 0) {
+        char csr_path[] = "/tmp/dijkstra-XXXXXX";
+        FILE *f = fdopen(mkstemp(csr_path), "wb");
+        assert(f != NULL);
+        csr_write_graph(g, 0, f);
+        fclose(f);
+        struct csr *sg = csr_map(csr_path);
+        assert(sg != NULL);
+        size_t *distances = malloc(sg->nnodes * sizeof(size_t));
+        assert(distances != NULL);
+        tstart = clock();
+        dijkstra_sparse(sg, source, distances, QUEUE_BINARY);
+        tend = clock();
+        printf("Dijkstra's Algorithm (sparse): %2.lf us\n", (tend - tstart) / MICROSECS);
+        assert(distances[dest] == distance);
+        delta_stepping(sg, source, distances, nnodes, DIJKSTRA_MAX_THREADS);
+        assert(distances[dest] == distance);
+        free(distances);
+        csr_destroy(sg);
+        unlink(csr_path);
+    }
+
     // Release graph.
     graph_destroy(g);
+
+    // Benchmark priority queues on a road-network-like graph.
+    test_road(nnodes, verbose);
+}
+
+// Benchmarks priority queues for Dijkstra's Algorithm on a graph that is loaded
+// from a binary sparse graph file.
+static void test_loaded(const char *filename)
+{
+    const enum queue_kind kinds[] = {QUEUE_BINARY, QUEUE_RADIX, QUEUE_PAIRING};
+    const char *names[] = {"binary heap", "radix heap", "pairing heap"};
+    size_t *distances[3];
+    double tstart = 0.0;
+    double tend = 0.0;
+    const double MICROSECS = ((CLOCKS_PER_SEC / 1000000.0));
+    struct csr *g = NULL;
+
+    tstart = clock();
+    g = csr_map(filename);
+    tend = clock();
+    if ((g == NULL) || (g->nnodes == 0)) {
+        fprintf(stderr, "Error: cannot load %s.\n", filename);
+        exit(EXIT_FAILURE);
+    }
+    printf("Loaded %zu nodes and %zu edges (%zu bytes): %2.lf us\n", g->nnodes, g->nedges,
+           g->mapping_size, (tend - tstart) / MICROSECS);
+
+    for (size_t i = 0; i < 3; i++) {
+        assert((distances[i] = malloc(g->nnodes * sizeof(size_t))) != NULL);
+
+        tstart = clock();
+        dijkstra_sparse(g, 0, distances[i], kinds[i]);
+        tend = clock();
+
+        // Report time.
+        printf("Dijkstra's Algorithm (%s): %2.lf us\n", names[i], (tend - tstart) / MICROSECS);
+
+        // Check results.
+        assert(!memcmp(distances[0], distances[i], g->nnodes * sizeof(size_t)));
+    }
+
+    // Parallel shortest paths.
+    test_parallel(g, distances[0]);
+
+    // Release resources.
+    for (size_t i = 0; i < 3; i++) {
+        free(distances[i]);
+    }
+    csr_destroy(g);
 }
 
 //==============================================================================
@@ -396,6 +2645,7 @@ static void usage(char *const argv[])
 {
     printf("%s - Testing program for Dijkstra's Algorithm.\n", argv[0]);
     printf("Usage: %s [--verbose] <>\num_nodes n", argv[0]);
+    printf("       %s --graph <graph file>\n", argv[0]);
     exit(EXIT_FAILURE);
 }
 
@@ -416,7 +2666,10 @@ int main(int argc, char *const argv[])
     }
 
     // Parse command line arguments.
-    if (argc == 2) {
+    if ((argc == 3) && (!strcmp(argv[1], "--graph"))) {
+        test_loaded(argv[2]);
+        return (EXIT_SUCCESS);
+    } else if (argc == 2) {
         sscanf(argv[1], "%zu", &nnodes);
     } else if ((argc == 3) && (!strcmp(argv[1], "--verbose"))) {
         sscanf(argv[2], "%zu", &nnodes);
@@ -0,0 +1,826 @@
+// Copyright (C) 2022 Pedro Henrique Penna <pedrohenriquepenna@outlook.com>
+
+#define _POSIX_C_SOURCE 200809L
+
+#include <assert.h>
+#include <pthread.h>
+#include <stdatomic.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+// Width of a tile in blocked Floyd-Warshall's Algorithm (in distances).
+#define APSP_TILE 64
+
+// Number of distances in a SIMD vector.
+#define APSP_LANES 8
+
+// Max number of threads.
+#define APSP_MAX_THREADS 8
+
+// Distance between nodes that are not connected. The sum of two distances never overflows.
+#define APSP_INF (INT32_MAX / 2)
+
+// Cost of relaxing an edge in Johnson's Algorithm, relative to the cost of
+// relaxing a pair of nodes in the blocked Floyd-Warshall's Algorithm.
+#define APSP_EDGE_COST 11
+
+// Cost of a heap operation per level of the heap in Johnson's Algorithm,
+// relative to the cost of relaxing a pair of nodes in the blocked
+// Floyd-Warshall's Algorithm.
+#define APSP_HEAP_COST 124
+
+// Graphs with at most this number of nodes are checked against the plain Floyd-Warshall's Algorithm.
+#define APSP_CHECK_NNODES 512
+
+//==============================================================================
+// Graph Data Structure
+//==============================================================================
+
+// Type of elements that are stored in the graph.
+typedef int type_t;
+
+// A graph node.
+struct node {
+    type_t element; // Element.
+};
+
+// A graph link.
+struct link {
+    unsigned weight; // Weight.
+};
+
+// A graph.
+struct graph {
+    size_t nnodes;      // Number of nodes.
+    struct node *nodes; // Nodes.
+    struct link *links; // Adjacency matrix.
+};
+
+// Returns the link between two nodes in a graph.
+static struct link *graph_link(const struct graph *g, size_t i, size_t j)
+{
+    return (&g->links[i * g->nnodes + j]);
+}
+
+// Creates a graph.
+static struct graph *graph_create(size_t nnodes)
+{
+    struct graph *g = NULL;
+
+    // Allocate data structure.
+    assert((g = malloc(sizeof(struct graph))) != NULL);
+    g->nnodes = nnodes;
+    assert((g->nodes = malloc(g->nnodes * sizeof(struct node))) != NULL);
+    assert((g->links = malloc(g->nnodes * g->nnodes * sizeof(struct link))) != NULL);
+
+    // Initialize data structure.
+    for (size_t i = 0; i < g->nnodes; i++) {
+        for (size_t j = 0; j < g->nnodes; j++) {
+            struct link *l = graph_link(g, i, j);
+            l->weight = 0;
+        }
+    }
+
+    return (g);
+}
+
+// Destroys a graph.
+static void graph_destroy(struct graph *g)
+{
+    free(g->links);
+    free(g->nodes);
+    free(g);
+}
+
+// Prints a graph.
+static void graph_print(const struct graph *g, FILE *f)
+{
+    size_t precision = 1;
+    for (size_t i = 1; i < g->nnodes; i *= 10) {
+        precision += 1;
+    }
+    fprintf(f, "graph {\n");
+    fprintf(f, "nnodes: %zu,\n", g->nnodes);
+    fprintf(f, "links: \n");
+    for (size_t i = 0; i < g->nnodes; i++) {
+        fprintf(f, " [ ");
+        for (size_t j = 0; j < g->nnodes; j++) {
+            const struct link *l = graph_link(g, i, j);
+            fprintf(f, "%*u ", (int)precision, l->weight);
+        }
+        fprintf(f, "]\n");
+    }
+    fprintf(f, "}\n");
+}
+
+
+//==============================================================================
+// Binary Heap Structure
+//==============================================================================
+
+// Swaps two elements.
+static void swap(size_t *x, size_t *y)
+{
+    size_t tmp = *x;
+    *x = *y;
+    *y = tmp;
+}
+
+// A heap of elements in the range [0, capacity).
+struct heap {
+    size_t *elements;   // Elements stored in the heap.
+    size_t *priorities; // Priorities of elements stored in the heap.
+    size_t *positions;  // Position of each element in the heap.
+    size_t length;      // Current number of elements that are stored in the heap.
+    size_t capacity;    // Max number of elements that can be stored in the heap.
+};
+
+// Creates an empty heap.
+static struct heap *heap_create(size_t capacity)
+{
+    struct heap *h = malloc(sizeof(struct heap));
+    assert(h != NULL);
+
+    // Initialize data structure.
+    h->length = 0;
+    h->capacity = capacity;
+    assert((h->priorities = malloc(h->capacity * sizeof(h->priorities[0]))) != NULL);
+    assert((h->elements = malloc(h->capacity * sizeof(h->elements[0]))) != NULL);
+    assert((h->positions = malloc(h->capacity * sizeof(h->positions[0]))) != NULL);
+
+    return (h);
+}
+
+// Destroys a heap.
+static void heap_destroy(struct heap *h)
+{
+    free(h->positions);
+    free(h->elements);
+    free(h->priorities);
+    free(h);
+}
+
+// Returns the number of elements that are stored in a heap.
+static size_t heap_length(const struct heap *h)
+{
+    return (h->length);
+}
+
+// Swaps two entries of a heap.
+static void heap_swap(struct heap *h, size_t i, size_t j)
+{
+    swap(&h->priorities[i], &h->priorities[j]);
+    swap(&h->elements[i], &h->elements[j]);
+    h->positions[h->elements[i]] = i;
+    h->positions[h->elements[j]] = j;
+}
+
+// Fixes the heap property after an insertion on a heap.
+static void heap_fix_up(struct heap *h, size_t node)
+{
+    while (node > 0) {
+        size_t root = (node - 1) / 2;
+
+        if (h->priorities[root] <= h->priorities[node]) {
+            break;
+        }
+
+        // Swap elements.
+        heap_swap(h, root, node);
+        node = root;
+    }
+}
+
+// Inserts an element in a heap.
+static void heap_push(struct heap *h, size_t element, size_t priority)
+{
+    // The heap should not be full.
+    assert(h->length < h->capacity);
+
+    // Increase the size of the heap.
+    h->length += 1;
+
+    // Insert element;
+    h->elements[h->length - 1] = element;
+    h->priorities[h->length - 1] = priority;
+    h->positions[element] = h->length - 1;
+    if (h->length > 1) {
+        heap_fix_up(h, h->length - 1);
+    }
+}
+
+// Fixes the heap property after a deletion on a heap.
+static void heap_fix_down(struct heap *h, size_t root)
+{
+    // Traverse the heap from top to bottom.
+    do {
+        size_t smallest = root;
+        size_t left = 2 * root + 1;
+        size_t right = 2 * root + 2;
+
+        // Done: reached leaf node.
+        if (left >= h->length) {
+            break;
+        }
+
+        // Check if left element is largest than the root.
+        if (h->priorities[left] < h->priorities[smallest]) {
+            smallest = left;
+        }
+
+        // Check if right element is largest than the root.
+        if ((right < h->length) && (h->priorities[right] < h->priorities[smallest])) {
+            smallest = right;
+        }
+
+        // Done: heap property is fixed.
+        if (smallest == root) {
+            break;
+        }
+
+        // Swap elements and advance root.
+        heap_swap(h, root, smallest);
+        root = smallest;
+    } while (true);
+}
+
+// Removes an element from a heap.
+static size_t heap_pop(struct heap *h)
+{
+    // Empty heap.
+    if (h->length == 0) {
+        fprintf(stderr, "Error: cannot pop() an empty heap\n");
+        exit(-1);
+    }
+
+    size_t x = h->elements[0];
+
+    // Remove element.
+    heap_swap(h, 0, h->length - 1);
+    h->length -= 1;
+    if (h->length > 1) {
+        heap_fix_down(h, 0);
+    }
+
+    return (x);
+}
+
+// Decreases the priority of an element in a heap.
+static size_t heap_increase_priority(struct heap *h, size_t element, size_t new_priority)
+{
+    size_t i = h->positions[element];
+    size_t old_priority = h->priorities[i];
+
+    // The element should be in the heap.
+    assert((i < h->length) && (h->elements[i] == element));
+    assert(old_priority > new_priority);
+
+    h->priorities[i] = new_priority;
+    heap_fix_up(h, i);
+
+    return (old_priority);
+}
+
+
+//==============================================================================
+// Sparse Graph Data Structure
+//==============================================================================
+
+// A sparse graph in compressed sparse row format.
+struct csr {
+    size_t nnodes;     // Number of nodes.
+    size_t nedges;     // Number of edges.
+    size_t *offsets;   // Offset of the first edge of each node (nnodes + 1 entries).
+    unsigned *targets; // Target node of each edge.
+    unsigned *weights; // Weight of each edge.
+};
+
+// Builds a sparse graph from a graph stored as an adjacency matrix.
+static struct csr *csr_from_graph(const struct graph *g)
+{
+    struct csr *s = NULL;
+    size_t k = 0;
+
+    // Allocate data structure.
+    assert((s = malloc(sizeof(struct csr))) != NULL);
+    s->nnodes = g->nnodes;
+    s->nedges = 0;
+    for (size_t i = 0; i < g->nnodes * g->nnodes; i++) {
+        s->nedges += (g->links[i].weight > 0);
+    }
+    assert((s->offsets = malloc((s->nnodes + 1) * sizeof(size_t))) != NULL);
+    assert((s->targets = malloc(s->nedges * sizeof(unsigned))) != NULL);
+    assert((s->weights = malloc(s->nedges * sizeof(unsigned))) != NULL);
+
+    // Initialize data structure.
+    for (size_t i = 0; i < g->nnodes; i++) {
+        s->offsets[i] = k;
+        for (size_t j = 0; j < g->nnodes; j++) {
+            const struct link *l = graph_link(g, i, j);
+            if (l->weight > 0) {
+                s->targets[k] = (unsigned)j;
+                s->weights[k] = l->weight;
+                k++;
+            }
+        }
+    }
+    s->offsets[s->nnodes] = k;
+
+    return (s);
+}
+
+// Destroys a sparse graph.
+static void csr_destroy(struct csr *s)
+{
+    free(s->weights);
+    free(s->targets);
+    free(s->offsets);
+    free(s);
+}
+
+//==============================================================================
+// Distance Matrix
+//==============================================================================
+
+// A matrix of distances between all pairs of nodes. Rows are padded to a
+// multiple of the tile width, and padding nodes are not connected to any
+// other node.
+struct apsp {
+    size_t nnodes;       // Number of nodes.
+    size_t stride;       // Number of distances in a row, including padding.
+    uint32_t *distances; // Distances.
+};
+
+// Creates a distance matrix with the links of a graph.
+static struct apsp *apsp_create(const struct graph *g)
+{
+    struct apsp *d = NULL;
+
+    // Allocate data structure. Rows are aligned for SIMD loads.
+    assert((d = malloc(sizeof(struct apsp))) != NULL);
+    d->nnodes = g->nnodes;
+    d->stride = ((g->nnodes + APSP_TILE - 1) / APSP_TILE) * APSP_TILE;
+    d->distances = aligned_alloc(APSP_LANES * sizeof(uint32_t),
+                                 d->stride * d->stride * sizeof(uint32_t));
+    assert(d->distances != NULL);
+
+    // Initialize data structure.
+    for (size_t i = 0; i < d->stride; i++) {
+        for (size_t j = 0; j < d->stride; j++) {
+            uint32_t w = APSP_INF;
+            if (i == j) {
+                w = 0;
+            } else if ((i < g->nnodes) && (j < g->nnodes) && (graph_link(g, i, j)->weight > 0)) {
+                w = graph_link(g, i, j)->weight;
+            }
+            d->distances[i * d->stride + j] = w;
+        }
+    }
+
+    return (d);
+}
+
+// Destroys a distance matrix.
+static void apsp_destroy(struct apsp *d)
+{
+    free(d->distances);
+    free(d);
+}
+
+// Returns the row of a distance matrix with distances from a node.
+static uint32_t *apsp_row(const struct apsp *d, size_t i)
+{
+    return (&d->distances[i * d->stride]);
+}
+
+// Checks whether two distance matrices hold the same distances.
+static bool apsp_equal(const struct apsp *a, const struct apsp *b)
+{
+    for (size_t i = 0; i < a->nnodes; i++) {
+        if (memcmp(apsp_row(a, i), apsp_row(b, i), a->nnodes * sizeof(uint32_t))) {
+            return (false);
+        }
+    }
+
+    return (true);
+}
+
+//==============================================================================
+// Floyd-Warshall's Algorithm
+//==============================================================================
+
+// Performs a Floyd-Warshall's Algorithm on a distance matrix.
+static void floyd_warshall(struct apsp *d)
+{
+    for (size_t k = 0; k < d->nnodes; k++) {
+        for (size_t i = 0; i < d->nnodes; i++) {
+            uint32_t dik = apsp_row(d, i)[k];
+            for (size_t j = 0; j < d->nnodes; j++) {
+                uint32_t distance = dik + apsp_row(d, k)[j];
+                if (distance < apsp_row(d, i)[j]) {
+                    apsp_row(d, i)[j] = distance;
+                }
+            }
+        }
+    }
+}
+
+// A vector of distances. Distances never exceed APSP_INF, thus lanes are
+// signed, which SIMD instruction sets compare natively.
+typedef int32_t vdist_t __attribute__((vector_size(APSP_LANES * sizeof(int32_t))));
+
+// Relaxes the distances of a tile through the nodes of another tile:
+// c[i][j] = min(c[i][j], a[i][k] + b[k][j]), that is, a min-plus product. Node k
+// is the outermost loop, so c may be the same tile as a or b.
+static void tile_minplus(uint32_t *c, const uint32_t *a, const uint32_t *b, size_t stride)
+{
+    for (size_t k = 0; k < APSP_TILE; k++) {
+        const vdist_t *bk = (const vdist_t *)&b[k * stride];
+
+        for (size_t i = 0; i < APSP_TILE; i++) {
+            vdist_t *ci = (vdist_t *)&c[i * stride];
+            int32_t aik = (int32_t)a[i * stride + k];
+
+            for (size_t j = 0; j < APSP_TILE / APSP_LANES; j++) {
+                vdist_t sum = bk[j] + aik;
+                vdist_t less = sum < ci[j];
+                ci[j] = (sum & less) | (ci[j] & ~less);
+            }
+        }
+    }
+}
+
+// A thread of a blocked Floyd-Warshall's Algorithm.
+struct fw_worker {
+    pthread_t thread;           // Thread.
+    size_t id;                  // Thread number.
+    size_t nthreads;            // Number of threads.
+    struct apsp *d;             // Distance matrix.
+    pthread_barrier_t *barrier; // Synchronizes all threads between phases.
+};
+
+// Returns a tile of a distance matrix.
+static uint32_t *fw_tile(const struct apsp *d, size_t i, size_t j)
+{
+    return (&d->distances[(i * d->stride + j) * APSP_TILE]);
+}
+
+// Runs a thread of a blocked Floyd-Warshall's Algorithm. For each tile k on
+// the diagonal, the tile itself is solved first, then the tiles in its row
+// and column, which depend on it only, and then all other tiles, which
+// depend on the row and the column only. Tiles within a phase are split
+// among threads.
+static void *fw_worker(void *arg)
+{
+    const struct fw_worker *w = arg;
+    const struct apsp *d = w->d;
+    const size_t ntiles = d->stride / APSP_TILE;
+
+    for (size_t k = 0; k < ntiles; k++) {
+        uint32_t *kk = fw_tile(d, k, k);
+
+        // Phase 1: diagonal tile.
+        if (w->id == 0) {
+            tile_minplus(kk, kk, kk, d->stride);
+        }
+        pthread_barrier_wait(w->barrier);
+
+        // Phase 2: tiles in the same row and column.
+        for (size_t t = w->id; t < 2 * ntiles; t += w->nthreads) {
+            if (t < ntiles) {
+                if (t != k) {
+                    uint32_t *kt = fw_tile(d, k, t);
+                    tile_minplus(kt, kk, kt, d->stride);
+                }
+            } else if (t - ntiles != k) {
+                uint32_t *tk = fw_tile(d, t - ntiles, k);
+                tile_minplus(tk, tk, kk, d->stride);
+            }
+        }
+        pthread_barrier_wait(w->barrier);
+
+        // Phase 3: remaining tiles, by rows.
+        for (size_t i = w->id; i < ntiles; i += w->nthreads) {
+            if (i == k) {
+                continue;
+            }
+            for (size_t j = 0; j < ntiles; j++) {
+                if (j != k) {
+                    tile_minplus(fw_tile(d, i, j), fw_tile(d, i, k), fw_tile(d, k, j), d->stride);
+                }
+            }
+        }
+        pthread_barrier_wait(w->barrier);
+    }
+
+    return (NULL);
+}
+
+// Performs a blocked Floyd-Warshall's Algorithm on a distance matrix, using
+// multiple threads. Tiles fit in the cache, and each one is relaxed with
+// SIMD min-plus products.
+static void floyd_warshall_blocked(struct apsp *d, size_t nthreads)
+{
+    struct fw_worker workers[APSP_MAX_THREADS];
+    pthread_barrier_t barrier;
+    int ret = 0;
+
+    assert((nthreads >= 1) && (nthreads <= APSP_MAX_THREADS));
+
+    ret = pthread_barrier_init(&barrier, NULL, nthreads);
+    assert(ret == 0);
+    for (size_t i = 0; i < nthreads; i++) {
+        workers[i] = (struct fw_worker){0, i, nthreads, d, &barrier};
+        ret = pthread_create(&workers[i].thread, NULL, fw_worker, &workers[i]);
+        assert(ret == 0);
+    }
+    ((void)ret);
+    for (size_t i = 0; i < nthreads; i++) {
+        pthread_join(workers[i].thread, NULL);
+    }
+    pthread_barrier_destroy(&barrier);
+}
+
+//==============================================================================
+// Johnson's Algorithm
+//==============================================================================
+
+// Performs a Dijkstra's Algorithm from a source to all nodes in a sparse
+// graph, and stores distances in a row of a distance matrix.
+static void dijkstra(const struct csr *g, size_t src, uint32_t *row, struct heap *h)
+{
+    for (size_t i = 0; i < g->nnodes; i++) {
+        row[i] = APSP_INF;
+    }
+    row[src] = 0;
+    heap_push(h, src, 0);
+
+    while (heap_length(h) != 0) {
+        size_t i = heap_pop(h);
+
+        for (size_t k = g->offsets[i]; k < g->offsets[i + 1]; k++) {
+            size_t j = g->targets[k];
+            uint32_t distance = row[i] + g->weights[k];
+
+            if (distance < row[j]) {
+                if (row[j] == APSP_INF) {
+                    heap_push(h, j, distance);
+                } else {
+                    heap_increase_priority(h, j, distance);
+                }
+                row[j] = distance;
+            }
+        }
+    }
+}
+
+// A thread of a Johnson's Algorithm.
+struct johnson_worker {
+    pthread_t thread;     // Thread.
+    const struct csr *g;  // Graph.
+    struct apsp *d;       // Distance matrix.
+    _Atomic size_t *next; // Next source.
+};
+
+// Runs a thread of a Johnson's Algorithm: threads grab sources until none is left.
+static void *johnson_worker(void *arg)
+{
+    const struct johnson_worker *w = arg;
+    struct heap *h = heap_create(w->g->nnodes);
+    size_t i = 0;
+
+    while ((i = atomic_fetch_add_explicit(w->next, 1, memory_order_relaxed)) < w->g->nnodes) {
+        dijkstra(w->g, i, apsp_row(w->d, i), h);
+    }
+    heap_destroy(h);
+
+    return (NULL);
+}
+
+// Performs a Johnson's Algorithm on a sparse graph, using multiple threads.
+// Links have non-negative weights, thus the reweighting step, which runs a
+// Bellman-Ford's Algorithm to remove negative weights, is not needed, and the
+// algorithm reduces to one independent Dijkstra's Algorithm per source.
+static void johnson(const struct csr *g, struct apsp *d, size_t nthreads)
+{
+    struct johnson_worker workers[APSP_MAX_THREADS];
+    _Atomic size_t next;
+
+    assert((nthreads >= 1) && (nthreads <= APSP_MAX_THREADS));
+    atomic_init(&next, 0);
+
+    for (size_t i = 0; i < nthreads; i++) {
+        workers[i] = (struct johnson_worker){0, g, d, &next};
+        int ret = pthread_create(&workers[i].thread, NULL, johnson_worker, &workers[i]);
+        assert(ret == 0);
+        ((void)ret);
+    }
+    for (size_t i = 0; i < nthreads; i++) {
+        pthread_join(workers[i].thread, NULL);
+    }
+}
+
+//==============================================================================
+// All-Pairs Shortest Paths
+//==============================================================================
+
+// Kinds of all-pairs shortest paths algorithms.
+enum apsp_kind {
+    APSP_FLOYD_WARSHALL, // Blocked Floyd-Warshall's Algorithm.
+    APSP_JOHNSON,        // Johnson's Algorithm.
+};
+
+// Picks an all-pairs shortest paths algorithm for a graph. Johnson's Algorithm
+// runs in O(|V| * (|E| + |V| * log |V|)) time, and Floyd-Warshall's Algorithm
+// in O(|V|^3) time, but with regular accesses that are vectorized. Johnson's
+// Algorithm wins if the density of the graph is below a threshold that grows
+// with the number of nodes.
+static enum apsp_kind apsp_pick(const struct csr *g)
+{
+    size_t levels = 1;
+
+    for (size_t n = g->nnodes; n > 1; n /= 2) {
+        levels++;
+    }
+
+    return ((APSP_EDGE_COST * g->nedges + APSP_HEAP_COST * g->nnodes * levels <
+             g->nnodes * g->nnodes)
+                ? APSP_JOHNSON
+                : APSP_FLOYD_WARSHALL);
+}
+
+// Computes distances between all pairs of nodes of a graph with the algorithm
+// that suits its density.
+static struct apsp *apsp(const struct graph *g, size_t nthreads, enum apsp_kind *kind)
+{
+    struct csr *s = csr_from_graph(g);
+    struct apsp *d = apsp_create(g);
+
+    *kind = apsp_pick(s);
+    switch (*kind) {
+        case APSP_JOHNSON:
+            johnson(s, d, nthreads);
+            break;
+        case APSP_FLOYD_WARSHALL:
+        default:
+            floyd_warshall_blocked(d, nthreads);
+            break;
+    }
+    csr_destroy(s);
+
+    return (d);
+}
+
+//==============================================================================
+// Test
+//==============================================================================
+
+// Returns the current time in microseconds.
+static double now(void)
+{
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+
+    return (ts.tv_sec * 1000000.0 + ts.tv_nsec / 1000.0);
+}
+
+// Benchmarks all-pairs shortest paths algorithms on a random graph with a given density.
+static void test_density(size_t nnodes, double p, bool verbose)
+{
+    const char *names[] = {"Floyd-Warshall's Algorithm", "Johnson's Algorithm"};
+    const unsigned MAX_WEIGHT = (unsigned)nnodes;
+    struct graph *g = graph_create(nnodes);
+    struct csr *s = NULL;
+    struct apsp *reference = NULL;
+    struct apsp *d = NULL;
+    enum apsp_kind kind = APSP_FLOYD_WARSHALL;
+    double tstart = 0.0;
+    double tend = 0.0;
+
+    // Initialize the graph.
+    for (size_t i = 0; i < g->nnodes; i++) {
+        for (size_t j = 0; j < g->nnodes; j++) {
+            if ((i != j) && ((double)rand() / RAND_MAX < p)) {
+                graph_link(g, i, j)->weight = 1 + (unsigned)rand() % MAX_WEIGHT;
+            }
+        }
+    }
+    s = csr_from_graph(g);
+    printf("Graph: %zu nodes, %zu edges (density %.4lf)\n", s->nnodes, s->nedges, p);
+
+    if (verbose) {
+        graph_print(g, stdout);
+    }
+
+    // Plain Floyd-Warshall's Algorithm.
+    if (nnodes <= APSP_CHECK_NNODES) {
+        reference = apsp_create(g);
+        tstart = now();
+        floyd_warshall(reference);
+        tend = now();
+        printf("Floyd-Warshall's Algorithm (plain): %2.lf us\n", tend - tstart);
+    }
+
+    for (size_t nthreads = 1; nthreads <= APSP_MAX_THREADS; nthreads *= APSP_MAX_THREADS) {
+        // Blocked Floyd-Warshall's Algorithm.
+        d = apsp_create(g);
+        tstart = now();
+        floyd_warshall_blocked(d, nthreads);
+        tend = now();
+        printf("Floyd-Warshall's Algorithm (blocked, %zu threads): %2.lf us\n", nthreads,
+               tend - tstart);
+        if (reference == NULL) {
+            reference = d;
+        } else {
+            assert(apsp_equal(d, reference));
+            apsp_destroy(d);
+        }
+
+        // Johnson's Algorithm.
+        d = apsp_create(g);
+        tstart = now();
+        johnson(s, d, nthreads);
+        tend = now();
+        printf("Johnson's Algorithm (%zu threads): %2.lf us\n", nthreads, tend - tstart);
+        assert(apsp_equal(d, reference));
+        apsp_destroy(d);
+    }
+
+    // Pick by density.
+    tstart = now();
+    d = apsp(g, APSP_MAX_THREADS, &kind);
+    tend = now();
+    printf("apsp(): %2.lf us (%s)\n", tend - tstart, names[kind]);
+    assert(apsp_equal(d, reference));
+
+    // Release resources.
+    apsp_destroy(d);
+    apsp_destroy(reference);
+    csr_destroy(s);
+    graph_destroy(g);
+}
+
+// Tests all-pairs shortest paths algorithms.
+static void test(size_t nnodes, bool verbose)
+{
+    // Fix random number generator seed
+    // to have a determinist behavior across runs.
+    srand(0);
+
+    // Dense graph.
+    test_density(nnodes, 0.5, verbose);
+
+    // Sparse graph, with about eight links per node.
+    test_density(nnodes, (nnodes > 8) ? 8.0 / nnodes : 0.5, verbose);
+}
+
+//==============================================================================
+// Usage
+//==============================================================================
+
+// Prints program usage and exits.
+static void usage(char *const argv[])
+{
+    printf("%s - Testing program for all-pairs shortest paths.\n", argv[0]);
+    printf("Usage: %s [--verbose] <num_nodes>\n", argv[0]);
+    exit(EXIT_FAILURE);
+}
+
+//==============================================================================
+// Main
+//==============================================================================
+
+// Drives the test function.
+int main(int argc, char *const argv[])
+{
+    size_t nnodes = 0;
+    bool verbose = false;
+
+    // Check for missing arguments.
+    if ((argc < 2) || (argc > 3)) {
+        printf("Error: invalid number of arguments.\n");
+        usage(argv);
+    }
+
+    // Parse command line arguments.
+    if (argc == 2) {
+        sscanf(argv[1], "%zu", &nnodes);
+    } else if ((argc == 3) && (!strcmp(argv[1], "--verbose"))) {
+        sscanf(argv[2], "%zu", &nnodes);
+        verbose = true;
+    } else {
+        printf("Error: invalid arguments.\n");
+        usage(argv);
+    }
+
+    // Run it!
+    test(nnodes, verbose);
+
+    return (EXIT_SUCCESS);
+}
@@ -1,12 +1,36 @@
 // Copyright (C) 2022 Pedro Henrique Penna <pedrohenriquepenna@outlook.com>
 
+#define _POSIX_C_SOURCE 200809L
+
 #include <assert.h>
+#include <fcntl.h>
+#include <pthread.h>
+#include <stdatomic.h>
 #include <stdbool.h>
 #include <stddef.h>
+#include <stdint.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
 #include <time.h>
+#include <unistd.h>
+
+// Magic number of binary sparse graph files ("CSR1").
+#define CSR_MAGIC 0x31525343
+
+// Flag of binary sparse graph files that store each edge in both directions.
+#define CSR_UNDIRECTED 1
+
+// Max number of threads in Boruvka's Algorithm.
+#define MST_MAX_THREADS 8
+
+// Number of edges per node in the sparse graph benchmark.
+#define EDGES_PER_NODE 10
+
+// No edge selected for a component in Boruvka's Algorithm.
+#define BORUVKA_NONE UINT64_MAX
 
 //==============================================================================
 // Graph Data Structure
@@ -76,13 +100,13 @@ static void graph_print(const struct graph *g, FILE *f)
         precision += 1;
     }
     fprintf(f, "graph {\n");
-    fprintf(f, "nnodes: %d,\n", g->nnodes);
+    fprintf(f, "nnodes: %zu,\n", g->nnodes);
     fprintf(f, "links: \n");
     for (size_t i = 0; i < g->nnodes; i++) {
         fprintf(f, " [ ");
         for (size_t j = 0; j < g->nnodes; j++) {
             const struct link *l = graph_link(g, i, j);
-            fprintf(f, "%*u ", precision, l->weight);
+            fprintf(f, "%*u ", (int)precision, l->weight);
         }
         fprintf(f, "]\n");
     }
@@ -101,10 +125,11 @@ static void swap(size_t *x, size_t *y)
     *y = tmp;
 }
 
-// A heap that can grow dynamically.
+// A heap of elements in the range [0, capacity).
 struct heap {
     size_t *elements;   // Elements stored in the heap.
     size_t *priorities; // Priorities of elements stored in the heap.
+    size_t *positions;  // Position of each element in the heap.
     size_t length;      // Current number of elements that are stored in the heap.
     size_t capacity;    // Max number of elements that can be stored in the heap.
 };
@@ -120,6 +145,7 @@ static struct heap *heap_create(size_t capacity)
     h->capacity = capacity;
     assert((h->priorities = malloc(h->capacity * sizeof(h->priorities[0]))) != NULL);
     assert((h->elements = malloc(h->capacity * sizeof(h->elements[0]))) != NULL);
+    assert((h->positions = malloc(h->capacity * sizeof(h->positions[0]))) != NULL);
 
     return (h);
 }
@@ -127,6 +153,7 @@ static struct heap *heap_create(size_t capacity)
 // Destroys a heap.
 static void heap_destroy(struct heap *h)
 {
+    free(h->positions);
     free(h->elements);
     free(h->priorities);
     free(h);
@@ -138,6 +165,15 @@ static size_t heap_length(const struct heap *h)
     return (h->length);
 }
 
+// Swaps two entries of a heap.
+static void heap_swap(struct heap *h, size_t i, size_t j)
+{
+    swap(&h->priorities[i], &h->priorities[j]);
+    swap(&h->elements[i], &h->elements[j]);
+    h->positions[h->elements[i]] = i;
+    h->positions[h->elements[j]] = j;
+}
+
 // Fixes the heap property after an insertion on a heap.
 static void heap_fix_up(struct heap *h, size_t node)
 {
@@ -149,8 +185,7 @@ static void heap_fix_up(struct heap *h, size_t node)
         }
 
         // Swap elements.
-        swap(&h->priorities[root], &h->priorities[node]);
-        swap(&h->elements[root], &h->elements[node]);
+        heap_swap(h, root, node);
         node = root;
     }
 }
@@ -167,6 +202,7 @@ static void heap_push(struct heap *h, size_t element, size_t priority)
     // Insert element;
     h->elements[h->length - 1] = element;
     h->priorities[h->length - 1] = priority;
+    h->positions[element] = h->length - 1;
     if (h->length > 1) {
         heap_fix_up(h, h->length - 1);
     }
@@ -202,8 +238,7 @@ static void heap_fix_down(struct heap *h, size_t root)
         }
 
         // Swap elements and advance root.
-        swap(&h->priorities[root], &h->priorities[smallest]);
-        swap(&h->elements[root], &h->elements[smallest]);
+        heap_swap(h, root, smallest);
         root = smallest;
     } while (true);
 }
@@ -220,8 +255,7 @@ static size_t heap_pop(struct heap *h)
     size_t x = h->elements[0];
 
     // Remove element.
-    swap(&h->priorities[0], &h->priorities[h->length - 1]);
-    swap(&h->elements[0], &h->elements[h->length - 1]);
+    heap_swap(h, 0, h->length - 1);
     h->length -= 1;
     if (h->length > 1) {
         heap_fix_down(h, 0);
@@ -233,46 +267,38 @@ static size_t heap_pop(struct heap *h)
 // Decreases the priority of an element in a heap.
 static size_t heap_increase_priority(struct heap *h, size_t element, size_t new_priority)
 {
-    size_t i = 0;
-    size_t old_priority = 0;
+    size_t i = h->positions[element];
+    size_t old_priority = h->priorities[i];
 
-    // Empty heap.
-    assert(h->length > 0);
-
-    // Search for element.
-    for (i = 0; i < h->length; i++) {
-        // Found
-        if (h->elements[i] == element) {
-            assert(h->priorities[i] > new_priority);
-            old_priority = h->priorities[i];
-            h->priorities[i] = new_priority;
-            heap_fix_up(h, i);
-            return (old_priority);
-        }
-    }
+    // The element should be in the heap.
+    assert((i < h->length) && (h->elements[i] == element));
+    assert(old_priority > new_priority);
 
-    // Should not happen.
-    printf("not found %zu\n", element);
-    assert(0);
+    h->priorities[i] = new_priority;
+    heap_fix_up(h, i);
 
-    return (-1);
+    return (old_priority);
 }
 
 //==============================================================================
 // Prim's Algorithm
 //==============================================================================
 
-// Performs a Prim's Algorithm in a graph.
-static void prim(const struct graph *g, size_t src, struct graph *t)
+// Performs a Prim's Algorithm in a graph. Returns the total weight of the tree.
+static size_t prim(const struct graph *g, size_t src, struct graph *t)
 {
     struct heap *h = NULL;
+    size_t weight = 0;
     size_t from[g->nnodes];
     size_t cost[g->nnodes];
+    bool done[g->nnodes];
 
     assert((h = heap_create(g->nnodes)) != NULL);
 
     // Push initial nodes.
-    cost[src] = 0;
+    memset(done, 0, sizeof(done));
+    done[src] = true;
+    from[src] = src, cost[src] = 0;
     for (size_t i = 0; i < g->nnodes; i++) {
         if (i != src) {
             struct link *l = graph_link(g, src, i);
@@ -291,18 +317,20 @@ static void prim(const struct graph *g, size_t src, struct graph *t)
     // Process all nodes that in the graph.
     while (heap_length(h) != 0) {
         size_t i = heap_pop(h);
+        done[i] = true;
 
         // Add edge to minimum spanning-tree.
         struct link *l1 = graph_link(g, from[i], i);
         struct link *l2 = graph_link(t, from[i], i);
         l2->weight = l1->weight;
+        weight += l1->weight;
 
         // Process all neighbor nodes.
         for (size_t j = 0; j < g->nnodes; j++) {
             struct link *l = graph_link(g, i, j);
 
-            // This is a neighbor.
-            if (l->weight > 0) {
+            // This is a neighbor that is not in the tree yet.
+            if ((l->weight > 0) && !done[j]) {
                 size_t new_cost = l->weight;
 
                 // This node was visited previously.
@@ -324,12 +352,701 @@ static void prim(const struct graph *g, size_t src, struct graph *t)
 
     // Release resources.
     heap_destroy(h);
+
+    return (weight);
+}
+
+//==============================================================================
+// Edge List
+//==============================================================================
+
+// A weighted edge.
+struct edge {
+    unsigned u;      // First endpoint.
+    unsigned v;      // Second endpoint.
+    unsigned weight; // Weight.
+};
+
+// A graph stored as an edge list.
+struct edge_list {
+    unsigned nnodes;    // Number of nodes.
+    size_t nedges;      // Number of edges.
+    struct edge *edges; // Edges.
+};
+
+// Creates an empty edge list.
+static struct edge_list *edge_list_create(unsigned nnodes, size_t capacity)
+{
+    struct edge_list *el = NULL;
+
+    assert((el = malloc(sizeof(struct edge_list))) != NULL);
+    assert((el->edges = malloc(capacity * sizeof(struct edge))) != NULL);
+    el->nnodes = nnodes;
+    el->nedges = 0;
+
+    return (el);
+}
+
+// Destroys an edge list.
+static void edge_list_destroy(struct edge_list *el)
+{
+    free(el->edges);
+    free(el);
+}
+
+// Builds the edge list of an undirected graph stored as an adjacency matrix.
+static struct edge_list *edge_list_from_graph(const struct graph *g)
+{
+    struct edge_list *el = edge_list_create(g->nnodes, g->nnodes * g->nnodes / 2);
+
+    for (size_t i = 0; i < g->nnodes; i++) {
+        for (size_t j = i + 1; j < g->nnodes; j++) {
+            const struct link *l = graph_link(g, i, j);
+            if (l->weight > 0) {
+                el->edges[el->nedges++] = (struct edge){i, j, l->weight};
+            }
+        }
+    }
+
+    return (el);
+}
+
+// Returns the total weight of a list of edges.
+static size_t edges_weight(const struct edge *edges, size_t nedges)
+{
+    size_t weight = 0;
+
+    for (size_t i = 0; i < nedges; i++) {
+        weight += edges[i].weight;
+    }
+
+    return (weight);
+}
+
+//==============================================================================
+// Disjoint Set
+//==============================================================================
+
+// A disjoint set.
+struct dset {
+    unsigned length;    // Number of elements.
+    unsigned *elements; // Elements.
+    unsigned *weights;  // Weight of elements.
+};
+
+// Creates a disjoint set.
+static struct dset *dset_create(unsigned length)
+{
+    struct dset *ds = NULL;
+
+    // Allocate resources.
+    assert((ds = malloc(sizeof(struct dset))) != NULL);
+    assert((ds->elements = malloc(length * sizeof(ds->elements[0]))) != NULL);
+    assert((ds->weights = malloc(length * sizeof(ds->weights[0]))) != NULL);
+
+    // Initialize.
+    ds->length = length;
+    for (unsigned i = 0; i < length; i++) {
+        ds->elements[i] = i;
+        ds->weights[i] = 1;
+    }
+
+    return (ds);
+}
+
+// Destroys a disjoint set.
+static void dset_destroy(struct dset *ds)
+{
+    free(ds->weights);
+    free(ds->elements);
+    free(ds);
+}
+
+// Finds the representative element of a set in a disjoint set.
+static unsigned dset_find(struct dset *ds, unsigned p)
+{
+    // Traverse set.
+    while (p != ds->elements[p]) {
+        // Path compression.
+        ds->elements[p] = ds->elements[ds->elements[p]];
+
+        // Move to the next element.
+        p = ds->elements[p];
+    }
+
+    return (p);
+}
+
+// Merges two sets of a disjoint set. Returns true if they were disjoint.
+static bool dset_union(struct dset *ds, unsigned p, unsigned q)
+{
+    // Find representative elements of each set.
+    unsigned p_set = dset_find(ds, p);
+    unsigned q_set = dset_find(ds, q);
+
+    // Already merged.
+    if (p_set == q_set) {
+        return (false);
+    }
+
+    // Weighted-union heuristic: link the representative element of the
+    // smaller set to the representative element of the larger set.
+    if (ds->weights[p_set] > ds->weights[q_set]) {
+        unsigned tmp = p_set;
+        p_set = q_set;
+        q_set = tmp;
+    }
+    ds->elements[p_set] = q_set;
+    ds->weights[q_set] += ds->weights[p_set];
+
+    return (true);
+}
+
+//==============================================================================
+// Kruskal's Algorithm
+//==============================================================================
+
+// Sorts edges by weight with a least-significant-digit radix sort.
+static void radix_sort(struct edge *edges, size_t nedges)
+{
+    struct edge *buffer = malloc(nedges * sizeof(struct edge));
+    struct edge *src = edges;
+    struct edge *dst = buffer;
+
+    assert((nedges == 0) || (buffer != NULL));
+
+    // Sort one byte at a time.
+    for (unsigned shift = 0; shift < 32; shift += 8) {
+        size_t offsets[256] = {0};
+
+        // Histogram.
+        for (size_t i = 0; i < nedges; i++) {
+            offsets[(src[i].weight >> shift) & 0xff]++;
+        }
+
+        // All edges have the same digit.
+        if ((nedges > 0) && (offsets[(src[0].weight >> shift) & 0xff] == nedges)) {
+            continue;
+        }
+
+        // Prefix sum.
+        for (size_t i = 0, sum = 0; i < 256; i++) {
+            size_t count = offsets[i];
+            offsets[i] = sum;
+            sum += count;
+        }
+
+        // Scatter.
+        for (size_t i = 0; i < nedges; i++) {
+            dst[offsets[(src[i].weight >> shift) & 0xff]++] = src[i];
+        }
+
+        struct edge *tmp = src;
+        src = dst;
+        dst = tmp;
+    }
+
+    // Sorted edges are in the buffer.
+    if (src != edges) {
+        memcpy(edges, src, nedges * sizeof(struct edge));
+    }
+
+    free(buffer);
+}
+
+// Performs a Kruskal's Algorithm in a graph. Edges are sorted in place.
+// Returns the number of edges in the spanning forest.
+static size_t kruskal(struct edge_list *el, struct edge *tree)
+{
+    size_t ntree = 0;
+    struct dset *ds = dset_create(el->nnodes);
+
+    radix_sort(el->edges, el->nedges);
+
+    // Add edges that connect different trees, in increasing order of weight.
+    for (size_t i = 0; (i < el->nedges) && (ntree + 1 < el->nnodes); i++) {
+        if (dset_union(ds, el->edges[i].u, el->edges[i].v)) {
+            tree[ntree++] = el->edges[i];
+        }
+    }
+
+    dset_destroy(ds);
+
+    return (ntree);
+}
+
+//==============================================================================
+// Boruvka's Algorithm
+//==============================================================================
+
+// Arguments of a Boruvka thread.
+struct worker {
+    pthread_t thread;           // Thread.
+    const struct edge_list *el; // Graph.
+    const unsigned *components; // Component of each node.
+    _Atomic uint64_t *cheapest; // Cheapest edge of each component.
+    size_t first;               // First edge to process.
+    size_t last;                // Last edge to process (exclusive).
+};
+
+// Lowers the cheapest edge of a component. Edges are keyed by weight and
+// then by index, so all components agree on a single order and never
+// select edges that form a cycle.
+static void boruvka_lower(_Atomic uint64_t *cheapest, uint64_t key)
+{
+    uint64_t current = atomic_load_explicit(cheapest, memory_order_relaxed);
+
+    while ((key < current) && !atomic_compare_exchange_weak(cheapest, &current, key)) {
+    }
+}
+
+// Finds the cheapest edge leaving each component, on a range of edges.
+static void *boruvka_worker(void *arg)
+{
+    struct worker *w = arg;
+
+    for (size_t i = w->first; i < w->last; i++) {
+        const struct edge *e = &w->el->edges[i];
+        unsigned cu = w->components[e->u];
+        unsigned cv = w->components[e->v];
+
+        // Edge inside a component.
+        if (cu == cv) {
+            continue;
+        }
+
+        uint64_t key = ((uint64_t)e->weight << 32) | i;
+        boruvka_lower(&w->cheapest[cu], key);
+        boruvka_lower(&w->cheapest[cv], key);
+    }
+
+    return (NULL);
+}
+
+// Performs a Boruvka's Algorithm in a graph with several threads.
+// Returns the number of edges in the spanning forest.
+static size_t boruvka(const struct edge_list *el, struct edge *tree, size_t nthreads)
+{
+    size_t ntree = 0;
+    bool merged = true;
+    struct worker workers[MST_MAX_THREADS];
+    struct dset *ds = dset_create(el->nnodes);
+    unsigned *components = malloc(el->nnodes * sizeof(unsigned));
+    _Atomic uint64_t *cheapest = malloc(el->nnodes * sizeof(_Atomic uint64_t));
+
+    assert((nthreads > 0) && (nthreads <= MST_MAX_THREADS));
+    assert((el->nnodes == 0) || ((components != NULL) && (cheapest != NULL)));
+
+    // Edge indexes must fit in the low half of keys.
+    assert(el->nedges <= UINT32_MAX);
+
+    for (unsigned i = 0; i < el->nnodes; i++) {
+        components[i] = i;
+    }
+
+    // Each round at least halves the number of components.
+    while (merged) {
+        merged = false;
+
+        for (unsigned i = 0; i < el->nnodes; i++) {
+            atomic_init(&cheapest[i], BORUVKA_NONE);
+        }
+
+        // Find the cheapest edge leaving each component in parallel.
+        for (size_t i = 0; i < nthreads; i++) {
+            workers[i].el = el;
+            workers[i].components = components;
+            workers[i].cheapest = cheapest;
+            workers[i].first = (el->nedges * i) / nthreads;
+            workers[i].last = (el->nedges * (i + 1)) / nthreads;
+            int ret = pthread_create(&workers[i].thread, NULL, boruvka_worker, &workers[i]);
+            assert(ret == 0);
+            ((void)ret);
+        }
+        for (size_t i = 0; i < nthreads; i++) {
+            pthread_join(workers[i].thread, NULL);
+        }
+
+        // Contract cheapest edges.
+        for (unsigned i = 0; i < el->nnodes; i++) {
+            uint64_t key = atomic_load_explicit(&cheapest[i], memory_order_relaxed);
+            if (key != BORUVKA_NONE) {
+                const struct edge *e = &el->edges[key & UINT32_MAX];
+                if (dset_union(ds, e->u, e->v)) {
+                    tree[ntree++] = *e;
+                    merged = true;
+                }
+            }
+        }
+        for (unsigned i = 0; i < el->nnodes; i++) {
+            components[i] = dset_find(ds, i);
+        }
+    }
+
+    // Release resources.
+    free(cheapest);
+    free(components);
+    dset_destroy(ds);
+
+    return (ntree);
+}
+
+// Returns the current time in microseconds.
+static double now(void)
+{
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+
+    return (ts.tv_sec * 1000000.0 + ts.tv_nsec / 1000.0);
+}
+
+//==============================================================================
+// Sparse Graph Data Structure
+//==============================================================================
+
+// An undirected sparse graph in compressed sparse row format. Each edge is
+// stored in the rows of both endpoints.
+struct csr {
+    unsigned nnodes;     // Number of nodes.
+    size_t nedges;       // Number of directed edges.
+    size_t *offsets;     // Offset of the first edge of each node (nnodes + 1 entries).
+    unsigned *targets;   // Target node of each edge.
+    unsigned *weights;   // Weight of each edge.
+    void *mapping;       // Mapped file (NULL if allocated).
+    size_t mapping_size; // Size of the mapped file.
+};
+
+// Builds a sparse graph from an edge list.
+static struct csr *csr_from_edge_list(const struct edge_list *el)
+{
+    struct csr *g = NULL;
+
+    // Allocate data structure.
+    assert((g = malloc(sizeof(struct csr))) != NULL);
+    g->nnodes = el->nnodes;
+    g->nedges = 2 * el->nedges;
+    g->mapping = NULL;
+    g->mapping_size = 0;
+    assert((g->offsets = calloc(g->nnodes + 1, sizeof(size_t))) != NULL);
+    assert((g->targets = malloc(g->nedges * sizeof(unsigned))) != NULL);
+    assert((g->weights = malloc(g->nedges * sizeof(unsigned))) != NULL);
+
+    // Count degrees, shifted by one node.
+    for (size_t i = 0; i < el->nedges; i++) {
+        g->offsets[el->edges[i].u + 1]++;
+        g->offsets[el->edges[i].v + 1]++;
+    }
+    for (unsigned i = 0; i < g->nnodes; i++) {
+        g->offsets[i + 1] += g->offsets[i];
+    }
+
+    // Place edges, using the first offset of each node as cursor.
+    for (size_t i = 0; i < el->nedges; i++) {
+        const struct edge *e = &el->edges[i];
+        size_t k = g->offsets[e->u]++;
+        g->targets[k] = e->v, g->weights[k] = e->weight;
+        k = g->offsets[e->v]++;
+        g->targets[k] = e->u, g->weights[k] = e->weight;
+    }
+
+    // Cursors now point to the next row, so shift them back.
+    for (unsigned i = g->nnodes; i > 0; i--) {
+        g->offsets[i] = g->offsets[i - 1];
+    }
+    g->offsets[0] = 0;
+
+    return (g);
+}
+
+// Destroys a sparse graph.
+static void csr_destroy(struct csr *g)
+{
+    if (g->mapping != NULL) {
+        munmap(g->mapping, g->mapping_size);
+    } else {
+        free(g->weights);
+        free(g->targets);
+        free(g->offsets);
+    }
+    free(g);
+}
+
+// Header of a binary sparse graph file, as written by graph/loader. It is
+// followed by the offsets (nnodes + 1 entries of 64 bits), the targets and
+// the weights (nedges entries of 32 bits each).
+struct csr_header {
+    uint32_t magic;  // Magic number.
+    uint32_t flags;  // Flags.
+    uint64_t nnodes; // Number of nodes.
+    uint64_t nedges; // Number of edges.
+};
+
+// Checks the arrays of a graph in compressed sparse row format: offsets
+// must start at zero, never decrease and end at the number of edges, and
+// targets must be valid nodes, so that the graph can be walked without
+// further checks.
+static bool csr_check_arrays(const uint64_t *offsets, const uint32_t *targets, uint64_t nnodes,
+                             uint64_t nedges)
+{
+    // Check offsets.
+    if ((offsets[0] != 0) || (offsets[nnodes] != nedges)) {
+        return (false);
+    }
+    for (uint64_t u = 0; u < nnodes; u++) {
+        if (offsets[u] > offsets[u + 1]) {
+            return (false);
+        }
+    }
+
+    // Check targets.
+    for (uint64_t k = 0; k < nedges; k++) {
+        if (targets[k] >= nnodes) {
+            return (false);
+        }
+    }
+
+    return (true);
+}
+
+// Checks the contents of a mapped binary sparse graph file. Sizes are
+// checked without overflowing before arrays are checked.
+static bool csr_check(const void *mapping, size_t size)
+{
+    const struct csr_header *h = mapping;
+    const uint64_t *offsets = (const uint64_t *)(h + 1);
+    size_t remaining = 0;
+
+    // Check header.
+    if ((size < sizeof(struct csr_header)) || (h->magic != CSR_MAGIC)) {
+        return (false);
+    }
+
+    // Check sizes. Targets are 32-bit node numbers.
+    remaining = size - sizeof(struct csr_header);
+    if ((h->nnodes > (uint64_t)UINT32_MAX + 1) || (h->nnodes >= remaining / sizeof(uint64_t))) {
+        return (false);
+    }
+    remaining -= (h->nnodes + 1) * sizeof(uint64_t);
+    if ((h->nedges > remaining / (2 * sizeof(uint32_t))) ||
+        (remaining != h->nedges * 2 * sizeof(uint32_t))) {
+        return (false);
+    }
+
+    return (csr_check_arrays(offsets, (const uint32_t *)(offsets + h->nnodes + 1), h->nnodes,
+                             h->nedges));
+}
+
+// Maps a binary sparse graph file in memory. No data is copied: the graph
+// points into the mapping, and pages are loaded on first access. Only files
+// that store each edge in both directions are accepted.
+static struct csr *csr_map(const char *path)
+{
+    int fd = -1;
+    struct stat st;
+    struct csr *g = NULL;
+    const struct csr_header *h = NULL;
+
+    if ((fd = open(path, O_RDONLY)) < 0) {
+        return (NULL);
+    }
+    if ((fstat(fd, &st) < 0) || ((size_t)st.st_size < sizeof(struct csr_header))) {
+        close(fd);
+        return (NULL);
+    }
+
+    assert((g = malloc(sizeof(struct csr))) != NULL);
+    g->mapping_size = (size_t)st.st_size;
+    g->mapping = mmap(NULL, g->mapping_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (g->mapping == MAP_FAILED) {
+        free(g);
+        return (NULL);
+    }
+
+    // Check contents.
+    h = g->mapping;
+    if (!csr_check(g->mapping, g->mapping_size) || (!(h->flags & CSR_UNDIRECTED)) ||
+        (h->nnodes >= UINT32_MAX)) {
+        munmap(g->mapping, g->mapping_size);
+        free(g);
+        return (NULL);
+    }
+
+    g->nnodes = h->nnodes;
+    g->nedges = h->nedges;
+    g->offsets = (size_t *)(h + 1);
+    g->targets = (unsigned *)(g->offsets + g->nnodes + 1);
+    g->weights = g->targets + g->nedges;
+
+    return (g);
+}
+
+// Writes a graph stored as an adjacency matrix to a binary sparse graph file.
+static void csr_write_graph(const struct graph *g, uint32_t flags, FILE *f)
+{
+    struct csr_header h = {CSR_MAGIC, flags, g->nnodes, 0};
+    uint64_t offset = 0;
+
+    // Count edges.
+    for (size_t i = 0; i < g->nnodes * g->nnodes; i++) {
+        h.nedges += (g->links[i].weight > 0);
+    }
+    assert(fwrite(&h, sizeof(h), 1, f) == 1);
+
+    // Offsets.
+    for (size_t i = 0; i < g->nnodes; i++) {
+        assert(fwrite(&offset, sizeof(offset), 1, f) == 1);
+        for (size_t j = 0; j < g->nnodes; j++) {
+            offset += (graph_link(g, i, j)->weight > 0);
+        }
+    }
+    assert(fwrite(&offset, sizeof(offset), 1, f) == 1);
+
+    // Targets.
+    for (size_t i = 0; i < g->nnodes * g->nnodes; i++) {
+        uint32_t target = i % g->nnodes;
+        if (g->links[i].weight > 0) {
+            assert(fwrite(&target, sizeof(target), 1, f) == 1);
+        }
+    }
+
+    // Weights.
+    for (size_t i = 0; i < g->nnodes * g->nnodes; i++) {
+        uint32_t weight = g->links[i].weight;
+        if (weight > 0) {
+            assert(fwrite(&weight, sizeof(weight), 1, f) == 1);
+        }
+    }
+}
+
+//==============================================================================
+// Sparse Prim's Algorithm
+//==============================================================================
+
+// Performs a Prim's Algorithm in a sparse graph. The tree is emitted as an
+// edge list, and memory is linear in the size of the graph. Returns the
+// number of edges in the spanning tree.
+static size_t prim_sparse(const struct csr *g, unsigned src, struct edge *tree)
+{
+    size_t ntree = 0;
+    struct heap *h = heap_create(g->nnodes);
+    unsigned *from = malloc(g->nnodes * sizeof(unsigned));
+    unsigned *cost = malloc(g->nnodes * sizeof(unsigned));
+    bool *done = calloc(g->nnodes, sizeof(bool));
+
+    assert((from != NULL) && (cost != NULL) && (done != NULL));
+
+    // Push source node.
+    for (unsigned i = 0; i < g->nnodes; i++) {
+        cost[i] = UINT32_MAX;
+    }
+    from[src] = src, cost[src] = 0;
+    heap_push(h, src, 0);
+
+    // Process all nodes that are reachable from the source.
+    while (heap_length(h) != 0) {
+        unsigned i = heap_pop(h);
+        done[i] = true;
+
+        // Add edge to minimum spanning-tree.
+        if (i != src) {
+            tree[ntree++] = (struct edge){from[i], i, cost[i]};
+        }
+
+        // Process all neighbor nodes that are not in the tree yet.
+        for (size_t k = g->offsets[i]; k < g->offsets[i + 1]; k++) {
+            unsigned j = g->targets[k];
+            unsigned new_cost = g->weights[k];
+
+            if (done[j] || (new_cost >= cost[j])) {
+                continue;
+            }
+
+            // This is the first time we visit this node.
+            if (cost[j] == UINT32_MAX) {
+                heap_push(h, j, new_cost);
+            } else {
+                heap_increase_priority(h, j, new_cost);
+            }
+            from[j] = i, cost[j] = new_cost;
+        }
+    }
+
+    // Release resources.
+    free(done);
+    free(cost);
+    free(from);
+    heap_destroy(h);
+
+    return (ntree);
 }
 
 //==============================================================================
 // Test
 //==============================================================================
 
+// Benchmarks Kruskal's and Boruvka's Algorithms on a sparse random graph.
+static void test_sparse(unsigned nnodes)
+{
+    size_t ntree = 0;
+    size_t weight = 0;
+    double tstart = 0.0;
+    double tend = 0.0;
+    struct edge_list *el = edge_list_create(nnodes, (size_t)EDGES_PER_NODE * nnodes);
+    struct edge *tree = malloc(nnodes * sizeof(struct edge));
+
+    assert(tree != NULL);
+
+    // Random graph, connected by a path.
+    for (unsigned i = 0; i + 1 < nnodes; i++) {
+        el->edges[el->nedges++] = (struct edge){i, i + 1, 1 + (unsigned)rand() % nnodes};
+    }
+    while ((nnodes > 0) && (el->nedges < (size_t)EDGES_PER_NODE * nnodes)) {
+        unsigned u = (unsigned)rand() % nnodes;
+        unsigned v = (unsigned)rand() % nnodes;
+        if (u != v) {
+            el->edges[el->nedges++] = (struct edge){u, v, 1 + (unsigned)rand() % nnodes};
+        }
+    }
+    printf("Sparse graph: %u nodes, %zu edges\n", el->nnodes, el->nedges);
+
+    // Boruvka's Algorithm.
+    for (size_t nthreads = 1; nthreads <= MST_MAX_THREADS; nthreads *= 2) {
+        tstart = now();
+        ntree = boruvka(el, tree, nthreads);
+        tend = now();
+        printf("Boruvka's Algorithm (%zu threads): %2.lf us\n", nthreads, tend - tstart);
+        assert((nnodes == 0) || (ntree == nnodes - 1));
+        if (nthreads == 1) {
+            weight = edges_weight(tree, ntree);
+        }
+        assert(edges_weight(tree, ntree) == weight);
+    }
+
+    // Prim's Algorithm.
+    if (nnodes > 0) {
+        struct csr *g = csr_from_edge_list(el);
+        tstart = now();
+        ntree = prim_sparse(g, 0, tree);
+        tend = now();
+        printf("Prim's Algorithm (sparse): %2.lf us\n", tend - tstart);
+        assert((ntree == nnodes - 1) && (edges_weight(tree, ntree) == weight));
+        csr_destroy(g);
+    }
+
+    // Kruskal's Algorithm.
+    tstart = now();
+    ntree = kruskal(el, tree);
+    tend = now();
+    printf("Kruskal's Algorithm: %2.lf us\n", tend - tstart);
+    assert(edges_weight(tree, ntree) == weight);
+
+    // Release resources.
+    free(tree);
+    edge_list_destroy(el);
+}
+
 // Tests Prim's Algorithm.
 static void test(size_t nnodes, bool verbose)
 {
@@ -342,26 +1059,30 @@ static void test(size_t nnodes, bool verbose)
     const double MICROSECS = ((CLOCKS_PER_SEC / 1000000.0));
     struct graph *g = graph_create(nnodes);
     struct graph *t = graph_create(nnodes);
+    size_t weight = 0;
+    size_t ntree = 0;
+    struct edge_list *el = NULL;
+    struct edge *tree = NULL;
 
     // Fix random number generator seed
     // to have a determinist behavior across runs.
     srand(0);
 
-    // Initialize the graph.
+    // Initialize the graph. Spanning trees are defined on undirected graphs.
     for (size_t i = 0; i < g->nnodes; i++) {
-        for (size_t j = 0; j < g->nnodes; j++) {
+        for (size_t j = i + 1; j < g->nnodes; j++) {
             float q = (rand() % 100) / 100.0;
             if (q < p) {
                 unsigned w = nnodes + (rand() % MAX_WEIGTH);
-                struct link *l = graph_link(g, i, j);
-                l->weight = w;
+                graph_link(g, i, j)->weight = w;
+                graph_link(g, j, i)->weight = w;
             }
         }
     }
     assert(source < dest);
     for (size_t i = source; i < dest; i++) {
-        struct link *l = graph_link(g, i, i + 1);
-        l->weight = 1;
+        graph_link(g, i, i + 1)->weight = 1;
+        graph_link(g, i + 1, i)->weight = 1;
     }
 
     if (verbose) {
@@ -370,7 +1091,7 @@ static void test(size_t nnodes, bool verbose)
 
     // Search in the array.
     tstart = clock();
-    prim(g, source, t);
+    weight = prim(g, source, t);
     tend = clock();
 
     // Report time.
@@ -380,9 +1101,79 @@ static void test(size_t nnodes, bool verbose)
         graph_print(t, stdout);
     }
 
+    // All algorithms must find a tree with the same weight.
+    el = edge_list_from_graph(g);
+    tree = malloc(nnodes * sizeof(struct edge));
+    assert(tree != NULL);
+    tstart = clock();
+    ntree = boruvka(el, tree, MST_MAX_THREADS);
+    tend = clock();
+    printf("Boruvka's Algorithm: %2.lf us\n", (tend - tstart) / MICROSECS);
+    assert((ntree == nnodes - 1) && (edges_weight(tree, ntree) == weight));
+    tstart = clock();
+    ntree = kruskal(el, tree);
+    tend = clock();
+    printf("Kruskal's Algorithm: %2.lf us\n", (tend - tstart) / MICROSECS);
+    assert((ntree == nnodes - 1) && (edges_weight(tree, ntree) == weight));
+
+    // Search in a sparse graph mapped from a file.
+    if (nnodes > 0) {
+        char csr_path[] = "/tmp/prim-XXXXXX";
+        FILE *f = fdopen(mkstemp(csr_path), "wb");
+        assert(f != NULL);
+        csr_write_graph(g, CSR_UNDIRECTED, f);
+        fclose(f);
+        struct csr *sg = csr_map(csr_path);
+        assert(sg != NULL);
+        tstart = clock();
+        ntree = prim_sparse(sg, source, tree);
+        tend = clock();
+        printf("Prim's Algorithm (sparse): %2.lf us\n", (tend - tstart) / MICROSECS);
+        assert((ntree == nnodes - 1) && (edges_weight(tree, ntree) == weight));
+        csr_destroy(sg);
+        unlink(csr_path);
+    }
+
     // Release resources.
+    free(tree);
+    edge_list_destroy(el);
     graph_destroy(t);
     graph_destroy(g);
+
+    // Benchmark on a sparse graph.
+    test_sparse(nnodes * nnodes);
+}
+
+// Runs Prim's Algorithm on a graph that is loaded from a binary sparse graph file.
+static void test_loaded(const char *filename)
+{
+    size_t ntree = 0;
+    double tstart = 0.0;
+    double tend = 0.0;
+    struct csr *g = NULL;
+    struct edge *tree = NULL;
+
+    tstart = now();
+    g = csr_map(filename);
+    tend = now();
+    if ((g == NULL) || (g->nnodes == 0)) {
+        fprintf(stderr, "Error: cannot load %s (must be undirected).\n", filename);
+        exit(EXIT_FAILURE);
+    }
+    printf("Loaded %u nodes and %zu edges (%zu bytes): %2.lf us\n", g->nnodes, g->nedges,
+           g->mapping_size, tend - tstart);
+
+    // Spanning tree of the component that contains the first node.
+    assert((tree = malloc(g->nnodes * sizeof(struct edge))) != NULL);
+    tstart = now();
+    ntree = prim_sparse(g, 0, tree);
+    tend = now();
+    printf("Prim's Algorithm (sparse): %2.lf us (%zu edges, weight %zu)\n", tend - tstart,
+           ntree, edges_weight(tree, ntree));
+
+    // Release resources.
+    free(tree);
+    csr_destroy(g);
 }
 
 //==============================================================================
@@ -394,6 +1185,7 @@ static void usage(char *const argv[])
 {
     printf("%s - Testing program for Prim's Algorithm.\n", argv[0]);
     printf("Usage: %s [--verbose] <>\num_nodes n", argv[0]);
+    printf("       %s --graph <undirected graph file>\n", argv[0]);
     exit(EXIT_FAILURE);
 }
 
@@ -414,7 +1206,10 @@ int main(int argc, char *const argv[])
     }
 
     // Parse command line arguments.
-    if (argc == 2) {
+    if ((argc == 3) && (!strcmp(argv[1], "--graph"))) {
+        test_loaded(argv[2]);
+        return (EXIT_SUCCESS);
+    } else if (argc == 2) {
         sscanf(argv[1], "%zu", &nnodes);
     } else if ((argc == 3) && (!strcmp(argv[1], "--verbose"))) {
         sscanf(argv[2], "%zu", &nnodes);
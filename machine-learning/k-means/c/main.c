@@ -1,6 +1,10 @@
 // Copyright (C) 2022 Pedro Henrique Penna <pedrohenriquepenna@outlook.com>
 
+#define _POSIX_C_SOURCE 200809L
+
 #include <assert.h>
+#include <math.h>
+#include <pthread.h>
 #include <stdbool.h>
 #include <stddef.h>
 #include <stdio.h>
@@ -8,6 +12,34 @@
 #include <string.h>
 #include <time.h>
 
+// Number of points that are sampled in each iteration of Mini-Batch K-Means.
+#define KMEANS_BATCH_SIZE 1024
+
+// Number of iterations of Mini-Batch K-Means.
+#define KMEANS_MINIBATCH_ITERATIONS 100
+
+// Max ratio between the inertia of Mini-Batch K-Means and the one of Lloyd's algorithm.
+#define KMEANS_MINIBATCH_SLACK 1.25
+
+// Number of elements in a SIMD vector.
+#define KMEANS_LANES 4
+
+// Number of points and of centroids in a block of the assignment kernel.
+// Dot products of a block are kept in registers.
+#define KMEANS_BLOCK_POINTS 4
+#define KMEANS_BLOCK_CENTROIDS 2
+
+// Number of points in a tile, and of centroids in a panel. A panel stays in
+// the cache while a tile is assigned.
+#define KMEANS_TILE 64
+#define KMEANS_PANEL 64
+
+// Max number of threads.
+#define KMEANS_MAX_THREADS 8
+
+// Max relative difference between the inertia of parallel K-Means and the one of Lloyd's algorithm.
+#define KMEANS_PARALLEL_SLACK 1e-9
+
 //==============================================================================
 // Vector
 //==============================================================================
@@ -91,6 +123,19 @@ static void vector_scale(struct vector *v, double scale)
     }
 }
 
+// Moves a vector towards another one by a fraction of the distance between them.
+static void vector_blend(struct vector *v1, struct vector *v2, double fraction)
+{
+    // Sanity check arguments.
+    assert(v1 != NULL);
+    assert(v2 != NULL);
+    assert(v1->dimension == v2->dimension);
+
+    for (unsigned i = 0; i < v1->dimension; i++) {
+        v1->elements[i] += fraction * (v2->elements[i] - v1->elements[i]);
+    }
+}
+
 // Computes the squared euclidean distance between two vectors.
 static double vector_distance2(struct vector *v1, struct vector *v2)
 {
@@ -122,37 +167,191 @@ static void vector_print(const struct vector *v)
     printf("] }\n");
 }
 
+//==============================================================================
+// Matrix
+//==============================================================================
+
+// A vector of elements that are processed at once.
+typedef double vdouble_t __attribute__((vector_size(KMEANS_LANES * sizeof(double))));
+
+// A matrix of vectors, which are stored contiguously in row-major order.
+// Rows are padded with zeros to a multiple of the SIMD width, and aligned.
+struct matrix {
+    size_t nrows;     // Number of rows.
+    unsigned ncols;   // Number of columns.
+    unsigned stride;  // Distance between rows (in elements).
+    double *elements; // Elements.
+};
+
+// Creates a matrix.
+static struct matrix *matrix_create(size_t nrows, unsigned ncols)
+{
+    // Sanity check arguments.
+    assert(ncols > 0);
+
+    struct matrix *m = NULL;
+    assert((m = malloc(sizeof(struct matrix))) != NULL);
+    m->nrows = nrows;
+    m->ncols = ncols;
+    m->stride = (ncols + KMEANS_LANES - 1) / KMEANS_LANES * KMEANS_LANES;
+    assert((m->elements = aligned_alloc(sizeof(vdouble_t), (nrows + 1) * m->stride * sizeof(double))) != NULL);
+    memset(m->elements, 0, (nrows + 1) * m->stride * sizeof(double));
+    return (m);
+}
+
+// Destroys the target matrix.
+static void matrix_destroy(struct matrix *m)
+{
+    // Sanity check arguments.
+    assert(m != NULL);
+
+    free(m->elements);
+    free(m);
+}
+
+// Returns a row of a matrix.
+static double *matrix_row(const struct matrix *m, size_t i)
+{
+    return (&m->elements[i * m->stride]);
+}
+
+// Builds a matrix whose rows are copies of vectors.
+static struct matrix *matrix_from_vectors(struct vector *const *vectors, size_t nvectors)
+{
+    struct matrix *m = matrix_create(nvectors, vectors[0]->dimension);
+
+    for (size_t i = 0; i < nvectors; i++) {
+        memcpy(matrix_row(m, i), vectors[i]->elements, m->ncols * sizeof(double));
+    }
+
+    return (m);
+}
+
+// Computes the squared euclidean distance between two rows. Elements are
+// visited in the same order as in vector_distance2().
+static double row_distance2(const double *r1, const double *r2, unsigned ncols)
+{
+    double distance = 0.0;
+
+    for (unsigned i = 0; i < ncols; i++) {
+        double x = r1[i] - r2[i];
+        distance += x * x;
+    }
+
+    return (distance);
+}
+
+// Computes the dot product of a row with itself.
+static double row_norm2(const double *r, unsigned stride)
+{
+    vdouble_t sum = {0};
+    double norm = 0.0;
+
+    for (unsigned i = 0; i < stride; i += KMEANS_LANES) {
+        const vdouble_t x = *(const vdouble_t *)&r[i];
+        sum += x * x;
+    }
+    for (unsigned l = 0; l < KMEANS_LANES; l++) {
+        norm += sum[l];
+    }
+
+    return (norm);
+}
+
 //==============================================================================
 // K-Means Clustering
 //==============================================================================
 
-// Initializes K-Means algorithm using Forgy's approach.
-static void kmeans_init(struct vector *const *points, unsigned npoints, struct vector **centroids, unsigned ncentroids)
+// Kinds of K-Means algorithms.
+enum kmeans_kind {
+    KMEANS_LLOYD,     // Lloyd's algorithm.
+    KMEANS_HAMERLY,   // Hamerly's algorithm.
+    KMEANS_ELKAN,     // Elkan's algorithm.
+    KMEANS_MINIBATCH, // Mini-Batch K-Means.
+};
+
+// Statistics of K-Means algorithm.
+struct kmeans_stats {
+    unsigned long niterations; // Number of iterations.
+    unsigned long ndistances;  // Number of distance evaluations.
+};
+
+// Computes the squared euclidean distance between two vectors, and counts it.
+static double kmeans_distance2(struct kmeans_stats *stats, struct vector *v1, struct vector *v2)
 {
-    // Choose random points to be initial centroids.
-    for (unsigned i = 0; i < ncentroids; i++) {
-        struct vector *p = points[rand() % npoints];
+    stats->ndistances++;
+    return (vector_distance2(v1, v2));
+}
 
-        vector_assign(centroids[i], p);
+// Computes the euclidean distance between two vectors, and counts it.
+static double kmeans_distance(struct kmeans_stats *stats, struct vector *v1, struct vector *v2)
+{
+    return (sqrt(kmeans_distance2(stats, v1, v2)));
+}
+
+// Initializes K-Means algorithm using k-means++ approach: the first centroid
+// is a random point, and each next centroid is a random point that is chosen
+// with probability proportional to its squared distance to the nearest
+// centroid chosen so far.
+static void kmeans_init(struct vector *const *points, unsigned npoints, struct vector **centroids, unsigned ncentroids,
+                        struct kmeans_stats *stats)
+{
+    double total = 0.0;
+    double *distances = NULL;
+    assert((distances = malloc(npoints * sizeof(double))) != NULL);
+
+    // Choose a random point to be the first centroid.
+    vector_assign(centroids[0], points[rand() % npoints]);
+    for (unsigned i = 0; i < npoints; i++) {
+        distances[i] = kmeans_distance2(stats, points[i], centroids[0]);
+        total += distances[i];
     }
+
+    // Choose remaining centroids.
+    for (unsigned j = 1; j < ncentroids; j++) {
+        double target = (rand() / ((double)RAND_MAX + 1.0)) * total;
+        unsigned chosen = rand() % npoints;
+
+        // Pick a point, unless all points are centroids already.
+        if (total > 0.0) {
+            for (chosen = 0; chosen < npoints - 1; chosen++) {
+                if (target < distances[chosen]) {
+                    break;
+                }
+                target -= distances[chosen];
+            }
+        }
+        vector_assign(centroids[j], points[chosen]);
+
+        // Update distances to nearest centroids.
+        total = 0.0;
+        for (unsigned i = 0; i < npoints; i++) {
+            double distance = kmeans_distance2(stats, points[i], centroids[j]);
+            if (distance < distances[i]) {
+                distances[i] = distance;
+            }
+            total += distances[i];
+        }
+    }
+
+    free(distances);
 }
 
 // Assign points to nearest clusters.
 static bool kmeans_assign(unsigned *clusters, struct vector *const *points, unsigned npoints, struct vector **centroids,
-                          unsigned ncentroids)
+                          unsigned ncentroids, struct kmeans_stats *stats)
 {
     bool changed = false;
 
     // Process all points.
     for (unsigned i = 0; i < npoints; i++) {
         unsigned nearest = 0;
-        double distance = vector_distance2(points[i], centroids[nearest]);
+        double distance = kmeans_distance2(stats, points[i], centroids[nearest]);
 
         // Find nearest centroid.
         for (unsigned j = 1; j < ncentroids; j++) {
-            double new_distance = vector_distance2(points[i], centroids[j]);
+            double new_distance = kmeans_distance2(stats, points[i], centroids[j]);
 
-            // printf(" %lf < %lf ?\n", new_distance, distance);
             // Found.
             if (new_distance < distance) {
                 distance = new_distance;
@@ -202,27 +401,370 @@ static void kmeans_update(const unsigned *clusters, struct vector *const *points
     free(count);
 }
 
-// K-Means Clustering.
-static void kmeans(unsigned *clusters, struct vector *const *points, unsigned npoints, unsigned nclusters)
+// Updates centroids, and computes how far each centroid moves.
+static void kmeans_move(const unsigned *clusters, struct vector *const *points, unsigned npoints,
+                        struct vector **centroids, struct vector **old, double *movements, unsigned ncentroids,
+                        struct kmeans_stats *stats)
+{
+    for (unsigned j = 0; j < ncentroids; j++) {
+        vector_assign(old[j], centroids[j]);
+    }
+    kmeans_update(clusters, points, npoints, centroids, ncentroids);
+    for (unsigned j = 0; j < ncentroids; j++) {
+        movements[j] = kmeans_distance(stats, old[j], centroids[j]);
+    }
+}
+
+// Computes the distances between all pairs of centroids, and half the
+// distance from each centroid to its nearest centroid. If a point is closer
+// than that to its centroid, no other centroid is closer to the point.
+static void kmeans_separation(struct vector **centroids, unsigned ncentroids, double *pairs, double *halves,
+                              struct kmeans_stats *stats)
+{
+    for (unsigned j = 0; j < ncentroids; j++) {
+        halves[j] = INFINITY;
+    }
+    for (unsigned j = 0; j < ncentroids; j++) {
+        pairs[j * ncentroids + j] = 0.0;
+        for (unsigned l = j + 1; l < ncentroids; l++) {
+            double distance = kmeans_distance(stats, centroids[j], centroids[l]);
+            pairs[j * ncentroids + l] = distance;
+            pairs[l * ncentroids + j] = distance;
+            if (distance / 2 < halves[j]) {
+                halves[j] = distance / 2;
+            }
+            if (distance / 2 < halves[l]) {
+                halves[l] = distance / 2;
+            }
+        }
+    }
+}
+
+// Runs Lloyd's algorithm: all distances between points and centroids are
+// computed in every iteration.
+static void kmeans_lloyd(unsigned *clusters, struct vector *const *points, unsigned npoints,
+                         struct vector **centroids, unsigned ncentroids, struct kmeans_stats *stats)
 {
     bool changed = false;
+
+    do {
+        // Assign points to clusters.
+        changed = kmeans_assign(clusters, points, npoints, centroids, ncentroids, stats);
+
+        // Update centroids.
+        kmeans_update(clusters, points, npoints, centroids, ncentroids);
+
+        stats->niterations++;
+    } while (changed);
+}
+
+// Runs Hamerly's algorithm. It keeps, for each point, an upper bound on the
+// distance to its centroid and a lower bound on the distance to any other
+// centroid. When centroids move, bounds are loosened by the movements,
+// instead of recomputed. Distances are computed only for points whose
+// bounds overlap, and clusters are the same as in Lloyd's algorithm.
+static void kmeans_hamerly(unsigned *clusters, struct vector *const *points, unsigned npoints,
+                           struct vector **centroids, unsigned ncentroids, struct kmeans_stats *stats)
+{
+    bool changed = true;
+    double *upper = NULL;
+    double *lower = NULL;
+    double *movements = NULL;
+    double *pairs = NULL;
+    double *halves = NULL;
+    struct vector **old = NULL;
+
+    assert((upper = malloc(npoints * sizeof(double))) != NULL);
+    assert((lower = malloc(npoints * sizeof(double))) != NULL);
+    assert((movements = malloc(ncentroids * sizeof(double))) != NULL);
+    assert((pairs = malloc(ncentroids * ncentroids * sizeof(double))) != NULL);
+    assert((halves = malloc(ncentroids * sizeof(double))) != NULL);
+    assert((old = malloc(ncentroids * sizeof(struct vector *))) != NULL);
+    for (unsigned j = 0; j < ncentroids; j++) {
+        old[j] = vector_create(points[0]->dimension);
+    }
+
+    // Find nearest and second nearest centroids.
+    for (unsigned i = 0; i < npoints; i++) {
+        upper[i] = INFINITY;
+        lower[i] = INFINITY;
+        for (unsigned j = 0; j < ncentroids; j++) {
+            double distance = kmeans_distance(stats, points[i], centroids[j]);
+            if (distance < upper[i]) {
+                lower[i] = upper[i];
+                upper[i] = distance;
+                clusters[i] = j;
+            } else if (distance < lower[i]) {
+                lower[i] = distance;
+            }
+        }
+    }
+    kmeans_move(clusters, points, npoints, centroids, old, movements, ncentroids, stats);
+    stats->niterations++;
+
+    while (changed) {
+        unsigned farthest = 0;
+        double second = 0.0;
+
+        changed = false;
+        kmeans_separation(centroids, ncentroids, pairs, halves, stats);
+
+        // Find the two largest movements.
+        for (unsigned j = 1; j < ncentroids; j++) {
+            if (movements[j] > movements[farthest]) {
+                second = movements[farthest];
+                farthest = j;
+            } else if (movements[j] > second) {
+                second = movements[j];
+            }
+        }
+
+        for (unsigned i = 0; i < npoints; i++) {
+            unsigned a = clusters[i];
+            double bound = 0.0;
+
+            // Loosen bounds.
+            upper[i] += movements[a];
+            lower[i] -= (a == farthest) ? second : movements[farthest];
+
+            // Skip points that stay in their clusters.
+            bound = (halves[a] > lower[i]) ? halves[a] : lower[i];
+            if (upper[i] <= bound) {
+                continue;
+            }
+            upper[i] = kmeans_distance(stats, points[i], centroids[a]);
+            if (upper[i] <= bound) {
+                continue;
+            }
+
+            // Find nearest and second nearest centroids.
+            upper[i] = INFINITY;
+            lower[i] = INFINITY;
+            for (unsigned j = 0; j < ncentroids; j++) {
+                double distance = kmeans_distance(stats, points[i], centroids[j]);
+                if (distance < upper[i]) {
+                    lower[i] = upper[i];
+                    upper[i] = distance;
+                    clusters[i] = j;
+                } else if (distance < lower[i]) {
+                    lower[i] = distance;
+                }
+            }
+            if (clusters[i] != a) {
+                changed = true;
+            }
+        }
+
+        kmeans_move(clusters, points, npoints, centroids, old, movements, ncentroids, stats);
+        stats->niterations++;
+    }
+
+    // Release resources.
+    for (unsigned j = 0; j < ncentroids; j++) {
+        vector_destroy(old[j]);
+    }
+    free(old);
+    free(halves);
+    free(pairs);
+    free(movements);
+    free(lower);
+    free(upper);
+}
+
+// Runs Elkan's algorithm. It keeps, for each point, an upper bound on the
+// distance to its centroid and a lower bound on the distance to each
+// centroid. A centroid is skipped if its lower bound, or half of its
+// distance to the centroid of the point, exceeds the upper bound. It skips
+// more distances than Hamerly's algorithm, but needs more memory.
+static void kmeans_elkan(unsigned *clusters, struct vector *const *points, unsigned npoints,
+                         struct vector **centroids, unsigned ncentroids, struct kmeans_stats *stats)
+{
+    bool changed = true;
+    double *upper = NULL;
+    double *lower = NULL;
+    double *movements = NULL;
+    double *pairs = NULL;
+    double *halves = NULL;
+    struct vector **old = NULL;
+
+    assert((upper = malloc(npoints * sizeof(double))) != NULL);
+    assert((lower = malloc((size_t)npoints * ncentroids * sizeof(double))) != NULL);
+    assert((movements = malloc(ncentroids * sizeof(double))) != NULL);
+    assert((pairs = malloc(ncentroids * ncentroids * sizeof(double))) != NULL);
+    assert((halves = malloc(ncentroids * sizeof(double))) != NULL);
+    assert((old = malloc(ncentroids * sizeof(struct vector *))) != NULL);
+    for (unsigned j = 0; j < ncentroids; j++) {
+        old[j] = vector_create(points[0]->dimension);
+    }
+
+    // Find nearest centroids.
+    for (unsigned i = 0; i < npoints; i++) {
+        double *bounds = &lower[(size_t)i * ncentroids];
+        upper[i] = INFINITY;
+        for (unsigned j = 0; j < ncentroids; j++) {
+            bounds[j] = kmeans_distance(stats, points[i], centroids[j]);
+            if (bounds[j] < upper[i]) {
+                upper[i] = bounds[j];
+                clusters[i] = j;
+            }
+        }
+    }
+    kmeans_move(clusters, points, npoints, centroids, old, movements, ncentroids, stats);
+    stats->niterations++;
+
+    while (changed) {
+        changed = false;
+        kmeans_separation(centroids, ncentroids, pairs, halves, stats);
+
+        for (unsigned i = 0; i < npoints; i++) {
+            double *bounds = &lower[(size_t)i * ncentroids];
+            unsigned a = clusters[i];
+            bool tight = false;
+
+            // Loosen bounds.
+            upper[i] += movements[a];
+            for (unsigned j = 0; j < ncentroids; j++) {
+                bounds[j] = (bounds[j] > movements[j]) ? bounds[j] - movements[j] : 0.0;
+            }
+
+            // Skip points that stay in their clusters.
+            if (upper[i] <= halves[a]) {
+                continue;
+            }
+
+            for (unsigned j = 0; j < ncentroids; j++) {
+                double distance = 0.0;
+
+                // Skip centroids that are farther than the current one.
+                if ((j == clusters[i]) || (upper[i] <= bounds[j]) ||
+                    (upper[i] <= pairs[clusters[i] * ncentroids + j] / 2)) {
+                    continue;
+                }
+
+                // Tighten the upper bound, once.
+                if (!tight) {
+                    upper[i] = kmeans_distance(stats, points[i], centroids[clusters[i]]);
+                    bounds[clusters[i]] = upper[i];
+                    tight = true;
+                    if ((upper[i] <= bounds[j]) || (upper[i] <= pairs[clusters[i] * ncentroids + j] / 2)) {
+                        continue;
+                    }
+                }
+
+                distance = kmeans_distance(stats, points[i], centroids[j]);
+                bounds[j] = distance;
+                if (distance < upper[i]) {
+                    upper[i] = distance;
+                    clusters[i] = j;
+                }
+            }
+            if (clusters[i] != a) {
+                changed = true;
+            }
+        }
+
+        kmeans_move(clusters, points, npoints, centroids, old, movements, ncentroids, stats);
+        stats->niterations++;
+    }
+
+    // Release resources.
+    for (unsigned j = 0; j < ncentroids; j++) {
+        vector_destroy(old[j]);
+    }
+    free(old);
+    free(halves);
+    free(pairs);
+    free(movements);
+    free(lower);
+    free(upper);
+}
+
+// Runs Mini-Batch K-Means. Each iteration samples a batch of points, and
+// moves the nearest centroid of each sampled point towards it, by a step
+// that shrinks as the centroid absorbs more points. Each iteration touches
+// a batch only, thus it suits huge datasets, but clusters are approximate.
+static void kmeans_minibatch(unsigned *clusters, struct vector *const *points, unsigned npoints,
+                             struct vector **centroids, unsigned ncentroids, struct kmeans_stats *stats)
+{
+    unsigned batch_size = (npoints < KMEANS_BATCH_SIZE) ? npoints : KMEANS_BATCH_SIZE;
+    unsigned *batch = NULL;
+    unsigned *nearest = NULL;
+    unsigned long *counts = NULL;
+
+    assert((batch = malloc(batch_size * sizeof(unsigned))) != NULL);
+    assert((nearest = malloc(batch_size * sizeof(unsigned))) != NULL);
+    assert((counts = calloc(ncentroids, sizeof(unsigned long))) != NULL);
+
+    for (unsigned it = 0; it < KMEANS_MINIBATCH_ITERATIONS; it++) {
+        // Sample a batch, and find nearest centroids with centroids fixed.
+        for (unsigned b = 0; b < batch_size; b++) {
+            double distance = INFINITY;
+            batch[b] = rand() % npoints;
+            for (unsigned j = 0; j < ncentroids; j++) {
+                double new_distance = kmeans_distance2(stats, points[batch[b]], centroids[j]);
+                if (new_distance < distance) {
+                    distance = new_distance;
+                    nearest[b] = j;
+                }
+            }
+        }
+
+        // Move centroids, with per-centroid learning rates.
+        for (unsigned b = 0; b < batch_size; b++) {
+            counts[nearest[b]]++;
+            vector_blend(centroids[nearest[b]], points[batch[b]], 1.0 / counts[nearest[b]]);
+        }
+
+        stats->niterations++;
+    }
+
+    // Assign points to clusters.
+    kmeans_assign(clusters, points, npoints, centroids, ncentroids, stats);
+
+    free(counts);
+    free(nearest);
+    free(batch);
+}
+
+// K-Means Clustering.
+static void kmeans(unsigned *clusters, struct vector *const *points, unsigned npoints, unsigned nclusters,
+                   enum kmeans_kind kind, struct kmeans_stats *stats)
+{
     struct vector *centroids[nclusters];
 
+    stats->niterations = 0;
+    stats->ndistances = 0;
+
     // Allocate centroids.
     for (unsigned i = 0; i < nclusters; i++) {
         centroids[i] = vector_create(points[0]->dimension);
     }
 
-    // Assign initial centroids.
-    kmeans_init(points, npoints, centroids, nclusters);
+    // No point is assigned to a cluster yet.
+    for (unsigned i = 0; i < npoints; i++) {
+        clusters[i] = nclusters;
+    }
 
-    do {
-        // Assign points to clusters.
-        changed = kmeans_assign(clusters, points, npoints, centroids, nclusters);
+    // Assign initial centroids.
+    kmeans_init(points, npoints, centroids, nclusters, stats);
 
-        // Update centroids.
-        kmeans_update(clusters, points, npoints, centroids, nclusters);
-    } while (changed);
+    switch (kind) {
+        case KMEANS_LLOYD:
+            kmeans_lloyd(clusters, points, npoints, centroids, nclusters, stats);
+            break;
+        case KMEANS_HAMERLY:
+            kmeans_hamerly(clusters, points, npoints, centroids, nclusters, stats);
+            break;
+        case KMEANS_ELKAN:
+            kmeans_elkan(clusters, points, npoints, centroids, nclusters, stats);
+            break;
+        case KMEANS_MINIBATCH:
+            kmeans_minibatch(clusters, points, npoints, centroids, nclusters, stats);
+            break;
+        default:
+            assert(false);
+            break;
+    }
 
     // Release resources.
     for (unsigned i = 0; i < nclusters; i++) {
@@ -230,18 +772,355 @@ static void kmeans(unsigned *clusters, struct vector *const *points, unsigned np
     }
 }
 
+//==============================================================================
+// Parallel K-Means Clustering
+//==============================================================================
+
+// Initializes K-Means algorithm on rows of a matrix, using k-means++
+// approach. Random numbers are drawn as in kmeans_init(), so both pick the
+// same initial centroids.
+static void kmeans_init_rows(const struct matrix *points, struct matrix *centroids, struct kmeans_stats *stats)
+{
+    double total = 0.0;
+    double *distances = NULL;
+    assert((distances = malloc(points->nrows * sizeof(double))) != NULL);
+
+    // Choose a random point to be the first centroid.
+    memcpy(matrix_row(centroids, 0), matrix_row(points, rand() % points->nrows), points->ncols * sizeof(double));
+    for (size_t i = 0; i < points->nrows; i++) {
+        distances[i] = row_distance2(matrix_row(points, i), matrix_row(centroids, 0), points->ncols);
+        total += distances[i];
+    }
+    stats->ndistances += points->nrows;
+
+    // Choose remaining centroids.
+    for (size_t j = 1; j < centroids->nrows; j++) {
+        double target = (rand() / ((double)RAND_MAX + 1.0)) * total;
+        size_t chosen = rand() % points->nrows;
+
+        // Pick a point, unless all points are centroids already.
+        if (total > 0.0) {
+            for (chosen = 0; chosen < points->nrows - 1; chosen++) {
+                if (target < distances[chosen]) {
+                    break;
+                }
+                target -= distances[chosen];
+            }
+        }
+        memcpy(matrix_row(centroids, j), matrix_row(points, chosen), points->ncols * sizeof(double));
+
+        // Update distances to nearest centroids.
+        total = 0.0;
+        for (size_t i = 0; i < points->nrows; i++) {
+            double distance = row_distance2(matrix_row(points, i), matrix_row(centroids, j), points->ncols);
+            if (distance < distances[i]) {
+                distances[i] = distance;
+            }
+            total += distances[i];
+        }
+        stats->ndistances += points->nrows;
+    }
+
+    free(distances);
+}
+
+// Computes the dot products between a block of points and a block of
+// centroids, that is, a block of the product of the point matrix and the
+// transposed centroid matrix. Blocks that are smaller than the kernel repeat
+// their last row, and extra results are ignored.
+static void kmeans_kernel(const struct matrix *points, size_t i, size_t npoints, const struct matrix *centroids,
+                          size_t j, size_t ncentroids, double dots[KMEANS_BLOCK_POINTS][KMEANS_BLOCK_CENTROIDS])
+{
+    const double *x[KMEANS_BLOCK_POINTS];
+    const double *c[KMEANS_BLOCK_CENTROIDS];
+    vdouble_t sums[KMEANS_BLOCK_POINTS][KMEANS_BLOCK_CENTROIDS];
+
+    for (size_t p = 0; p < KMEANS_BLOCK_POINTS; p++) {
+        x[p] = matrix_row(points, i + ((p < npoints) ? p : npoints - 1));
+        for (size_t q = 0; q < KMEANS_BLOCK_CENTROIDS; q++) {
+            sums[p][q] = (vdouble_t){0};
+        }
+    }
+    for (size_t q = 0; q < KMEANS_BLOCK_CENTROIDS; q++) {
+        c[q] = matrix_row(centroids, j + ((q < ncentroids) ? q : ncentroids - 1));
+    }
+
+    for (unsigned l = 0; l < points->stride; l += KMEANS_LANES) {
+        vdouble_t vc[KMEANS_BLOCK_CENTROIDS];
+        for (size_t q = 0; q < KMEANS_BLOCK_CENTROIDS; q++) {
+            vc[q] = *(const vdouble_t *)&c[q][l];
+        }
+        for (size_t p = 0; p < KMEANS_BLOCK_POINTS; p++) {
+            const vdouble_t vx = *(const vdouble_t *)&x[p][l];
+            for (size_t q = 0; q < KMEANS_BLOCK_CENTROIDS; q++) {
+                sums[p][q] += vx * vc[q];
+            }
+        }
+    }
+
+    for (size_t p = 0; p < KMEANS_BLOCK_POINTS; p++) {
+        for (size_t q = 0; q < KMEANS_BLOCK_CENTROIDS; q++) {
+            dots[p][q] = 0.0;
+            for (unsigned l = 0; l < KMEANS_LANES; l++) {
+                dots[p][q] += sums[p][q][l];
+            }
+        }
+    }
+}
+
+// Assigns a tile of points to nearest clusters. Since
+// ||x - c||^2 = ||x||^2 + ||c||^2 - 2 x.c, and ||x||^2 is the same for all
+// centroids, the nearest centroid minimizes ||c||^2 - 2 x.c, and dot
+// products are computed as a blocked matrix product. Returns the number of
+// points that changed clusters.
+static size_t kmeans_assign_tile(unsigned *clusters, const struct matrix *points, size_t begin, size_t end,
+                                 const struct matrix *centroids, const double *norms)
+{
+    double best[KMEANS_TILE];
+    unsigned nearest[KMEANS_TILE];
+    double dots[KMEANS_BLOCK_POINTS][KMEANS_BLOCK_CENTROIDS];
+    size_t nchanged = 0;
+
+    for (size_t i = begin; i < end; i++) {
+        best[i - begin] = INFINITY;
+        nearest[i - begin] = 0;
+    }
+
+    for (size_t panel = 0; panel < centroids->nrows; panel += KMEANS_PANEL) {
+        const size_t last = (panel + KMEANS_PANEL < centroids->nrows) ? panel + KMEANS_PANEL : centroids->nrows;
+        for (size_t i = begin; i < end; i += KMEANS_BLOCK_POINTS) {
+            const size_t np = (end - i < KMEANS_BLOCK_POINTS) ? end - i : KMEANS_BLOCK_POINTS;
+            for (size_t j = panel; j < last; j += KMEANS_BLOCK_CENTROIDS) {
+                const size_t nc = (last - j < KMEANS_BLOCK_CENTROIDS) ? last - j : KMEANS_BLOCK_CENTROIDS;
+                kmeans_kernel(points, i, np, centroids, j, nc, dots);
+                for (size_t p = 0; p < np; p++) {
+                    for (size_t q = 0; q < nc; q++) {
+                        double distance = norms[j + q] - 2 * dots[p][q];
+                        if (distance < best[i - begin + p]) {
+                            best[i - begin + p] = distance;
+                            nearest[i - begin + p] = (unsigned)(j + q);
+                        }
+                    }
+                }
+            }
+        }
+    }
+
+    for (size_t i = begin; i < end; i++) {
+        if (clusters[i] != nearest[i - begin]) {
+            clusters[i] = nearest[i - begin];
+            nchanged++;
+        }
+    }
+
+    return (nchanged);
+}
+
+// A thread of parallel K-Means.
+struct kmeans_worker {
+    pthread_t thread;                // Thread.
+    struct kmeans_parallel *km;      // Parallel K-Means.
+    size_t begin;                    // First point.
+    size_t end;                      // Last point (exclusive).
+    size_t first;                    // First centroid that this thread reduces.
+    size_t last;                     // Last centroid that this thread reduces (exclusive).
+    struct matrix *sums;             // Sums of points in each cluster.
+    size_t *counts;                  // Number of points in each cluster.
+    size_t nchanged;                 // Number of points that changed clusters.
+};
+
+// State of parallel K-Means.
+struct kmeans_parallel {
+    const struct matrix *points;                      // Points.
+    struct matrix *centroids;                         // Centroids.
+    double *norms;                                    // Squared norms of centroids.
+    unsigned *clusters;                               // Clusters of points.
+    size_t nthreads;                                  // Number of threads.
+    unsigned long niterations;                        // Number of iterations.
+    pthread_barrier_t barrier;                        // Synchronizes threads between steps.
+    struct kmeans_worker workers[KMEANS_MAX_THREADS]; // Threads.
+};
+
+// Runs a thread of parallel K-Means. In the assignment step, each thread
+// assigns its range of points tile by tile, and adds each tile to private
+// sums, while the tile is in the cache. In the update step, each thread
+// reduces the sums of all threads for its range of centroids. Threads stop
+// when no point changes clusters.
+static void *kmeans_worker(void *arg)
+{
+    struct kmeans_worker *w = arg;
+    struct kmeans_parallel *km = w->km;
+    const struct matrix *points = km->points;
+    struct matrix *centroids = km->centroids;
+    size_t nchanged = 0;
+
+    do {
+        // Assignment step.
+        memset(w->sums->elements, 0, centroids->nrows * centroids->stride * sizeof(double));
+        memset(w->counts, 0, centroids->nrows * sizeof(size_t));
+        w->nchanged = 0;
+        for (size_t begin = w->begin; begin < w->end; begin += KMEANS_TILE) {
+            const size_t end = (begin + KMEANS_TILE < w->end) ? begin + KMEANS_TILE : w->end;
+            w->nchanged += kmeans_assign_tile(km->clusters, points, begin, end, centroids, km->norms);
+            for (size_t i = begin; i < end; i++) {
+                vdouble_t *sum = (vdouble_t *)matrix_row(w->sums, km->clusters[i]);
+                const vdouble_t *x = (const vdouble_t *)matrix_row(points, i);
+                for (unsigned l = 0; l < points->stride / KMEANS_LANES; l++) {
+                    sum[l] += x[l];
+                }
+                w->counts[km->clusters[i]]++;
+            }
+        }
+        pthread_barrier_wait(&km->barrier);
+
+        // Update step. Centroids of empty clusters do not move.
+        nchanged = 0;
+        for (size_t t = 0; t < km->nthreads; t++) {
+            nchanged += km->workers[t].nchanged;
+        }
+        for (size_t j = w->first; j < w->last; j++) {
+            size_t count = 0;
+            for (size_t t = 0; t < km->nthreads; t++) {
+                count += km->workers[t].counts[j];
+            }
+            if (count > 0) {
+                vdouble_t *c = (vdouble_t *)matrix_row(centroids, j);
+                for (unsigned l = 0; l < centroids->stride / KMEANS_LANES; l++) {
+                    c[l] = (vdouble_t){0};
+                    for (size_t t = 0; t < km->nthreads; t++) {
+                        c[l] += ((const vdouble_t *)matrix_row(km->workers[t].sums, j))[l];
+                    }
+                    c[l] /= (double)count;
+                }
+                km->norms[j] = row_norm2(matrix_row(centroids, j), centroids->stride);
+            }
+        }
+        if (w == &km->workers[0]) {
+            km->niterations++;
+        }
+        pthread_barrier_wait(&km->barrier);
+    } while (nchanged > 0);
+
+    return (NULL);
+}
+
+// K-Means Clustering of points that are stored contiguously, using
+// Lloyd's algorithm with multiple threads. The assignment step is computed
+// as a blocked matrix product with SIMD instructions.
+static void kmeans_parallel(unsigned *clusters, const struct matrix *points, unsigned nclusters, size_t nthreads,
+                            struct kmeans_stats *stats)
+{
+    struct kmeans_parallel *km = NULL;
+    int ret = 0;
+
+    // Sanity check arguments.
+    assert((nthreads >= 1) && (nthreads <= KMEANS_MAX_THREADS));
+
+    stats->niterations = 0;
+    stats->ndistances = 0;
+
+    assert((km = malloc(sizeof(struct kmeans_parallel))) != NULL);
+    km->points = points;
+    km->centroids = matrix_create(nclusters, points->ncols);
+    assert((km->norms = malloc(nclusters * sizeof(double))) != NULL);
+    km->clusters = clusters;
+    km->nthreads = nthreads;
+    km->niterations = 0;
+
+    // No point is assigned to a cluster yet.
+    for (size_t i = 0; i < points->nrows; i++) {
+        clusters[i] = nclusters;
+    }
+
+    // Assign initial centroids.
+    kmeans_init_rows(points, km->centroids, stats);
+    for (unsigned j = 0; j < nclusters; j++) {
+        km->norms[j] = row_norm2(matrix_row(km->centroids, j), km->centroids->stride);
+    }
+
+    ret = pthread_barrier_init(&km->barrier, NULL, nthreads);
+    assert(ret == 0);
+    for (size_t t = 0; t < nthreads; t++) {
+        struct kmeans_worker *w = &km->workers[t];
+        w->km = km;
+        w->begin = points->nrows * t / nthreads;
+        w->end = points->nrows * (t + 1) / nthreads;
+        w->first = nclusters * t / nthreads;
+        w->last = nclusters * (t + 1) / nthreads;
+        w->sums = matrix_create(nclusters, points->ncols);
+        assert((w->counts = malloc(nclusters * sizeof(size_t))) != NULL);
+        w->nchanged = 0;
+    }
+    for (size_t t = 0; t < nthreads; t++) {
+        ret = pthread_create(&km->workers[t].thread, NULL, kmeans_worker, &km->workers[t]);
+        assert(ret == 0);
+    }
+    ((void)ret);
+    for (size_t t = 0; t < nthreads; t++) {
+        pthread_join(km->workers[t].thread, NULL);
+    }
+
+    stats->niterations = km->niterations;
+    stats->ndistances += km->niterations * points->nrows * nclusters;
+
+    // Release resources.
+    pthread_barrier_destroy(&km->barrier);
+    for (size_t t = 0; t < nthreads; t++) {
+        free(km->workers[t].counts);
+        matrix_destroy(km->workers[t].sums);
+    }
+    free(km->norms);
+    matrix_destroy(km->centroids);
+    free(km);
+}
+
 //==============================================================================
 // Test
 //==============================================================================
 
+// Returns the current time in microseconds.
+static double now(void)
+{
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+
+    return (ts.tv_sec * 1000000.0 + ts.tv_nsec / 1000.0);
+}
+
+// Computes the sum of squared distances from points to the means of their clusters.
+static double test_inertia(const unsigned *clusters, struct vector *const *points, unsigned npoints,
+                           unsigned nclusters)
+{
+    double inertia = 0.0;
+    struct vector *centroids[nclusters];
+
+    for (unsigned i = 0; i < nclusters; i++) {
+        centroids[i] = vector_create(points[0]->dimension);
+    }
+    kmeans_update(clusters, points, npoints, centroids, nclusters);
+    for (unsigned i = 0; i < npoints; i++) {
+        inertia += vector_distance2(points[i], centroids[clusters[i]]);
+    }
+    for (unsigned i = 0; i < nclusters; i++) {
+        vector_destroy(centroids[i]);
+    }
+
+    return (inertia);
+}
+
 // Tests K-Means Clustering
 static void test(unsigned npoints, unsigned nclusters, unsigned dimension, bool verbose)
 {
+    const char *names[] = {"Lloyd", "Hamerly", "Elkan", "Mini-Batch"};
+    const enum kmeans_kind kinds[] = {KMEANS_LLOYD, KMEANS_HAMERLY, KMEANS_ELKAN, KMEANS_MINIBATCH};
     double tstart = 0.0;
     double tend = 0.0;
-    const double MICROSECS = ((CLOCKS_PER_SEC / 1000000.0));
     struct vector **points = NULL;
     unsigned *clusters = NULL;
+    unsigned *expected = NULL;
+    struct matrix *matrix = NULL;
+    double inertia = 0.0;
 
     // Fix random number generator seed
     // to have a determinist behavior across runs.
@@ -256,6 +1135,7 @@ static void test(unsigned npoints, unsigned nclusters, unsigned dimension, bool
 
     // Allocate clusters
     assert((clusters = malloc(npoints * sizeof(unsigned))) != NULL);
+    assert((expected = malloc(npoints * sizeof(unsigned))) != NULL);
 
     if (verbose) {
         for (unsigned i = 0; i < npoints; i++) {
@@ -263,17 +1143,61 @@ static void test(unsigned npoints, unsigned nclusters, unsigned dimension, bool
         }
     }
 
-    // Cluster data.
-    tstart = clock();
-    kmeans(clusters, points, npoints, nclusters);
-    tend = clock();
+    for (unsigned k = 0; k < sizeof(kinds) / sizeof(kinds[0]); k++) {
+        struct kmeans_stats stats;
 
-    // Report time.
-    printf("K-Means Clustering: %2.lf us\n", (tend - tstart) / MICROSECS);
+        // Cluster data, from the same initial centroids.
+        srand(1);
+        tstart = now();
+        kmeans(clusters, points, npoints, nclusters, kinds[k], &stats);
+        tend = now();
+
+        // Report time.
+        printf("K-Means Clustering (%s): %2.lf us, %lu iterations, %lu distances, inertia %.2lf\n", names[k],
+               tend - tstart, stats.niterations, stats.ndistances,
+               test_inertia(clusters, points, npoints, nclusters));
+
+        // Bounds skip distances, but not clusters.
+        switch (kinds[k]) {
+            case KMEANS_LLOYD:
+                memcpy(expected, clusters, npoints * sizeof(unsigned));
+                inertia = test_inertia(clusters, points, npoints, nclusters);
+                break;
+            case KMEANS_HAMERLY:
+            case KMEANS_ELKAN:
+                assert(!memcmp(clusters, expected, npoints * sizeof(unsigned)));
+                break;
+            case KMEANS_MINIBATCH:
+                assert(test_inertia(clusters, points, npoints, nclusters) <= KMEANS_MINIBATCH_SLACK * inertia);
+                break;
+            default:
+                assert(false);
+                break;
+        }
+    }
+
+    // Contiguous points, with multiple threads.
+    matrix = matrix_from_vectors(points, npoints);
+    for (size_t nthreads = 1; nthreads <= KMEANS_MAX_THREADS; nthreads *= KMEANS_MAX_THREADS) {
+        struct kmeans_stats stats;
+
+        srand(1);
+        tstart = now();
+        kmeans_parallel(clusters, matrix, nclusters, nthreads, &stats);
+        tend = now();
+
+        printf("K-Means Clustering (Parallel, %zu threads): %2.lf us, %lu iterations, %lu distances, inertia %.2lf\n",
+               nthreads, tend - tstart, stats.niterations, stats.ndistances,
+               test_inertia(clusters, points, npoints, nclusters));
+
+        // Distances are rounded differently, but clusters are about the same.
+        assert(fabs(test_inertia(clusters, points, npoints, nclusters) - inertia) <= KMEANS_PARALLEL_SLACK * inertia);
+    }
+    matrix_destroy(matrix);
 
     if (verbose) {
         for (unsigned i = 0; i < npoints; i++) {
-            printf("Point %u -> Cluster %u\n", i, clusters[i]);
+            printf("Point %u -> Cluster %u\n", i, expected[i]);
         }
     }
 
@@ -282,6 +1206,7 @@ static void test(unsigned npoints, unsigned nclusters, unsigned dimension, bool
         vector_destroy(points[i]);
     }
     free(points);
+    free(expected);
     free(clusters);
 }
 
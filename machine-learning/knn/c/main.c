@@ -1,6 +1,11 @@
 // Copyright (C) 2022 Pedro Henrique Penna <pedrohenriquepenna@outlook.com>
 
+#define _POSIX_C_SOURCE 200809L
+
 #include <assert.h>
+#include <math.h>
+#include <pthread.h>
+#include <stdatomic.h>
 #include <stdbool.h>
 #include <stddef.h>
 #include <stdio.h>
@@ -8,6 +13,28 @@
 #include <string.h>
 #include <time.h>
 
+// Number of queries in a tile of batched queries.
+#define KNN_QUERY_TILE 16
+
+// Number of points in a tile of batched queries. A tile of points stays in
+// the cache while it is compared against a tile of queries.
+#define KNN_POINT_TILE 256
+
+// Max number of threads.
+#define KNN_MAX_THREADS 8
+
+// Number of queries in the benchmark of batched queries.
+#define KNN_NQUERIES 64
+
+// Data sets with at most this number of points are also searched with a full sort.
+#define KNN_SORT_MAX_POINTS 4096
+
+// Max number of points in a leaf of a spatial tree.
+#define TREE_LEAF_SIZE 16
+
+// Number of queries that a thread grabs at once in batched tree queries.
+#define TREE_QUERY_CHUNK 16
+
 //==============================================================================
 // Vector
 //==============================================================================
@@ -92,6 +119,19 @@ static void vector_print(const struct vector *v)
 // K-Nearest Neighbors
 //==============================================================================
 
+// Kinds of K-Nearest Neighbors algorithms.
+enum knn_kind {
+    KNN_SORT,   // Sort all distances.
+    KNN_SELECT, // Select the k-th distance, and sort the k nearest only.
+    KNN_HEAP,   // Keep the k nearest in a bounded heap.
+};
+
+// A neighbor of a query.
+struct neighbor {
+    double distance; // Squared distance to the query.
+    unsigned index;  // Index of the point.
+};
+
 // Sorts distances in ascending order.
 static void sort_distances(double *distances,
                            unsigned *indexes,
@@ -114,29 +154,713 @@ static void sort_distances(double *distances,
     }
 }
 
-// K-Nearest Neighbors.
+// Compares two neighbors. Ties in distance are broken by index.
+static bool neighbor_less(const struct neighbor *n1, const struct neighbor *n2)
+{
+    return ((n1->distance < n2->distance) || (!(n1->distance > n2->distance) && (n1->index < n2->index)));
+}
+
+// Swaps two neighbors.
+static void neighbor_swap(struct neighbor *n1, struct neighbor *n2)
+{
+    struct neighbor tmp = *n1;
+    *n1 = *n2;
+    *n2 = tmp;
+}
+
+// Fixes the heap property after an insertion on a max-heap of neighbors.
+static void heap_sift_up(struct neighbor *heap, size_t i)
+{
+    while ((i > 0) && neighbor_less(&heap[(i - 1) / 2], &heap[i])) {
+        neighbor_swap(&heap[(i - 1) / 2], &heap[i]);
+        i = (i - 1) / 2;
+    }
+}
+
+// Fixes the heap property after a replacement of the root of a max-heap of neighbors.
+static void heap_sift_down(struct neighbor *heap, size_t n, size_t i)
+{
+    for (;;) {
+        size_t largest = i;
+        const size_t left = 2 * i + 1;
+        const size_t right = 2 * i + 2;
+
+        if ((left < n) && neighbor_less(&heap[largest], &heap[left])) {
+            largest = left;
+        }
+        if ((right < n) && neighbor_less(&heap[largest], &heap[right])) {
+            largest = right;
+        }
+        if (largest == i) {
+            break;
+        }
+        neighbor_swap(&heap[i], &heap[largest]);
+        i = largest;
+    }
+}
+
+// Offers a neighbor to a max-heap that keeps the k nearest neighbors seen so far.
+static void heap_offer(struct neighbor *heap, size_t *n, size_t k, struct neighbor neighbor)
+{
+    if (*n < k) {
+        heap[*n] = neighbor;
+        heap_sift_up(heap, (*n)++);
+    } else if (neighbor_less(&neighbor, &heap[0])) {
+        heap[0] = neighbor;
+        heap_sift_down(heap, k, 0);
+    }
+}
+
+// Sorts neighbors in ascending order with a heapsort. Neighbors must form a max-heap.
+static void heap_sort(struct neighbor *heap, size_t n)
+{
+    for (size_t end = n; end > 1; end--) {
+        neighbor_swap(&heap[0], &heap[end - 1]);
+        heap_sift_down(heap, end - 1, 0);
+    }
+}
+
+// Moves the k-th smallest neighbor of a range to its sorted position with
+// a bounded heap: the smallest neighbors are kept in a max-heap at the start
+// of the range, and the root of that heap is the k-th smallest.
+static void heap_select(struct neighbor *neighbors, size_t left, size_t right, size_t kth)
+{
+    struct neighbor *heap = &neighbors[left];
+    const size_t k = kth - left + 1;
+
+    for (size_t i = 1; i < k; i++) {
+        heap_sift_up(heap, i);
+    }
+    for (size_t i = kth + 1; i <= right; i++) {
+        if (neighbor_less(&neighbors[i], &heap[0])) {
+            neighbor_swap(&neighbors[i], &heap[0]);
+            heap_sift_down(heap, k, 0);
+        }
+    }
+    neighbor_swap(&heap[0], &heap[k - 1]);
+}
+
+// Partitions a range of neighbors around the median of its first, middle
+// and last neighbors. Returns the position of the pivot.
+static size_t select_partition(struct neighbor *neighbors, size_t left, size_t right)
+{
+    const size_t middle = left + (right - left) / 2;
+    size_t store = left;
+
+    // Move the median of three to the end.
+    if (neighbor_less(&neighbors[middle], &neighbors[left])) {
+        neighbor_swap(&neighbors[middle], &neighbors[left]);
+    }
+    if (neighbor_less(&neighbors[right], &neighbors[left])) {
+        neighbor_swap(&neighbors[right], &neighbors[left]);
+    }
+    if (neighbor_less(&neighbors[middle], &neighbors[right])) {
+        neighbor_swap(&neighbors[middle], &neighbors[right]);
+    }
+
+    for (size_t i = left; i < right; i++) {
+        if (neighbor_less(&neighbors[i], &neighbors[right])) {
+            neighbor_swap(&neighbors[i], &neighbors[store++]);
+        }
+    }
+    neighbor_swap(&neighbors[store], &neighbors[right]);
+
+    return (store);
+}
+
+// Moves the k-th smallest neighbor to its sorted position, with smaller
+// neighbors before it and larger ones after it, using introselect: a
+// quickselect that falls back to heap_select() when partitions are too
+// unbalanced, so it runs in linear time on average and O(n log k) time in
+// the worst case.
+static void introselect(struct neighbor *neighbors, size_t n, size_t kth)
+{
+    size_t left = 0;
+    size_t right = n - 1;
+    size_t depth = 0;
+
+    // Allow about twice the expected number of partitions.
+    for (size_t m = n; m > 1; m /= 2) {
+        depth += 2;
+    }
+
+    while (left < right) {
+        size_t pivot = 0;
+
+        if (depth-- == 0) {
+            heap_select(neighbors, left, right, kth);
+            return;
+        }
+
+        pivot = select_partition(neighbors, left, right);
+        if (pivot == kth) {
+            return;
+        } else if (kth < pivot) {
+            right = pivot - 1;
+        } else {
+            left = pivot + 1;
+        }
+    }
+}
+
+// K-Nearest Neighbors. Nearest neighbors are reported in ascending order of distance.
 static void knn(struct vector **nearest,
                 struct vector *const *points,
                 unsigned npoints,
                 unsigned k,
-                const struct vector *query)
+                const struct vector *query,
+                enum knn_kind kind)
+{
+    // Sanity check arguments.
+    assert((k >= 1) && (k <= npoints));
+
+    switch (kind) {
+        case KNN_SORT: {
+            double *distances = NULL;
+            unsigned *indexes = NULL;
+            assert((distances = malloc(npoints * sizeof(double))) != NULL);
+            assert((indexes = malloc(npoints * sizeof(unsigned))) != NULL);
+
+            // Compute distances.
+            for (unsigned i = 0; i < npoints; i++) {
+                indexes[i] = i;
+                distances[i] = vector_distance2(points[i], query);
+            }
+
+            // Sort distances.
+            sort_distances(distances, indexes, npoints);
+
+            /// Find K-nearest neighbors.
+            for (unsigned i = 0; i < k; i++) {
+                nearest[i] = points[indexes[i]];
+            }
+
+            free(indexes);
+            free(distances);
+        } break;
+
+        case KNN_SELECT: {
+            struct neighbor *neighbors = NULL;
+            assert((neighbors = malloc(npoints * sizeof(struct neighbor))) != NULL);
+
+            // Compute distances.
+            for (unsigned i = 0; i < npoints; i++) {
+                neighbors[i] = (struct neighbor){vector_distance2(points[i], query), i};
+            }
+
+            // Select K-nearest neighbors, and sort them only.
+            introselect(neighbors, npoints, k - 1);
+            for (size_t i = 1; i < k; i++) {
+                heap_sift_up(neighbors, i);
+            }
+            heap_sort(neighbors, k);
+            for (unsigned i = 0; i < k; i++) {
+                nearest[i] = points[neighbors[i].index];
+            }
+
+            free(neighbors);
+        } break;
+
+        case KNN_HEAP: {
+            struct neighbor *heap = NULL;
+            size_t n = 0;
+            assert((heap = malloc(k * sizeof(struct neighbor))) != NULL);
+
+            // Keep K-nearest neighbors seen so far.
+            for (unsigned i = 0; i < npoints; i++) {
+                heap_offer(heap, &n, k, (struct neighbor){vector_distance2(points[i], query), i});
+            }
+            heap_sort(heap, n);
+            for (unsigned i = 0; i < k; i++) {
+                nearest[i] = points[heap[i].index];
+            }
+
+            free(heap);
+        } break;
+
+        default:
+            assert(false);
+            break;
+    }
+}
+
+// A thread of batched K-Nearest Neighbors.
+struct knn_worker {
+    pthread_t thread;                // Thread.
+    struct vector *const *points;    // Points.
+    unsigned npoints;                // Number of points.
+    unsigned k;                      // Number of neighbors.
+    struct vector *const *queries;   // Queries.
+    unsigned nqueries;               // Number of queries.
+    struct neighbor *results;        // Neighbors of each query.
+    atomic_uint *next;               // Next query to grab.
+};
+
+// Runs a thread of batched K-Nearest Neighbors. Threads grab tiles of
+// queries until none is left. Each tile of points is compared against all
+// queries of a tile while it is in the cache, and each query keeps its
+// nearest neighbors in a bounded heap.
+static void *knn_worker(void *arg)
+{
+    const struct knn_worker *w = arg;
+    unsigned first = 0;
+
+    while ((first = atomic_fetch_add(w->next, KNN_QUERY_TILE)) < w->nqueries) {
+        const unsigned last = (first + KNN_QUERY_TILE < w->nqueries) ? first + KNN_QUERY_TILE : w->nqueries;
+        size_t counts[KNN_QUERY_TILE] = {0};
+
+        for (unsigned begin = 0; begin < w->npoints; begin += KNN_POINT_TILE) {
+            const unsigned end = (begin + KNN_POINT_TILE < w->npoints) ? begin + KNN_POINT_TILE : w->npoints;
+            for (unsigned q = first; q < last; q++) {
+                struct neighbor *heap = &w->results[(size_t)q * w->k];
+                for (unsigned i = begin; i < end; i++) {
+                    heap_offer(heap, &counts[q - first], w->k,
+                               (struct neighbor){vector_distance2(w->points[i], w->queries[q]), i});
+                }
+            }
+        }
+
+        for (unsigned q = first; q < last; q++) {
+            heap_sort(&w->results[(size_t)q * w->k], w->k);
+        }
+    }
+
+    return (NULL);
+}
+
+// Batched K-Nearest Neighbors, using multiple threads. The nearest
+// neighbors of query q are reported in results[q * k] to
+// results[q * k + k - 1], in ascending order of distance.
+static void knn_batch(struct neighbor *results,
+                      struct vector *const *points,
+                      unsigned npoints,
+                      unsigned k,
+                      struct vector *const *queries,
+                      unsigned nqueries,
+                      size_t nthreads)
 {
-    // Distances.
-    double distances[npoints];
-    unsigned indexes[npoints];
+    struct knn_worker workers[KNN_MAX_THREADS];
+    atomic_uint next = 0;
+    int ret = 0;
+
+    // Sanity check arguments.
+    assert((k >= 1) && (k <= npoints));
+    assert((nthreads >= 1) && (nthreads <= KNN_MAX_THREADS));
 
-    // Compute distances.
+    for (size_t i = 0; i < nthreads; i++) {
+        workers[i] = (struct knn_worker){0, points, npoints, k, queries, nqueries, results, &next};
+        ret = pthread_create(&workers[i].thread, NULL, knn_worker, &workers[i]);
+        assert(ret == 0);
+    }
+    ((void)ret);
+    for (size_t i = 0; i < nthreads; i++) {
+        pthread_join(workers[i].thread, NULL);
+    }
+}
+
+//==============================================================================
+// Spatial Trees
+//==============================================================================
+
+// Kinds of spatial trees.
+enum tree_kind {
+    TREE_KD,   // KD-tree.
+    TREE_BALL, // Ball tree.
+};
+
+// A node of a spatial tree. Nodes are laid out in preorder in a contiguous
+// array, so the left child of a node immediately follows it.
+struct tree_node {
+    unsigned begin; // First point.
+    unsigned end;   // Last point plus one.
+    unsigned left;  // Left child (zero for leaves).
+    unsigned right; // Right child (zero for leaves).
+    unsigned axis;  // KD-tree: split axis.
+    double split;   // KD-tree: split value.
+    double radius;  // Ball tree: radius of the ball.
+};
+
+// A spatial tree. Points are copied in leaf order, so that each leaf is a
+// contiguous block of coordinates.
+struct tree {
+    enum tree_kind kind;      // Kind of tree.
+    unsigned dimension;       // Dimension of points.
+    unsigned npoints;         // Number of points.
+    unsigned nnodes;          // Number of nodes.
+    struct tree_node *nodes;  // Nodes.
+    unsigned *indexes;        // Indexes of points, in leaf order.
+    double *coordinates;      // Coordinates of points, in leaf order.
+    double *centers;          // Ball tree: center of each node.
+};
+
+// A thread that builds a subtree of a spatial tree.
+struct tree_builder {
+    pthread_t thread;                // Thread.
+    struct tree *tree;               // Tree.
+    struct vector *const *points;    // Points.
+    struct neighbor *scratch;        // Sort keys of points.
+    unsigned node;                   // Root of the subtree.
+    unsigned begin;                  // First point.
+    unsigned end;                    // Last point plus one.
+    unsigned nspawns;                // Levels of the subtree that spawn threads.
+};
+
+// Computes the squared euclidean distance between two points.
+static double point_distance2(const double *p1, const double *p2, unsigned dimension)
+{
+    double distance = 0.0;
+
+    for (unsigned i = 0; i < dimension; i++) {
+        double x = p1[i] - p2[i];
+        distance += x * x;
+    }
+
+    return (distance);
+}
+
+// Returns the number of nodes in a subtree that has a given number of points.
+static unsigned tree_nnodes(unsigned npoints)
+{
+    if (npoints <= TREE_LEAF_SIZE) {
+        return (1);
+    }
+
+    return (1 + tree_nnodes(npoints / 2) + tree_nnodes(npoints - npoints / 2));
+}
+
+// Computes sort keys of the points in a node of a KD-tree: their coordinates
+// in the axis of largest spread.
+static void tree_keys_kd(struct tree_builder *b, struct tree_node *node)
+{
+    double spread = -1.0;
+
+    for (unsigned j = 0; j < b->tree->dimension; j++) {
+        double min = INFINITY;
+        double max = -INFINITY;
+        for (unsigned i = b->begin; i < b->end; i++) {
+            const double x = b->points[b->tree->indexes[i]]->elements[j];
+            min = (x < min) ? x : min;
+            max = (x > max) ? x : max;
+        }
+        if (max - min > spread) {
+            spread = max - min;
+            node->axis = j;
+        }
+    }
+
+    for (unsigned i = b->begin; i < b->end; i++) {
+        const unsigned index = b->tree->indexes[i];
+        b->scratch[i] = (struct neighbor){b->points[index]->elements[node->axis], index};
+    }
+}
+
+// Computes sort keys of the points in a node of a ball tree: their
+// projections on the line through two far apart points. Also computes the
+// center and the radius of the node.
+static void tree_keys_ball(struct tree_builder *b, struct tree_node *node)
+{
+    const unsigned dimension = b->tree->dimension;
+    double *center = &b->tree->centers[(size_t)b->node * dimension];
+    const double *farthest1 = NULL;
+    const double *farthest2 = NULL;
+    double max = -1.0;
+
+    // Compute center.
+    for (unsigned j = 0; j < dimension; j++) {
+        center[j] = 0.0;
+    }
+    for (unsigned i = b->begin; i < b->end; i++) {
+        const double *p = b->points[b->tree->indexes[i]]->elements;
+        for (unsigned j = 0; j < dimension; j++) {
+            center[j] += p[j];
+        }
+    }
+    for (unsigned j = 0; j < dimension; j++) {
+        center[j] /= (b->end - b->begin);
+    }
+
+    // Compute radius, and find the farthest point from the center.
+    for (unsigned i = b->begin; i < b->end; i++) {
+        const double *p = b->points[b->tree->indexes[i]]->elements;
+        const double d = point_distance2(p, center, dimension);
+        if (d > max) {
+            max = d;
+            farthest1 = p;
+        }
+    }
+    node->radius = sqrt(max);
+
+    // Find the farthest point from the farthest point.
+    max = -1.0;
+    for (unsigned i = b->begin; i < b->end; i++) {
+        const double *p = b->points[b->tree->indexes[i]]->elements;
+        const double d = point_distance2(p, farthest1, dimension);
+        if (d > max) {
+            max = d;
+            farthest2 = p;
+        }
+    }
+
+    for (unsigned i = b->begin; i < b->end; i++) {
+        const unsigned index = b->tree->indexes[i];
+        const double *p = b->points[index]->elements;
+        double key = 0.0;
+        for (unsigned j = 0; j < dimension; j++) {
+            key += p[j] * (farthest2[j] - farthest1[j]);
+        }
+        b->scratch[i] = (struct neighbor){key, index};
+    }
+}
+
+// Builds a subtree of a spatial tree. Points are split at the median of
+// their sort keys, and the right subtree is built by a new thread in the
+// topmost levels.
+static void *tree_build(void *arg)
+{
+    struct tree_builder *b = arg;
+    struct tree *tree = b->tree;
+    struct tree_node *node = &tree->nodes[b->node];
+    const unsigned npoints = b->end - b->begin;
+    const unsigned middle = npoints / 2;
+
+    *node = (struct tree_node){b->begin, b->end, 0, 0, 0, 0.0, 0.0};
+
+    switch (tree->kind) {
+        case TREE_KD:
+            if (npoints > TREE_LEAF_SIZE) {
+                tree_keys_kd(b, node);
+            }
+            break;
+        case TREE_BALL:
+            tree_keys_ball(b, node);
+            break;
+        default:
+            assert(false);
+            break;
+    }
+
+    // Leaf: copy points.
+    if (npoints <= TREE_LEAF_SIZE) {
+        for (unsigned i = b->begin; i < b->end; i++) {
+            memcpy(&tree->coordinates[(size_t)i * tree->dimension], b->points[tree->indexes[i]]->elements,
+                   tree->dimension * sizeof(double));
+        }
+        return (NULL);
+    }
+
+    // Split points at the median.
+    introselect(&b->scratch[b->begin], npoints, middle);
+    for (unsigned i = b->begin; i < b->end; i++) {
+        tree->indexes[i] = b->scratch[i].index;
+    }
+    node->split = b->scratch[b->begin + middle].distance;
+    node->left = b->node + 1;
+    node->right = b->node + 1 + tree_nnodes(middle);
+
+    // Build children.
+    struct tree_builder left = {0, tree, b->points, b->scratch, node->left, b->begin, b->begin + middle, 0};
+    struct tree_builder right = {0, tree, b->points, b->scratch, node->right, b->begin + middle, b->end, 0};
+    if (b->nspawns > 0) {
+        int ret = 0;
+        left.nspawns = right.nspawns = b->nspawns - 1;
+        ret = pthread_create(&right.thread, NULL, tree_build, &right);
+        assert(ret == 0);
+        ((void)ret);
+        tree_build(&left);
+        pthread_join(right.thread, NULL);
+    } else {
+        tree_build(&left);
+        tree_build(&right);
+    }
+
+    return (NULL);
+}
+
+// Creates a spatial tree, using multiple threads.
+static struct tree *tree_create(struct vector *const *points, unsigned npoints, enum tree_kind kind, size_t nthreads)
+{
+    struct tree *tree = NULL;
+    struct neighbor *scratch = NULL;
+    unsigned nspawns = 0;
+
+    // Sanity check arguments.
+    assert(npoints >= 1);
+    assert((nthreads >= 1) && (nthreads <= KNN_MAX_THREADS));
+
+    assert((tree = malloc(sizeof(struct tree))) != NULL);
+    tree->kind = kind;
+    tree->dimension = points[0]->dimension;
+    tree->npoints = npoints;
+    tree->nnodes = tree_nnodes(npoints);
+    assert((tree->nodes = malloc(tree->nnodes * sizeof(struct tree_node))) != NULL);
+    assert((tree->indexes = malloc(npoints * sizeof(unsigned))) != NULL);
+    assert((tree->coordinates = malloc((size_t)npoints * tree->dimension * sizeof(double))) != NULL);
+    tree->centers = NULL;
+    if (kind == TREE_BALL) {
+        assert((tree->centers = malloc((size_t)tree->nnodes * tree->dimension * sizeof(double))) != NULL);
+    }
+    assert((scratch = malloc(npoints * sizeof(struct neighbor))) != NULL);
     for (unsigned i = 0; i < npoints; i++) {
-        indexes[i] = i;
-        distances[i] = vector_distance2(points[i], query);
+        tree->indexes[i] = i;
+    }
+
+    // Spawn threads in the topmost levels.
+    for (size_t n = nthreads; n > 1; n /= 2) {
+        nspawns++;
     }
 
-    // Sort distances.
-    sort_distances(distances, indexes, npoints);
+    struct tree_builder root = {0, tree, points, scratch, 0, 0, npoints, nspawns};
+    tree_build(&root);
+
+    free(scratch);
+
+    return (tree);
+}
+
+// Destroys a spatial tree.
+static void tree_destroy(struct tree *tree)
+{
+    // Sanity check arguments.
+    assert(tree != NULL);
+
+    free(tree->centers);
+    free(tree->coordinates);
+    free(tree->indexes);
+    free(tree->nodes);
+    free(tree);
+}
+
+// Returns a lower bound on the squared distance between a query and the
+// points of a node of a ball tree.
+static double tree_bound_ball(const struct tree *tree, unsigned node, const double *query)
+{
+    const double distance =
+        sqrt(point_distance2(query, &tree->centers[(size_t)node * tree->dimension], tree->dimension)) -
+        tree->nodes[node].radius;
 
-    /// Find K-nearest neighbors.
-    for (unsigned i = 0; i < k; i++) {
-        nearest[i] = points[indexes[i]];
+    return ((distance > 0.0) ? distance * distance : 0.0);
+}
+
+// Searches a subtree of a spatial tree. Subtrees whose points are farther
+// from the query than the k-th nearest neighbor found so far are pruned.
+static void tree_search(const struct tree *tree,
+                        unsigned node,
+                        const double *query,
+                        struct neighbor *heap,
+                        size_t *n,
+                        size_t k)
+{
+    const struct tree_node *nd = &tree->nodes[node];
+    unsigned near = 0;
+    unsigned far = 0;
+    double near_bound = 0.0;
+    double far_bound = 0.0;
+
+    // Leaf: scan points.
+    if (nd->left == 0) {
+        for (unsigned i = nd->begin; i < nd->end; i++) {
+            const double distance =
+                point_distance2(query, &tree->coordinates[(size_t)i * tree->dimension], tree->dimension);
+            heap_offer(heap, n, k, (struct neighbor){distance, tree->indexes[i]});
+        }
+        return;
+    }
+
+    // Compute lower bounds on distances to children.
+    switch (tree->kind) {
+        case TREE_KD: {
+            const double diff = query[nd->axis] - nd->split;
+            near = (diff < 0.0) ? nd->left : nd->right;
+            far = (diff < 0.0) ? nd->right : nd->left;
+            far_bound = diff * diff;
+        } break;
+        case TREE_BALL: {
+            const double left = tree_bound_ball(tree, nd->left, query);
+            const double right = tree_bound_ball(tree, nd->right, query);
+            near = (left < right) ? nd->left : nd->right;
+            far = (left < right) ? nd->right : nd->left;
+            near_bound = (left < right) ? left : right;
+            far_bound = (left < right) ? right : left;
+        } break;
+        default:
+            assert(false);
+            break;
+    }
+
+    // Visit the nearest child first.
+    if ((*n < k) || !(near_bound > heap[0].distance)) {
+        tree_search(tree, near, query, heap, n, k);
+    }
+    if ((*n < k) || !(far_bound > heap[0].distance)) {
+        tree_search(tree, far, query, heap, n, k);
+    }
+}
+
+// Exact K-Nearest Neighbors with a spatial tree. Nearest neighbors are
+// reported in ascending order of distance.
+static void tree_knn(struct neighbor *nearest, const struct tree *tree, unsigned k, const struct vector *query)
+{
+    size_t n = 0;
+
+    // Sanity check arguments.
+    assert((k >= 1) && (k <= tree->npoints));
+    assert(query->dimension == tree->dimension);
+
+    tree_search(tree, 0, query->elements, nearest, &n, k);
+    heap_sort(nearest, n);
+}
+
+// A thread of batched tree queries.
+struct tree_worker {
+    pthread_t thread;                // Thread.
+    const struct tree *tree;         // Tree.
+    unsigned k;                      // Number of neighbors.
+    struct vector *const *queries;   // Queries.
+    unsigned nqueries;               // Number of queries.
+    struct neighbor *results;        // Neighbors of each query.
+    atomic_uint *next;               // Next query to grab.
+};
+
+// Runs a thread of batched tree queries.
+static void *tree_worker(void *arg)
+{
+    const struct tree_worker *w = arg;
+    unsigned first = 0;
+
+    while ((first = atomic_fetch_add(w->next, TREE_QUERY_CHUNK)) < w->nqueries) {
+        const unsigned last = (first + TREE_QUERY_CHUNK < w->nqueries) ? first + TREE_QUERY_CHUNK : w->nqueries;
+        for (unsigned q = first; q < last; q++) {
+            tree_knn(&w->results[(size_t)q * w->k], w->tree, w->k, w->queries[q]);
+        }
+    }
+
+    return (NULL);
+}
+
+// Batched K-Nearest Neighbors with a spatial tree, using multiple threads.
+// Results are reported as in knn_batch().
+static void tree_knn_batch(struct neighbor *results,
+                           const struct tree *tree,
+                           unsigned k,
+                           struct vector *const *queries,
+                           unsigned nqueries,
+                           size_t nthreads)
+{
+    struct tree_worker workers[KNN_MAX_THREADS];
+    atomic_uint next = 0;
+    int ret = 0;
+
+    // Sanity check arguments.
+    assert((nthreads >= 1) && (nthreads <= KNN_MAX_THREADS));
+
+    for (size_t i = 0; i < nthreads; i++) {
+        workers[i] = (struct tree_worker){0, tree, k, queries, nqueries, results, &next};
+        ret = pthread_create(&workers[i].thread, NULL, tree_worker, &workers[i]);
+        assert(ret == 0);
+    }
+    ((void)ret);
+    for (size_t i = 0; i < nthreads; i++) {
+        pthread_join(workers[i].thread, NULL);
     }
 }
 
@@ -144,15 +868,37 @@ static void knn(struct vector **nearest,
 // Test
 //==============================================================================
 
+// Returns the current time in microseconds.
+static double now(void)
+{
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+
+    return (ts.tv_sec * 1000000.0 + ts.tv_nsec / 1000.0);
+}
+
 // Tests K-Nearest Neighbors.
 static void test(unsigned npoints, unsigned dimension, bool verbose)
 {
+    const char *names[] = {"sort", "select", "heap"};
+    const enum knn_kind kinds[] = {KNN_SORT, KNN_SELECT, KNN_HEAP};
+    const char *tree_names[] = {"KD-Tree", "Ball Tree"};
+    const enum tree_kind tree_kinds[] = {TREE_KD, TREE_BALL};
     double tstart = 0.0;
     double tend = 0.0;
-    const double MICROSECS = ((CLOCKS_PER_SEC / 1000000.0));
-    const unsigned K = 3;
+    const unsigned K = (npoints - 1 < 3) ? npoints - 1 : 3;
+    const unsigned nqueries = KNN_NQUERIES;
+    bool first = true;
     struct vector **points = NULL;
-    struct vector *neighbors[K];
+    struct vector **queries = NULL;
+    struct vector **neighbors = NULL;
+    struct vector **expected = NULL;
+    struct neighbor *results = NULL;
+    struct neighbor *tree_results = NULL;
+
+    // Sanity check arguments.
+    assert(npoints >= 2);
 
     // Fix random number generator seed
     // to have a determinist behavior across runs.
@@ -164,6 +910,8 @@ static void test(unsigned npoints, unsigned dimension, bool verbose)
         points[i] = vector_create(dimension);
         vector_random(points[i]);
     }
+    assert((neighbors = malloc(npoints * sizeof(struct vector *))) != NULL);
+    assert((expected = malloc(npoints * sizeof(struct vector *))) != NULL);
 
     if (verbose) {
         printf("Data Set:\n");
@@ -175,27 +923,192 @@ static void test(unsigned npoints, unsigned dimension, bool verbose)
     }
 
     // Run.
-    tstart = clock();
-    knn(neighbors, &points[1], npoints - 1, K, points[0]);
-    tend = clock();
+    for (unsigned k = 0; k < sizeof(kinds) / sizeof(kinds[0]); k++) {
+        if ((kinds[k] == KNN_SORT) && (npoints > KNN_SORT_MAX_POINTS)) {
+            continue;
+        }
+
+        tstart = now();
+        knn(neighbors, &points[1], npoints - 1, K, points[0], kinds[k]);
+        tend = now();
 
-    // Report time.
-    printf("K-Nearest Neighbors: %2.lf us\n", (tend - tstart) / MICROSECS);
+        // Report time.
+        printf("K-Nearest Neighbors (%s): %2.lf us\n", names[k], tend - tstart);
+
+        // All algorithms find the same neighbors, for any number of neighbors.
+        if (first) {
+            memcpy(expected, neighbors, K * sizeof(struct vector *));
+            first = false;
+        } else {
+            assert(!memcmp(neighbors, expected, K * sizeof(struct vector *)));
+        }
+    }
+    if (npoints - 1 <= KNN_SORT_MAX_POINTS) {
+        for (unsigned n = 1; n < npoints; n = (n < 16) ? n + 1 : 2 * n) {
+            knn(expected, &points[1], npoints - 1, n, points[0], KNN_SORT);
+            knn(neighbors, &points[1], npoints - 1, n, points[0], KNN_SELECT);
+            assert(!memcmp(neighbors, expected, n * sizeof(struct vector *)));
+            knn(neighbors, &points[1], npoints - 1, n, points[0], KNN_HEAP);
+            assert(!memcmp(neighbors, expected, n * sizeof(struct vector *)));
+        }
+    }
 
     if (verbose) {
         printf("Neighbors:\n");
         for (unsigned i = 0; i < K; i++) {
-            vector_print(neighbors[i]);
+            vector_print(expected[i]);
+        }
+    }
+
+    // Batched queries.
+    assert((queries = malloc(nqueries * sizeof(struct vector *))) != NULL);
+    assert((results = malloc(nqueries * K * sizeof(struct neighbor))) != NULL);
+    for (unsigned q = 0; q < nqueries; q++) {
+        queries[q] = vector_create(dimension);
+        vector_random(queries[q]);
+    }
+    tstart = now();
+    for (unsigned q = 0; q < nqueries; q++) {
+        knn(neighbors, points, npoints, K, queries[q], KNN_HEAP);
+    }
+    tend = now();
+    printf("K-Nearest Neighbors (heap, %u queries): %2.lf us\n", nqueries, tend - tstart);
+    for (size_t nthreads = 1; nthreads <= KNN_MAX_THREADS; nthreads *= KNN_MAX_THREADS) {
+        tstart = now();
+        knn_batch(results, points, npoints, K, queries, nqueries, nthreads);
+        tend = now();
+        printf("K-Nearest Neighbors (batch, %u queries, %zu threads): %2.lf us\n", nqueries, nthreads,
+               tend - tstart);
+        for (unsigned q = 0; q < nqueries; q++) {
+            knn(neighbors, points, npoints, K, queries[q], KNN_HEAP);
+            for (unsigned i = 0; i < K; i++) {
+                assert(points[results[q * K + i].index] == neighbors[i]);
+            }
+        }
+    }
+
+    // Spatial trees.
+    assert((tree_results = malloc(((npoints > nqueries * K) ? npoints : nqueries * K) * sizeof(struct neighbor))) !=
+           NULL);
+    for (unsigned k = 0; k < sizeof(tree_kinds) / sizeof(tree_kinds[0]); k++) {
+        for (size_t nthreads = 1; nthreads <= KNN_MAX_THREADS; nthreads *= KNN_MAX_THREADS) {
+            tstart = now();
+            struct tree *tree = tree_create(points, npoints, tree_kinds[k], nthreads);
+            tend = now();
+            printf("%s (build, %zu threads): %2.lf us\n", tree_names[k], nthreads, tend - tstart);
+
+            tstart = now();
+            tree_knn_batch(tree_results, tree, K, queries, nqueries, nthreads);
+            tend = now();
+            printf("%s (batch, %u queries, %zu threads): %2.lf us\n", tree_names[k], nqueries, nthreads,
+                   tend - tstart);
+
+            // Trees find the same neighbors as a brute force search.
+            for (unsigned i = 0; i < nqueries * K; i++) {
+                assert(tree_results[i].index == results[i].index);
+            }
+            for (unsigned n = 1; n <= npoints; n = (n < 16) ? n + 1 : 2 * n) {
+                tree_knn(tree_results, tree, n, points[0]);
+                knn(neighbors, points, npoints, n, points[0], KNN_HEAP);
+                for (unsigned i = 0; i < n; i++) {
+                    assert(points[tree_results[i].index] == neighbors[i]);
+                }
+            }
+
+            tree_destroy(tree);
         }
     }
 
     // Release resources.
+    for (unsigned q = 0; q < nqueries; q++) {
+        vector_destroy(queries[q]);
+    }
+    free(tree_results);
+    free(results);
+    free(queries);
     for (unsigned i = 0; i < npoints; i++) {
         vector_destroy(points[i]);
     }
+    free(expected);
+    free(neighbors);
     free(points);
 }
 
+// Benchmarks brute force K-Nearest Neighbors against spatial trees, for
+// increasing dimensions.
+static void benchmark(unsigned npoints)
+{
+    const unsigned K = 8;
+    const unsigned nqueries = 16 * KNN_NQUERIES;
+    struct neighbor *expected = NULL;
+    struct neighbor *results = NULL;
+
+    // Sanity check arguments.
+    assert(npoints >= K);
+
+    srand(0);
+
+    assert((expected = malloc(nqueries * K * sizeof(struct neighbor))) != NULL);
+    assert((results = malloc(nqueries * K * sizeof(struct neighbor))) != NULL);
+
+    printf("%9s %12s %12s %12s %12s %12s\n", "dimension", "brute (us)", "kd build", "kd query", "ball build",
+           "ball query");
+    for (unsigned dimension = 2; dimension <= 64; dimension *= 2) {
+        const enum tree_kind kinds[] = {TREE_KD, TREE_BALL};
+        struct vector **points = NULL;
+        struct vector **queries = NULL;
+        double tstart = 0.0;
+        double tend = 0.0;
+
+        assert((points = malloc(npoints * sizeof(struct vector *))) != NULL);
+        assert((queries = malloc(nqueries * sizeof(struct vector *))) != NULL);
+        for (unsigned i = 0; i < npoints; i++) {
+            points[i] = vector_create(dimension);
+            vector_random(points[i]);
+        }
+        for (unsigned q = 0; q < nqueries; q++) {
+            queries[q] = vector_create(dimension);
+            vector_random(queries[q]);
+        }
+
+        tstart = now();
+        knn_batch(expected, points, npoints, K, queries, nqueries, 1);
+        tend = now();
+        printf("%9u %12.lf", dimension, tend - tstart);
+
+        for (unsigned k = 0; k < sizeof(kinds) / sizeof(kinds[0]); k++) {
+            tstart = now();
+            struct tree *tree = tree_create(points, npoints, kinds[k], 1);
+            tend = now();
+            printf(" %12.lf", tend - tstart);
+
+            tstart = now();
+            tree_knn_batch(results, tree, K, queries, nqueries, 1);
+            tend = now();
+            printf(" %12.lf", tend - tstart);
+
+            for (unsigned i = 0; i < nqueries * K; i++) {
+                assert(results[i].index == expected[i].index);
+            }
+
+            tree_destroy(tree);
+        }
+        printf("\n");
+
+        for (unsigned q = 0; q < nqueries; q++) {
+            vector_destroy(queries[q]);
+        }
+        for (unsigned i = 0; i < npoints; i++) {
+            vector_destroy(points[i]);
+        }
+        free(queries);
+        free(points);
+    }
+
+    free(results);
+    free(expected);
+}
+
 //==============================================================================
 // Usage
 //==============================================================================
@@ -205,6 +1118,7 @@ static void usage(char *const argv[])
 {
     printf("%s - Testing program for k-nearest neighbors.\n", argv[0]);
     printf("Usage: %s [--verbose] <number of points> <dimension>\n", argv[0]);
+    printf("       %s --benchmark <number of points>\n", argv[0]);
     exit(EXIT_FAILURE);
 }
 
@@ -226,7 +1140,11 @@ int main(int argc, char *const argv[])
     }
 
     // Parse command line arguments.
-    if (argc == 3) {
+    if ((argc == 3) && (!strcmp(argv[1], "--benchmark"))) {
+        sscanf(argv[2], "%u", &npoints);
+        benchmark(npoints);
+        return (EXIT_SUCCESS);
+    } else if (argc == 3) {
         sscanf(argv[1], "%u", &npoints);
         sscanf(argv[2], "%u", &dimension);
     } else if ((argc == 4) && (!strcmp(argv[1], "--verbose"))) {
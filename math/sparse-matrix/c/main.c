@@ -0,0 +1,1024 @@
+// Copyright (C) 2022 Pedro Henrique Penna <pedrohenriquepenna@outlook.com>
+
+#define _POSIX_C_SOURCE 200809L
+
+#include <assert.h>
+#include <math.h>
+#include <pthread.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+// Max number of threads.
+#define SPARSE_MAX_THREADS 8
+
+// Size of matrices that are checked against dense matrices.
+#define SPARSE_CHECK_SIZE 128
+
+// Max difference between two values that are considered equal.
+#define SPARSE_EPSILON 1e-8
+
+// Damping factor of PageRank: probability of following a link, instead of
+// jumping to a random node.
+#define PAGERANK_DAMPING 0.85
+
+// PageRank stops when the sum of changes in ranks falls below this value.
+#define PAGERANK_TOLERANCE 1e-10
+
+// Max number of iterations of PageRank.
+#define PAGERANK_MAX_ITERATIONS 1000
+
+// Average number of links per node in random graphs.
+#define GRAPH_DEGREE 8
+
+// Skew of targets of links in random graphs. Higher values concentrate links
+// on fewer nodes.
+#define GRAPH_SKEW 2.0
+
+//==============================================================================
+// Sparse Matrix
+//==============================================================================
+
+// Formats of sparse matrices.
+enum sparse_format {
+    SPARSE_CSR, // Compressed sparse rows.
+    SPARSE_CSC, // Compressed sparse columns.
+};
+
+// A sparse matrix. Lines are rows in the compressed sparse rows format, and
+// columns in the compressed sparse columns format. Indices within a line are
+// sorted.
+struct sparse {
+    enum sparse_format format; // Format.
+    size_t nrows;              // Number of rows.
+    size_t ncols;              // Number of columns.
+    size_t nnz;                // Number of non-zero elements.
+    size_t *offsets;           // Offsets of lines in indices and values.
+    unsigned *indices;         // Column (row) indices of elements in a row (column).
+    double *values;            // Non-zero elements.
+};
+
+// Returns the number of lines of a sparse matrix.
+static size_t sparse_nlines(const struct sparse *s)
+{
+    return ((s->format == SPARSE_CSR) ? s->nrows : s->ncols);
+}
+
+// Returns the number of elements in the lines that are crossed by the lines
+// of a sparse matrix.
+static size_t sparse_nothers(const struct sparse *s)
+{
+    return ((s->format == SPARSE_CSR) ? s->ncols : s->nrows);
+}
+
+// Creates a sparse matrix.
+static struct sparse *sparse_create(enum sparse_format format, size_t nrows, size_t ncols,
+                                    size_t nnz)
+{
+    struct sparse *s = NULL;
+
+    assert((nrows <= UINT32_MAX) && (ncols <= UINT32_MAX));
+
+    assert((s = malloc(sizeof(struct sparse))) != NULL);
+    s->format = format;
+    s->nrows = nrows;
+    s->ncols = ncols;
+    s->nnz = nnz;
+    assert((s->offsets = calloc(sparse_nlines(s) + 1, sizeof(size_t))) != NULL);
+    assert((s->indices = malloc((nnz + 1) * sizeof(unsigned))) != NULL);
+    assert((s->values = malloc((nnz + 1) * sizeof(double))) != NULL);
+
+    return (s);
+}
+
+// Destroys a sparse matrix.
+static void sparse_destroy(struct sparse *s)
+{
+    assert(s != NULL);
+
+    free(s->values);
+    free(s->indices);
+    free(s->offsets);
+    free(s);
+}
+
+// Swaps the lines and the indices of a sparse matrix, that is, builds the
+// transpose of its lines. Lines of the input are visited in the order given
+// by a permutation, and indices are renamed by the inverse of that
+// permutation. Both may be NULL, for the identity. Lines of the output have
+// sorted indices, because lines of the input are visited in order.
+static struct sparse *sparse_swap(const struct sparse *s, const unsigned *perm,
+                                  const unsigned *inverse)
+{
+    const size_t nlines = sparse_nlines(s);
+    const size_t nothers = sparse_nothers(s);
+    struct sparse *t = NULL;
+    size_t *next = NULL;
+
+    // Swapped lines are transposed: the output has the other format.
+    t = sparse_create((s->format == SPARSE_CSR) ? SPARSE_CSC : SPARSE_CSR, s->nrows, s->ncols,
+                      s->nnz);
+    assert((next = malloc(nothers * sizeof(size_t))) != NULL);
+
+    // Count elements in each line of the output.
+    for (size_t k = 0; k < s->nnz; k++) {
+        const unsigned j = s->indices[k];
+        t->offsets[((inverse != NULL) ? inverse[j] : j) + 1]++;
+    }
+    for (size_t j = 0; j < nothers; j++) {
+        t->offsets[j + 1] += t->offsets[j];
+        next[j] = t->offsets[j];
+    }
+
+    // Scatter elements.
+    for (size_t i = 0; i < nlines; i++) {
+        const size_t line = (perm != NULL) ? perm[i] : i;
+        for (size_t k = s->offsets[line]; k < s->offsets[line + 1]; k++) {
+            const unsigned j = (inverse != NULL) ? inverse[s->indices[k]] : s->indices[k];
+            const size_t dest = next[j]++;
+            t->indices[dest] = (unsigned)i;
+            t->values[dest] = s->values[k];
+        }
+    }
+
+    free(next);
+
+    return (t);
+}
+
+// Converts a sparse matrix from one format to the other.
+static struct sparse *sparse_convert(const struct sparse *s)
+{
+    return (sparse_swap(s, NULL, NULL));
+}
+
+// Transposes a sparse matrix. The transpose keeps the format.
+static struct sparse *sparse_transpose(const struct sparse *s)
+{
+    struct sparse *t = sparse_swap(s, NULL, NULL);
+
+    t->format = s->format;
+    t->nrows = s->ncols;
+    t->ncols = s->nrows;
+
+    return (t);
+}
+
+// Permutes rows and columns of a square sparse matrix: element (i, j) of
+// the output is element (perm[i], perm[j]) of the input.
+static struct sparse *sparse_permute(const struct sparse *s, const unsigned *perm)
+{
+    const size_t n = s->nrows;
+    unsigned *inverse = NULL;
+    struct sparse *t = NULL;
+    struct sparse *u = NULL;
+
+    assert(s->nrows == s->ncols);
+
+    assert((inverse = malloc(n * sizeof(unsigned))) != NULL);
+    for (size_t i = 0; i < n; i++) {
+        inverse[perm[i]] = (unsigned)i;
+    }
+
+    // Swap twice, so that the output has sorted indices and the same format.
+    t = sparse_swap(s, perm, inverse);
+    u = sparse_swap(t, NULL, NULL);
+
+    sparse_destroy(t);
+    free(inverse);
+
+    return (u);
+}
+
+// Builds a sparse matrix in compressed sparse rows format from a list of
+// elements. Duplicate elements are kept, and add up in products.
+static struct sparse *sparse_from_elements(size_t nrows, size_t ncols, size_t nnz,
+                                           const unsigned *rows, const unsigned *cols,
+                                           const double *values)
+{
+    struct sparse *s = sparse_create(SPARSE_CSC, nrows, ncols, nnz);
+    struct sparse *t = NULL;
+    size_t *next = NULL;
+
+    // Bucket elements by columns, in any order within a column.
+    assert((next = malloc(ncols * sizeof(size_t))) != NULL);
+    for (size_t k = 0; k < nnz; k++) {
+        s->offsets[cols[k] + 1]++;
+    }
+    for (size_t j = 0; j < ncols; j++) {
+        s->offsets[j + 1] += s->offsets[j];
+        next[j] = s->offsets[j];
+    }
+    for (size_t k = 0; k < nnz; k++) {
+        const size_t dest = next[cols[k]]++;
+        s->indices[dest] = rows[k];
+        s->values[dest] = values[k];
+    }
+    free(next);
+
+    // Sort indices.
+    t = sparse_convert(s);
+    sparse_destroy(s);
+
+    return (t);
+}
+
+// Builds a sparse matrix from a dense matrix, which is stored in row-major order.
+static struct sparse *sparse_from_dense(enum sparse_format format, size_t nrows, size_t ncols,
+                                        const double *dense)
+{
+    struct sparse *s = NULL;
+    size_t nnz = 0;
+
+    for (size_t k = 0; k < nrows * ncols; k++) {
+        if (fabs(dense[k]) > 0.0) {
+            nnz++;
+        }
+    }
+
+    s = sparse_create(format, nrows, ncols, nnz);
+    nnz = 0;
+    for (size_t i = 0; i < sparse_nlines(s); i++) {
+        for (size_t j = 0; j < sparse_nothers(s); j++) {
+            const double value = (format == SPARSE_CSR) ? dense[i * ncols + j] : dense[j * ncols + i];
+            if (fabs(value) > 0.0) {
+                s->indices[nnz] = (unsigned)j;
+                s->values[nnz] = value;
+                nnz++;
+            }
+        }
+        s->offsets[i + 1] = nnz;
+    }
+
+    return (s);
+}
+
+// Prints a sparse matrix.
+static void sparse_print(const struct sparse *s, FILE *f)
+{
+    fprintf(f, "sparse {\n  ");
+    fprintf(f, "format: %s,\n  ", (s->format == SPARSE_CSR) ? "csr" : "csc");
+    fprintf(f, "nrows: %zu,\n  ", s->nrows);
+    fprintf(f, "ncols: %zu,\n  ", s->ncols);
+    fprintf(f, "nnz: %zu,\n  ", s->nnz);
+    fprintf(f, "lines: [\n");
+    for (size_t i = 0; i < sparse_nlines(s); i++) {
+        fprintf(f, "    %zu:", i);
+        for (size_t k = s->offsets[i]; k < s->offsets[i + 1]; k++) {
+            fprintf(f, " (%u, %.4f)", s->indices[k], s->values[k]);
+        }
+        fprintf(f, "\n");
+    }
+    fprintf(f, "  ]\n}\n");
+}
+
+//==============================================================================
+// Sparse Matrix-Vector Multiplication
+//==============================================================================
+
+// Multiplies a range of rows of a sparse matrix in compressed sparse rows
+// format by a vector: y[i] = sum(A[i][j] * x[j]), for i in [begin, end).
+static void spmv_rows(const struct sparse *a, const double *x, double *y, size_t begin, size_t end)
+{
+    for (size_t i = begin; i < end; i++) {
+        double sum = 0.0;
+        for (size_t k = a->offsets[i]; k < a->offsets[i + 1]; k++) {
+            sum += a->values[k] * x[a->indices[k]];
+        }
+        y[i] = sum;
+    }
+}
+
+// Multiplies a sparse matrix in compressed sparse columns format by a vector.
+// Columns scatter into all elements of y, thus they are not split among threads.
+static void spmv_columns(const struct sparse *a, const double *x, double *y)
+{
+    memset(y, 0, a->nrows * sizeof(double));
+    for (size_t j = 0; j < a->ncols; j++) {
+        const double xj = x[j];
+        for (size_t k = a->offsets[j]; k < a->offsets[j + 1]; k++) {
+            y[a->indices[k]] += a->values[k] * xj;
+        }
+    }
+}
+
+// Splits the rows of a sparse matrix in compressed sparse rows format into
+// ranges with about the same number of non-zero elements. Range i is
+// [bounds[i], bounds[i + 1]).
+static void spmv_split(const struct sparse *a, size_t nparts, size_t *bounds)
+{
+    bounds[0] = 0;
+    for (size_t p = 1; p < nparts; p++) {
+        const size_t target = (a->nnz * p) / nparts;
+        size_t lo = bounds[p - 1];
+        size_t hi = a->nrows;
+
+        // Find the first row that starts at or after the target.
+        while (lo < hi) {
+            const size_t mid = lo + (hi - lo) / 2;
+            if (a->offsets[mid] < target) {
+                lo = mid + 1;
+            } else {
+                hi = mid;
+            }
+        }
+        bounds[p] = lo;
+    }
+    bounds[nparts] = a->nrows;
+}
+
+// A thread of a sparse matrix-vector multiplication.
+struct spmv_worker {
+    pthread_t thread;         // Thread.
+    const struct sparse *a;   // Matrix.
+    const double *x;          // Input vector.
+    double *y;                // Output vector.
+    size_t begin;             // First row.
+    size_t end;               // Last row (exclusive).
+};
+
+// Runs a thread of a sparse matrix-vector multiplication.
+static void *spmv_worker(void *arg)
+{
+    const struct spmv_worker *w = arg;
+
+    spmv_rows(w->a, w->x, w->y, w->begin, w->end);
+
+    return (NULL);
+}
+
+// Multiplies a sparse matrix by a vector: y = A * x. Matrices in compressed
+// sparse rows format are split among threads by ranges of rows.
+static void spmv(const struct sparse *a, const double *x, double *y, size_t nthreads)
+{
+    struct spmv_worker workers[SPARSE_MAX_THREADS];
+    size_t bounds[SPARSE_MAX_THREADS + 1];
+    int ret = 0;
+
+    assert((nthreads >= 1) && (nthreads <= SPARSE_MAX_THREADS));
+
+    switch (a->format) {
+        case SPARSE_CSR:
+            spmv_split(a, nthreads, bounds);
+            for (size_t i = 0; i < nthreads; i++) {
+                workers[i] = (struct spmv_worker){0, a, x, y, bounds[i], bounds[i + 1]};
+                ret = pthread_create(&workers[i].thread, NULL, spmv_worker, &workers[i]);
+                assert(ret == 0);
+            }
+            ((void)ret);
+            for (size_t i = 0; i < nthreads; i++) {
+                pthread_join(workers[i].thread, NULL);
+            }
+            break;
+        case SPARSE_CSC:
+            spmv_columns(a, x, y);
+            break;
+        default:
+            assert(false);
+            break;
+    }
+}
+
+// Returns the number of bytes that a sparse matrix-vector multiplication
+// moves from and to memory. The matrix and y are moved once. If reuse is
+// true, so is x, otherwise x is moved once per non-zero element.
+static double spmv_bytes(const struct sparse *a, bool reuse)
+{
+    const double matrix =
+        (sparse_nlines(a) + 1) * sizeof(size_t) + a->nnz * (sizeof(unsigned) + sizeof(double));
+    const double x = (reuse ? a->ncols : a->nnz) * sizeof(double);
+    const double y = a->nrows * sizeof(double);
+
+    return (matrix + x + y);
+}
+
+//==============================================================================
+// Vertex Reordering
+//==============================================================================
+
+// Orderings of nodes.
+enum reorder_kind {
+    REORDER_NONE,   // Keep the original order.
+    REORDER_DEGREE, // Sort by degree.
+    REORDER_RCM,    // Reverse Cuthill-McKee.
+};
+
+// Compares two sort keys.
+static int reorder_compare(const void *a, const void *b)
+{
+    const uint64_t x = *(const uint64_t *)a;
+    const uint64_t y = *(const uint64_t *)b;
+
+    return ((x > y) - (x < y));
+}
+
+// Orders nodes of a square sparse matrix in compressed sparse rows format by
+// decreasing number of elements in their columns, that is, by the number of
+// times that SpMV reads their element of x. Frequently read elements are
+// then packed in the same cache lines.
+static void reorder_degree(const struct sparse *a, unsigned *perm)
+{
+    const size_t n = a->nrows;
+    size_t *counts = NULL;
+    uint64_t *keys = NULL;
+
+    assert((counts = calloc(n, sizeof(size_t))) != NULL);
+    assert((keys = malloc(n * sizeof(uint64_t))) != NULL);
+
+    for (size_t k = 0; k < a->nnz; k++) {
+        counts[a->indices[k]]++;
+    }
+
+    // Sort (complemented count, node) keys, which breaks ties by node.
+    for (size_t i = 0; i < n; i++) {
+        const uint64_t count = (counts[i] < UINT32_MAX) ? counts[i] : UINT32_MAX;
+        keys[i] = ((UINT32_MAX - count) << 32) | i;
+    }
+    qsort(keys, n, sizeof(uint64_t), reorder_compare);
+    for (size_t i = 0; i < n; i++) {
+        perm[i] = (unsigned)keys[i];
+    }
+
+    free(keys);
+    free(counts);
+}
+
+// Orders nodes of a square sparse matrix in compressed sparse rows format
+// with the Reverse Cuthill-McKee algorithm, which brings the non-zero
+// elements close to the diagonal. Links are taken in both directions. A
+// breadth-first search starts from a node with the lowest degree in each
+// component, and visits the neighbors of each node by increasing degree.
+// The resulting order is reversed.
+static void reorder_rcm(const struct sparse *a, unsigned *perm)
+{
+    const size_t n = a->nrows;
+    struct sparse *t = sparse_transpose(a);
+    const struct sparse *directions[] = {a, t};
+    uint64_t *starts = NULL;
+    uint64_t *neighbors = NULL;
+    bool *visited = NULL;
+    size_t head = 0;
+    size_t tail = 0;
+
+    assert((starts = malloc(n * sizeof(uint64_t))) != NULL);
+    assert((neighbors = malloc(n * sizeof(uint64_t))) != NULL);
+    assert((visited = calloc(n, sizeof(bool))) != NULL);
+
+    // Sort (degree, node) keys.
+    for (size_t i = 0; i < n; i++) {
+        const uint64_t degree = (a->offsets[i + 1] - a->offsets[i]) + (t->offsets[i + 1] - t->offsets[i]);
+        starts[i] = (degree << 32) | i;
+    }
+    qsort(starts, n, sizeof(uint64_t), reorder_compare);
+
+    // Breadth-first search, using the permutation as queue.
+    for (size_t s = 0; s < n; s++) {
+        const unsigned start = (unsigned)starts[s];
+        if (visited[start]) {
+            continue;
+        }
+        visited[start] = true;
+        perm[tail++] = start;
+
+        while (head < tail) {
+            const unsigned node = perm[head++];
+            size_t nneighbors = 0;
+
+            // Gather unvisited neighbors in both directions.
+            for (size_t d = 0; d < 2; d++) {
+                const struct sparse *m = directions[d];
+                for (size_t k = m->offsets[node]; k < m->offsets[node + 1]; k++) {
+                    const unsigned j = m->indices[k];
+                    if (!visited[j]) {
+                        const uint64_t degree = (a->offsets[j + 1] - a->offsets[j]) +
+                                                (t->offsets[j + 1] - t->offsets[j]);
+                        visited[j] = true;
+                        neighbors[nneighbors++] = (degree << 32) | j;
+                    }
+                }
+            }
+
+            // Enqueue neighbors by increasing degree.
+            qsort(neighbors, nneighbors, sizeof(uint64_t), reorder_compare);
+            for (size_t i = 0; i < nneighbors; i++) {
+                perm[tail++] = (unsigned)neighbors[i];
+            }
+        }
+    }
+
+    // Reverse.
+    for (size_t i = 0; i < n / 2; i++) {
+        const unsigned tmp = perm[i];
+        perm[i] = perm[n - 1 - i];
+        perm[n - 1 - i] = tmp;
+    }
+
+    free(visited);
+    free(neighbors);
+    free(starts);
+    sparse_destroy(t);
+}
+
+// Computes a new order for the nodes of a square sparse matrix in compressed
+// sparse rows format: perm[i] is the node that is placed at position i.
+static unsigned *reorder(const struct sparse *a, enum reorder_kind kind)
+{
+    unsigned *perm = NULL;
+
+    assert(a->format == SPARSE_CSR);
+    assert(a->nrows == a->ncols);
+
+    assert((perm = malloc(a->nrows * sizeof(unsigned))) != NULL);
+
+    switch (kind) {
+        case REORDER_NONE:
+            for (size_t i = 0; i < a->nrows; i++) {
+                perm[i] = (unsigned)i;
+            }
+            break;
+        case REORDER_DEGREE:
+            reorder_degree(a, perm);
+            break;
+        case REORDER_RCM:
+            reorder_rcm(a, perm);
+            break;
+        default:
+            assert(false);
+            break;
+    }
+
+    return (perm);
+}
+
+//==============================================================================
+// PageRank
+//==============================================================================
+
+// A thread of PageRank.
+struct pagerank_worker {
+    pthread_t thread;        // Thread.
+    size_t id;               // Thread number.
+    struct pagerank *pr;     // PageRank.
+    size_t begin;            // First node.
+    size_t end;              // Last node (exclusive).
+    double delta;            // Sum of changes in ranks of nodes.
+    double dangling;         // Sum of new ranks of dangling nodes.
+};
+
+// State of PageRank.
+struct pagerank {
+    const struct sparse *m;                             // Transition matrix.
+    const bool *dangling;                               // Nodes without outgoing links?
+    double *ranks;                                      // Current ranks.
+    double *next;                                       // Next ranks.
+    size_t nthreads;                                    // Number of threads.
+    size_t niterations;                                 // Number of iterations.
+    bool done;                                          // Converged?
+    pthread_barrier_t barrier;                          // Synchronizes threads between iterations.
+    struct pagerank_worker workers[SPARSE_MAX_THREADS]; // Threads.
+};
+
+// Runs a thread of PageRank. Each thread pulls the ranks of its range of
+// nodes from their in-neighbors with a SpMV, then adds the rank that is
+// teleported and that leaks from dangling nodes. The first thread reduces
+// changes and swaps ranks between iterations.
+static void *pagerank_worker(void *arg)
+{
+    struct pagerank_worker *w = arg;
+    struct pagerank *pr = w->pr;
+    const double n = (double)pr->m->nrows;
+
+    while (!pr->done) {
+        double dangling = 0.0;
+        double delta = 0.0;
+
+        // Rank from dangling nodes is spread among all nodes.
+        for (size_t i = 0; i < pr->nthreads; i++) {
+            dangling += pr->workers[i].dangling;
+        }
+        const double base = (1.0 - PAGERANK_DAMPING) / n + PAGERANK_DAMPING * dangling / n;
+
+        spmv_rows(pr->m, pr->ranks, pr->next, w->begin, w->end);
+        dangling = 0.0;
+        for (size_t i = w->begin; i < w->end; i++) {
+            pr->next[i] = base + PAGERANK_DAMPING * pr->next[i];
+            delta += fabs(pr->next[i] - pr->ranks[i]);
+            if (pr->dangling[i]) {
+                dangling += pr->next[i];
+            }
+        }
+        pthread_barrier_wait(&pr->barrier);
+        w->delta = delta;
+        w->dangling = dangling;
+        pthread_barrier_wait(&pr->barrier);
+
+        if (w->id == 0) {
+            double *tmp = pr->ranks;
+            pr->ranks = pr->next;
+            pr->next = tmp;
+            delta = 0.0;
+            for (size_t i = 0; i < pr->nthreads; i++) {
+                delta += pr->workers[i].delta;
+            }
+            pr->niterations++;
+            pr->done = (delta < PAGERANK_TOLERANCE) || (pr->niterations >= PAGERANK_MAX_ITERATIONS);
+        }
+        pthread_barrier_wait(&pr->barrier);
+    }
+
+    return (NULL);
+}
+
+// Computes ranks of nodes with pull-based PageRank, using multiple threads.
+// The transition matrix is in compressed sparse rows format, and element
+// (i, j) is 1 / outdegree(j) if j links to i, thus rows list in-neighbors.
+// Returns the number of iterations.
+static size_t pagerank(const struct sparse *m, double *ranks, size_t nthreads)
+{
+    const size_t n = m->nrows;
+    struct pagerank *pr = NULL;
+    size_t bounds[SPARSE_MAX_THREADS + 1];
+    bool *dangling = NULL;
+    size_t niterations = 0;
+    int ret = 0;
+
+    assert(m->format == SPARSE_CSR);
+    assert(m->nrows == m->ncols);
+    assert((nthreads >= 1) && (nthreads <= SPARSE_MAX_THREADS));
+
+    assert((pr = malloc(sizeof(struct pagerank))) != NULL);
+    assert((dangling = malloc(n * sizeof(bool))) != NULL);
+    assert((pr->next = malloc(n * sizeof(double))) != NULL);
+
+    // Dangling nodes do not appear in any row.
+    for (size_t i = 0; i < n; i++) {
+        dangling[i] = true;
+        ranks[i] = 1.0 / n;
+    }
+    for (size_t k = 0; k < m->nnz; k++) {
+        dangling[m->indices[k]] = false;
+    }
+
+    pr->m = m;
+    pr->dangling = dangling;
+    pr->ranks = ranks;
+    pr->nthreads = nthreads;
+    pr->niterations = 0;
+    pr->done = false;
+    ret = pthread_barrier_init(&pr->barrier, NULL, nthreads);
+    assert(ret == 0);
+    spmv_split(m, nthreads, bounds);
+    for (size_t i = 0; i < nthreads; i++) {
+        double initial = 0.0;
+        for (size_t j = bounds[i]; j < bounds[i + 1]; j++) {
+            if (dangling[j]) {
+                initial += ranks[j];
+            }
+        }
+        pr->workers[i] = (struct pagerank_worker){0, i, pr, bounds[i], bounds[i + 1], 0.0, initial};
+    }
+    for (size_t i = 0; i < nthreads; i++) {
+        ret = pthread_create(&pr->workers[i].thread, NULL, pagerank_worker, &pr->workers[i]);
+        assert(ret == 0);
+    }
+    ((void)ret);
+    for (size_t i = 0; i < nthreads; i++) {
+        pthread_join(pr->workers[i].thread, NULL);
+    }
+
+    // Ranks may have been left in the other buffer.
+    if (pr->ranks != ranks) {
+        memcpy(ranks, pr->ranks, n * sizeof(double));
+        pr->next = pr->ranks;
+    }
+    niterations = pr->niterations;
+
+    pthread_barrier_destroy(&pr->barrier);
+    free(pr->next);
+    free(dangling);
+    free(pr);
+
+    return (niterations);
+}
+
+// Builds the transition matrix of PageRank from an adjacency matrix in
+// compressed sparse rows format, in which rows list out-neighbors.
+static struct sparse *pagerank_matrix(const struct sparse *adjacency)
+{
+    struct sparse *m = sparse_transpose(adjacency);
+
+    for (size_t k = 0; k < m->nnz; k++) {
+        const unsigned j = m->indices[k];
+        m->values[k] = 1.0 / (adjacency->offsets[j + 1] - adjacency->offsets[j]);
+    }
+
+    return (m);
+}
+
+//==============================================================================
+// Test
+//==============================================================================
+
+// Returns the current time in microseconds.
+static double now(void)
+{
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+
+    return (ts.tv_sec * 1000000.0 + ts.tv_nsec / 1000.0);
+}
+
+// Checks whether two vectors hold the same values.
+static bool vector_equal(const double *x, const double *y, size_t n)
+{
+    for (size_t i = 0; i < n; i++) {
+        if (fabs(x[i] - y[i]) > SPARSE_EPSILON) {
+            return (false);
+        }
+    }
+
+    return (true);
+}
+
+// Tests sparse matrix-vector multiplication against dense matrices.
+static void test_spmv(size_t nrows, size_t ncols, bool verbose)
+{
+    double *dense = NULL;
+    double *x = NULL;
+    double *expected = NULL;
+    double *y = NULL;
+    struct sparse *csr = NULL;
+    struct sparse *csc = NULL;
+    struct sparse *t = NULL;
+
+    assert((dense = malloc(nrows * ncols * sizeof(double))) != NULL);
+    assert((x = malloc(ncols * sizeof(double))) != NULL);
+    assert((expected = malloc(nrows * sizeof(double))) != NULL);
+    assert((y = malloc(nrows * sizeof(double))) != NULL);
+
+    // Initialize a matrix with about one tenth of non-zero elements.
+    for (size_t k = 0; k < nrows * ncols; k++) {
+        dense[k] = (rand() % 10 == 0) ? (double)rand() / RAND_MAX : 0.0;
+    }
+    for (size_t j = 0; j < ncols; j++) {
+        x[j] = (double)rand() / RAND_MAX;
+    }
+    for (size_t i = 0; i < nrows; i++) {
+        expected[i] = 0.0;
+        for (size_t j = 0; j < ncols; j++) {
+            expected[i] += dense[i * ncols + j] * x[j];
+        }
+    }
+
+    csr = sparse_from_dense(SPARSE_CSR, nrows, ncols, dense);
+    csc = sparse_from_dense(SPARSE_CSC, nrows, ncols, dense);
+    if (verbose) {
+        sparse_print(csr, stdout);
+        sparse_print(csc, stdout);
+    }
+
+    // Both formats.
+    for (size_t nthreads = 1; nthreads <= SPARSE_MAX_THREADS; nthreads *= 2) {
+        spmv(csr, x, y, nthreads);
+        assert(vector_equal(y, expected, nrows));
+    }
+    spmv(csc, x, y, 1);
+    assert(vector_equal(y, expected, nrows));
+
+    // Conversions.
+    t = sparse_convert(csr);
+    assert(t->format == SPARSE_CSC);
+    assert(!memcmp(t->offsets, csc->offsets, (ncols + 1) * sizeof(size_t)));
+    assert(!memcmp(t->indices, csc->indices, csc->nnz * sizeof(unsigned)));
+    spmv(t, x, y, 1);
+    assert(vector_equal(y, expected, nrows));
+    sparse_destroy(t);
+    t = sparse_convert(csc);
+    assert(t->format == SPARSE_CSR);
+    assert(!memcmp(t->indices, csr->indices, csr->nnz * sizeof(unsigned)));
+    spmv(t, x, y, SPARSE_MAX_THREADS);
+    assert(vector_equal(y, expected, nrows));
+    sparse_destroy(t);
+
+    printf("SpMV: %zu x %zu matrix, %zu non-zero elements, ok\n", nrows, ncols, csr->nnz);
+
+    // Release resources.
+    sparse_destroy(csc);
+    sparse_destroy(csr);
+    free(y);
+    free(expected);
+    free(x);
+    free(dense);
+}
+
+// Builds the adjacency matrix of a random graph. Sources and targets of
+// links are skewed towards a few nodes, and then nodes are shuffled, so that
+// popular nodes are spread over memory.
+static struct sparse *test_graph(size_t nnodes)
+{
+    const size_t nedges = nnodes * GRAPH_DEGREE;
+    unsigned *sources = NULL;
+    unsigned *targets = NULL;
+    unsigned *names = NULL;
+    double *values = NULL;
+    struct sparse *a = NULL;
+
+    assert((sources = malloc(nedges * sizeof(unsigned))) != NULL);
+    assert((targets = malloc(nedges * sizeof(unsigned))) != NULL);
+    assert((names = malloc(nnodes * sizeof(unsigned))) != NULL);
+    assert((values = malloc(nedges * sizeof(double))) != NULL);
+
+    for (size_t i = 0; i < nnodes; i++) {
+        names[i] = (unsigned)i;
+    }
+    for (size_t i = nnodes; i > 1; i--) {
+        const size_t j = (size_t)rand() % i;
+        const unsigned tmp = names[i - 1];
+        names[i - 1] = names[j];
+        names[j] = tmp;
+    }
+
+    for (size_t k = 0; k < nedges; k++) {
+        const double u = (double)rand() / ((double)RAND_MAX + 1.0);
+        const double v = (double)rand() / ((double)RAND_MAX + 1.0);
+        sources[k] = names[(size_t)(nnodes * pow(u, GRAPH_SKEW))];
+        targets[k] = names[(size_t)(nnodes * pow(v, GRAPH_SKEW))];
+        values[k] = 1.0;
+    }
+    a = sparse_from_elements(nnodes, nnodes, nedges, sources, targets, values);
+
+    free(values);
+    free(names);
+    free(targets);
+    free(sources);
+
+    return (a);
+}
+
+// Computes ranks of nodes with push-based PageRank, on a single thread.
+static void test_pagerank_reference(const struct sparse *a, double *ranks)
+{
+    const size_t n = a->nrows;
+    double *next = NULL;
+    double delta = 0.0;
+    size_t niterations = 0;
+
+    assert((next = malloc(n * sizeof(double))) != NULL);
+
+    for (size_t i = 0; i < n; i++) {
+        ranks[i] = 1.0 / n;
+    }
+    do {
+        double dangling = 0.0;
+        for (size_t i = 0; i < n; i++) {
+            if (a->offsets[i] == a->offsets[i + 1]) {
+                dangling += ranks[i];
+            }
+        }
+        for (size_t i = 0; i < n; i++) {
+            next[i] = (1.0 - PAGERANK_DAMPING) / n + PAGERANK_DAMPING * dangling / n;
+        }
+        for (size_t i = 0; i < n; i++) {
+            const size_t degree = a->offsets[i + 1] - a->offsets[i];
+            for (size_t k = a->offsets[i]; k < a->offsets[i + 1]; k++) {
+                next[a->indices[k]] += PAGERANK_DAMPING * ranks[i] / degree;
+            }
+        }
+        delta = 0.0;
+        for (size_t i = 0; i < n; i++) {
+            delta += fabs(next[i] - ranks[i]);
+            ranks[i] = next[i];
+        }
+    } while ((delta >= PAGERANK_TOLERANCE) && (++niterations < PAGERANK_MAX_ITERATIONS));
+
+    free(next);
+}
+
+// Benchmarks PageRank on a random graph, with each ordering of nodes.
+static void test_pagerank(size_t nnodes)
+{
+    const char *names[] = {"none", "degree", "rcm"};
+    const enum reorder_kind kinds[] = {REORDER_NONE, REORDER_DEGREE, REORDER_RCM};
+    struct sparse *a = test_graph(nnodes);
+    struct sparse *m = pagerank_matrix(a);
+    double *expected = NULL;
+    double *ranks = NULL;
+    double *reordered = NULL;
+    double sum = 0.0;
+
+    assert((expected = malloc(nnodes * sizeof(double))) != NULL);
+    assert((ranks = malloc(nnodes * sizeof(double))) != NULL);
+    assert((reordered = malloc(nnodes * sizeof(double))) != NULL);
+
+    printf("Graph: %zu nodes, %zu edges\n", a->nrows, a->nnz);
+    printf("SpMV: %.1lf to %.1lf bytes/edge\n", spmv_bytes(m, true) / m->nnz,
+           spmv_bytes(m, false) / m->nnz);
+
+    test_pagerank_reference(a, expected);
+    for (size_t i = 0; i < nnodes; i++) {
+        sum += expected[i];
+    }
+    assert(fabs(sum - 1.0) < SPARSE_EPSILON);
+
+    for (size_t r = 0; r < sizeof(kinds) / sizeof(kinds[0]); r++) {
+        double tstart = now();
+        unsigned *perm = reorder(m, kinds[r]);
+        struct sparse *p = sparse_permute(m, perm);
+        double tend = now();
+        printf("Reordering (%s): %2.lf us\n", names[r], tend - tstart);
+
+        for (size_t nthreads = 1; nthreads <= SPARSE_MAX_THREADS; nthreads *= SPARSE_MAX_THREADS) {
+            tstart = now();
+            const size_t niterations = pagerank(p, reordered, nthreads);
+            tend = now();
+
+            // Ranks of reordered nodes are the same.
+            for (size_t i = 0; i < nnodes; i++) {
+                ranks[perm[i]] = reordered[i];
+            }
+            assert(vector_equal(ranks, expected, nnodes));
+
+            const double seconds = (tend - tstart) / 1000000.0;
+            printf("PageRank (%s, %zu threads): %zu iterations, %.1lf iterations/s, %.2lf GB/s\n",
+                   names[r], nthreads, niterations, niterations / seconds,
+                   niterations * spmv_bytes(p, true) / seconds / 1e9);
+        }
+
+        sparse_destroy(p);
+        free(perm);
+    }
+
+    // Release resources.
+    free(reordered);
+    free(ranks);
+    free(expected);
+    sparse_destroy(m);
+    sparse_destroy(a);
+}
+
+// Tests sparse matrices.
+static void test(size_t nnodes, bool verbose)
+{
+    // Fix random number generator seed
+    // to have a determinist behavior across runs.
+    srand(0);
+
+    test_spmv(SPARSE_CHECK_SIZE, SPARSE_CHECK_SIZE / 2, verbose);
+    test_pagerank(nnodes);
+}
+
+//==============================================================================
+// Usage
+//==============================================================================
+
+// Prints program usage and exits.
+static void usage(char *const argv[])
+{
+    printf("%s - Testing program for sparse matrices.\n", argv[0]);
+    printf("Usage: %s [--verbose] <num_nodes>\n", argv[0]);
+    exit(EXIT_FAILURE);
+}
+
+//==============================================================================
+// Main
+//==============================================================================
+
+// Drives the test function.
+int main(int argc, char *const argv[])
+{
+    size_t nnodes = 0;
+    bool verbose = false;
+
+    // Check for missing arguments.
+    if ((argc < 2) || (argc > 3)) {
+        printf("Error: invalid number of arguments.\n");
+        usage(argv);
+    }
+
+    // Parse command line arguments.
+    if (argc == 2) {
+        sscanf(argv[1], "%zu", &nnodes);
+    } else if ((argc == 3) && (!strcmp(argv[1], "--verbose"))) {
+        sscanf(argv[2], "%zu", &nnodes);
+        verbose = true;
+    } else {
+        printf("Error: invalid arguments.\n");
+        usage(argv);
+    }
+
+    // Check for invalid arguments.
+    if (nnodes == 0) {
+        printf("Error: number of nodes must be positive.\n");
+        usage(argv);
+    }
+
+    // Run it!
+    test(nnodes, verbose);
+
+    return (EXIT_SUCCESS);
+}
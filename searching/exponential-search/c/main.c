@@ -8,9 +8,25 @@
 #include <string.h>
 #include <time.h>
 
+#if defined(__AVX2__) || defined(__SSE2__)
+#include <immintrin.h>
+#endif
+
 // Type of elements that are stored in the array.
 typedef int type_t;
 
+// Vectorized kernels compare 32-bit keys.
+_Static_assert(sizeof(type_t) == 4, "vectorized kernels require 32-bit keys");
+
+// Number of keys compared by each vectorized step.
+#define BLOCK_SIZE 8
+
+// Size ratio above which intersections switch from block compares to galloping.
+#define GALLOP_RATIO 32
+
+// Number of lists in the k-way intersection benchmark.
+#define NLISTS 6
+
 // Compares two elements.
 static int cmp(const void *x, const void *y)
 {
@@ -54,6 +70,293 @@ static size_t exponential_search(const type_t array[], size_t length, type_t ele
     return binary_search(array, bound / 2, (bound < length) ? bound + 1 : length, element);
 }
 
+// Searches for the first element that is not less than a given one, galloping
+// from a starting position. The cost depends on the distance to the answer,
+// not on the length of the array.
+static size_t gallop(const type_t array[], size_t low, size_t length, type_t element)
+{
+    size_t bound = 1;
+    size_t high = 0;
+
+    // Probe positions low + 1, low + 2, low + 4, ... until we overshoot.
+    while ((low + bound < length) && (array[low + bound] < element)) {
+        bound *= 2;
+    }
+    high = (low + bound < length) ? low + bound + 1 : length;
+    low = low + bound / 2;
+
+    // Lower bound on the bracketed range.
+    while (low < high) {
+        size_t mid = low + (high - low) / 2;
+        if (array[mid] < element) {
+            low = mid + 1;
+        } else {
+            high = mid;
+        }
+    }
+
+    return (low);
+}
+
+//==============================================================================
+// Vector Primitives
+//==============================================================================
+
+#if defined(__AVX2__)
+
+// A vector of keys.
+typedef __m256i vkey_t;
+
+// Broadcasts a key to all lanes of a vector.
+static inline vkey_t vkey_broadcast(type_t key)
+{
+    return (_mm256_set1_epi32(key));
+}
+
+// Returns a bitmask of the keys in a block that match a broadcast key.
+static inline unsigned vkey_match(const type_t block[], vkey_t key)
+{
+    __m256i keys = _mm256_loadu_si256((const __m256i *)block);
+    __m256i eq = _mm256_cmpeq_epi32(keys, key);
+
+    return ((unsigned)_mm256_movemask_ps(_mm256_castsi256_ps(eq)));
+}
+
+#elif defined(__SSE2__)
+
+// A vector of keys.
+typedef __m128i vkey_t;
+
+// Broadcasts a key to all lanes of a vector.
+static inline vkey_t vkey_broadcast(type_t key)
+{
+    return (_mm_set1_epi32(key));
+}
+
+// Returns a bitmask of the keys in a block that match a broadcast key.
+static inline unsigned vkey_match(const type_t block[], vkey_t key)
+{
+    __m128i lo = _mm_cmpeq_epi32(_mm_loadu_si128((const __m128i *)&block[0]), key);
+    __m128i hi = _mm_cmpeq_epi32(_mm_loadu_si128((const __m128i *)&block[4]), key);
+
+    return ((unsigned)_mm_movemask_ps(_mm_castsi128_ps(lo)) |
+            ((unsigned)_mm_movemask_ps(_mm_castsi128_ps(hi)) << 4));
+}
+
+#else
+
+// A vector of keys.
+typedef type_t vkey_t;
+
+// Broadcasts a key to all lanes of a vector.
+static inline vkey_t vkey_broadcast(type_t key)
+{
+    return (key);
+}
+
+// Returns a bitmask of the keys in a block that match a broadcast key.
+static inline unsigned vkey_match(const type_t block[], vkey_t key)
+{
+    unsigned mask = 0;
+
+    for (size_t i = 0; i < BLOCK_SIZE; i++) {
+        mask |= (unsigned)(block[i] == key) << i;
+    }
+
+    return (mask);
+}
+
+#endif
+
+//==============================================================================
+// Set Operations
+//==============================================================================
+
+// Intersects two sorted lists of distinct elements using a linear merge.
+static size_t intersect_merge(const type_t a[], size_t na, const type_t b[], size_t nb,
+                              type_t out[])
+{
+    size_t i = 0;
+    size_t j = 0;
+    size_t n = 0;
+
+    while ((i < na) && (j < nb)) {
+        if (a[i] < b[j]) {
+            i++;
+        } else if (b[j] < a[i]) {
+            j++;
+        } else {
+            out[n++] = a[i];
+            i++;
+            j++;
+        }
+    }
+
+    return (n);
+}
+
+// Intersects two sorted lists of distinct elements by galloping over the longer one.
+static size_t intersect_gallop(const type_t a[], size_t na, const type_t b[], size_t nb,
+                               type_t out[])
+{
+    size_t j = 0;
+    size_t n = 0;
+
+    // Ensure that the first list is the shorter one.
+    if (na > nb) {
+        return (intersect_gallop(b, nb, a, na, out));
+    }
+
+    for (size_t i = 0; (i < na) && (j < nb); i++) {
+        j = gallop(b, j, nb, a[i]);
+        if ((j < nb) && (b[j] == a[i])) {
+            out[n++] = a[i];
+            j++;
+        }
+    }
+
+    return (n);
+}
+
+// Intersects two sorted lists of distinct elements using block compares.
+static size_t intersect_simd(const type_t a[], size_t na, const type_t b[], size_t nb,
+                             type_t out[])
+{
+    size_t i = 0;
+    size_t j = 0;
+    size_t n = 0;
+
+    while ((i < na) && (j + BLOCK_SIZE <= nb)) {
+        // Skip blocks that are entirely smaller than the current element.
+        if (b[j + BLOCK_SIZE - 1] < a[i]) {
+            j += BLOCK_SIZE;
+            continue;
+        }
+
+        // Compare the current element against the whole block.
+        if (vkey_match(&b[j], vkey_broadcast(a[i])) != 0) {
+            out[n++] = a[i];
+        }
+        i++;
+    }
+
+    // Merge the remaining elements.
+    return (n + intersect_merge(&a[i], na - i, &b[j], nb - j, &out[n]));
+}
+
+// Intersects two sorted lists of distinct elements, picking a strategy by their sizes.
+static size_t intersect(const type_t a[], size_t na, const type_t b[], size_t nb, type_t out[])
+{
+    size_t shorter = (na < nb) ? na : nb;
+    size_t longer = (na < nb) ? nb : na;
+
+    if (longer / GALLOP_RATIO > shorter) {
+        return (intersect_gallop(a, na, b, nb, out));
+    }
+
+    return (intersect_simd(a, na, b, nb, out));
+}
+
+// Intersects several sorted lists of distinct elements, from the shortest to the longest.
+// The output array must be large enough to hold the shortest list.
+static size_t intersect_many(type_t *const lists[], const size_t lengths[], size_t nlists,
+                             type_t out[])
+{
+    size_t n = 0;
+    size_t *order = NULL;
+
+    assert(nlists > 0);
+    assert((order = malloc(nlists * sizeof(size_t))) != NULL);
+
+    // Sort lists by length.
+    for (size_t i = 0; i < nlists; i++) {
+        size_t j = i;
+        while ((j > 0) && (lengths[order[j - 1]] > lengths[i])) {
+            order[j] = order[j - 1];
+            j--;
+        }
+        order[j] = i;
+    }
+
+    // Candidates are the shortest list. Each pass can only shrink them, so the
+    // intersection can be computed in place.
+    n = lengths[order[0]];
+    memmove(out, lists[order[0]], n * sizeof(type_t));
+    for (size_t i = 1; (i < nlists) && (n > 0); i++) {
+        n = intersect(out, n, lists[order[i]], lengths[order[i]], out);
+    }
+
+    free(order);
+
+    return (n);
+}
+
+// Unites two sorted lists of distinct elements using a linear merge.
+static size_t union_merge(const type_t a[], size_t na, const type_t b[], size_t nb, type_t out[])
+{
+    size_t i = 0;
+    size_t j = 0;
+    size_t n = 0;
+
+    while ((i < na) && (j < nb)) {
+        if (a[i] < b[j]) {
+            out[n++] = a[i++];
+        } else if (b[j] < a[i]) {
+            out[n++] = b[j++];
+        } else {
+            out[n++] = a[i];
+            i++;
+            j++;
+        }
+    }
+
+    // Copy the remaining elements.
+    while (i < na) {
+        out[n++] = a[i++];
+    }
+    while (j < nb) {
+        out[n++] = b[j++];
+    }
+
+    return (n);
+}
+
+// Unites two sorted lists of distinct elements, galloping over runs of either list.
+static size_t union_gallop(const type_t a[], size_t na, const type_t b[], size_t nb, type_t out[])
+{
+    size_t i = 0;
+    size_t j = 0;
+    size_t n = 0;
+
+    while ((i < na) && (j < nb)) {
+        if (a[i] < b[j]) {
+            // Copy the run of the first list that precedes the head of the second one.
+            size_t k = gallop(a, i, na, b[j]);
+            memcpy(&out[n], &a[i], (k - i) * sizeof(type_t));
+            n += k - i;
+            i = k;
+        } else if (b[j] < a[i]) {
+            // Copy the run of the second list that precedes the head of the first one.
+            size_t k = gallop(b, j, nb, a[i]);
+            memcpy(&out[n], &b[j], (k - j) * sizeof(type_t));
+            n += k - j;
+            j = k;
+        } else {
+            out[n++] = a[i];
+            i++;
+            j++;
+        }
+    }
+
+    // Copy the remaining elements.
+    memcpy(&out[n], &a[i], (na - i) * sizeof(type_t));
+    n += na - i;
+    memcpy(&out[n], &b[j], (nb - j) * sizeof(type_t));
+    n += nb - j;
+
+    return (n);
+}
+
 // Initializes an array.
 static void initialize_array(type_t array[], size_t length)
 {
@@ -62,6 +365,124 @@ static void initialize_array(type_t array[], size_t length)
     }
 }
 
+// Initializes a sorted list of distinct elements, with a given average gap.
+static void initialize_list(type_t list[], size_t length, size_t gap)
+{
+    type_t x = 0;
+
+    for (size_t i = 0; i < length; i++) {
+        x += 1 + (type_t)((size_t)rand() % (2 * gap - 1));
+        list[i] = x;
+    }
+}
+
+// Benchmarks a set operation on two lists.
+static double benchmark(size_t (*op)(const type_t[], size_t, const type_t[], size_t, type_t[]),
+                        const type_t a[], size_t na, const type_t b[], size_t nb, type_t out[],
+                        size_t *n)
+{
+    double tstart = 0.0;
+    double tend = 0.0;
+    const double MICROSECS = ((CLOCKS_PER_SEC / 1000000.0));
+
+    tstart = clock();
+    *n = op(a, na, b, nb, out);
+    tend = clock();
+
+    return ((tend - tstart) / MICROSECS);
+}
+
+// Tests set operations on sorted lists of different sizes.
+static void test_set_operations(size_t length, bool verbose)
+{
+    size_t n[2];
+    double tstart = 0.0;
+    double tend = 0.0;
+    const double MICROSECS = ((CLOCKS_PER_SEC / 1000000.0));
+    type_t *big = NULL;
+    type_t *small = NULL;
+    type_t *out[2] = {NULL, NULL};
+    type_t *lists[NLISTS];
+    size_t lengths[NLISTS];
+
+    // Allocate lists.
+    big = malloc(length * sizeof(type_t));
+    assert(big != NULL);
+    small = malloc(length * sizeof(type_t));
+    assert(small != NULL);
+    for (size_t i = 0; i < 2; i++) {
+        out[i] = malloc(2 * length * sizeof(type_t));
+        assert(out[i] != NULL);
+    }
+
+    initialize_list(big, length, 4);
+
+    printf("%8s %12s %12s %12s %12s %12s\n", "ratio", "merge", "gallop", "simd", "union-merge",
+           "union-gallop");
+
+    // Sweep size ratios from 1:1 to 1:10^5.
+    for (size_t ratio = 1; (ratio <= 100000) && (length / ratio > 0); ratio *= 10) {
+        size_t nsmall = length / ratio;
+        double t[5];
+        char label[32];
+
+        initialize_list(small, nsmall, 4 * ratio);
+
+        // Intersections must all agree.
+        t[0] = benchmark(intersect_merge, small, nsmall, big, length, out[0], &n[0]);
+        t[1] = benchmark(intersect_gallop, small, nsmall, big, length, out[1], &n[1]);
+        assert((n[0] == n[1]) && !memcmp(out[0], out[1], n[0] * sizeof(type_t)));
+        t[2] = benchmark(intersect_simd, small, nsmall, big, length, out[1], &n[1]);
+        assert((n[0] == n[1]) && !memcmp(out[0], out[1], n[0] * sizeof(type_t)));
+
+        if (verbose) {
+            printf("Intersection 1:%zu: %zu elements\n", ratio, n[0]);
+        }
+
+        // Unions must all agree.
+        t[3] = benchmark(union_merge, small, nsmall, big, length, out[0], &n[0]);
+        t[4] = benchmark(union_gallop, small, nsmall, big, length, out[1], &n[1]);
+        assert((n[0] == n[1]) && !memcmp(out[0], out[1], n[0] * sizeof(type_t)));
+
+        snprintf(label, sizeof(label), "1:%zu", ratio);
+        printf("%8s %9.lf us %9.lf us %9.lf us %9.lf us %9.lf us\n", label, t[0], t[1], t[2],
+               t[3], t[4]);
+    }
+
+    // Intersect several lists at once.
+    for (size_t i = 0; i < NLISTS; i++) {
+        lengths[i] = length >> (3 * i);
+        lengths[i] = (lengths[i] > 0) ? lengths[i] : 1;
+        lists[i] = malloc(lengths[i] * sizeof(type_t));
+        assert(lists[i] != NULL);
+        initialize_list(lists[i], lengths[i], (size_t)1 << (3 * i));
+    }
+    tstart = clock();
+    n[1] = intersect_many(lists, lengths, NLISTS, out[1]);
+    tend = clock();
+
+    // Check against chained linear merges.
+    n[0] = lengths[0];
+    memcpy(out[0], lists[0], n[0] * sizeof(type_t));
+    for (size_t i = 1; i < NLISTS; i++) {
+        n[0] = intersect_merge(out[0], n[0], lists[i], lengths[i], out[0]);
+    }
+    assert((n[0] == n[1]) && !memcmp(out[0], out[1], n[0] * sizeof(type_t)));
+
+    printf("%d-way Intersection: %2.lf us, %zu elements\n", NLISTS, (tend - tstart) / MICROSECS,
+           n[1]);
+
+    // Release lists.
+    for (size_t i = 0; i < NLISTS; i++) {
+        free(lists[i]);
+    }
+    for (size_t i = 0; i < 2; i++) {
+        free(out[i]);
+    }
+    free(small);
+    free(big);
+}
+
 // Tests Exponential Search.
 static void test(size_t length, bool verbose)
 {
@@ -106,6 +527,9 @@ static void test(size_t length, bool verbose)
 
     // Release array.
     free(array);
+
+    // Test set operations built on top of it.
+    test_set_operations(length, verbose);
 }
 
 // Prints program usage and exits.
@@ -1,8 +1,11 @@
 // Copyright (C) 2023 Pedro Henrique Penna <pedrohenriquepenna@outlook.com>
 
 #include <assert.h>
+#include <limits.h>
+#include <math.h>
 #include <stdbool.h>
 #include <stddef.h>
+#include <stdint.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
@@ -11,21 +14,78 @@
 // Type of elements that are stored in the array.
 typedef int type_t;
 
+// Maximum error (in positions) of a learned index prediction.
+#define PGM_EPSILON 32
+
+// Maximum number of levels in a learned index.
+#define PGM_MAX_LEVELS 16
+
+// Number of lookups issued in each benchmark.
+#define NLOOKUPS 100000
+
+// A linear segment of a learned index.
+struct segment {
+    type_t key;   // First key covered by the segment.
+    size_t first; // Position of the first key covered by the segment.
+    double slope; // Slope of the segment.
+};
+
+// A learned index (Piecewise Geometric Model).
+struct pgm_index {
+    size_t epsilon;                           // Maximum prediction error.
+    size_t nlevels;                           // Number of levels.
+    size_t nsegments[PGM_MAX_LEVELS];         // Segments on each level.
+    struct segment *segments[PGM_MAX_LEVELS]; // Segments of each level.
+};
+
 // Compares two elements.
 static int cmp(const void *x, const void *y)
 {
     return (*((const type_t *)x) - *((const type_t *)y));
 }
 
+// Searches for an element in a sorted range using Binary Search.
+static size_t binary_search(const type_t array[], size_t low, size_t high, type_t element)
+{
+    while (low < high) {
+        size_t mid = low + (high - low) / 2;
+
+        // Found.
+        if (array[mid] == element) {
+            return mid;
+        }
+
+        // Search on the left sub-array.
+        else if (element < array[mid]) {
+            high = mid;
+        }
+        // Search on the right sub-array.
+        else {
+            low = mid + 1;
+        }
+    }
+
+    // Not found.
+    return ((size_t)-1);
+}
+
 // Searches for an element in a sorted array using Interpolation Search.
 static size_t interpolation_search(const type_t array[], size_t length, type_t element)
 {
     size_t low = 0;
     size_t high = length;
 
-    while (low < high) {
-        // Interpolate.
-        size_t mid = low + ((element - array[low]) * (high - low) / (array[high - 1] - array[low]));
+    while ((low < high) && (element >= array[low]) && (element <= array[high - 1])) {
+        // All elements in the range are equal.
+        if (array[high - 1] == array[low]) {
+            return (low);
+        }
+
+        // Interpolate. Differences are taken in 64-bit and the
+        // product in floating point, so that it cannot overflow.
+        double offset = (double)((int64_t)element - (int64_t)array[low]);
+        double range = (double)((int64_t)array[high - 1] - (int64_t)array[low]);
+        size_t mid = low + (size_t)(offset / range * (double)(high - 1 - low));
 
         // Found.
         if (array[mid] == element) {
@@ -46,58 +106,324 @@ static size_t interpolation_search(const type_t array[], size_t length, type_t e
     return ((size_t)-1);
 }
 
-// Initializes an array.
-static void initialize_array(type_t array[], size_t length)
+// Searches for an element in a sorted array using Exponential Search.
+static size_t exponential_search(const type_t array[], size_t length, type_t element)
+{
+    size_t bound = 1;
+
+    while ((bound < length) && (array[bound] < element)) {
+        bound *= 2;
+    }
+
+    return binary_search(array, bound / 2, (bound < length) ? bound + 1 : length, element);
+}
+
+// Builds one level of a learned index over the distinct keys of a sorted array.
+static size_t pgm_build_level(struct segment segments[], const type_t keys[], size_t length,
+                              size_t epsilon)
+{
+    size_t nsegments = 0;
+    double slope_low = 0.0;
+    double slope_high = INFINITY;
+
+    // Start the first segment.
+    segments[0].key = keys[0];
+    segments[0].first = 0;
+
+    for (size_t i = 1; i < length; i++) {
+        struct segment *s = &segments[nsegments];
+
+        // Skip duplicates, so that every key maps to its first occurrence.
+        if (keys[i] == keys[i - 1]) {
+            continue;
+        }
+
+        // Compute the range of slopes that keep this key within the error bound.
+        double dx = (double)((int64_t)keys[i] - (int64_t)s->key);
+        double low = ((double)i - (double)epsilon - (double)s->first) / dx;
+        double high = ((double)i + (double)epsilon - (double)s->first) / dx;
+
+        // Shrink the cone of feasible slopes.
+        if ((low <= slope_high) && (high >= slope_low)) {
+            slope_low = (low > slope_low) ? low : slope_low;
+            slope_high = (high < slope_high) ? high : slope_high;
+            continue;
+        }
+
+        // The cone is empty, so close the current segment and start a new one.
+        s->slope = isinf(slope_high) ? 0.0 : (slope_low + slope_high) / 2.0;
+        nsegments++;
+        segments[nsegments].key = keys[i];
+        segments[nsegments].first = i;
+        slope_low = 0.0;
+        slope_high = INFINITY;
+    }
+
+    // Close the last segment.
+    segments[nsegments].slope =
+        isinf(slope_high) ? 0.0 : (slope_low + slope_high) / 2.0;
+
+    return (nsegments + 1);
+}
+
+// Builds a learned index over a sorted array.
+static void pgm_build(struct pgm_index *pgm, const type_t array[], size_t length, size_t epsilon)
+{
+    type_t *keys = NULL;
+
+    assert(length > 0);
+
+    pgm->epsilon = epsilon;
+    pgm->nlevels = 0;
+
+    // Build the bottom level over the input array.
+    pgm->segments[0] = malloc(length * sizeof(struct segment));
+    assert(pgm->segments[0] != NULL);
+    pgm->nsegments[0] = pgm_build_level(pgm->segments[0], array, length, epsilon);
+    pgm->segments[0] = realloc(pgm->segments[0], pgm->nsegments[0] * sizeof(struct segment));
+    assert(pgm->segments[0] != NULL);
+    pgm->nlevels++;
+
+    // Recursively build upper levels over the first keys of the segments below.
+    keys = malloc(pgm->nsegments[0] * sizeof(type_t));
+    assert(keys != NULL);
+    while (pgm->nsegments[pgm->nlevels - 1] > 1) {
+        size_t level = pgm->nlevels;
+        size_t n = pgm->nsegments[level - 1];
+
+        assert(level < PGM_MAX_LEVELS);
+
+        for (size_t i = 0; i < n; i++) {
+            keys[i] = pgm->segments[level - 1][i].key;
+        }
+
+        pgm->segments[level] = malloc(n * sizeof(struct segment));
+        assert(pgm->segments[level] != NULL);
+        pgm->nsegments[level] = pgm_build_level(pgm->segments[level], keys, n, epsilon);
+        pgm->nlevels++;
+    }
+    free(keys);
+}
+
+// Releases a learned index.
+static void pgm_destroy(struct pgm_index *pgm)
+{
+    for (size_t i = 0; i < pgm->nlevels; i++) {
+        free(pgm->segments[i]);
+    }
+    pgm->nlevels = 0;
+}
+
+// Returns the size (in bytes) of a learned index.
+static size_t pgm_size(const struct pgm_index *pgm)
+{
+    size_t size = sizeof(struct pgm_index);
+
+    for (size_t i = 0; i < pgm->nlevels; i++) {
+        size += pgm->nsegments[i] * sizeof(struct segment);
+    }
+
+    return (size);
+}
+
+// Predicts the position of an element using the i-th segment of a level.
+static size_t pgm_predict(const struct segment segments[], size_t nsegments, size_t i,
+                          size_t length, type_t element)
+{
+    const struct segment *s = &segments[i];
+    double dx = (double)((int64_t)element - (int64_t)s->key);
+    size_t pos = s->first + (size_t)(s->slope * dx);
+    size_t limit = (i + 1 < nsegments) ? segments[i + 1].first : length - 1;
+
+    // Never predict past the first key of the next segment.
+    return ((pos < limit) ? pos : limit);
+}
+
+// Searches for an element in a sorted array using a learned index.
+static size_t pgm_search(const struct pgm_index *pgm, const type_t array[], size_t length,
+                         type_t element)
+{
+    size_t seg = 0;
+    size_t eps = pgm->epsilon + 1;
+
+    if ((length == 0) || (element < array[0])) {
+        return ((size_t)-1);
+    }
+
+    // Walk down the levels, finding the segment that covers the element.
+    for (size_t level = pgm->nlevels - 1; level > 0; level--) {
+        const struct segment *below = pgm->segments[level - 1];
+        size_t n = pgm->nsegments[level - 1];
+        size_t pos = pgm_predict(pgm->segments[level], pgm->nsegments[level], seg, n, element);
+        size_t low = (pos > eps) ? pos - eps : 0;
+        size_t high = (pos + eps + 1 < n) ? pos + eps + 1 : n;
+
+        // Bounded search for the last segment whose first key is not greater than the element.
+        while (low + 1 < high) {
+            size_t mid = low + (high - low) / 2;
+            if (below[mid].key <= element) {
+                low = mid;
+            } else {
+                high = mid;
+            }
+        }
+        seg = low;
+    }
+
+    // Bounded search on the input array.
+    size_t pos = pgm_predict(pgm->segments[0], pgm->nsegments[0], seg, length, element);
+    size_t low = (pos > eps) ? pos - eps : 0;
+    size_t high = (pos + eps + 1 < length) ? pos + eps + 1 : length;
+
+    return (binary_search(array, low, high, element));
+}
+
+// Samples a standard normal distribution using the Box-Muller transform.
+static double normal(void)
+{
+    double u1 = (rand() + 1.0) / (RAND_MAX + 2.0);
+    double u2 = (rand() + 1.0) / (RAND_MAX + 2.0);
+
+    return (sqrt(-2.0 * log(u1)) * cos(2.0 * 3.14159265358979323846 * u2));
+}
+
+// Initializes an array with uniformly distributed keys.
+static void initialize_uniform(type_t array[], size_t length)
+{
+    for (size_t i = 0; i < length; i++) {
+        array[i] = (type_t)rand();
+    }
+}
+
+// Initializes an array with log-normally distributed keys.
+static void initialize_lognormal(type_t array[], size_t length)
 {
     for (size_t i = 0; i < length; i++) {
-        array[i] = (type_t)(rand() % length);
+        double x = exp(1.5 * normal()) * 100000.0;
+        array[i] = (x < (double)INT_MAX) ? (type_t)x : INT_MAX;
     }
 }
 
+// Initializes an array with bursty keys, resembling event timestamps.
+static void initialize_timestamps(type_t array[], size_t length)
+{
+    int64_t t = 0;
+
+    for (size_t i = 0; i < length; i++) {
+        // Most events come in bursts, with a few long gaps.
+        t += ((rand() % 100) < 95) ? (rand() % 4) : (rand() % 10000);
+        array[i] = (t < INT_MAX) ? (type_t)t : INT_MAX;
+    }
+}
+
+// Benchmarks a search function.
+static void benchmark(const char *name, size_t (*search)(const type_t[], size_t, type_t),
+                      const type_t array[], size_t length, const type_t keys[])
+{
+    double tstart = 0.0;
+    double tend = 0.0;
+    const double MICROSECS = ((CLOCKS_PER_SEC / 1000000.0));
+
+    tstart = clock();
+    for (size_t i = 0; i < NLOOKUPS; i++) {
+        size_t found_key = search(array, length, keys[i]);
+
+        // Check if we found the given key.
+        assert(found_key != (size_t)-1);
+        assert(array[found_key] == keys[i]);
+        ((void)found_key);
+    }
+    tend = clock();
+
+    printf("  %-22s %8.2lf ns/lookup\n", name,
+           ((tend - tstart) / MICROSECS) * 1000.0 / NLOOKUPS);
+}
+
+// Learned index used by the benchmark.
+static struct pgm_index learned_index;
+
+// Searches for an element using the benchmark's learned index.
+static size_t learned_search(const type_t array[], size_t length, type_t element)
+{
+    return (pgm_search(&learned_index, array, length, element));
+}
+
+// Wraps Binary Search to the benchmark interface.
+static size_t full_binary_search(const type_t array[], size_t length, type_t element)
+{
+    return (binary_search(array, 0, length, element));
+}
+
 // Tests Interpolation Search.
 static void test(size_t length, bool verbose)
 {
+    type_t *array = NULL;
+    type_t *keys = NULL;
     double tstart = 0.0;
     double tend = 0.0;
-    type_t *array = NULL;
     const double MICROSECS = ((CLOCKS_PER_SEC / 1000000.0));
-    size_t found_key = (size_t)-1;
-    size_t search_key = 1;
+    const struct {
+        const char *name;
+        void (*initialize)(type_t[], size_t);
+    } datasets[] = {
+        {"uniform", initialize_uniform},
+        {"lognormal", initialize_lognormal},
+        {"timestamps", initialize_timestamps},
+    };
 
     // Fix random number generator seed
     // to have a determinist behavior across runs.
     srand(0);
 
-    // Allocate an initialize array.
+    // Allocate arrays.
     array = malloc(length * sizeof(type_t));
     assert(array != NULL);
-    initialize_array(array, length);
+    keys = malloc(NLOOKUPS * sizeof(type_t));
+    assert(keys != NULL);
 
-    // Pickup a key within the range.
-    search_key = (size_t)rand() % length;
+    for (size_t d = 0; d < sizeof(datasets) / sizeof(datasets[0]); d++) {
+        // Initialize array.
+        datasets[d].initialize(array, length);
+        qsort(array, length, sizeof(type_t), cmp);
 
-    qsort(array, length, sizeof(type_t), cmp);
+        // Pickup keys within the range.
+        for (size_t i = 0; i < NLOOKUPS; i++) {
+            keys[i] = array[(size_t)rand() % length];
+        }
 
-    if (verbose) {
-        printf("Search: key = %d, value = %d\n", search_key, array[search_key]);
-    }
+        // Build learned index.
+        tstart = clock();
+        pgm_build(&learned_index, array, length, PGM_EPSILON);
+        tend = clock();
 
-    // Search in the array.
-    tstart = clock();
-    found_key = interpolation_search(array, length, array[search_key]);
-    tend = clock();
+        printf("Dataset: %s\n", datasets[d].name);
+        printf("  Learned Index Build: %2.lf us, %zu levels, %zu segments, %zu bytes\n",
+               (tend - tstart) / MICROSECS, learned_index.nlevels, learned_index.nsegments[0],
+               pgm_size(&learned_index));
+
+        if (verbose) {
+            for (size_t i = 0; i < learned_index.nlevels; i++) {
+                printf("  Level %zu: %zu segments\n", i, learned_index.nsegments[i]);
+            }
+        }
 
-    // Report time.
-    printf("Interpolation Search: %2.lf us\n", (tend - tstart) / MICROSECS);
+        // Search in the array.
+        benchmark("Binary Search:", full_binary_search, array, length, keys);
+        benchmark("Interpolation Search:", interpolation_search, array, length, keys);
+        benchmark("Exponential Search:", exponential_search, array, length, keys);
+        benchmark("Learned Index Search:", learned_search, array, length, keys);
 
-    // Check if we found the given key.
-    assert(found_key != (size_t)-1);
+        // Check that absent keys are not found.
+        if (array[length - 1] < INT_MAX) {
+            assert(learned_search(array, length, array[length - 1] + 1) == (size_t)-1);
+            assert(interpolation_search(array, length, array[length - 1] + 1) == (size_t)-1);
+        }
 
-    if (verbose) {
-        printf("Output: %s\n", (found_key != (size_t)-1) ? "found" : "not found");
+        pgm_destroy(&learned_index);
     }
 
-    // Release array.
+    // Release arrays.
+    free(keys);
     free(array);
 }
 
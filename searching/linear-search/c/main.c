@@ -3,14 +3,110 @@
 #include <assert.h>
 #include <stdbool.h>
 #include <stddef.h>
+#include <stdint.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
 #include <time.h>
+#include <unistd.h>
+
+#if defined(__AVX2__) || defined(__SSE2__)
+#include <immintrin.h>
+#endif
 
 // Type of elements that are stored in the array.
 typedef int type_t;
 
+// Vectorized kernels compare 32-bit keys.
+_Static_assert(sizeof(type_t) == 4, "vectorized kernels require 32-bit keys");
+
+// Number of keys compared by each vectorized step.
+#define BLOCK_SIZE 8
+
+// Number of lookups issued in each benchmark.
+#define NLOOKUPS 1000000
+
+// Array length above which benchmarks issue proportionally fewer lookups, so
+// that each one scans about the same number of keys.
+#define NLOOKUPS_MAX_LENGTH 1024
+
+// Cache size assumed when the system does not report it.
+#define DEFAULT_CACHE_SIZE (1 << 20)
+
+//==============================================================================
+// Vector Primitives
+//==============================================================================
+
+#if defined(__AVX2__)
+
+// A vector of keys.
+typedef __m256i vkey_t;
+
+// Broadcasts a key to all lanes of a vector.
+static inline vkey_t vkey_broadcast(type_t key)
+{
+    return (_mm256_set1_epi32(key));
+}
+
+// Returns a bitmask of the keys in a block that match a broadcast key.
+static inline unsigned vkey_match(const type_t block[], vkey_t key)
+{
+    __m256i keys = _mm256_loadu_si256((const __m256i *)block);
+    __m256i eq = _mm256_cmpeq_epi32(keys, key);
+
+    return ((unsigned)_mm256_movemask_ps(_mm256_castsi256_ps(eq)));
+}
+
+#elif defined(__SSE2__)
+
+// A vector of keys.
+typedef __m128i vkey_t;
+
+// Broadcasts a key to all lanes of a vector.
+static inline vkey_t vkey_broadcast(type_t key)
+{
+    return (_mm_set1_epi32(key));
+}
+
+// Returns a bitmask of the keys in a block that match a broadcast key.
+static inline unsigned vkey_match(const type_t block[], vkey_t key)
+{
+    __m128i lo = _mm_cmpeq_epi32(_mm_loadu_si128((const __m128i *)&block[0]), key);
+    __m128i hi = _mm_cmpeq_epi32(_mm_loadu_si128((const __m128i *)&block[4]), key);
+
+    return ((unsigned)_mm_movemask_ps(_mm_castsi128_ps(lo)) |
+            ((unsigned)_mm_movemask_ps(_mm_castsi128_ps(hi)) << 4));
+}
+
+#else
+
+// A vector of keys.
+typedef type_t vkey_t;
+
+// Broadcasts a key to all lanes of a vector.
+static inline vkey_t vkey_broadcast(type_t key)
+{
+    return (key);
+}
+
+// Returns a bitmask of the keys in a block that match a broadcast key.
+static inline unsigned vkey_match(const type_t block[], vkey_t key)
+{
+    unsigned mask = 0;
+
+    for (size_t i = 0; i < BLOCK_SIZE; i++) {
+        mask |= (unsigned)(block[i] == key) << i;
+    }
+
+    return (mask);
+}
+
+#endif
+
+//==============================================================================
+// Search Kernels
+//==============================================================================
+
 // Searches for an element in an array using Linear Search.
 static size_t linear_search(const type_t array[], size_t length, type_t element)
 {
@@ -25,6 +121,135 @@ static size_t linear_search(const type_t array[], size_t length, type_t element)
     return ((size_t)-1);
 }
 
+// Searches for an element in an array using vectorized Linear Search.
+static size_t linear_search_simd(const type_t array[], size_t length, type_t element)
+{
+    size_t i = 0;
+    vkey_t key = vkey_broadcast(element);
+
+    // Compare a block of keys at a time, and stop at the first match.
+    for (; i + BLOCK_SIZE <= length; i += BLOCK_SIZE) {
+        unsigned mask = vkey_match(&array[i], key);
+        if (mask != 0) {
+            return (i + (size_t)__builtin_ctz(mask));
+        }
+    }
+
+    // Search in the remaining keys.
+    for (; i < length; i++) {
+        if (array[i] == element) {
+            return (i);
+        }
+    }
+
+    return ((size_t)-1);
+}
+
+// Finds all occurrences of an element in an array, and marks them in a bitmap.
+static void linear_search_bitmap(const type_t array[], size_t length, type_t element,
+                                 uint64_t bitmap[])
+{
+    size_t i = 0;
+    vkey_t key = vkey_broadcast(element);
+
+    memset(bitmap, 0, ((length + 63) / 64) * sizeof(uint64_t));
+
+    // Blocks are aligned to a byte within a word of the bitmap.
+    for (; i + BLOCK_SIZE <= length; i += BLOCK_SIZE) {
+        uint64_t mask = vkey_match(&array[i], key);
+        bitmap[i / 64] |= mask << (i % 64);
+    }
+
+    for (; i < length; i++) {
+        bitmap[i / 64] |= (uint64_t)(array[i] == element) << (i % 64);
+    }
+}
+
+// Counts the occurrences of an element in an array.
+static size_t linear_search_count(const type_t array[], size_t length, type_t element)
+{
+    size_t i = 0;
+    size_t count = 0;
+    vkey_t key = vkey_broadcast(element);
+
+    for (; i + BLOCK_SIZE <= length; i += BLOCK_SIZE) {
+        count += (size_t)__builtin_popcount(vkey_match(&array[i], key));
+    }
+
+    for (; i < length; i++) {
+        count += (array[i] == element);
+    }
+
+    return (count);
+}
+
+// Searches for multiple elements in an array in a single pass.
+static void linear_search_multi(const type_t array[], size_t length, const type_t elements[],
+                                size_t nelements, size_t indexes[])
+{
+    size_t i = 0;
+    size_t remaining = nelements;
+
+    for (size_t j = 0; j < nelements; j++) {
+        indexes[j] = (size_t)-1;
+    }
+
+    // Load each block of keys once, and compare it against all pending elements.
+    for (; (i + BLOCK_SIZE <= length) && (remaining > 0); i += BLOCK_SIZE) {
+        for (size_t j = 0; j < nelements; j++) {
+            if (indexes[j] == (size_t)-1) {
+                unsigned mask = vkey_match(&array[i], vkey_broadcast(elements[j]));
+                if (mask != 0) {
+                    indexes[j] = i + (size_t)__builtin_ctz(mask);
+                    remaining--;
+                }
+            }
+        }
+    }
+
+    // Search in the remaining keys.
+    for (; (i < length) && (remaining > 0); i++) {
+        for (size_t j = 0; j < nelements; j++) {
+            if ((indexes[j] == (size_t)-1) && (array[i] == elements[j])) {
+                indexes[j] = i;
+                remaining--;
+            }
+        }
+    }
+}
+
+// Searches for an element in a sorted array using Binary Search.
+static size_t binary_search(const type_t array[], size_t length, type_t element)
+{
+    size_t low = 0;
+    size_t high = length;
+
+    while (low < high) {
+        size_t mid = low + (high - low) / 2;
+
+        // Found.
+        if (array[mid] == element) {
+            return mid;
+        }
+
+        // Search on the left sub-array.
+        else if (element < array[mid]) {
+            high = mid;
+        }
+        // Search on the right sub-array.
+        else {
+            low = mid + 1;
+        }
+    }
+
+    // Not found.
+    return ((size_t)-1);
+}
+
+//==============================================================================
+// Testing
+//==============================================================================
+
 // Initializes an array.
 static void initialize_array(type_t array[], size_t length)
 {
@@ -33,6 +258,134 @@ static void initialize_array(type_t array[], size_t length)
     }
 }
 
+// Checks vectorized kernels against the scalar Linear Search.
+static void check(const type_t array[], size_t length, type_t key)
+{
+    size_t count = 0;
+    size_t indexes[4];
+    uint64_t *bitmap = NULL;
+    const type_t keys[4] = {key, key + 1, -1, array[length - 1]};
+
+    // First match.
+    assert(linear_search_simd(array, length, key) == linear_search(array, length, key));
+
+    // All matches.
+    bitmap = malloc(((length + 63) / 64) * sizeof(uint64_t));
+    assert(bitmap != NULL);
+    linear_search_bitmap(array, length, key, bitmap);
+    for (size_t i = 0; i < length; i++) {
+        bool marked = (bitmap[i / 64] >> (i % 64)) & 1;
+        assert(marked == (array[i] == key));
+        count += (array[i] == key);
+        ((void)marked);
+    }
+    free(bitmap);
+
+    // Number of matches.
+    assert(linear_search_count(array, length, key) == count);
+
+    // Multiple elements.
+    linear_search_multi(array, length, keys, 4, indexes);
+    for (size_t j = 0; j < 4; j++) {
+        assert(indexes[j] == linear_search(array, length, keys[j]));
+    }
+}
+
+// Benchmarks a search function on a hot array.
+static double benchmark(size_t (*search)(const type_t[], size_t, type_t), const type_t array[],
+                        size_t length, const type_t keys[], size_t nlookups)
+{
+    double tstart = 0.0;
+    double tend = 0.0;
+    size_t found = 0;
+    const double MICROSECS = ((CLOCKS_PER_SEC / 1000000.0));
+
+    tstart = clock();
+    for (size_t i = 0; i < nlookups; i++) {
+        found += (search(array, length, keys[i]) != (size_t)-1);
+    }
+    tend = clock();
+
+    assert(found == nlookups);
+    ((void)found);
+
+    // Report time per lookup in nanoseconds.
+    return (((tend - tstart) / MICROSECS) * 1000.0 / nlookups);
+}
+
+// Returns the largest array length that fits in the last private cache level.
+static size_t crossover_max_length(void)
+{
+    long size = sysconf(_SC_LEVEL2_CACHE_SIZE);
+
+    if (size <= 0) {
+        size = DEFAULT_CACHE_SIZE;
+    }
+
+    return ((size_t)size / sizeof(type_t));
+}
+
+// Finds the array length at which Binary Search outperforms vectorized Linear
+// Search. The sweep stops at the first win or once the array no longer fits in
+// cache, where lookups are no longer on a hot array.
+static void crossover(bool verbose)
+{
+    const size_t max_length = crossover_max_length();
+    size_t length = BLOCK_SIZE;
+    double simd = 0.0;
+    double binary = 0.0;
+    type_t *array = NULL;
+    type_t *keys = NULL;
+
+    array = malloc(max_length * sizeof(type_t));
+    assert(array != NULL);
+    keys = malloc(NLOOKUPS * sizeof(type_t));
+    assert(keys != NULL);
+
+    // Sorted array of distinct keys, so that all searches apply.
+    for (size_t i = 0; i < max_length; i++) {
+        array[i] = (type_t)(2 * i);
+    }
+
+    if (verbose) {
+        printf("%8s %12s %12s %12s\n", "length", "linear", "simd", "binary");
+    }
+
+    for (; length <= max_length; length *= 2) {
+        size_t nlookups = NLOOKUPS;
+
+        if (length > NLOOKUPS_MAX_LENGTH) {
+            nlookups = NLOOKUPS / (length / NLOOKUPS_MAX_LENGTH);
+        }
+        for (size_t i = 0; i < nlookups; i++) {
+            keys[i] = array[(size_t)rand() % length];
+        }
+
+        double linear = benchmark(linear_search, array, length, keys, nlookups);
+        simd = benchmark(linear_search_simd, array, length, keys, nlookups);
+        binary = benchmark(binary_search, array, length, keys, nlookups);
+
+        if (verbose) {
+            printf("%8zu %9.2lf ns %9.2lf ns %9.2lf ns\n", length, linear, simd, binary);
+        }
+
+        if (binary < simd) {
+            break;
+        }
+    }
+
+    if (length <= max_length) {
+        printf("Crossover: binary search wins from %zu keys (%.2lfx faster)\n", length,
+               simd / binary);
+    } else {
+        printf("Crossover: binary search does not win up to %zu keys (%.2lfx slower)\n",
+               max_length, binary / simd);
+    }
+
+    free(keys);
+    free(array);
+}
+
 // Tests Linear Search.
 static void test(size_t length, bool verbose)
 {
@@ -66,10 +419,24 @@ static void test(size_t length, bool verbose)
     // Report time.
     printf("Linear Search: %2.lf us\n", (tend - tstart) / MICROSECS);
 
+    // Search in the array using vectorized instructions.
+    tstart = clock();
+    index = linear_search_simd(array, length, key);
+    tend = clock();
+
+    // Report time.
+    printf("SIMD Linear Search: %2.lf us\n", (tend - tstart) / MICROSECS);
+
     if (verbose) {
         printf("Output: %s\n", (index != (size_t)-1) ? "found" : "not found");
     }
 
+    // Check vectorized kernels.
+    check(array, length, key);
+
+    // Look for the crossover point against Binary Search.
+    crossover(verbose);
+
     // Release array.
     free(array);
 }